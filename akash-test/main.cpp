@@ -15,6 +15,7 @@
 #include "akash-test/security/cert_unit_test.h"
 #include "akash-test/security/crypto_unit_test.h"
 #include "akash-test/security/digest_unit_test.h"
+#include "akash-test/tls/tls_unit_test.h"
 
 
 int main(int argc, wchar_t* argv[]) {
@@ -28,12 +29,25 @@ int main(int argc, wchar_t* argv[]) {
 
     //akash::test::TEST_ECDP_X25519();
     //akash::test::TEST_ECDP_X448();
+    //akash::test::TEST_ECDP_P256();
     //akash::test::TEST_AES();
     //akash::test::TEST_AEAD_AES_GCM();
+    //akash::test::TEST_AEAD_CHACHA20_POLY1305();
+    //akash::test::TEST_AEAD_AES_CCM();
+    //akash::test::TEST_TLS13_KEY_SCHEDULE();
+    //akash::test::TEST_TLS13_RECORD_PROTECTION();
     //akash::test::TEST_RSA();
     //akash::test::TEST_CERT();
     //akash::test::TEST_MD5();
     //akash::test::TEST_SHA();
+    //akash::test::TEST_SHA_BLOCK();
+    //akash::test::TEST_SHA512_BLOCK();
+    //akash::test::TEST_SHA_UPDATE();
+    //akash::test::TEST_SHA_PEEK_RESULT();
+    //akash::test::TEST_HMAC_KEY();
+    //akash::test::TEST_SHA256_MB();
+    //akash::test::TEST_TLS_RECORD_BUFFER();
+    //akash::test::TEST_TLS_OUTPUT_QUEUE();
 
     akash::tls::TLS tls_client;
     tls_client.testHandshake();
@@ -12,6 +12,7 @@
 #include "utils/log.h"
 #include "akash/security/big_integer/big_integer.h"
 #include "akash/security/big_integer/byte_string.h"
+#include "akash/security/big_integer/fixed_big_integer.h"
 
 
 namespace {
@@ -68,7 +69,7 @@ namespace {
     bool testDivs(int64_t left, Digit right) {
         auto test = utl::BigInteger::from64(left);
         test.div(right);
-        return test.toInt64() == left / right;
+        return test.toInt64() == left / int64_t(right);
     }
 
     bool testDivOverflow() {
@@ -606,6 +607,54 @@ namespace test {
         }
     }
 
+    void TEST_FIXED_BIG_INTEGER() {
+        using Fixed = FixedBigInteger<521>;
+
+        auto p = BigInteger::fromString(
+            "FFFFFFFF 00000001 00000000 00000000 00000000 FFFFFFFF FFFFFFFF FFFFFFFF", 16);
+        auto fp = Fixed::fromBigInteger(p);
+
+        for (int i = 1; i <= 521; ++i) {
+            auto a = BigInteger::fromRandom(i);
+            auto b = BigInteger::fromRandom(522 - i);
+            if (i & 1) {
+                a.inv();
+            }
+            auto fa = Fixed::fromBigInteger(a);
+            auto fb = Fixed::fromBigInteger(b);
+
+            ubassert(fa.toBigInteger() == a);
+            ubassert((fa + fb).toBigInteger() == a + b);
+            ubassert((fa - fb).toBigInteger() == a - b);
+            ubassert((fb - fa).toBigInteger() == b - a);
+            ubassert((fa * fb).toBigInteger() == a * b);
+            ubassert((fa / fb).toBigInteger() == a / b);
+            ubassert((fa % fb).toBigInteger() == a % b);
+            ubassert(((fa * fb) / fa).toBigInteger() == b);
+            ubassert((fa * Digit(i)).toBigInteger() == a * Digit(i));
+            ubassert((fa / Digit(i)).toBigInteger() == a / Digit(i));
+            ubassert(fa.compare(fb) == a.compare(b));
+
+            auto fm = fa;
+            fm.modP(fp);
+            auto m = a;
+            m.modP(p);
+            ubassert(fm.toBigInteger() == m);
+
+            uint8_t buf[66];
+            fm.getBytesBE(buf, sizeof buf);
+            ubassert(Fixed::fromBytesBE(buf, sizeof buf) == fm);
+            ubassert(BigInteger::fromBytesBE(std::string(reinterpret_cast<char*>(buf), sizeof buf)) == m);
+
+            if (i % 16 == 0 && !m.isZero()) {
+                ubassert(fm.invmod(fp).toBigInteger() == m.invmod(p));
+                auto e = BigInteger::fromRandom(256);
+                ubassert(Fixed(fm).powMod(Fixed::fromBigInteger(e), fp).toBigInteger()
+                    == BigInteger(m).powMod(e, p));
+            }
+        }
+    }
+
     void TEST_BYTE_STRING() {
         {
             uint8_t a[] { 0x01, 0x00, 0x64, 0xEB, 0x99 };
@@ -13,6 +13,8 @@ namespace test {
 
     void TEST_BIG_INTEGER();
 
+    void TEST_FIXED_BIG_INTEGER();
+
     void TEST_BYTE_STRING();
 
 }
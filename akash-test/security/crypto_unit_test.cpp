@@ -7,13 +7,24 @@
 #include "akash-test/security/crypto_unit_test.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iomanip>
 
 #include "utils/log.h"
 #include "akash/security/crypto/aes.h"
+#include "akash/security/crypto/aesni.h"
+#include "akash/security/crypto/chacha20.h"
+#include "akash/security/crypto/curve25519.h"
+#include "akash/security/crypto/curve448.h"
 #include "akash/security/crypto/ecdp.h"
+#include "akash/security/crypto/p256.h"
+#include "akash/security/crypto/poly1305.h"
 #include "akash/security/crypto/aead.h"
 #include "akash/security/crypto/rsa.h"
+#include "akash/security/digest/sha.h"
+#include "akash/tls/tls_key_schedule.h"
+#include "akash/tls/tls_record_protection.h"
+#include "akash/tls/tls_transcript_hash.h"
 
 
 using stringu8 = std::basic_string<uint8_t>;
@@ -64,6 +75,10 @@ namespace akash {
 namespace test {
 
     int TEST_AES() {
+        // 没有 AES-NI 时默认使用执行时间与数据无关的位切片实现
+        ubassert(crypto::AES::getImpl() == (crypto::AESNI::isSupported() ?
+            crypto::AES::Impl::AESNI : crypto::AES::Impl::Bitsliced));
+
         //uint8_t key[] { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
         //uint8_t key[] { 0x8e, 0x73, 0xb0, 0xf7, 0xda, 0x0e, 0x64, 0x52, 0xc8, 0x10, 0xf3, 0x2b, 0x80, 0x90, 0x79, 0xe5, 0x62, 0xf8, 0xea, 0xd2, 0x52, 0x2c, 0x6b, 0x7b };
         uint8_t key[] { 0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81, 0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4 };
@@ -79,6 +94,98 @@ namespace test {
             ubassert(plain[i] == input[i]);
         }
 
+        // FIPS PUB 197 附录 C
+        auto prev_impl = crypto::AES::getImpl();
+        const crypto::AES::Impl impls[] {
+            crypto::AES::Impl::Reference,
+            crypto::AES::Impl::TTable,
+            crypto::AES::Impl::Bitsliced,
+            crypto::AES::Impl::AESNI,
+        };
+        for (auto impl : impls) {
+            crypto::AES::setImpl(impl);
+
+            auto pt = getStrBytes("00112233445566778899aabbccddeeff");
+            auto k128 = getStrBytes("000102030405060708090a0b0c0d0e0f");
+            auto k192 = getStrBytes("000102030405060708090a0b0c0d0e0f1011121314151617");
+            auto k256 = getStrBytes("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+
+            uint8_t ct[16];
+            crypto::AES::encrypt(pt.data(), ct, k128.data(), uint32_t(k128.size()));
+            ubassert(getBytesStr(ct, 16) == "69c4e0d86a7b0430d8cdb78070b4c55a");
+            crypto::AES::encrypt(pt.data(), ct, k192.data(), uint32_t(k192.size()));
+            ubassert(getBytesStr(ct, 16) == "dda97ca4864cdfe06eaf70a0ec0d7191");
+            crypto::AES::encrypt(pt.data(), ct, k256.data(), uint32_t(k256.size()));
+            ubassert(getBytesStr(ct, 16) == "8ea2b7ca516745bfeafc49904b496089");
+        }
+
+        // 各实现处理多个块的结果应与参考实现一致
+        {
+            uint8_t blocks[16 * 9];
+            for (size_t i = 0; i < sizeof(blocks); ++i) {
+                blocks[i] = uint8_t(i * 7 + 3);
+            }
+
+            for (size_t count = 1; count <= 9; ++count) {
+                uint8_t ref[sizeof(blocks)];
+                crypto::AES::setImpl(crypto::AES::Impl::Reference);
+                crypto::AES::encryptBlocks(blocks, ref, count, key, sizeof(key));
+
+                for (auto impl : impls) {
+                    uint8_t result[sizeof(blocks)];
+                    crypto::AES::setImpl(impl);
+                    crypto::AES::encryptBlocks(blocks, result, count, key, sizeof(key));
+                    ubassert(std::memcmp(ref, result, count * 16) == 0);
+                }
+            }
+        }
+
+        // 已扩展的密钥可以重复用于加密、解密和 CTR
+        {
+            auto pt = getStrBytes("00112233445566778899aabbccddeeff");
+            auto k192 = getStrBytes("000102030405060708090a0b0c0d0e0f1011121314151617");
+
+            crypto::AESKey bad;
+            ubassert(!bad.init(k192.data(), 17));
+            ubassert(!bad.isValid());
+
+            crypto::AESKey k(k192.data(), uint32_t(k192.size()));
+            ubassert(k.isValid() && k.getNr() == 12);
+
+            uint8_t data[16 * 9 + 7];
+            for (size_t i = 0; i < sizeof(data); ++i) {
+                data[i] = uint8_t(i * 11 + 5);
+            }
+
+            uint8_t ref_ctr[sizeof(data)];
+            uint8_t ICB[16];
+            std::memset(ICB, 0x5A, 12);
+            ICB[12] = ICB[13] = ICB[14] = 0xFF; ICB[15] = 0xFC;
+            crypto::AES::setImpl(crypto::AES::Impl::Reference);
+            crypto::AES::encryptCTR32(ICB, data, sizeof(data), ref_ctr, k);
+
+            for (auto impl : impls) {
+                crypto::AES::setImpl(impl);
+
+                uint8_t ct[16], _pt[16];
+                crypto::AES::encrypt(pt.data(), ct, k);
+                ubassert(getBytesStr(ct, 16) == "dda97ca4864cdfe06eaf70a0ec0d7191");
+                crypto::AES::decrypt(ct, _pt, k);
+                ubassert(std::memcmp(pt.data(), _pt, 16) == 0);
+
+                uint8_t enc[16 * 9], dec[16 * 9];
+                crypto::AES::encryptBlocks(data, enc, 9, k);
+                crypto::AES::decryptBlocks(enc, dec, 9, k);
+                ubassert(std::memcmp(data, dec, sizeof(dec)) == 0);
+
+                uint8_t ctr[sizeof(data)];
+                std::memcpy(ctr, data, sizeof(data));
+                crypto::AES::encryptCTR32(ICB, ctr, sizeof(ctr), ctr, k);
+                ubassert(std::memcmp(ref_ctr, ctr, sizeof(ctr)) == 0);
+            }
+        }
+        crypto::AES::setImpl(prev_impl);
+
         return 0;
     }
 
@@ -133,6 +240,56 @@ namespace test {
         std::transform(out.begin(), out.end(), out.begin(), ::tolower);
 
         ubassert(swapHexStrBytes("4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742") == out);
+
+        // 专用实现
+        {
+            uint8_t r[crypto::Curve25519::kKeySize];
+            auto sk = getStrBytes("a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4");
+            auto su = getStrBytes("e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c");
+            ubassert(crypto::Curve25519::X25519(r, sk.data(), su.data()));
+            ubassert(getBytesStr(r, sizeof(r)) == "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552");
+
+            auto a_priv = getStrBytes("77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a");
+            auto b_priv = getStrBytes("5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb");
+            uint8_t base[crypto::Curve25519::kKeySize] = { 9 };
+            uint8_t a_pub[crypto::Curve25519::kKeySize];
+            uint8_t b_pub[crypto::Curve25519::kKeySize];
+            ubassert(crypto::Curve25519::X25519(a_pub, a_priv.data(), base));
+            ubassert(crypto::Curve25519::X25519(b_pub, b_priv.data(), base));
+            ubassert(getBytesStr(a_pub, sizeof(a_pub)) == "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a");
+            ubassert(getBytesStr(b_pub, sizeof(b_pub)) == "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f");
+
+            uint8_t a_K[crypto::Curve25519::kKeySize];
+            uint8_t b_K[crypto::Curve25519::kKeySize];
+            ubassert(crypto::Curve25519::X25519(a_K, a_priv.data(), b_pub));
+            ubassert(crypto::Curve25519::X25519(b_K, b_priv.data(), a_pub));
+            ubassert(getBytesStr(a_K, sizeof(a_K)) == "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742");
+            ubassert(getBytesStr(b_K, sizeof(b_K)) == getBytesStr(a_K, sizeof(a_K)));
+
+            // 小阶点
+            uint8_t zero[crypto::Curve25519::kKeySize] = { 0 };
+            ubassert(!crypto::Curve25519::X25519(r, a_priv.data(), zero));
+        }
+
+        // 与通用实现对比
+        for (int i = 0; i < 16; ++i) {
+            uint8_t priv[crypto::Curve25519::kKeySize];
+            uint8_t pub[crypto::Curve25519::kKeySize];
+            crypto::Curve25519::generateKey(priv, pub);
+
+            auto rk = utl::BigInteger::fromBytesLE(
+                std::string(reinterpret_cast<char*>(priv), sizeof(priv)));
+            rk.setBit(255, 0);
+            rk.setBit(254, 1);
+            rk.setBit(2, 0);
+            rk.setBit(1, 0);
+            rk.setBit(0, 0);
+            crypto::ECDP::X25519(p, rk, utl::BigInteger::fromU32(Up), &result);
+
+            auto ref = result.getBytesLE();
+            ref.resize(crypto::Curve25519::kKeySize, 0);
+            ubassert(std::string(reinterpret_cast<char*>(pub), sizeof(pub)) == ref);
+        }
     }
 
     void TEST_ECDP_X448() {
@@ -161,6 +318,132 @@ namespace test {
 
         ubassert(swapHexStrBytes("ce3e4ff95a60dc6697da1db1d85e6afbdf79b50a2412d7546d5f239f"
             "e14fbaadeb445fc66a01b0779d98223961111e21766282f73dd96b6f") == out);
+
+        // 专用实现
+        {
+            uint8_t r[crypto::Curve448::kKeySize];
+            auto sk = getStrBytes(
+                "3d262fddf9ec8e88495266fea19a34d28882acef045104d0d1aae121"
+                "700a779c984c24f8cdd78fbff44943eba368f54b29259a4f1c600ad3");
+            auto su = getStrBytes(
+                "06fce640fa3487bfda5f6cf2d5263f8aad88334cbd07437f020f08f9"
+                "814dc031ddbdc38c19c6da2583fa5429db94ada18aa7a7fb4ef8a086");
+            ubassert(crypto::Curve448::X448(r, sk.data(), su.data()));
+            ubassert(getBytesStr(r, sizeof(r)) ==
+                "ce3e4ff95a60dc6697da1db1d85e6afbdf79b50a2412d7546d5f239f"
+                "e14fbaadeb445fc66a01b0779d98223961111e21766282f73dd96b6f");
+
+            auto a_priv = getStrBytes(
+                "9a8f4925d1519f5775cf46b04b5800d4ee9ee8bae8bc5565d498c28d"
+                "d9c9baf574a9419744897391006382a6f127ab1d9ac2d8c0a598726b");
+            auto b_priv = getStrBytes(
+                "1c306a7ac2a0e2e0990b294470cba339e6453772b075811d8fad0d1d"
+                "6927c120bb5ee8972b0d3e21374c9c921b09d1b0366f10b65173992d");
+            uint8_t base[crypto::Curve448::kKeySize] = { 5 };
+            uint8_t a_pub[crypto::Curve448::kKeySize];
+            uint8_t b_pub[crypto::Curve448::kKeySize];
+            ubassert(crypto::Curve448::X448(a_pub, a_priv.data(), base));
+            ubassert(crypto::Curve448::X448(b_pub, b_priv.data(), base));
+            ubassert(getBytesStr(a_pub, sizeof(a_pub)) ==
+                "9b08f7cc31b7e3e67d22d5aea121074a273bd2b83de09c63faa73d2c"
+                "22c5d9bbc836647241d953d40c5b12da88120d53177f80e532c41fa0");
+            ubassert(getBytesStr(b_pub, sizeof(b_pub)) ==
+                "3eb7a829b0cd20f5bcfc0b599b6feccf6da4627107bdb0d4f345b430"
+                "27d8b972fc3e34fb4232a13ca706dcb57aec3dae07bdc1c67bf33609");
+
+            uint8_t a_K[crypto::Curve448::kKeySize];
+            uint8_t b_K[crypto::Curve448::kKeySize];
+            ubassert(crypto::Curve448::X448(a_K, a_priv.data(), b_pub));
+            ubassert(crypto::Curve448::X448(b_K, b_priv.data(), a_pub));
+            ubassert(getBytesStr(a_K, sizeof(a_K)) ==
+                "07fff4181ac6cc95ec1c16a94a0f74d12da232ce40a77552281d282b"
+                "b60c0b56fd2464c335543936521c24403085d59a449a5037514a879d");
+            ubassert(getBytesStr(b_K, sizeof(b_K)) == getBytesStr(a_K, sizeof(a_K)));
+
+            uint8_t zero[crypto::Curve448::kKeySize] = { 0 };
+            ubassert(!crypto::Curve448::X448(r, a_priv.data(), zero));
+        }
+
+        // 与通用实现对比
+        for (int i = 0; i < 8; ++i) {
+            uint8_t priv[crypto::Curve448::kKeySize];
+            uint8_t pub[crypto::Curve448::kKeySize];
+            crypto::Curve448::generateKey(priv, pub);
+
+            auto rk = utl::BigInteger::fromBytesLE(
+                std::string(reinterpret_cast<char*>(priv), sizeof(priv)));
+            rk.setBit(447, 1);
+            rk.setBit(1, 0);
+            rk.setBit(0, 0);
+            crypto::ECDP::X448(p, rk, utl::BigInteger::fromU32(Up), &result);
+
+            auto ref = result.getBytesLE();
+            ref.resize(crypto::Curve448::kKeySize, 0);
+            ubassert(std::string(reinterpret_cast<char*>(pub), sizeof(pub)) == ref);
+        }
+    }
+
+    void TEST_ECDP_P256() {
+        auto i = getStrBytes("c88f01f510d9ac3f70a292daa2316de544e9aab8afe84049c62a9c57862d1433");
+        auto r = getStrBytes("c6ef9c5d78ae012a011164acb397ce2088685d8f06bf9be0b283ab46476bee53");
+
+        uint8_t gi[crypto::P256::kPointSize];
+        uint8_t gr[crypto::P256::kPointSize];
+        ubassert(crypto::P256::computePublicKey(i.data(), gi));
+        ubassert(crypto::P256::computePublicKey(r.data(), gr));
+        ubassert(getBytesStr(gi, sizeof(gi)) ==
+            "04"
+            "dad0b65394221cf9b051e1feca5787d098dfe637fc90b9ef945d0c3772581180"
+            "5271a0461cdb8252d61f1c456fa3e59ab1f45b33accf5f58389e0577b8990bb3");
+
+        uint8_t gir[crypto::P256::kScalarSize];
+        uint8_t gri[crypto::P256::kScalarSize];
+        ubassert(crypto::P256::ECDH(i.data(), gr, gir));
+        ubassert(crypto::P256::ECDH(r.data(), gi, gri));
+        ubassert(getBytesStr(gir, sizeof(gir)) ==
+            "d6840f6b42f6edafd13116e0e12565202fef8e9ece7dce03812464d04b9442de");
+        ubassert(getBytesStr(gri, sizeof(gri)) == getBytesStr(gir, sizeof(gir)));
+
+        // 不在曲线上的点
+        gr[crypto::P256::kPointSize - 1] ^= 1;
+        ubassert(!crypto::P256::verifyPoint(gr));
+        ubassert(!crypto::P256::ECDH(i.data(), gr, gir));
+
+        // 与通用实现对比
+        uint8_t h;
+        utl::BigInteger p, a, b, S, Gx, Gy, n;
+        crypto::ECDP::secp256r1(&p, &a, &b, &S, &Gx, &Gy, &n, &h);
+        for (int c = 0; c < 16; ++c) {
+            uint8_t priv[crypto::P256::kScalarSize];
+            uint8_t pub[crypto::P256::kPointSize];
+            ubassert(crypto::P256::generateKey(priv, pub));
+            ubassert(crypto::P256::verifyPoint(pub));
+
+            auto d = utl::BigInteger::fromBytesBE(
+                std::string(reinterpret_cast<char*>(priv), sizeof(priv)));
+            auto x = Gx;
+            auto y = Gy;
+            crypto::ECDP::mulPoint(p, a, d, &x, &y);
+
+            auto px = utl::BigInteger::fromBytesBE(
+                std::string(reinterpret_cast<char*>(pub + 1), crypto::P256::kScalarSize));
+            auto py = utl::BigInteger::fromBytesBE(
+                std::string(reinterpret_cast<char*>(pub + 1 + crypto::P256::kScalarSize), crypto::P256::kScalarSize));
+            ubassert(px == x && py == y);
+
+            uint8_t secret[crypto::P256::kScalarSize];
+            ubassert(crypto::P256::ECDH(priv, gi, secret));
+
+            x = utl::BigInteger::fromBytesBE(
+                std::string(reinterpret_cast<char*>(gi + 1), crypto::P256::kScalarSize));
+            y = utl::BigInteger::fromBytesBE(
+                std::string(reinterpret_cast<char*>(gi + 1 + crypto::P256::kScalarSize), crypto::P256::kScalarSize));
+            crypto::ECDP::mulPoint(p, a, d, &x, &y);
+
+            auto sx = utl::BigInteger::fromBytesBE(
+                std::string(reinterpret_cast<char*>(secret), sizeof(secret)));
+            ubassert(sx == x);
+        }
     }
 
     void TEST_AEAD_AES_GCM() {
@@ -357,7 +640,681 @@ namespace test {
                 K.data(), K.length(), IV.data(), IV.length(),
                 C.data(), C.length(), A.data(), A.length(), T, sizeof T, &*_P.begin()));
         }
+
+        // 使用已扩展的密钥时结果不变
+        {
+            stringu8 K = getStrBytes("feffe9928665731c6d6a8f9467308308");
+            stringu8 IV = getStrBytes("cafebabefacedbaddecaf888");
+            stringu8 P = getStrBytes("d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+                "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39");
+            stringu8 A = getStrBytes("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+
+            crypto::AESKey key(K.data(), uint32_t(K.length()));
+            stringu8 C(P.length(), 0);
+            uint8_t T[16];
+            for (int i = 0; i < 2; ++i) {
+                crypto::GCM::GCM_AE(
+                    key, IV.data(), IV.length(),
+                    P.data(), P.length(), A.data(), A.length(), &*C.begin(), T, sizeof T);
+                ubassert(getBytesStr(C.data(), C.length())
+                    == "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+                    "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091");
+                ubassert(getBytesStr(T, sizeof T) == "5bc94fbc3221a5db94fae95ae7121a47");
+
+                stringu8 _P(C.length(), 0);
+                ubassert(crypto::GCM::GCM_AD(
+                    key, IV.data(), IV.length(),
+                    C.data(), C.length(), A.data(), A.length(), T, sizeof T, &*_P.begin()));
+                ubassert(_P == P);
+            }
+        }
+
+        // GCMContext 的结果应与 GCM 一致，包括原地加密/解密和非 96 位的 IV
+        {
+            auto prev_impl = crypto::AES::getImpl();
+
+            uint8_t K[32];
+            uint8_t IV[60];
+            uint8_t A[37];
+            uint8_t P[16 * 20 + 9];
+            for (size_t i = 0; i < sizeof(K); ++i) K[i] = uint8_t(i * 31 + 3);
+            for (size_t i = 0; i < sizeof(IV); ++i) IV[i] = uint8_t(i * 17 + 9);
+            for (size_t i = 0; i < sizeof(A); ++i) A[i] = uint8_t(i * 7 + 1);
+            for (size_t i = 0; i < sizeof(P); ++i) P[i] = uint8_t(i * 23 + 5);
+
+            const crypto::AES::Impl impls[] {
+                crypto::AES::Impl::TTable,
+                crypto::AES::Impl::AESNI,
+            };
+            const size_t key_lengths[] { 16, 24, 32 };
+            const size_t iv_lengths[] { 12, 1, 16, sizeof(IV) };
+            const size_t a_lengths[] { 0, 13, sizeof(A) };
+            const size_t lengths[] { 0, 1, 16, 33, 128, sizeof(P) };
+            for (auto impl : impls) {
+                crypto::AES::setImpl(impl);
+                for (auto lk : key_lengths) {
+                    crypto::GCMContext ctx;
+                    ubassert(ctx.init(K, lk));
+                    for (auto l_iv : iv_lengths) {
+                        for (auto la : a_lengths) {
+                            for (auto lp : lengths) {
+                                uint8_t C1[sizeof(P)], C2[sizeof(P)];
+                                uint8_t T1[16], T2[16];
+                                crypto::GCM::GCM_AE(K, lk, IV, l_iv, P, lp, A, la, C1, T1, 16);
+
+                                std::memcpy(C2, P, lp);
+                                ctx.seal(IV, l_iv, C2, lp, A, la, C2, T2, 16);
+                                ubassert(std::memcmp(C1, C2, lp) == 0);
+                                ubassert(std::memcmp(T1, T2, 16) == 0);
+
+                                ubassert(ctx.open(IV, l_iv, C2, lp, A, la, T2, 16, C2));
+                                ubassert(std::memcmp(P, C2, lp) == 0);
+
+                                T2[15] ^= 1;
+                                ubassert(!ctx.open(IV, l_iv, C1, lp, A, la, T2, 16, C2));
+                            }
+                        }
+                    }
+                }
+            }
+            crypto::AES::setImpl(prev_impl);
+        }
+
+        // 流式接口：AAD 和明文分多段输入时结果应与 seal/open 一致
+        {
+            auto prev_impl = crypto::AES::getImpl();
+
+            uint8_t K[16];
+            uint8_t IV[12];
+            uint8_t A[45];
+            uint8_t P[16 * 40 + 11];
+            for (size_t i = 0; i < sizeof(K); ++i) K[i] = uint8_t(i * 19 + 2);
+            for (size_t i = 0; i < sizeof(IV); ++i) IV[i] = uint8_t(i * 3 + 4);
+            for (size_t i = 0; i < sizeof(A); ++i) A[i] = uint8_t(i * 41 + 6);
+            for (size_t i = 0; i < sizeof(P); ++i) P[i] = uint8_t(i * 37 + 8);
+
+            const crypto::AES::Impl impls[] {
+                crypto::AES::Impl::TTable,
+                crypto::AES::Impl::AESNI,
+            };
+            // 每段的长度依次循环使用
+            const size_t pieces[] { 1, 15, 3, 16, 33, 7, 600 };
+
+            for (auto impl : impls) {
+                crypto::AES::setImpl(impl);
+
+                crypto::GCMContext ctx;
+                ubassert(ctx.init(K, sizeof(K)));
+
+                uint8_t C[sizeof(P)];
+                uint8_t T[16];
+                ctx.seal(IV, sizeof(IV), P, sizeof(P), A, sizeof(A), C, T, 16);
+
+                for (size_t first = 0; first < 7; ++first) {
+                    crypto::GCMStream stream(ctx);
+
+                    // 原地加密
+                    uint8_t buf[sizeof(P)];
+                    std::memcpy(buf, P, sizeof(P));
+                    stream.init(IV, sizeof(IV), true);
+                    stream.updateAAD(A, 10);
+                    stream.updateAAD(A + 10, sizeof(A) - 10);
+                    size_t pos = 0;
+                    for (size_t i = first; pos < sizeof(P); ++i) {
+                        size_t n = std::min(pieces[i % 7], sizeof(P) - pos);
+                        stream.update(buf + pos, n, buf + pos);
+                        pos += n;
+                    }
+                    uint8_t _T[16];
+                    stream.finish(_T, 16);
+                    ubassert(std::memcmp(C, buf, sizeof(C)) == 0);
+                    ubassert(std::memcmp(T, _T, 16) == 0);
+
+                    stream.init(IV, sizeof(IV), false);
+                    stream.updateAAD(A, sizeof(A));
+                    pos = 0;
+                    for (size_t i = first; pos < sizeof(P); ++i) {
+                        size_t n = std::min(pieces[(i + 3) % 7], sizeof(P) - pos);
+                        stream.update(buf + pos, n, buf + pos);
+                        pos += n;
+                    }
+                    ubassert(stream.verify(T, 16));
+                    ubassert(std::memcmp(P, buf, sizeof(P)) == 0);
+                }
+
+                // 校验失败时 open 清零输出
+                uint8_t out[sizeof(P)];
+                T[0] ^= 0x80;
+                ubassert(!ctx.open(IV, sizeof(IV), C, sizeof(C), A, sizeof(A), T, 16, out));
+                ubassert(std::all_of(out, out + sizeof(out), [](uint8_t b) { return b == 0; }));
+            }
+            crypto::AES::setImpl(prev_impl);
+        }
+
+        // AES-NI 与 PCLMULQDQ 的结果应与可移植实现一致
+        if (crypto::AESNI::isSupported()) {
+            auto prev_impl = crypto::AES::getImpl();
+
+            uint8_t K[32];
+            uint8_t IV[12];
+            uint8_t A[40];
+            uint8_t P[16 * 20 + 5];
+            for (size_t i = 0; i < sizeof(K); ++i) K[i] = uint8_t(i * 13 + 1);
+            for (size_t i = 0; i < sizeof(IV); ++i) IV[i] = uint8_t(i * 29 + 7);
+            for (size_t i = 0; i < sizeof(A); ++i) A[i] = uint8_t(i * 5 + 11);
+            for (size_t i = 0; i < sizeof(P); ++i) P[i] = uint8_t(i * 3 + 17);
+
+            const size_t key_lengths[] { 16, 24, 32 };
+            const size_t lengths[] { 0, 1, 15, 16, 17, 64, 127, 128, 129, sizeof(P) };
+            for (auto lk : key_lengths) {
+                for (auto lp : lengths) {
+                    uint8_t C1[sizeof(P)], C2[sizeof(P)];
+                    uint8_t T1[16], T2[16];
+
+                    crypto::AES::setImpl(crypto::AES::Impl::TTable);
+                    crypto::GCM::GCM_AE(K, lk, IV, sizeof(IV), P, lp, A, sizeof(A), C1, T1, 16);
+                    crypto::AES::setImpl(crypto::AES::Impl::AESNI);
+                    crypto::GCM::GCM_AE(K, lk, IV, sizeof(IV), P, lp, A, sizeof(A), C2, T2, 16);
+                    ubassert(std::memcmp(C1, C2, lp) == 0);
+                    ubassert(std::memcmp(T1, T2, 16) == 0);
+
+                    uint8_t _P[sizeof(P)];
+                    ubassert(crypto::GCM::GCM_AD(
+                        K, lk, IV, sizeof(IV), C2, lp, A, sizeof(A), T2, 16, _P));
+                    ubassert(std::memcmp(P, _P, lp) == 0);
+                }
+            }
+
+            // 计数器从 0xFFFFFFFD 开始，覆盖 inc32 的回绕
+            {
+                uint8_t ICB[16];
+                std::memset(ICB, 0xAB, 12);
+                ICB[12] = ICB[13] = ICB[14] = 0xFF; ICB[15] = 0xFD;
+
+                uint8_t CB[16 * 10];
+                for (int i = 0; i < 10; ++i) {
+                    std::memcpy(CB + i * 16, ICB, 12);
+                    uint32_t c = 0xFFFFFFFDu + uint32_t(i);
+                    CB[i * 16 + 12] = uint8_t(c >> 24);
+                    CB[i * 16 + 13] = uint8_t(c >> 16);
+                    CB[i * 16 + 14] = uint8_t(c >> 8);
+                    CB[i * 16 + 15] = uint8_t(c);
+                }
+                uint8_t ks[sizeof(CB)];
+                crypto::AES::setImpl(crypto::AES::Impl::TTable);
+                crypto::AES::encryptBlocks(CB, ks, 10, K, 16);
+
+                uint8_t rk[crypto::AESNI::kMaxRoundKeySize];
+                uint32_t Nr = crypto::AESNI::keyExpansion(K, 16, rk);
+                uint8_t out[sizeof(CB)];
+                crypto::AESNI::ctr32(rk, Nr, ICB, P, sizeof(CB) - 3, out);
+                for (size_t i = 0; i < sizeof(CB) - 3; ++i) {
+                    ubassert(out[i] == uint8_t(P[i] ^ ks[i]));
+                }
+            }
+
+            // 实现方式在初始化时确定，之后的 setImpl 不影响已有的上下文
+            {
+                crypto::AES::setImpl(crypto::AES::Impl::AESNI);
+                crypto::GCMContext ctx;
+                ubassert(ctx.init(K, 16));
+                crypto::AES::setImpl(crypto::AES::Impl::Reference);
+
+                uint8_t C1[sizeof(P)], C2[sizeof(P)];
+                uint8_t T1[16], T2[16];
+                crypto::GCM::GCM_AE(K, 16, IV, sizeof(IV), P, sizeof(P), A, sizeof(A), C1, T1, 16);
+                ctx.seal(IV, sizeof(IV), P, sizeof(P), A, sizeof(A), C2, T2, 16);
+                ubassert(std::memcmp(C1, C2, sizeof(P)) == 0);
+                ubassert(std::memcmp(T1, T2, 16) == 0);
+            }
+            crypto::AES::setImpl(prev_impl);
+        }
+    }
+
+    void TEST_AEAD_CHACHA20_POLY1305() {
+        const std::string sunscreen =
+            "Ladies and Gentlemen of the class of '99: If I could offer you only one "
+            "tip for the future, sunscreen would be it.";
+        stringu8 plaintext(sunscreen.begin(), sunscreen.end());
+
+        // Section 2.4.2
+        {
+            stringu8 K = getStrBytes("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+            stringu8 N = getStrBytes("000000000000004a00000000");
+            stringu8 C(plaintext.length(), 0);
+            crypto::ChaCha20::encrypt(
+                K.data(), 1, N.data(), plaintext.data(), plaintext.length(), &*C.begin());
+            ubassert(getBytesStr(C.data(), C.length())
+                == "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"
+                "f91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d8"
+                "07ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+                "5af90bbf74a35be6b40b8eedf2785e42874d");
+        }
+
+        // Section 2.5.2
+        {
+            stringu8 K = getStrBytes("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+            std::string msg = "Cryptographic Forum Research Group";
+            uint8_t tag[16];
+            crypto::Poly1305::mac(
+                K.data(), reinterpret_cast<const uint8_t*>(msg.data()), msg.length(), tag);
+            ubassert(getBytesStr(tag, 16) == "a8061dc1305136c6c22b8baf0c0127a9");
+
+            // 分段输入
+            crypto::Poly1305 poly;
+            poly.init(K.data());
+            for (size_t i = 0; i < msg.length(); i += 5) {
+                size_t n = std::min<size_t>(5, msg.length() - i);
+                poly.update(reinterpret_cast<const uint8_t*>(msg.data()) + i, n);
+            }
+            poly.finish(tag);
+            ubassert(getBytesStr(tag, 16) == "a8061dc1305136c6c22b8baf0c0127a9");
+        }
+
+        // Section 2.8.2
+        {
+            stringu8 K = getStrBytes("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f");
+            stringu8 N = getStrBytes("070000004041424344454647");
+            stringu8 A = getStrBytes("50515253c0c1c2c3c4c5c6c7");
+
+            crypto::ChaCha20Poly1305 aead;
+            ubassert(!aead.init(K.data(), 16));
+            ubassert(aead.init(K.data(), K.length()));
+
+            stringu8 C(plaintext.length(), 0);
+            uint8_t T[16];
+            aead.seal(N.data(), plaintext.data(), plaintext.length(), A.data(), A.length(), &*C.begin(), T);
+            ubassert(getBytesStr(C.data(), C.length())
+                == "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+                "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+                "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+                "3ff4def08e4b7a9de576d26586cec64b6116");
+            ubassert(getBytesStr(T, 16) == "1ae10b594f09e26a7e902ecbd0600691");
+
+            stringu8 P(C.length(), 0);
+            ubassert(aead.open(N.data(), C.data(), C.length(), A.data(), A.length(), T, &*P.begin()));
+            ubassert(P == plaintext);
+
+            T[0] ^= 1;
+            ubassert(!aead.open(N.data(), C.data(), C.length(), A.data(), A.length(), T, &*P.begin()));
+        }
+
+        // 各实现的密钥流应一致，包括计数器回绕
+        {
+            auto prev_impl = crypto::ChaCha20::getImpl();
+
+            uint8_t K[32];
+            uint8_t N[12];
+            uint8_t data[64 * 27 + 13];
+            for (size_t i = 0; i < sizeof(K); ++i) K[i] = uint8_t(i * 7 + 1);
+            for (size_t i = 0; i < sizeof(N); ++i) N[i] = uint8_t(i * 5 + 3);
+            for (size_t i = 0; i < sizeof(data); ++i) data[i] = uint8_t(i * 13 + 9);
+
+            const crypto::ChaCha20::Impl impls[] {
+                crypto::ChaCha20::Impl::Scalar,
+                crypto::ChaCha20::Impl::SSE2,
+                crypto::ChaCha20::Impl::AVX2,
+            };
+            const uint32_t counters[] { 0, 0xFFFFFFFBu };
+
+            for (auto counter : counters) {
+                uint8_t ref[sizeof(data)];
+                crypto::ChaCha20::setImpl(crypto::ChaCha20::Impl::Scalar);
+                crypto::ChaCha20::encrypt(K, counter, N, data, sizeof(data), ref);
+
+                for (auto impl : impls) {
+                    crypto::ChaCha20::setImpl(impl);
+                    uint8_t out[sizeof(data)];
+                    std::memcpy(out, data, sizeof(data));
+                    crypto::ChaCha20::encrypt(K, counter, N, out, sizeof(out), out);
+                    ubassert(std::memcmp(ref, out, sizeof(out)) == 0);
+
+                    uint8_t blk[64];
+                    crypto::ChaCha20::block(K, counter + 9, N, blk);
+                    for (size_t i = 0; i < 64; ++i) {
+                        ubassert(uint8_t(blk[i] ^ data[64 * 9 + i]) == ref[64 * 9 + i]);
+                    }
+                }
+            }
+            crypto::ChaCha20::setImpl(prev_impl);
+        }
     }
 
+    void TEST_AEAD_AES_CCM() {
+        struct Vector {
+            const char* N;
+            const char* A;
+            const char* P;
+            size_t t;
+            const char* CT;
+        };
+        const Vector vectors[] {
+            // Example 1
+            { "10111213141516",
+              "0001020304050607",
+              "20212223",
+              4, "7162015b4dac255d" },
+            // Example 2
+            { "1011121314151617",
+              "000102030405060708090a0b0c0d0e0f",
+              "202122232425262728292a2b2c2d2e2f",
+              6, "d2a1f0e051ea5f62081a7792073d593d1fc64fbfaccd" },
+            // Example 3
+            { "101112131415161718191a1b",
+              "000102030405060708090a0b0c0d0e0f10111213",
+              "202122232425262728292a2b2c2d2e2f3031323334353637",
+              8, "e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5484392fbc1b09951" },
+        };
+
+        stringu8 K = getStrBytes("404142434445464748494a4b4c4d4e4f");
+
+        auto prev_impl = crypto::AES::getImpl();
+        const crypto::AES::Impl impls[] {
+            crypto::AES::Impl::TTable,
+            crypto::AES::Impl::Bitsliced,
+            crypto::AES::Impl::AESNI,
+        };
+
+        for (auto impl : impls) {
+            crypto::AES::setImpl(impl);
+
+            crypto::CCMContext ccm;
+            ubassert(!ccm.init(K.data(), 15));
+            ubassert(ccm.init(K.data(), K.length()));
+
+            for (const auto& v : vectors) {
+                stringu8 N = getStrBytes(v.N);
+                stringu8 A = getStrBytes(v.A);
+                stringu8 P = getStrBytes(v.P);
+
+                stringu8 C(P.length(), 0);
+                uint8_t T[16];
+                ccm.seal(N.data(), N.length(), P.data(), P.length(), A.data(), A.length(), &*C.begin(), T, v.t);
+                ubassert(getBytesStr(C.data(), C.length()) + getBytesStr(T, v.t) == v.CT);
+
+                stringu8 R(C.length(), 0);
+                ubassert(ccm.open(N.data(), N.length(), C.data(), C.length(), A.data(), A.length(), T, v.t, &*R.begin()));
+                ubassert(R == P);
+
+                T[v.t - 1] ^= 1;
+                ubassert(!ccm.open(N.data(), N.length(), C.data(), C.length(), A.data(), A.length(), T, v.t, &*R.begin()));
+                ubassert(R == stringu8(R.length(), 0));
+            }
+
+            // Example 4，AAD 长度为 2^16，使用 0xfffe 开头的长度编码
+            {
+                stringu8 N = getStrBytes("101112131415161718191a1b1c");
+                stringu8 A(65536, 0);
+                for (size_t i = 0; i < A.length(); ++i) A[i] = uint8_t(i);
+                stringu8 P = getStrBytes("202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f");
+
+                stringu8 C(P);
+                uint8_t T[14];
+                ccm.seal(N.data(), N.length(), C.data(), C.length(), A.data(), A.length(), &*C.begin(), T, 14);
+                ubassert(getBytesStr(C.data(), C.length()) + getBytesStr(T, 14)
+                    == "69915dad1e84c6376a68c2967e4dab615ae0fd1faec44cc484828529463ccf72"
+                    "b4ac6bec93e8598e7f0dadbcea5b");
+
+                ubassert(ccm.open(N.data(), N.length(), C.data(), C.length(), A.data(), A.length(), T, 14, &*C.begin()));
+                ubassert(C == P);
+            }
+        }
+
+        // 各实现对较长的消息应得到相同的结果，包括不完整的块
+        {
+            uint8_t N[12];
+            uint8_t A[13];
+            uint8_t data[16 * 37 + 5];
+            for (size_t i = 0; i < sizeof(N); ++i) N[i] = uint8_t(i * 5 + 3);
+            for (size_t i = 0; i < sizeof(A); ++i) A[i] = uint8_t(i * 11 + 7);
+            for (size_t i = 0; i < sizeof(data); ++i) data[i] = uint8_t(i * 13 + 9);
+
+            uint8_t ref[sizeof(data)];
+            uint8_t ref_T[16];
+            crypto::AES::setImpl(crypto::AES::Impl::TTable);
+            {
+                crypto::CCMContext ccm;
+                ccm.init(K.data(), K.length());
+                ccm.seal(N, sizeof(N), data, sizeof(data), A, sizeof(A), ref, ref_T, 16);
+            }
+
+            for (auto impl : impls) {
+                crypto::AES::setImpl(impl);
+                crypto::CCMContext ccm;
+                ccm.init(K.data(), K.length());
+
+                uint8_t buf[sizeof(data)];
+                uint8_t T[16];
+                std::memcpy(buf, data, sizeof(data));
+                ccm.seal(N, sizeof(N), buf, sizeof(buf), A, sizeof(A), buf, T, 16);
+                ubassert(std::memcmp(buf, ref, sizeof(buf)) == 0);
+                ubassert(std::memcmp(T, ref_T, 16) == 0);
+
+                ubassert(ccm.open(N, sizeof(N), buf, sizeof(buf), A, sizeof(A), T, 16, buf));
+                ubassert(std::memcmp(buf, data, sizeof(buf)) == 0);
+            }
+        }
+
+        crypto::AES::setImpl(prev_impl);
+    }
+
+    void TEST_TLS13_KEY_SCHEDULE() {
+        // Section 3，Simple 1-RTT Handshake
+        stringu8 CH = getStrBytes(
+            "010000c00303cb34ecb1e78163ba1c38c6dacb196a6dffa21a8d9912ec18a2ef6283024dece7000006130113031302"
+            "010000910000000b0009000006736572766572ff01000100000a00140012001d0017001800190100010101020103"
+            "010400230000003300260024001d002099381de560e4bd43d23d8e435a7dbafeb3c06e51c13cae4d5413691e529a"
+            "af2c002b0003020304000d0020001e040305030603020308040805080604010501060102010402050206020202002d"
+            "00020101001c00024001");
+        stringu8 SH = getStrBytes(
+            "020000560303a6af06a4121860dc5e6e60249cd34c95930c8ac5cb1434dac155772ed3e2692800130100002e0033"
+            "0024001d0020c9828876112095fe66762bdbf7c672e156d6cc253b833df1dd69b1b04e751f0f002b00020304");
+        stringu8 ecdhe = getStrBytes("8bd4054fb55b9d63fdfbacf9f04b9f0d35e6d63f537563efd46272900f89492d");
+
+        // early secret，PSK 和 salt 均为 32 个 0
+        uint8_t zero[32] = { 0 };
+        uint8_t early[digest::USHA::kMaxHashSize];
+        ubassert(digest::HKDF::hkdfExtract(
+            digest::SHAVersion::SHA256, zero, 32, zero, 32, early) == digest::shaSuccess);
+        ubassert(getBytesStr(early, 32) == "33ad0a1c607ec03b09e6cd9893680ce210adf300aa1f2660e1b22e10f170f92a");
+
+        // Derive-Secret(early, "derived", "")
+        uint8_t empty_hash[32];
+        {
+            digest::SHA256 sha256;
+            sha256.init();
+            ubassert(sha256.result(empty_hash) == digest::shaSuccess);
+        }
+        uint8_t derived[32];
+        ubassert(tls::KeySchedule::HKDFExpandLabel(
+            digest::SHAVersion::SHA256, early, 32, "derived", empty_hash, 32, derived, 32));
+        ubassert(getBytesStr(derived, 32) == "6f2615a108c702c5678f54fc9dbab69716c076189c48250cebeac3576c3611ba");
+
+        // handshake secret
+        uint8_t handshake[digest::USHA::kMaxHashSize];
+        ubassert(digest::HKDF::hkdfExtract(
+            digest::SHAVersion::SHA256, derived, 32,
+            ecdhe.data(), int(ecdhe.length()), handshake) == digest::shaSuccess);
+        ubassert(getBytesStr(handshake, 32) == "1dc826e93606aa6fdc0aadc12f741b01046aa6b99f691ed221a9f0ca043fbeac");
+
+        // secret 长度小于摘要长度时失败
+        uint8_t out[32];
+        ubassert(!tls::KeySchedule::HKDFExpandLabel(
+            digest::SHAVersion::SHA256, early, 31, "derived", empty_hash, 32, out, 32));
+
+        // 完整的密钥计划
+        tls::TranscriptHash transcript;
+        ubassert(transcript.init(digest::SHAVersion::SHA256));
+        ubassert(transcript.update(CH.data(), CH.length()));
+        ubassert(transcript.update(SH.data(), SH.length()));
+
+        uint8_t hash[tls::TranscriptHash::kMaxHashSize];
+        ubassert(transcript.current(hash));
+        ubassert(getBytesStr(hash, 32) == "860c06edc07858ee8e78f0e7428c58edd6b43f2ca3e6e95f02ed063cf0e1cad8");
+
+        tls::KeySchedule ks;
+        ubassert(!ks.getSecret(tls::KeySchedule::Secret::ClientHandshakeTraffic));
+        ubassert(ks.init(tls::CipherSuite::TLS_AES_128_GCM_SHA256));
+        ubassert(ks.getHashSize() == 32 && ks.getKeyLength() == 16);
+        ubassert(ks.deriveHandshakeSecrets(ecdhe.data(), ecdhe.length(), transcript));
+        ubassert(!ks.getSecret(tls::KeySchedule::Secret::ClientApplicationTraffic));
+
+        auto c_hs = ks.getSecret(tls::KeySchedule::Secret::ClientHandshakeTraffic);
+        auto s_hs = ks.getSecret(tls::KeySchedule::Secret::ServerHandshakeTraffic);
+        ubassert(c_hs && s_hs);
+        ubassert(getBytesStr(c_hs, 32) == "b3eddb126e067f35a780b3abf45e2d8f3b1a950738f52e9600746a0e27a55a21");
+        ubassert(getBytesStr(s_hs, 32) == "b67b7d690cc16c4e75e54213cb2d37b4e9c912bcded9105d42befd59d391ad38");
+
+        // Section 7.3，key 与 iv
+        tls::KeySchedule::TrafficKey key;
+        ubassert(ks.getTrafficKey(tls::KeySchedule::Secret::ServerHandshakeTraffic, &key));
+        ubassert(key.key_length == 16);
+        ubassert(getBytesStr(key.key, key.key_length) == "3fce516009c21727d0f2e4e86ee403bc");
+        ubassert(getBytesStr(key.iv, tls::KeySchedule::kIVSize) == "5d313eb2671276ee13000b30");
+
+        ubassert(ks.getTrafficKey(tls::KeySchedule::Secret::ClientHandshakeTraffic, &key));
+        ubassert(key.key_length == 16);
+        ubassert(getBytesStr(key.key, key.key_length) == "dbfaa693d1762c5b666af5d950258d01");
+        ubassert(getBytesStr(key.iv, tls::KeySchedule::kIVSize) == "5bd3c71b836e0b76bb73265f");
+
+        // 同一 secret 上直接调用 HKDFExpandLabel 应得到相同的结果
+        uint8_t iv[tls::KeySchedule::kIVSize];
+        ubassert(tls::KeySchedule::HKDFExpandLabel(
+            digest::SHAVersion::SHA256, c_hs, 32, "iv", nullptr, 0, iv, sizeof(iv)));
+        ubassert(std::memcmp(iv, key.iv, sizeof(iv)) == 0);
+    }
+
+    void TEST_TLS13_RECORD_PROTECTION() {
+        struct Suite {
+            tls::CipherSuite suite;
+            size_t key_length;
+            size_t tag_size;
+        };
+        const Suite suites[] {
+            { tls::CipherSuite::TLS_AES_128_GCM_SHA256, 16, 16 },
+            { tls::CipherSuite::TLS_AES_256_GCM_SHA384, 32, 16 },
+            { tls::CipherSuite::TLS_CHACHA20_POLY1305_SHA256, 32, 16 },
+            { tls::CipherSuite::TLS_AES_128_CCM_SHA256, 16, 16 },
+            { tls::CipherSuite::TLS_AES_128_CCM_8_SHA256, 16, 8 },
+        };
+        const size_t lengths[] { 0, 1, 15, 16, 17, 100, 1000 };
+        const size_t kHeaderSize = tls::RecordProtection::kHeaderSize;
+
+        tls::KeySchedule::TrafficKey key;
+        for (size_t i = 0; i < sizeof(key.key); ++i) key.key[i] = uint8_t(i * 7 + 1);
+        for (size_t i = 0; i < sizeof(key.iv); ++i) key.iv[i] = uint8_t(i * 3 + 2);
+
+        for (const auto& s : suites) {
+            key.key_length = s.key_length;
+
+            tls::RecordProtection writer;
+            tls::RecordProtection reader;
+            ubassert(!writer.isEnabled());
+            ubassert(writer.init(s.suite, key));
+            ubassert(reader.init(s.suite, key));
+            ubassert(writer.isEnabled());
+            ubassert(writer.getTagSize() == s.tag_size);
+
+            uint64_t seq = 0;
+            for (size_t length : lengths) {
+                size_t sealed = writer.getSealedSize(length);
+                ubassert(sealed == kHeaderSize + length + 1 + s.tag_size);
+
+                stringu8 P(length, 0);
+                for (size_t i = 0; i < length; ++i) P[i] = uint8_t(i * 13 + seq);
+
+                stringu8 record(sealed, 0);
+                std::memcpy(&record[kHeaderSize], P.data(), length);
+                ubassert(writer.seal(tls::ContentType::Handshake, &record[0], length));
+                ubassert(writer.getSequenceNumber() == seq + 1);
+
+                // 外层记录头总是 application_data, legacy_record_version 为 0x0303
+                ubassert(record[0] == uint8_t(tls::ContentType::ApplicationData));
+                ubassert(record[1] == 3 && record[2] == 3);
+                ubassert(((size_t(record[3]) << 8) | record[4]) == sealed - kHeaderSize);
+                if (length > 0) {
+                    ubassert(std::memcmp(&record[kHeaderSize], P.data(), length) != 0);
+                }
+
+                // 篡改认证标签后解密失败，序列号不变
+                stringu8 tampered(record);
+                tampered[sealed - 1] ^= 1;
+                tls::ContentType type;
+                size_t content_length;
+                ubassert(!reader.open(
+                    tampered.data(), &tampered[kHeaderSize], sealed - kHeaderSize,
+                    &type, &content_length));
+                ubassert(reader.getSequenceNumber() == seq);
+
+                // 篡改记录头 (AAD) 同样失败
+                tampered = record;
+                tampered[4] ^= 1;
+                ubassert(!reader.open(
+                    tampered.data(), &tampered[kHeaderSize], sealed - kHeaderSize,
+                    &type, &content_length));
+                ubassert(reader.getSequenceNumber() == seq);
+
+                stringu8 copy(record);
+                ubassert(reader.open(
+                    record.data(), &record[kHeaderSize], sealed - kHeaderSize,
+                    &type, &content_length));
+                ubassert(reader.getSequenceNumber() == seq + 1);
+                ubassert(type == tls::ContentType::Handshake);
+                ubassert(content_length == length);
+                ubassert(std::memcmp(&record[kHeaderSize], P.data(), length) == 0);
+
+                // 序列号已前进，重放同一条记录时 nonce 不同，解密失败
+                ubassert(!reader.open(
+                    copy.data(), &copy[kHeaderSize], sealed - kHeaderSize,
+                    &type, &content_length));
+                ubassert(reader.getSequenceNumber() == seq + 1);
+
+                ++seq;
+            }
+
+            // 明文过长时不加密
+            stringu8 big(writer.getSealedSize(tls::RecordProtection::kMaxPlaintextSize + 1), 0);
+            ubassert(!writer.seal(
+                tls::ContentType::ApplicationData, &big[0], tls::RecordProtection::kMaxPlaintextSize + 1));
+            ubassert(writer.getSequenceNumber() == seq);
+
+            writer.clear();
+            ubassert(!writer.isEnabled());
+            ubassert(writer.getSequenceNumber() == 0);
+        }
+
+        // 第 n 条记录的 nonce 为 iv 与 n 异或，与直接使用 GCMContext 的结果比较
+        {
+            key.key_length = 16;
+            tls::RecordProtection writer;
+            ubassert(writer.init(tls::CipherSuite::TLS_AES_128_GCM_SHA256, key));
+
+            crypto::GCMContext gcm;
+            ubassert(gcm.init(key.key, key.key_length));
+
+            const uint8_t content[] = { 'h', 'e', 'l', 'l', 'o' };
+            for (uint64_t n = 0; n < 3; ++n) {
+                size_t sealed = writer.getSealedSize(sizeof(content));
+                stringu8 record(sealed, 0);
+                std::memcpy(&record[kHeaderSize], content, sizeof(content));
+                ubassert(writer.seal(tls::ContentType::ApplicationData, &record[0], sizeof(content)));
+
+                uint8_t nonce[tls::KeySchedule::kIVSize];
+                std::memcpy(nonce, key.iv, sizeof(nonce));
+                nonce[sizeof(nonce) - 1] ^= uint8_t(n);
+
+                uint8_t inner[sizeof(content) + 1];
+                std::memcpy(inner, content, sizeof(content));
+                inner[sizeof(content)] = uint8_t(tls::ContentType::ApplicationData);
+
+                uint8_t C[sizeof(inner)];
+                uint8_t T[16];
+                gcm.seal(nonce, sizeof(nonce), inner, sizeof(inner), record.data(), kHeaderSize, C, T, 16);
+                ubassert(std::memcmp(&record[kHeaderSize], C, sizeof(C)) == 0);
+                ubassert(std::memcmp(&record[kHeaderSize + sizeof(C)], T, 16) == 0);
+            }
+        }
+    }
+
+}
 }
-}
\ No newline at end of file
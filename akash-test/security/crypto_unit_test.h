@@ -30,12 +30,41 @@ namespace test {
      */
     void TEST_ECDP_X448();
 
+    /**
+     * 该测试代码来自 RFC5903
+     * https://tools.ietf.org/html/rfc5903
+     */
+    void TEST_ECDP_P256();
+
     /**
      * 该测试代码来自:
      * https://csrc.nist.gov/Projects/Cryptographic-Algorithm-Validation-Program/CAVP-TESTING-BLOCK-CIPHER-MODES
      */
     void TEST_AEAD_AES_GCM();
 
+    /**
+     * 该测试代码来自 RFC8439
+     * https://tools.ietf.org/html/rfc8439
+     */
+    void TEST_AEAD_CHACHA20_POLY1305();
+
+    /**
+     * 该测试代码来自 NIST SP 800-38C 附录 C
+     * https://csrc.nist.gov/publications/detail/sp/800-38c/final
+     */
+    void TEST_AEAD_AES_CCM();
+
+    /**
+     * 该测试代码来自 RFC8448 第 3 节
+     * https://tools.ietf.org/html/rfc8448
+     */
+    void TEST_TLS13_KEY_SCHEDULE();
+
+    /**
+     * RFC8446 第 5.2 节记录保护的往返测试，覆盖所有 TLS 1.3 密码套件
+     */
+    void TEST_TLS13_RECORD_PROTECTION();
+
 }
 }
 
@@ -6,6 +6,7 @@
 
 #include "akash-test/security/digest_unit_test.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -14,6 +15,9 @@
 #include "utils/log.h"
 
 #include "akash/security/digest/sha.h"
+#include "akash/security/digest/sha256_mb.h"
+#include "akash/security/digest/sha_block.h"
+#include "akash/security/digest/sha512_block.h"
 #include "akash/security/digest/md5.h"
 
 /*
@@ -1097,5 +1101,360 @@ int TEST_MD5() {
     return 0;
 }
 
+int TEST_SHA_BLOCK() {
+    using digest::SHABlock;
+
+    uint8_t data[64 * 7];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i * 29 + 3);
+    }
+
+    const uint32_t init1[5] = {
+        0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    const uint32_t init256[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+
+    auto prev_impl = SHABlock::getImpl();
+    const SHABlock::Impl impls[] {
+        SHABlock::Impl::AVX2,
+        SHABlock::Impl::SHANI,
+    };
+
+    // 块数为奇数和偶数时结果都应与参考实现一致
+    for (size_t count = 1; count <= 7; ++count) {
+        uint32_t ref1[5], ref256[8];
+        std::memcpy(ref1, init1, sizeof(ref1));
+        std::memcpy(ref256, init256, sizeof(ref256));
+        SHABlock::setImpl(SHABlock::Impl::Reference);
+        SHABlock::sha1(ref1, data, count);
+        SHABlock::sha256(ref256, data, count);
+
+        for (auto impl : impls) {
+            SHABlock::setImpl(impl);
+            if (SHABlock::getImpl() != impl) {
+                continue;
+            }
+
+            uint32_t s1[5], s256[8];
+            std::memcpy(s1, init1, sizeof(s1));
+            std::memcpy(s256, init256, sizeof(s256));
+            SHABlock::sha1(s1, data, count);
+            SHABlock::sha256(s256, data, count);
+            ubassert(std::memcmp(s1, ref1, sizeof(s1)) == 0);
+            ubassert(std::memcmp(s256, ref256, sizeof(s256)) == 0);
+        }
+    }
+
+    // FIPS 180-2 "abc"
+    for (auto impl : impls) {
+        SHABlock::setImpl(impl);
+        if (SHABlock::getImpl() != impl) {
+            continue;
+        }
+
+        uint8_t md1[digest::SHA1::kHashSize];
+        digest::SHA1 sha1;
+        sha1.init();
+        sha1.update(reinterpret_cast<const uint8_t*>(TEST1), 3);
+        sha1.result(md1);
+        ubassert(md1[0] == 0xA9 && md1[1] == 0x99 && md1[19] == 0x9D);
+
+        uint8_t md224[digest::SHA224::kHashSize];
+        digest::SHA224 sha224;
+        sha224.init();
+        sha224.update(reinterpret_cast<const uint8_t*>(TEST1), 3);
+        sha224.result(md224);
+        ubassert(md224[0] == 0x23 && md224[1] == 0x09 && md224[27] == 0xA7);
+    }
+
+    SHABlock::setImpl(prev_impl);
+    return 0;
+}
+
+int TEST_SHA512_BLOCK() {
+    using digest::SHA512Block;
+
+    uint8_t data[128 * 5];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i * 29 + 3);
+    }
+
+    const uint64_t init512[8] = {
+        0x6A09E667F3BCC908ull, 0xBB67AE8584CAA73Bull,
+        0x3C6EF372FE94F82Bull, 0xA54FF53A5F1D36F1ull,
+        0x510E527FADE682D1ull, 0x9B05688C2B3E6C1Full,
+        0x1F83D9ABFB41BD6Bull, 0x5BE0CD19137E2179ull };
+
+    auto prev_impl = SHA512Block::getImpl();
+    const SHA512Block::Impl impls[] {
+        SHA512Block::Impl::AVX2,
+        SHA512Block::Impl::AVX512,
+    };
+
+    // 块数为奇数和偶数时结果都应与参考实现一致
+    for (size_t count = 1; count <= 5; ++count) {
+        uint64_t ref[8];
+        std::memcpy(ref, init512, sizeof(ref));
+        SHA512Block::setImpl(SHA512Block::Impl::Reference);
+        SHA512Block::compress(ref, data, count);
+
+        for (auto impl : impls) {
+            SHA512Block::setImpl(impl);
+            if (SHA512Block::getImpl() != impl) {
+                continue;
+            }
+
+            uint64_t s[8];
+            std::memcpy(s, init512, sizeof(s));
+            SHA512Block::compress(s, data, count);
+            ubassert(std::memcmp(s, ref, sizeof(s)) == 0);
+        }
+    }
+
+    // FIPS 180-2 "abc"
+    for (auto impl : impls) {
+        SHA512Block::setImpl(impl);
+        if (SHA512Block::getImpl() != impl) {
+            continue;
+        }
+
+        uint8_t md384[digest::SHA384::kHashSize];
+        digest::SHA384 sha384;
+        sha384.init();
+        sha384.update(reinterpret_cast<const uint8_t*>(TEST1), 3);
+        sha384.result(md384);
+        ubassert(md384[0] == 0xCB && md384[1] == 0x00 && md384[47] == 0xA7);
+
+        uint8_t md512[digest::SHA512::kHashSize];
+        digest::SHA512 sha512;
+        sha512.init();
+        sha512.update(reinterpret_cast<const uint8_t*>(TEST1), 3);
+        sha512.result(md512);
+        ubassert(md512[0] == 0xDD && md512[1] == 0xAF && md512[63] == 0x9F);
+    }
+
+    SHA512Block::setImpl(prev_impl);
+    return 0;
+}
+
+int TEST_SHA_UPDATE() {
+    uint8_t data[1000];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i * 13 + 7);
+    }
+
+    // 分块长度覆盖不足一块、恰好一块以及跨越多块的情况
+    const size_t chunks[] { 1, 3, 63, 64, 65, 127, 128, 129, 300, 1000 };
+    const digest::SHAVersion versions[] {
+        digest::SHAVersion::SHA1, digest::SHAVersion::SHA224,
+        digest::SHAVersion::SHA256, digest::SHAVersion::SHA384,
+        digest::SHAVersion::SHA512,
+    };
+
+    for (auto which : versions) {
+        // 逐字节输入的结果作为参考
+        uint8_t ref[digest::USHA::kMaxHashSize];
+        digest::USHA sha;
+        sha.init(which);
+        for (size_t i = 0; i < sizeof(data); ++i) {
+            sha.update(data + i, 1);
+        }
+        sha.result(ref);
+
+        for (auto chunk : chunks) {
+            for (size_t skew = 0; skew < 3; ++skew) {
+                uint8_t md[digest::USHA::kMaxHashSize];
+                sha.init(which);
+                sha.update(data, skew);
+                for (size_t i = skew; i < sizeof(data); i += chunk) {
+                    sha.update(data + i, std::min(chunk, sizeof(data) - i));
+                }
+                ubassert(sha.result(md) == digest::shaSuccess);
+                ubassert(std::memcmp(md, ref, digest::USHA::USHAHashSize(which)) == 0);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int TEST_SHA_PEEK_RESULT() {
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i * 7 + 1);
+    }
+
+    const digest::SHAVersion versions[] {
+        digest::SHAVersion::SHA1, digest::SHAVersion::SHA224,
+        digest::SHAVersion::SHA256, digest::SHAVersion::SHA384,
+        digest::SHAVersion::SHA512,
+    };
+
+    for (auto which : versions) {
+        auto hash_size = digest::USHA::USHAHashSize(which);
+
+        // 每输入一段取一次摘要，应与只输入该前缀时的结果一致，且不影响之后的输入
+        digest::USHA running;
+        running.init(which);
+        for (size_t length = 0; length <= sizeof(data); length += 50) {
+            if (length > 0) {
+                running.update(data + length - 50, 50);
+            }
+
+            uint8_t peek[digest::USHA::kMaxHashSize];
+            ubassert(running.peekResult(peek) == digest::shaSuccess);
+
+            uint8_t md[digest::USHA::kMaxHashSize];
+            digest::USHA sha;
+            sha.init(which);
+            sha.update(data, length);
+            sha.result(md);
+            ubassert(std::memcmp(peek, md, hash_size) == 0);
+
+            // 复制得到的对象可以独立地继续输入
+            digest::USHA fork(running);
+            fork.update(data, 1);
+            uint8_t forked[digest::USHA::kMaxHashSize];
+            fork.result(forked);
+            ubassert(std::memcmp(forked, md, hash_size) != 0);
+        }
+    }
+
+    return 0;
+}
+
+int TEST_HMAC_KEY() {
+    uint8_t key[200];
+    uint8_t text[300];
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        key[i] = uint8_t(i * 11 + 5);
+    }
+    for (size_t i = 0; i < sizeof(text); ++i) {
+        text[i] = uint8_t(i * 3 + 9);
+    }
+
+    const digest::SHAVersion versions[] {
+        digest::SHAVersion::SHA1, digest::SHAVersion::SHA224,
+        digest::SHAVersion::SHA256, digest::SHAVersion::SHA384,
+        digest::SHAVersion::SHA512,
+    };
+    // 密钥短于、等于和长于块长度
+    const int key_lens[] { 0, 20, 64, 128, 200 };
+
+    for (auto which : versions) {
+        auto hash_size = digest::USHA::USHAHashSize(which);
+        for (auto key_len : key_lens) {
+            digest::HMACKey hmac_key;
+            ubassert(hmac_key.init(which, key, key_len) == digest::shaSuccess);
+
+            // 同一个密钥多次使用
+            for (int text_len = 0; text_len <= 300; text_len += 100) {
+                uint8_t ref[digest::USHA::kMaxHashSize];
+                uint8_t md[digest::USHA::kMaxHashSize];
+                ubassert(digest::HMAC::calculate(
+                    which, text, text_len, key, key_len, ref) == digest::shaSuccess);
+                ubassert(digest::HMAC::calculate(
+                    hmac_key, text, text_len, md) == digest::shaSuccess);
+                ubassert(std::memcmp(md, ref, hash_size) == 0);
+            }
+
+            if (key_len < hash_size) {
+                continue;
+            }
+
+            uint8_t okm_ref[100];
+            uint8_t okm[100];
+            ubassert(digest::HKDF::hkdfExpand(
+                which, key, key_len, text, 50, okm_ref, 100) == digest::shaSuccess);
+            ubassert(digest::HKDF::hkdfExpand(
+                hmac_key, text, 50, okm, 100) == digest::shaSuccess);
+            ubassert(std::memcmp(okm, okm_ref, 100) == 0);
+        }
+    }
+
+    // 未初始化的密钥
+    digest::HMACKey empty;
+    uint8_t md[digest::USHA::kMaxHashSize];
+    ubassert(digest::HMAC::calculate(empty, text, 10, md) != digest::shaSuccess);
+
+    return 0;
+}
+
+int TEST_SHA256_MB() {
+    using digest::SHA256MB;
+
+    // 长度覆盖 0、填充需要两块的情况以及较长的消息
+    const size_t kCount = 53;
+    uint8_t data[64 * 9];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i * 31 + 7);
+    }
+
+    const uint8_t* ptrs[kCount];
+    size_t lengths[kCount];
+    uint8_t expected[kCount][SHA256MB::kHashSize];
+    for (size_t i = 0; i < kCount; ++i) {
+        ptrs[i] = data + i % 5;
+        lengths[i] = (i * 37) % (sizeof(data) - 5);
+        if (i < 4) {
+            lengths[i] = 55 + i;
+        }
+
+        digest::SHA256 sha;
+        sha.init();
+        sha.update(ptrs[i], unsigned(lengths[i]));
+        sha.result(expected[i]);
+    }
+
+    auto prev_impl = SHA256MB::getImpl();
+    const SHA256MB::Impl impls[] {
+        SHA256MB::Impl::Scalar,
+        SHA256MB::Impl::SSE2,
+        SHA256MB::Impl::AVX2,
+        SHA256MB::Impl::AVX512,
+    };
+
+    for (auto impl : impls) {
+        SHA256MB::setImpl(impl);
+        if (SHA256MB::getImpl() != impl) {
+            continue;
+        }
+
+        uint8_t digests[kCount][SHA256MB::kHashSize];
+        std::memset(digests, 0, sizeof(digests));
+        SHA256MB::hash(ptrs, lengths, kCount, digests);
+        ubassert(std::memcmp(digests, expected, sizeof(digests)) == 0);
+
+        // 逐个提交，已完成的任务数应与提交数一致
+        std::memset(digests, 0, sizeof(digests));
+        SHA256MB mb;
+        size_t completed = 0;
+        for (size_t i = 0; i < kCount; ++i) {
+            completed += mb.submit(ptrs[i], lengths[i], digests[i]);
+            ubassert(mb.getPendingCount() <= SHA256MB::getLaneCount(impl));
+        }
+        completed += mb.flush();
+        ubassert(completed == kCount);
+        ubassert(mb.getPendingCount() == 0);
+        ubassert(std::memcmp(digests, expected, sizeof(digests)) == 0);
+
+        // FIPS 180-2 "abc"
+        uint8_t md[SHA256MB::kHashSize];
+        mb.submit(reinterpret_cast<const uint8_t*>(TEST1), 3, md);
+        mb.flush();
+        uint8_t abc[SHA256MB::kHashSize];
+        digest::SHA256 sha;
+        sha.init();
+        sha.update(reinterpret_cast<const uint8_t*>(TEST1), 3);
+        sha.result(abc);
+        ubassert(std::memcmp(md, abc, sizeof(md)) == 0);
+        ubassert(md[0] == 0xBA && md[31] == 0xAD);
+    }
+
+    SHA256MB::setImpl(prev_impl);
+    return 0;
+}
+
+}
 }
-}
\ No newline at end of file
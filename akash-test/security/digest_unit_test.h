@@ -19,6 +19,36 @@ namespace test {
     int TEST_SHA();
     int TEST_MD5();
 
+    /**
+     * SHA-1/SHA-256 压缩函数的各实现与参考实现比较
+     */
+    int TEST_SHA_BLOCK();
+
+    /**
+     * SHA-384/SHA-512 压缩函数的各实现与参考实现比较
+     */
+    int TEST_SHA512_BLOCK();
+
+    /**
+     * 以不同的分块长度输入消息，结果应与逐字节输入一致
+     */
+    int TEST_SHA_UPDATE();
+
+    /**
+     * peekResult 的结果应与只输入当前前缀时一致
+     */
+    int TEST_SHA_PEEK_RESULT();
+
+    /**
+     * 使用 HMACKey 的 HMAC 和 HKDF-Expand 与直接使用密钥的结果比较
+     */
+    int TEST_HMAC_KEY();
+
+    /**
+     * 多缓冲区 SHA-256 的结果与逐条计算的 SHA256 比较
+     */
+    int TEST_SHA256_MB();
+
 }
 }
 
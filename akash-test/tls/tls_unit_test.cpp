@@ -0,0 +1,439 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash-test/tls/tls_unit_test.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "utils/log.h"
+#include "akash/socket/socket.h"
+#include "akash/tls/tls_output_queue.h"
+#include "akash/tls/tls_record_buffer.h"
+#include "akash/tls/tls_record_protection.h"
+
+
+using stringu8 = std::basic_string<uint8_t>;
+
+namespace {
+
+    const size_t kHeaderSize = akash::tls::RecordProtection::kHeaderSize;
+
+    stringu8 makeRecord(akash::tls::ContentType type, size_t length, uint8_t seed) {
+        stringu8 record(kHeaderSize + length, 0);
+        record[0] = uint8_t(type);
+        record[1] = 3;
+        record[2] = 3;
+        record[3] = uint8_t(length >> 8);
+        record[4] = uint8_t(length);
+        for (size_t i = 0; i < length; ++i) {
+            record[kHeaderSize + i] = uint8_t(i * 7 + seed);
+        }
+        return record;
+    }
+
+    // 记录所有发送的数据。每次写入最多接受 max_write 字节，模拟部分写入
+    class FakeSocketClient : public akash::SocketClient {
+    public:
+        bool connect(const std::string& ip, uint16_t port) override { return true; }
+        bool connectByHost(const std::string& host, uint16_t port) override { return true; }
+
+        bool send(const std::string& buf) override {
+            akash::SocketBuffer sb;
+            sb.data = reinterpret_cast<const uint8_t*>(buf.data());
+            sb.length = buf.length();
+            return send(&sb, 1);
+        }
+
+        bool send(const akash::SocketBuffer* bufs, size_t count) override {
+            ++send_calls;
+            size_t offset = 0;
+            while (count > 0) {
+                // 一次写入从中断处继续，最多 max_write 字节
+                size_t room = max_write;
+                while (count > 0 && room > 0) {
+                    size_t n = std::min(room, bufs->length - offset);
+                    sent.append(bufs->data + offset, n);
+                    offset += n;
+                    room -= n;
+                    if (offset == bufs->length) {
+                        ++bufs;
+                        --count;
+                        offset = 0;
+                    }
+                }
+                ++writes;
+            }
+            return true;
+        }
+
+        bool recv(int length, std::string* buf) override { return false; }
+        bool recv(std::string* buf) override { return false; }
+        bool recv(uint8_t* buf, size_t length, size_t* received) override { return false; }
+        bool shutdown() override { return true; }
+        void close() override {}
+
+        size_t max_write = ~size_t(0);
+        size_t send_calls = 0;
+        size_t writes = 0;
+        stringu8 sent;
+    };
+
+    struct Record {
+        akash::tls::ContentType type;
+        stringu8 content;
+    };
+
+    // 将发送的数据拆成记录，reader 不为空时解密
+    bool splitRecords(
+        stringu8 stream, akash::tls::RecordProtection* reader, std::vector<Record>* records)
+    {
+        records->clear();
+        size_t pos = 0;
+        while (pos < stream.size()) {
+            if (stream.size() - pos < kHeaderSize) {
+                return false;
+            }
+            auto header = &stream[pos];
+            size_t length = (size_t(header[3]) << 8) | header[4];
+            if (stream.size() - pos - kHeaderSize < length) {
+                return false;
+            }
+
+            size_t record_length = kHeaderSize + length;
+            Record record;
+            record.type = akash::tls::ContentType(header[0]);
+            if (reader) {
+                if (record.type != akash::tls::ContentType::ApplicationData ||
+                    !reader->open(header, header + kHeaderSize, length, &record.type, &length))
+                {
+                    return false;
+                }
+            }
+            record.content.assign(header + kHeaderSize, length);
+            records->push_back(std::move(record));
+            pos += record_length;
+        }
+        return true;
+    }
+
+    void feed(akash::tls::RecordBuffer* rb, const uint8_t* data, size_t length, size_t min_length) {
+        size_t space;
+        auto buf = rb->prepare(min_length, &space);
+        ubassert(space >= length);
+        std::memcpy(buf, data, length);
+        rb->commit(length);
+    }
+
+}
+
+namespace akash {
+namespace test {
+
+    void TEST_TLS_RECORD_BUFFER() {
+        using RecordState = tls::RecordBuffer::RecordState;
+        const size_t kMaxLength = 100;
+
+        // 记录头和记录体被拆成任意大小的片段时，每条记录仍然完整、连续地取出
+        {
+            const size_t lengths[] { 0, 1, 4, 5, 17, 100, 3, 64 };
+            std::vector<stringu8> records;
+            stringu8 stream;
+            for (size_t i = 0; i < std::size(lengths); ++i) {
+                records.push_back(makeRecord(tls::ContentType::Handshake, lengths[i], uint8_t(i)));
+                stream += records.back();
+            }
+
+            for (size_t chunk = 1; chunk <= 7; ++chunk) {
+                tls::RecordBuffer rb(kHeaderSize + kMaxLength + 16);
+                size_t next = 0;
+                for (size_t pos = 0; pos < stream.size();) {
+                    size_t n = std::min(chunk, stream.size() - pos);
+                    feed(&rb, stream.data() + pos, n, kHeaderSize + kMaxLength);
+                    pos += n;
+
+                    size_t length;
+                    RecordState state;
+                    while ((state = rb.peekRecord(kMaxLength, &length)) == RecordState::Complete) {
+                        ubassert(next < records.size());
+                        ubassert(length == records[next].size());
+                        ubassert(std::memcmp(rb.data(), records[next].data(), length) == 0);
+                        rb.consume(length);
+                        ++next;
+                    }
+                    ubassert(state == RecordState::Incomplete);
+                }
+                ubassert(next == records.size());
+                ubassert(rb.size() == 0);
+            }
+        }
+
+        // 末尾空间不足时，不完整的记录被移到开头，之后接收的部分与之连续
+        {
+            tls::RecordBuffer rb(64);
+            auto a = makeRecord(tls::ContentType::ApplicationData, 35, 1);
+            auto b = makeRecord(tls::ContentType::ApplicationData, 30, 2);
+
+            stringu8 first = a + b.substr(0, 10);
+            feed(&rb, first.data(), first.size(), 64);
+
+            size_t length;
+            ubassert(rb.peekRecord(kMaxLength, &length) == RecordState::Complete);
+            ubassert(length == a.size());
+            rb.consume(length);
+            ubassert(rb.peekRecord(kMaxLength, &length) == RecordState::Incomplete);
+
+            // 剩余空间足够时不移动
+            auto before = rb.data();
+            size_t space;
+            auto buf = rb.prepare(4, &space);
+            ubassert(rb.data() == before);
+            ubassert(buf == before + 10);
+            ubassert(space == 64 - first.size());
+
+            // 剩余空间不足一条记录时移动到开头
+            buf = rb.prepare(b.size(), &space);
+            ubassert(rb.data() != before);
+            ubassert(rb.size() == 10);
+            ubassert(buf == rb.data() + 10);
+            ubassert(space == 64 - 10);
+            ubassert(std::memcmp(rb.data(), b.data(), 10) == 0);
+
+            std::memcpy(buf, b.data() + 10, b.size() - 10);
+            rb.commit(b.size() - 10);
+            ubassert(rb.peekRecord(kMaxLength, &length) == RecordState::Complete);
+            ubassert(length == b.size());
+            ubassert(std::memcmp(rb.data(), b.data(), b.size()) == 0);
+
+            // 全部取走后从头开始写入
+            rb.consume(length);
+            ubassert(rb.size() == 0);
+            buf = rb.prepare(1, &space);
+            ubassert(buf == rb.data());
+            ubassert(space == rb.capacity());
+        }
+
+        // 记录头中的长度超过上限时立即拒绝，不等待记录体
+        {
+            tls::RecordBuffer rb(64);
+            size_t length;
+            ubassert(rb.peekRecord(kMaxLength, &length) == RecordState::Incomplete);
+
+            auto oversized = makeRecord(tls::ContentType::ApplicationData, kMaxLength + 1, 3);
+            feed(&rb, oversized.data(), kHeaderSize - 1, 64);
+            ubassert(rb.peekRecord(kMaxLength, &length) == RecordState::Incomplete);
+            feed(&rb, oversized.data() + kHeaderSize - 1, 1, 64);
+            ubassert(rb.peekRecord(kMaxLength, &length) == RecordState::Oversized);
+
+            // 长度恰好等于上限的记录不会被拒绝，只是尚未接收完整
+            rb.clear();
+            auto max_record = makeRecord(tls::ContentType::ApplicationData, kMaxLength, 4);
+            feed(&rb, max_record.data(), kHeaderSize + 10, 64);
+            ubassert(rb.peekRecord(kMaxLength, &length) == RecordState::Incomplete);
+            ubassert(rb.peekRecord(
+                tls::RecordProtection::kMaxCiphertextSize, &length) == RecordState::Incomplete);
+            ubassert(rb.peekRecord(kMaxLength - 1, &length) == RecordState::Oversized);
+        }
+    }
+
+    void TEST_TLS_OUTPUT_QUEUE() {
+        using FlushPolicy = tls::OutputQueue::FlushPolicy;
+        const tls::ProtocolVersion v12 { 3, 3 };
+        const tls::ProtocolVersion v10 { 3, 1 };
+
+        tls::KeySchedule::TrafficKey key;
+        for (size_t i = 0; i < sizeof(key.key); ++i) key.key[i] = uint8_t(i * 5 + 3);
+        for (size_t i = 0; i < sizeof(key.iv); ++i) key.iv[i] = uint8_t(i * 11 + 1);
+        key.key_length = 16;
+
+        stringu8 P(40000, 0);
+        for (size_t i = 0; i < P.size(); ++i) P[i] = uint8_t(i * 13 + 7);
+
+        std::vector<Record> records;
+
+        // Throughput：相同类型、版本的连续明文合并为一条记录，flush 时一次写入
+        {
+            FakeSocketClient socket;
+            tls::OutputQueue queue(1024);
+            queue.setSocket(&socket);
+            ubassert(queue.getFlushPolicy() == FlushPolicy::Latency);
+            queue.setFlushPolicy(FlushPolicy::Throughput);
+
+            ubassert(queue.queuePlaintext(tls::ContentType::Handshake, v10, P.data(), 10));
+            ubassert(queue.queuePlaintext(tls::ContentType::Handshake, v10, P.data() + 10, 20));
+            ubassert(queue.queuePlaintext(tls::ContentType::Handshake, v12, P.data() + 30, 5));
+            ubassert(queue.queuePlaintext(tls::ContentType::Alert, v12, P.data() + 35, 2));
+            ubassert(queue.queuePlaintext(tls::ContentType::Handshake, v12, P.data() + 37, 3));
+            ubassert(socket.send_calls == 0);
+            ubassert(!queue.empty());
+
+            ubassert(queue.flush());
+            ubassert(queue.empty());
+            ubassert(socket.send_calls == 1);
+            ubassert(socket.writes == 1);
+            ubassert(splitRecords(socket.sent, nullptr, &records));
+            ubassert(records.size() == 4);
+            ubassert(records[0].type == tls::ContentType::Handshake);
+            ubassert(records[0].content == P.substr(0, 30));
+            ubassert(socket.sent[1] == 3 && socket.sent[2] == 1);
+            ubassert(records[1].content == P.substr(30, 5));
+            ubassert(records[2].type == tls::ContentType::Alert);
+            ubassert(records[2].content == P.substr(35, 2));
+            ubassert(records[3].content == P.substr(37, 3));
+
+            // 空队列不写入
+            ubassert(queue.flush());
+            ubassert(socket.send_calls == 1);
+        }
+
+        // Throughput：加密内容合并为一条记录；closeRecord 之后不再合并
+        {
+            FakeSocketClient socket;
+            tls::OutputQueue queue(4096);
+            queue.setSocket(&socket);
+            queue.setFlushPolicy(FlushPolicy::Throughput);
+
+            tls::RecordProtection writer;
+            tls::RecordProtection reader;
+            ubassert(writer.init(tls::CipherSuite::TLS_AES_128_GCM_SHA256, key));
+            ubassert(reader.init(tls::CipherSuite::TLS_AES_128_GCM_SHA256, key));
+
+            ubassert(queue.queueProtected(tls::ContentType::Handshake, P.data(), 100, &writer));
+            ubassert(queue.queueProtected(tls::ContentType::Handshake, P.data() + 100, 50, &writer));
+            ubassert(queue.closeRecord());
+            ubassert(queue.queueProtected(tls::ContentType::Handshake, P.data() + 150, 10, &writer));
+            ubassert(queue.queueProtected(tls::ContentType::ApplicationData, P.data() + 160, 40, &writer));
+            ubassert(socket.send_calls == 0);
+
+            ubassert(queue.flush());
+            ubassert(socket.send_calls == 1);
+            ubassert(writer.getSequenceNumber() == 3);
+            ubassert(splitRecords(socket.sent, &reader, &records));
+            ubassert(records.size() == 3);
+            ubassert(records[0].type == tls::ContentType::Handshake);
+            ubassert(records[0].content == P.substr(0, 150));
+            ubassert(records[1].type == tls::ContentType::Handshake);
+            ubassert(records[1].content == P.substr(150, 10));
+            ubassert(records[2].type == tls::ContentType::ApplicationData);
+            ubassert(records[2].content == P.substr(160, 40));
+        }
+
+        // Latency：每次加入后立即发送，内容不跨调用合并
+        {
+            FakeSocketClient socket;
+            tls::OutputQueue queue(1024);
+            queue.setSocket(&socket);
+            queue.setFlushPolicy(FlushPolicy::Latency);
+
+            ubassert(queue.queuePlaintext(tls::ContentType::Handshake, v12, P.data(), 10));
+            ubassert(socket.send_calls == 1);
+            ubassert(queue.empty());
+            ubassert(queue.queuePlaintext(tls::ContentType::Handshake, v12, P.data() + 10, 20));
+            ubassert(socket.send_calls == 2);
+
+            auto key32 = key;
+            key32.key_length = 32;
+            tls::RecordProtection writer;
+            tls::RecordProtection reader;
+            ubassert(writer.init(tls::CipherSuite::TLS_CHACHA20_POLY1305_SHA256, key32));
+            ubassert(reader.init(tls::CipherSuite::TLS_CHACHA20_POLY1305_SHA256, key32));
+            ubassert(queue.queueProtected(tls::ContentType::Handshake, P.data() + 30, 5, &writer));
+            ubassert(socket.send_calls == 3);
+
+            ubassert(splitRecords(socket.sent.substr(0, 2 * kHeaderSize + 30), nullptr, &records));
+            ubassert(records.size() == 2);
+            ubassert(records[0].content == P.substr(0, 10));
+            ubassert(records[1].content == P.substr(10, 20));
+            ubassert(splitRecords(socket.sent.substr(2 * kHeaderSize + 30), &reader, &records));
+            ubassert(records.size() == 1);
+            ubassert(records[0].content == P.substr(30, 5));
+        }
+
+        // 加密区域已满时先发送已关闭的记录，剩余内容继续放入新的记录
+        {
+            FakeSocketClient socket;
+            const size_t kSealCapacity =
+                2 * (tls::RecordProtection::kHeaderSize + tls::RecordProtection::kMaxCiphertextSize);
+            tls::OutputQueue queue(kSealCapacity);
+            queue.setSocket(&socket);
+            queue.setFlushPolicy(FlushPolicy::Throughput);
+
+            tls::RecordProtection writer;
+            tls::RecordProtection reader;
+            ubassert(writer.init(tls::CipherSuite::TLS_AES_128_CCM_8_SHA256, key));
+            ubassert(reader.init(tls::CipherSuite::TLS_AES_128_CCM_8_SHA256, key));
+
+            // 两条最长的记录之后放不下第三条
+            ubassert(queue.queueProtected(tls::ContentType::Handshake, P.data(), P.size(), &writer));
+            ubassert(socket.send_calls == 1);
+            ubassert(queue.flush());
+            ubassert(socket.send_calls == 2);
+
+            ubassert(splitRecords(socket.sent, &reader, &records));
+            ubassert(records.size() == 3);
+            const size_t kMaxLength = tls::RecordProtection::kMaxPlaintextSize;
+            ubassert(records[0].content == P.substr(0, kMaxLength));
+            ubassert(records[1].content == P.substr(kMaxLength, kMaxLength));
+            ubassert(records[2].content == P.substr(2 * kMaxLength));
+        }
+
+        // 明文记录头用完时中途发送一次，之后的记录接着写入
+        {
+            FakeSocketClient socket;
+            tls::OutputQueue queue(1024);
+            queue.setSocket(&socket);
+            queue.setFlushPolicy(FlushPolicy::Throughput);
+
+            const size_t kCount = 40;
+            for (size_t i = 0; i < kCount; ++i) {
+                auto type = (i & 1) ? tls::ContentType::Alert : tls::ContentType::Handshake;
+                ubassert(queue.queuePlaintext(type, v12, P.data() + i * 3, 3));
+            }
+            ubassert(socket.send_calls == 1);
+            ubassert(queue.flush());
+            ubassert(socket.send_calls == 2);
+
+            ubassert(splitRecords(socket.sent, nullptr, &records));
+            ubassert(records.size() == kCount);
+            for (size_t i = 0; i < kCount; ++i) {
+                ubassert(records[i].content == P.substr(i * 3, 3));
+            }
+        }
+
+        // 部分写入：socket 每次只接受少量字节，从中断处继续，所有段在 send 返回之前保持有效
+        for (size_t max_write : { size_t(1), size_t(3), size_t(7), size_t(100) }) {
+            FakeSocketClient socket;
+            socket.max_write = max_write;
+            tls::OutputQueue queue(2048);
+            queue.setSocket(&socket);
+            queue.setFlushPolicy(FlushPolicy::Throughput);
+
+            tls::RecordProtection writer;
+            tls::RecordProtection reader;
+            ubassert(writer.init(tls::CipherSuite::TLS_AES_128_GCM_SHA256, key));
+            ubassert(reader.init(tls::CipherSuite::TLS_AES_128_GCM_SHA256, key));
+
+            ubassert(queue.queuePlaintext(tls::ContentType::Handshake, v12, P.data(), 64));
+            ubassert(queue.queuePlaintext(tls::ContentType::ChangeCipherSpec, v12, P.data() + 64, 1));
+            ubassert(queue.queueProtected(tls::ContentType::Handshake, P.data() + 65, 300, &writer));
+            ubassert(queue.flush());
+            ubassert(socket.send_calls == 1);
+            ubassert(socket.writes == (socket.sent.size() + max_write - 1) / max_write);
+
+            ubassert(splitRecords(socket.sent.substr(0, 2 * kHeaderSize + 65), nullptr, &records));
+            ubassert(records.size() == 2);
+            ubassert(records[0].content == P.substr(0, 64));
+            ubassert(records[1].type == tls::ContentType::ChangeCipherSpec);
+            ubassert(splitRecords(socket.sent.substr(2 * kHeaderSize + 65), &reader, &records));
+            ubassert(records.size() == 1);
+            ubassert(records[0].content == P.substr(65, 300));
+        }
+    }
+
+}
+}
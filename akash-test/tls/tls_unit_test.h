@@ -0,0 +1,28 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_TEST_TLS_TLS_UNIT_TEST_H_
+#define AKASH_TEST_TLS_TLS_UNIT_TEST_H_
+
+
+namespace akash {
+namespace test {
+
+    /**
+     * 接收缓冲区的分帧测试：记录头被拆开、记录跨越缓冲区整理、超长记录的拒绝
+     */
+    void TEST_TLS_RECORD_BUFFER();
+
+    /**
+     * 发送队列的测试：记录合并、队列已满时的中途发送、部分写入和两种发送策略。
+     * 使用记录所有写入的 SocketClient 代替真实的连接
+     */
+    void TEST_TLS_OUTPUT_QUEUE();
+
+}
+}
+
+#endif  // AKASH_TEST_TLS_TLS_UNIT_TEST_H_
@@ -5,7 +5,12 @@
 #include "utils/log.h"
 #include "utils/numbers.hpp"
 
+#ifdef AKASH_BIG_INTEGER_64BIT_DIGIT
+// Comba 数组位于栈上，Word 为 128 位时需要限制其大小
+#define MP_WARRAY  512
+#else
 #define MP_WARRAY  65536
+#endif
 
 #define TOOM_MUL_CUTOFF  800
 #define KARATSUBA_MUL_CUTOFF  70
@@ -525,7 +530,7 @@ namespace utl {
                 remain -= int(kBaseBitCount);
                 result |= uint64_t(int_.buf_[i]) << (i * kBaseBitCount);
             } else {
-                result |= uint64_t(int_.buf_[i] & uint64_t((1 << remain) - 1)) << (i * kBaseBitCount);
+                result |= uint64_t(int_.buf_[i] & ((uint64_t(1) << remain) - 1)) << (i * kBaseBitCount);
                 remain = 0;
             }
         }
@@ -751,7 +756,7 @@ namespace utl {
                 continue;
             }
             for (int j = 0; j < int(kBaseBitCount); ++j) {
-                if (d & (1 << j)) {
+                if (d & (Digit(1) << j)) {
                     return i * int(kBaseBitCount) + j;
                 }
             }
@@ -853,7 +858,7 @@ namespace utl {
 
             for (int j = 0; j < pb; ++j) {
                 Word wd = t.buf_[i + j] + Word(l.buf_[i]) * r.buf_[j] + u;
-                t.buf_[i + j] = wd & kBaseMask;
+                t.buf_[i + j] = Digit(wd & kBaseMask);
                 u = Digit(wd >> kBaseBitCount);
             }
 
@@ -876,7 +881,7 @@ namespace utl {
             Digit u = 0;
             for (j = digs - i, k = 0; j < r.used_; ++j, ++k) {
                 Word wd = t.buf_[digs + k] + Word(l.buf_[i]) * r.buf_[digs - i + k] + u;
-                t.buf_[digs + k] = wd & kBaseMask;
+                t.buf_[digs + k] = Digit(wd & kBaseMask);
                 u = Digit(wd >> kBaseBitCount);
             }
 
@@ -909,7 +914,7 @@ namespace utl {
                 _w += Word(*tmpl++) * (*tmpr--);
             }
 
-            w[i] = _w & kBaseMask;
+            w[i] = Digit(_w & kBaseMask);
             _w >>= kBaseBitCount;
         }
 
@@ -934,21 +939,21 @@ namespace utl {
         for (int i = 0; i < a.used_; ++i) {
             // 算平方
             Word r = t.buf_[i << 1] + Word(a.buf_[i]) * a.buf_[i];
-            t.buf_[2 * i] = r & kBaseMask;
+            t.buf_[2 * i] = Digit(r & kBaseMask);
 
             // 算二重积
             int j;
             Digit u = Digit(r >> kBaseBitCount);
             for (j = i + 1; j < a.used_; ++j) {
                 r = 2 * Word(a.buf_[i]) * a.buf_[j] + t.buf_[i + j] + u;
-                t.buf_[i + j] = r & kBaseMask;
+                t.buf_[i + j] = Digit(r & kBaseMask);
                 u = Digit(r >> kBaseBitCount);
             }
 
             // 算最后一个进位
             while (u > 0) {
                 r = t.buf_[i + j] + u;
-                t.buf_[i + j] = r & kBaseMask;
+                t.buf_[i + j] = Digit(r & kBaseMask);
                 u = Digit(r >> kBaseBitCount);
                 ++j;
             }
@@ -985,7 +990,7 @@ namespace utl {
                 _W += Word(a.buf_[i >> 1]) * a.buf_[i >> 1];
             }
 
-            W[i] = _W & kBaseMask;
+            W[i] = Digit(_W & kBaseMask);
             W1 = _W >> kBaseBitCount;
         }
 
@@ -1597,7 +1602,7 @@ namespace utl {
 
         Digit d = exp % kBaseBitCount;
         if (d != 0) {
-            Digit mask = (1 << d) - 1;
+            Digit mask = (Digit(1) << d) - 1;
             Digit r = 0;
             for (int i = 0; i < result->used_; ++i) {
                 Digit rr = (result->buf_[i] >> (kBaseBitCount - d)) & mask;
@@ -1632,7 +1637,7 @@ namespace utl {
 
         Digit k = exp % kBaseBitCount;
         if (k != 0) {
-            Digit mask = (1 << k) - 1;
+            Digit mask = (Digit(1) << k) - 1;
             Digit r = 0;
             for (int i = result->used_ - 1; i >= 0; --i) {
                 Digit rr = result->buf_[i] & mask;
@@ -1660,7 +1665,7 @@ namespace utl {
         }
 
         Digit k = exp % kBaseBitCount;
-        result->buf_[exp / kBaseBitCount] &= (1 << k) - 1;
+        result->buf_[exp / kBaseBitCount] &= (Digit(1) << k) - 1;
         result->shrink();
     }
 
@@ -1818,7 +1823,7 @@ namespace utl {
                 if (tmp > Word(kBaseMask)) {
                     tmp = kBaseMask;
                 }
-                q.buf_[i - t - 1] = tmp & Word(kBaseMask);
+                q.buf_[i - t - 1] = Digit(tmp & Word(kBaseMask));
             }
 
             q.buf_[i - t - 1] = (q.buf_[i - t - 1] + 1) & kBaseMask;
@@ -1983,7 +1988,7 @@ namespace utl {
         Digit u = 0;
         for (i = 0; i < a.used_; ++i) {
             auto r = Word(u) + Word(a.buf_[i]) * b;
-            c->buf_[i] = r & kBaseMask;
+            c->buf_[i] = Digit(r & kBaseMask);
             u = Digit(r >> kBaseBitCount);
         }
 
@@ -2208,11 +2213,11 @@ namespace utl {
 
         for (int i = 0; i < n.used_; ++i) {
             int j;
-            Digit mu = Word(x->buf_[i]) * rho & kBaseMask;
+            Digit mu = Digit(Word(x->buf_[i]) * rho & kBaseMask);
             Digit u = 0;
             for (j = 0; j < n.used_; ++j) {
                 Word r = Word(mu) * n.buf_[j] + x->buf_[i + j] + u;
-                x->buf_[i + j] = r & kBaseMask;
+                x->buf_[i + j] = Digit(r & kBaseMask);
                 u = Digit(r >> kBaseBitCount);
             }
 
@@ -2248,7 +2253,7 @@ namespace utl {
         }
 
         for (i = 0; i < n.used_; ++i) {
-            Digit mu = (W[i] & kBaseMask) * rho & kBaseMask;
+            Digit mu = Digit((W[i] & kBaseMask) * rho & kBaseMask);
             for (int j = 0; j < n.used_; ++j) {
                 W[i + j] += Word(mu) * n.buf_[j];
             }
@@ -2259,7 +2264,7 @@ namespace utl {
             W[i + 1] += W[i] >> kBaseBitCount;
         }
         for (i = 0; i < n.used_ + 1; ++i) {
-            x->buf_[i] = W[i + n.used_] & kBaseMask;
+            x->buf_[i] = Digit(W[i + n.used_] & kBaseMask);
         }
 
         for (; i < old_used; ++i) {
@@ -2293,7 +2298,7 @@ namespace utl {
             }
         }
 
-        *rho = ((Word(1) << kBaseBitCount) - x) & kBaseMask;
+        *rho = Digit(((Word(1) << kBaseBitCount) - x) & kBaseMask);
     }
 
     void BigInteger::drReduce(IntArray* x, const IntArray& n, Digit k) {
@@ -2306,7 +2311,7 @@ namespace utl {
             Digit mu = 0;
             for (int i = 0; i < m; ++i) {
                 Word r = Word(x->buf_[m + i]) * k + x->buf_[i] + mu;
-                x->buf_[i] = r & kBaseMask;
+                x->buf_[i] = Digit(r & kBaseMask);
                 mu = Digit(r >> kBaseBitCount);
             }
 
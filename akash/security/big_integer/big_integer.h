@@ -8,6 +8,9 @@
 
 namespace utl {
 
+    template <int Bits>
+    class FixedBigInteger;
+
     // 按照图书：BigNum Math: Implementing Cryptographic Multiple Precision Arithmetic
     // 中的代码编写而成，书中代码来自 LibTomMath 库
     class BigInteger {
@@ -16,16 +19,17 @@ namespace utl {
         using Word = IntArray::Word;
 
         // Digit 的可用二进制位数
-        const static Digit kDigitBitCount = 32;
+        const static Digit kDigitBitCount = sizeof(Digit) * 8;
 
         // Word 的可用二进制位数
-        const static Digit kWordBitCount = 64;
+        const static Digit kWordBitCount = sizeof(Word) * 8;
 
         // kBase 的以2为底的指数
-        const static Digit kBaseBitCount = 28;
+        // 每个 Digit 保留 4 位用于进位检测
+        const static Digit kBaseBitCount = kDigitBitCount - 4;
 
         // 采用的基（即进制数），必须是2的幂
-        const static Digit kBase = 1 << kBaseBitCount;
+        const static Digit kBase = Digit(1) << kBaseBitCount;
 
         // 用于将 (n % kBase) 转换为 (n & kBaseMask)
         const static Digit kBaseMask = kBase - 1;
@@ -239,6 +243,9 @@ namespace utl {
 
         static bool isPowOf2(Digit b, int* p);
 
+        template <int Bits>
+        friend class FixedBigInteger;
+
         IntArray int_;
     };
 
@@ -0,0 +1,1172 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_BIG_INTEGER_FIXED_BIG_INTEGER_H_
+#define AKASH_SECURITY_BIG_INTEGER_FIXED_BIG_INTEGER_H_
+
+#include <cstring>
+#include <string>
+
+#include "utils/log.h"
+
+#include "akash/security/big_integer/big_integer.h"
+
+
+namespace utl {
+
+    // 定长大数。
+    // 采用与 BigInteger 相同的基（2^28，或 AKASH_BIG_INTEGER_64BIT_DIGIT 时的 2^60），但数据直接存放在对象内部，
+    // 构造、复制和运算过程中不进行任何堆分配，适用于曲线、有限域等位数固定的运算。
+    // Bits 为操作数的最大位数，内部容量为其两倍再加一个 Digit，
+    // 以便容纳两个操作数的乘积。结果超出容量时断言失败。
+    template <int Bits>
+    class FixedBigInteger {
+    public:
+        using Digit = BigInteger::Digit;
+        using Word = BigInteger::Word;
+
+        const static int kBaseBitCount = int(BigInteger::kBaseBitCount);
+        const static Digit kBase = BigInteger::kBase;
+        const static Digit kBaseMask = BigInteger::kBaseMask;
+
+        // 内部数组的 Digit 个数
+        const static int kDigitCount = (2 * Bits + kBaseBitCount - 1) / kBaseBitCount + 1;
+
+        static_assert(kDigitCount < BigInteger::kDelta, "Bits is too large for comba multiplication.");
+
+        static FixedBigInteger from32(int32_t i);
+        static FixedBigInteger from64(int64_t i);
+        static FixedBigInteger fromU32(uint32_t i);
+        static FixedBigInteger fromU64(uint64_t i);
+        static FixedBigInteger fromString(const std::string& str, int radix);
+        static FixedBigInteger fromBytesBE(const uint8_t* bytes, size_t length);
+        static FixedBigInteger fromBytesLE(const uint8_t* bytes, size_t length);
+        static FixedBigInteger fromBigInteger(const BigInteger& bi);
+
+        FixedBigInteger();
+
+        void zero();
+        void swap(FixedBigInteger& rhs);
+        void destroy();
+
+        void setInt32(int32_t i);
+        void setInt64(int64_t i);
+        void setUInt32(uint32_t i);
+        void setUInt64(uint64_t i);
+        void setBit(uint32_t idx, uint8_t val);
+
+        FixedBigInteger& add(const FixedBigInteger& rhs);
+        FixedBigInteger& sub(const FixedBigInteger& rhs);
+        FixedBigInteger& mul(const FixedBigInteger& rhs);
+        FixedBigInteger& div(const FixedBigInteger& rhs);
+        FixedBigInteger& mod(const FixedBigInteger& rhs);
+        FixedBigInteger& modP(const FixedBigInteger& rhs);
+
+        FixedBigInteger& add(Digit b);
+        FixedBigInteger& sub(Digit b);
+        FixedBigInteger& mul(Digit b);
+        FixedBigInteger& div(Digit b);
+
+        FixedBigInteger& pow(Digit exp);
+        FixedBigInteger& powMod(const FixedBigInteger& exp, const FixedBigInteger& m);
+        FixedBigInteger& abs();
+        FixedBigInteger& inv();
+        FixedBigInteger& shl(int offset);
+        FixedBigInteger& shr(int offset);
+
+        FixedBigInteger& mul2();
+        FixedBigInteger& mul2exp(int exp);
+        FixedBigInteger& div2();
+        FixedBigInteger& div2exp(int exp);
+        FixedBigInteger& mod2exp(int exp);
+        FixedBigInteger& exp2();
+
+        FixedBigInteger& ond(const FixedBigInteger& rhs);
+        FixedBigInteger& exor(const FixedBigInteger& rhs);
+
+        FixedBigInteger gcd(const FixedBigInteger& rhs) const;
+        // {out} = 1/{this} mod {rhs}
+        // {rhs} >= 2, 0 < {this} < {rhs}
+        FixedBigInteger invmod(const FixedBigInteger& rhs) const;
+
+        int compare(const FixedBigInteger& rhs) const;
+
+        FixedBigInteger operator+(const FixedBigInteger& rhs) const;
+        FixedBigInteger operator-(const FixedBigInteger& rhs) const;
+        FixedBigInteger operator*(const FixedBigInteger& rhs) const;
+        FixedBigInteger operator/(const FixedBigInteger& rhs) const;
+        FixedBigInteger operator%(const FixedBigInteger& rhs) const;
+        FixedBigInteger operator&(const FixedBigInteger& rhs) const;
+        FixedBigInteger operator^(const FixedBigInteger& rhs) const;
+
+        FixedBigInteger operator+(Digit b) const;
+        FixedBigInteger operator-(Digit b) const;
+        FixedBigInteger operator*(Digit b) const;
+        FixedBigInteger operator/(Digit b) const;
+
+        bool operator>(const FixedBigInteger& rhs) const;
+        bool operator>=(const FixedBigInteger& rhs) const;
+        bool operator<(const FixedBigInteger& rhs) const;
+        bool operator<=(const FixedBigInteger& rhs) const;
+        bool operator==(const FixedBigInteger& rhs) const;
+
+        BigInteger toBigInteger() const;
+        void toString(int radix, std::string* str) const;
+
+        int getBitCount() const;
+        int getByteCount() const;
+        uint8_t getBit(uint32_t idx) const;
+
+        // 将数值的绝对值写入 length 字节的缓冲区，高位补零
+        void getBytesBE(uint8_t* out, size_t length) const;
+        void getBytesLE(uint8_t* out, size_t length) const;
+
+        bool isOdd() const;
+        bool isZero() const;
+        bool isMinus() const;
+
+    private:
+        void shrink();
+
+        static int cmpUnsItl(const FixedBigInteger& l, const FixedBigInteger& r);
+        static int cmpItl(const FixedBigInteger& l, const FixedBigInteger& r);
+
+        // |result| = |l| + |r|
+        static void lowAdd(const FixedBigInteger& l, const FixedBigInteger& r, FixedBigInteger* result);
+        // |result| = |l| - |r|, |l| >= |r|
+        static void lowSub(const FixedBigInteger& l, const FixedBigInteger& r, FixedBigInteger* result);
+        // Comba 乘法
+        static void lowMul(const FixedBigInteger& l, const FixedBigInteger& r, FixedBigInteger* result);
+
+        static void addItl(const FixedBigInteger& l, const FixedBigInteger& r, bool r_minus, FixedBigInteger* result);
+        static void divItl(const FixedBigInteger& a, const FixedBigInteger& b, FixedBigInteger* c, FixedBigInteger* d);
+        static void divdItl(const FixedBigInteger& a, Digit b, FixedBigInteger* c, Digit* d);
+        static bool invmodItl(const FixedBigInteger& a, const FixedBigInteger& b, FixedBigInteger* c);
+
+        Digit buf_[kDigitCount];
+        int used_;
+        bool is_minus_;
+    };
+
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::from32(int32_t i) {
+        FixedBigInteger fbi;
+        fbi.setInt32(i);
+        return fbi;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::from64(int64_t i) {
+        FixedBigInteger fbi;
+        fbi.setInt64(i);
+        return fbi;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::fromU32(uint32_t i) {
+        FixedBigInteger fbi;
+        fbi.setUInt32(i);
+        return fbi;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::fromU64(uint64_t i) {
+        FixedBigInteger fbi;
+        fbi.setUInt64(i);
+        return fbi;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::fromString(const std::string& str, int radix) {
+        // 仅用于常量的解析，直接借用 BigInteger 的实现
+        return fromBigInteger(BigInteger::fromString(str, radix));
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::fromBytesBE(const uint8_t* bytes, size_t length) {
+        FixedBigInteger fbi;
+        for (size_t i = 0; i < length; ++i) {
+            auto bit = (length - 1 - i) * 8;
+            auto pos = int(bit / kBaseBitCount);
+            auto off = int(bit % kBaseBitCount);
+            Digit b = bytes[i];
+            if (b == 0) {
+                continue;
+            }
+            ubassert(pos < kDigitCount);
+            fbi.buf_[pos] |= (b << off) & kBaseMask;
+            if (off > kBaseBitCount - 8) {
+                ubassert(pos + 1 < kDigitCount);
+                fbi.buf_[pos + 1] |= b >> (kBaseBitCount - off);
+            }
+        }
+
+        fbi.used_ = kDigitCount;
+        fbi.shrink();
+        return fbi;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::fromBytesLE(const uint8_t* bytes, size_t length) {
+        FixedBigInteger fbi;
+        for (size_t i = 0; i < length; ++i) {
+            auto bit = i * 8;
+            auto pos = int(bit / kBaseBitCount);
+            auto off = int(bit % kBaseBitCount);
+            Digit b = bytes[i];
+            if (b == 0) {
+                continue;
+            }
+            ubassert(pos < kDigitCount);
+            fbi.buf_[pos] |= (b << off) & kBaseMask;
+            if (off > kBaseBitCount - 8) {
+                ubassert(pos + 1 < kDigitCount);
+                fbi.buf_[pos + 1] |= b >> (kBaseBitCount - off);
+            }
+        }
+
+        fbi.used_ = kDigitCount;
+        fbi.shrink();
+        return fbi;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::fromBigInteger(const BigInteger& bi) {
+        FixedBigInteger fbi;
+        ubassert(bi.int_.used_ <= kDigitCount);
+        std::memcpy(fbi.buf_, bi.int_.buf_, bi.int_.used_ * sizeof(Digit));
+        fbi.used_ = bi.int_.used_;
+        fbi.is_minus_ = bi.int_.is_minus_;
+        return fbi;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>::FixedBigInteger()
+        : buf_(),
+          used_(0),
+          is_minus_(false) {}
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::zero() {
+        std::memset(buf_, 0, sizeof(buf_));
+        used_ = 0;
+        is_minus_ = false;
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::swap(FixedBigInteger& rhs) {
+        FixedBigInteger tmp(*this);
+        *this = rhs;
+        rhs = tmp;
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::destroy() {
+        zero();
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::setInt32(int32_t i) {
+        if (i >= 0) {
+            setUInt32(static_cast<uint32_t>(i));
+        } else {
+            setUInt32(~static_cast<uint32_t>(i) + 1);
+            inv();
+        }
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::setInt64(int64_t i) {
+        if (i >= 0) {
+            setUInt64(static_cast<uint64_t>(i));
+        } else {
+            setUInt64(~static_cast<uint64_t>(i) + 1);
+            inv();
+        }
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::setUInt32(uint32_t i) {
+        setUInt64(i);
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::setUInt64(uint64_t i) {
+        zero();
+        while (i != 0) {
+            ubassert(used_ < kDigitCount);
+            buf_[used_++] = Digit(i & kBaseMask);
+            i >>= kBaseBitCount;
+        }
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::setBit(uint32_t idx, uint8_t val) {
+        auto pos = int(idx / kBaseBitCount);
+        auto off = idx % kBaseBitCount;
+        ubassert(pos < kDigitCount);
+        if (val & 1) {
+            buf_[pos] |= Digit(1) << off;
+            if (pos >= used_) {
+                used_ = pos + 1;
+            }
+        } else {
+            buf_[pos] &= ~(Digit(1) << off);
+            shrink();
+        }
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::add(const FixedBigInteger& rhs) {
+        addItl(*this, rhs, rhs.is_minus_, this);
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::sub(const FixedBigInteger& rhs) {
+        addItl(*this, rhs, !rhs.is_minus_, this);
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::mul(const FixedBigInteger& rhs) {
+        bool neg = is_minus_ != rhs.is_minus_;
+        lowMul(*this, rhs, this);
+        is_minus_ = used_ > 0 ? neg : false;
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::div(const FixedBigInteger& rhs) {
+        divItl(*this, rhs, this, nullptr);
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::mod(const FixedBigInteger& rhs) {
+        divItl(*this, rhs, nullptr, this);
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::modP(const FixedBigInteger& rhs) {
+        divItl(*this, rhs, nullptr, this);
+        if (is_minus_) {
+            addItl(*this, rhs, rhs.is_minus_, this);
+        }
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::add(Digit b) {
+        return add(fromU64(b));
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::sub(Digit b) {
+        return sub(fromU64(b));
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::mul(Digit b) {
+        Word carry = 0;
+        for (int i = 0; i < used_; ++i) {
+            carry += Word(buf_[i]) * b;
+            buf_[i] = Digit(carry & kBaseMask);
+            carry >>= kBaseBitCount;
+        }
+        while (carry != 0) {
+            ubassert(used_ < kDigitCount);
+            buf_[used_++] = Digit(carry & kBaseMask);
+            carry >>= kBaseBitCount;
+        }
+        shrink();
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::div(Digit b) {
+        divdItl(*this, b, this, nullptr);
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::pow(Digit exp) {
+        FixedBigInteger g(*this);
+        setUInt32(1);
+        for (int i = int(BigInteger::kDigitBitCount) - 1; i >= 0; --i) {
+            exp2();
+            if ((exp >> i) & 1) {
+                mul(g);
+            }
+        }
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::powMod(
+        const FixedBigInteger& exp, const FixedBigInteger& m)
+    {
+        if (m.is_minus_) {
+            uthrow("");
+            return *this;
+        }
+
+        FixedBigInteger g;
+        if (exp.is_minus_) {
+            if (!invmodItl(*this, m, &g)) {
+                uthrow("");
+                return *this;
+            }
+        } else {
+            g = *this;
+            g.modP(m);
+        }
+
+        setUInt32(1);
+        for (int i = exp.getBitCount() - 1; i >= 0; --i) {
+            exp2().mod(m);
+            if (exp.getBit(i)) {
+                mul(g).mod(m);
+            }
+        }
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::abs() {
+        is_minus_ = false;
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::inv() {
+        if (used_ > 0) {
+            is_minus_ = !is_minus_;
+        }
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::shl(int offset) {
+        if (offset <= 0 || used_ == 0) {
+            return *this;
+        }
+        ubassert(used_ + offset <= kDigitCount);
+        for (int i = used_ - 1; i >= 0; --i) {
+            buf_[i + offset] = buf_[i];
+        }
+        for (int i = 0; i < offset; ++i) {
+            buf_[i] = 0;
+        }
+        used_ += offset;
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::shr(int offset) {
+        if (offset <= 0) {
+            return *this;
+        }
+        if (offset >= used_) {
+            zero();
+            return *this;
+        }
+        for (int i = 0; i < used_ - offset; ++i) {
+            buf_[i] = buf_[i + offset];
+        }
+        for (int i = used_ - offset; i < used_; ++i) {
+            buf_[i] = 0;
+        }
+        used_ -= offset;
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::mul2() {
+        return mul2exp(1);
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::mul2exp(int exp) {
+        if (exp <= 0 || used_ == 0) {
+            return *this;
+        }
+
+        shl(exp / kBaseBitCount);
+
+        int d = exp % kBaseBitCount;
+        if (d != 0) {
+            Digit carry = 0;
+            for (int i = 0; i < used_; ++i) {
+                Digit tmp = buf_[i] >> (kBaseBitCount - d);
+                buf_[i] = ((buf_[i] << d) | carry) & kBaseMask;
+                carry = tmp;
+            }
+            if (carry != 0) {
+                ubassert(used_ < kDigitCount);
+                buf_[used_++] = carry;
+            }
+        }
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::div2() {
+        return div2exp(1);
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::div2exp(int exp) {
+        if (exp <= 0) {
+            return *this;
+        }
+
+        shr(exp / kBaseBitCount);
+
+        int d = exp % kBaseBitCount;
+        if (d != 0) {
+            Digit mask = (Digit(1) << d) - 1;
+            Digit carry = 0;
+            for (int i = used_ - 1; i >= 0; --i) {
+                Digit tmp = buf_[i] & mask;
+                buf_[i] = (buf_[i] >> d) | (carry << (kBaseBitCount - d));
+                carry = tmp;
+            }
+        }
+        shrink();
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::mod2exp(int exp) {
+        if (exp <= 0) {
+            zero();
+            return *this;
+        }
+        if (exp >= used_ * kBaseBitCount) {
+            return *this;
+        }
+
+        int pos = exp / kBaseBitCount;
+        for (int i = pos + 1; i < used_; ++i) {
+            buf_[i] = 0;
+        }
+        buf_[pos] &= (Digit(1) << (exp % kBaseBitCount)) - 1;
+        shrink();
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::exp2() {
+        lowMul(*this, *this, this);
+        is_minus_ = false;
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::ond(const FixedBigInteger& rhs) {
+        for (int i = 0; i < used_; ++i) {
+            buf_[i] &= rhs.buf_[i];
+        }
+        is_minus_ = false;
+        shrink();
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits>& FixedBigInteger<Bits>::exor(const FixedBigInteger& rhs) {
+        for (int i = 0; i < rhs.used_; ++i) {
+            buf_[i] ^= rhs.buf_[i];
+        }
+        if (rhs.used_ > used_) {
+            used_ = rhs.used_;
+        }
+        is_minus_ = false;
+        shrink();
+        return *this;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::gcd(const FixedBigInteger& rhs) const {
+        FixedBigInteger a(*this), b(rhs);
+        a.abs();
+        b.abs();
+        while (!b.isZero()) {
+            FixedBigInteger t(a);
+            t.mod(b);
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::invmod(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp;
+        if (!invmodItl(*this, rhs, &tmp)) {
+            uthrow("");
+        }
+        return tmp;
+    }
+
+    template <int Bits>
+    int FixedBigInteger<Bits>::compare(const FixedBigInteger& rhs) const {
+        return cmpItl(*this, rhs);
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator+(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp(*this);
+        tmp.add(rhs);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator-(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp(*this);
+        tmp.sub(rhs);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator*(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp(*this);
+        tmp.mul(rhs);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator/(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp(*this);
+        tmp.div(rhs);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator%(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp(*this);
+        tmp.mod(rhs);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator&(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp(*this);
+        tmp.ond(rhs);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator^(const FixedBigInteger& rhs) const {
+        FixedBigInteger tmp(*this);
+        tmp.exor(rhs);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator+(Digit b) const {
+        FixedBigInteger tmp(*this);
+        tmp.add(b);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator-(Digit b) const {
+        FixedBigInteger tmp(*this);
+        tmp.sub(b);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator*(Digit b) const {
+        FixedBigInteger tmp(*this);
+        tmp.mul(b);
+        return tmp;
+    }
+
+    template <int Bits>
+    FixedBigInteger<Bits> FixedBigInteger<Bits>::operator/(Digit b) const {
+        FixedBigInteger tmp(*this);
+        tmp.div(b);
+        return tmp;
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::operator>(const FixedBigInteger& rhs) const {
+        return cmpItl(*this, rhs) > 0;
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::operator>=(const FixedBigInteger& rhs) const {
+        return cmpItl(*this, rhs) >= 0;
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::operator<(const FixedBigInteger& rhs) const {
+        return cmpItl(*this, rhs) < 0;
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::operator<=(const FixedBigInteger& rhs) const {
+        return cmpItl(*this, rhs) <= 0;
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::operator==(const FixedBigInteger& rhs) const {
+        return cmpItl(*this, rhs) == 0;
+    }
+
+    template <int Bits>
+    BigInteger FixedBigInteger<Bits>::toBigInteger() const {
+        BigInteger bi;
+        bi.int_.grow(used_);
+        std::memcpy(bi.int_.buf_, buf_, used_ * sizeof(Digit));
+        bi.int_.used_ = used_;
+        bi.int_.is_minus_ = is_minus_;
+        return bi;
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::toString(int radix, std::string* str) const {
+        toBigInteger().toString(radix, str);
+    }
+
+    template <int Bits>
+    int FixedBigInteger<Bits>::getBitCount() const {
+        if (used_ == 0) {
+            return 0;
+        }
+
+        int count = (used_ - 1) * kBaseBitCount;
+        auto top = buf_[used_ - 1];
+        while (top != 0) {
+            ++count;
+            top >>= 1;
+        }
+        return count;
+    }
+
+    template <int Bits>
+    int FixedBigInteger<Bits>::getByteCount() const {
+        return (getBitCount() + 7) / 8;
+    }
+
+    template <int Bits>
+    uint8_t FixedBigInteger<Bits>::getBit(uint32_t idx) const {
+        auto pos = int(idx / kBaseBitCount);
+        auto off = idx % kBaseBitCount;
+        if (pos >= used_) {
+            return 0;
+        }
+        return (buf_[pos] >> off) & 0x1;
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::getBytesBE(uint8_t* out, size_t length) const {
+        getBytesLE(out, length);
+        for (size_t i = 0; i < length / 2; ++i) {
+            auto tmp = out[i];
+            out[i] = out[length - 1 - i];
+            out[length - 1 - i] = tmp;
+        }
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::getBytesLE(uint8_t* out, size_t length) const {
+        ubassert(size_t(getByteCount()) <= length);
+        for (size_t i = 0; i < length; ++i) {
+            auto bit = i * 8;
+            auto pos = int(bit / kBaseBitCount);
+            auto off = int(bit % kBaseBitCount);
+            if (pos >= used_) {
+                out[i] = 0;
+                continue;
+            }
+
+            Digit b = buf_[pos] >> off;
+            if (off > kBaseBitCount - 8 && pos + 1 < used_) {
+                b |= buf_[pos + 1] << (kBaseBitCount - off);
+            }
+            out[i] = uint8_t(b & 0xFF);
+        }
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::isOdd() const {
+        return buf_[0] & Digit(1);
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::isZero() const {
+        return used_ == 0;
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::isMinus() const {
+        return is_minus_;
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::shrink() {
+        while (used_ > 0 && buf_[used_ - 1] == 0) {
+            --used_;
+        }
+        if (used_ == 0) {
+            is_minus_ = false;
+        }
+    }
+
+    template <int Bits>
+    int FixedBigInteger<Bits>::cmpUnsItl(const FixedBigInteger& l, const FixedBigInteger& r) {
+        if (l.used_ > r.used_) return 1;
+        if (l.used_ < r.used_) return -1;
+
+        for (int i = l.used_ - 1; i >= 0; --i) {
+            if (l.buf_[i] > r.buf_[i]) return 1;
+            if (l.buf_[i] < r.buf_[i]) return -1;
+        }
+        return 0;
+    }
+
+    template <int Bits>
+    int FixedBigInteger<Bits>::cmpItl(const FixedBigInteger& l, const FixedBigInteger& r) {
+        if (l.is_minus_ != r.is_minus_) {
+            return l.is_minus_ ? -1 : 1;
+        }
+        if (l.is_minus_) {
+            return cmpUnsItl(r, l);
+        }
+        return cmpUnsItl(l, r);
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::lowAdd(
+        const FixedBigInteger& l, const FixedBigInteger& r, FixedBigInteger* result)
+    {
+        int max = l.used_ > r.used_ ? l.used_ : r.used_;
+
+        Digit carry = 0;
+        for (int i = 0; i < max; ++i) {
+            Digit sum = l.buf_[i] + r.buf_[i] + carry;
+            result->buf_[i] = sum & kBaseMask;
+            carry = sum >> kBaseBitCount;
+        }
+        if (carry != 0) {
+            ubassert(max < kDigitCount);
+            result->buf_[max++] = carry;
+        }
+
+        for (int i = max; i < result->used_; ++i) {
+            result->buf_[i] = 0;
+        }
+        result->used_ = max;
+        result->shrink();
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::lowSub(
+        const FixedBigInteger& l, const FixedBigInteger& r, FixedBigInteger* result)
+    {
+        int max = l.used_;
+
+        Digit borrow = 0;
+        for (int i = 0; i < max; ++i) {
+            Digit diff = l.buf_[i] - r.buf_[i] - borrow;
+            borrow = diff >> (BigInteger::kDigitBitCount - 1);
+            result->buf_[i] = diff & kBaseMask;
+        }
+
+        for (int i = max; i < result->used_; ++i) {
+            result->buf_[i] = 0;
+        }
+        result->used_ = max;
+        result->shrink();
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::lowMul(
+        const FixedBigInteger& l, const FixedBigInteger& r, FixedBigInteger* result)
+    {
+        if (l.used_ == 0 || r.used_ == 0) {
+            result->zero();
+            return;
+        }
+
+        int pa = l.used_ + r.used_;
+        ubassert(pa <= kDigitCount);
+
+        // 每一列最多累加 kDigitCount 个 2 * kBaseBitCount 位的积
+        // （2^28 基时为 56 位，2^60 基时为 120 位），kDigitCount < kDelta 保证其和不会溢出 Word
+        Digit tmp[kDigitCount];
+        Word w = 0;
+        for (int ix = 0; ix < pa; ++ix) {
+            int ty = ix < r.used_ - 1 ? ix : r.used_ - 1;
+            int tx = ix - ty;
+            int iy = l.used_ - tx < ty + 1 ? l.used_ - tx : ty + 1;
+
+            for (int iz = 0; iz < iy; ++iz) {
+                w += Word(l.buf_[tx + iz]) * r.buf_[ty - iz];
+            }
+            tmp[ix] = Digit(w & kBaseMask);
+            w >>= kBaseBitCount;
+        }
+
+        std::memcpy(result->buf_, tmp, pa * sizeof(Digit));
+        for (int i = pa; i < result->used_; ++i) {
+            result->buf_[i] = 0;
+        }
+        result->used_ = pa;
+        result->shrink();
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::addItl(
+        const FixedBigInteger& l, const FixedBigInteger& r, bool r_minus, FixedBigInteger* result)
+    {
+        bool l_minus = l.is_minus_;
+        if (l_minus == r_minus) {
+            lowAdd(l, r, result);
+            result->is_minus_ = result->used_ > 0 ? l_minus : false;
+            return;
+        }
+
+        if (cmpUnsItl(l, r) >= 0) {
+            lowSub(l, r, result);
+            result->is_minus_ = result->used_ > 0 ? l_minus : false;
+        } else {
+            lowSub(r, l, result);
+            result->is_minus_ = result->used_ > 0 ? r_minus : false;
+        }
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::divItl(
+        const FixedBigInteger& a, const FixedBigInteger& b, FixedBigInteger* c, FixedBigInteger* d)
+    {
+        if (b.isZero()) {
+            uthrow("");
+            return;
+        }
+
+        if (cmpUnsItl(a, b) < 0) {
+            if (d) {
+                *d = a;
+            }
+            if (c) {
+                c->zero();
+            }
+            return;
+        }
+
+        bool q_minus = a.is_minus_ != b.is_minus_;
+        bool r_minus = a.is_minus_;
+
+        if (b.used_ == 1) {
+            Digit rem;
+            divdItl(a, b.buf_[0], c, &rem);
+            if (c) {
+                c->is_minus_ = c->used_ > 0 ? q_minus : false;
+            }
+            if (d) {
+                d->setUInt64(rem);
+                d->is_minus_ = d->used_ > 0 ? r_minus : false;
+            }
+            return;
+        }
+
+        // Knuth 算法 D，先将除数规格化，使其最高 Digit 的最高位为 1
+        int n = b.used_;
+        int m = a.used_ - n;
+
+        int norm = 0;
+        for (Digit top = b.buf_[n - 1]; top < (kBase >> 1); top <<= 1) {
+            ++norm;
+        }
+
+        Digit u[kDigitCount + 1];
+        Digit v[kDigitCount];
+        Digit q[kDigitCount];
+
+        Digit carry = 0;
+        for (int i = 0; i < a.used_; ++i) {
+            u[i] = ((a.buf_[i] << norm) | carry) & kBaseMask;
+            carry = norm ? a.buf_[i] >> (kBaseBitCount - norm) : 0;
+        }
+        u[a.used_] = carry;
+
+        carry = 0;
+        for (int i = 0; i < n; ++i) {
+            v[i] = ((b.buf_[i] << norm) | carry) & kBaseMask;
+            carry = norm ? b.buf_[i] >> (kBaseBitCount - norm) : 0;
+        }
+
+        for (int j = m; j >= 0; --j) {
+            Word num = (Word(u[j + n]) << kBaseBitCount) | u[j + n - 1];
+            Word qhat = num / v[n - 1];
+            Word rhat = num % v[n - 1];
+
+            while (qhat >= kBase ||
+                qhat * v[n - 2] > ((rhat << kBaseBitCount) | u[j + n - 2]))
+            {
+                --qhat;
+                rhat += v[n - 1];
+                if (rhat >= kBase) {
+                    break;
+                }
+            }
+
+            // u[j..j+n] -= qhat * v
+            Word mc = 0;
+            Digit borrow = 0;
+            for (int i = 0; i < n; ++i) {
+                Word p = qhat * v[i] + mc;
+                mc = p >> kBaseBitCount;
+                Digit diff = u[i + j] - Digit(p & kBaseMask) - borrow;
+                borrow = diff >> (BigInteger::kDigitBitCount - 1);
+                u[i + j] = diff & kBaseMask;
+            }
+            Digit diff = u[j + n] - Digit(mc) - borrow;
+            borrow = diff >> (BigInteger::kDigitBitCount - 1);
+            u[j + n] = diff & kBaseMask;
+
+            // qhat 大了 1，加回一个 v
+            if (borrow) {
+                --qhat;
+                Digit ac = 0;
+                for (int i = 0; i < n; ++i) {
+                    Digit sum = u[i + j] + v[i] + ac;
+                    u[i + j] = sum & kBaseMask;
+                    ac = sum >> kBaseBitCount;
+                }
+                u[j + n] = (u[j + n] + ac) & kBaseMask;
+            }
+            q[j] = Digit(qhat);
+        }
+
+        if (c) {
+            c->zero();
+            std::memcpy(c->buf_, q, (m + 1) * sizeof(Digit));
+            c->used_ = m + 1;
+            c->shrink();
+            c->is_minus_ = c->used_ > 0 ? q_minus : false;
+        }
+        if (d) {
+            d->zero();
+            for (int i = 0; i < n; ++i) {
+                Digit hi = (norm && i + 1 < n) ? (u[i + 1] << (kBaseBitCount - norm)) : 0;
+                d->buf_[i] = ((u[i] >> norm) | hi) & kBaseMask;
+            }
+            d->used_ = n;
+            d->shrink();
+            d->is_minus_ = d->used_ > 0 ? r_minus : false;
+        }
+    }
+
+    template <int Bits>
+    void FixedBigInteger<Bits>::divdItl(
+        const FixedBigInteger& a, Digit b, FixedBigInteger* c, Digit* d)
+    {
+        if (b == 0) {
+            uthrow("");
+            return;
+        }
+
+        FixedBigInteger q;
+        Word w = 0;
+        for (int i = a.used_ - 1; i >= 0; --i) {
+            w = (w << kBaseBitCount) | a.buf_[i];
+            q.buf_[i] = Digit(w / b);
+            w %= b;
+        }
+        q.used_ = a.used_;
+        q.shrink();
+        q.is_minus_ = q.used_ > 0 ? a.is_minus_ : false;
+
+        if (d) {
+            *d = Digit(w);
+        }
+        if (c) {
+            *c = q;
+        }
+    }
+
+    template <int Bits>
+    bool FixedBigInteger<Bits>::invmodItl(
+        const FixedBigInteger& a, const FixedBigInteger& b, FixedBigInteger* c)
+    {
+        if (b.is_minus_ || b.isZero() || a.isZero()) {
+            uthrow("");
+            return false;
+        }
+
+        FixedBigInteger x(a);
+        x.modP(b);
+
+        // a 为 b 的倍数时不可逆
+        FixedBigInteger y(b);
+        if (x.isZero() || (!x.isOdd() && !y.isOdd())) {
+            return false;
+        }
+
+        FixedBigInteger u(x);
+        FixedBigInteger v(y);
+
+        FixedBigInteger A, B, C, D;
+        A.setUInt32(1);
+        D.setUInt32(1);
+
+        do {
+            while (!u.isOdd()) {
+                u.div2();
+                if (A.isOdd() || B.isOdd()) {
+                    A.add(y);
+                    B.sub(x);
+                }
+                A.div2();
+                B.div2();
+            }
+
+            while (!v.isOdd()) {
+                v.div2();
+                if (C.isOdd() || D.isOdd()) {
+                    C.add(y);
+                    D.sub(x);
+                }
+                C.div2();
+                D.div2();
+            }
+
+            if (cmpItl(u, v) >= 0) {
+                u.sub(v);
+                A.sub(C);
+                B.sub(D);
+            } else {
+                v.sub(u);
+                C.sub(A);
+                D.sub(B);
+            }
+        } while (!u.isZero());
+
+        if (!(v.used_ == 1 && v.buf_[0] == 1)) {
+            return false;
+        }
+
+        while (C.is_minus_) {
+            C.add(b);
+        }
+        while (cmpUnsItl(C, b) >= 0) {
+            C.sub(b);
+        }
+
+        *c = C;
+        return true;
+    }
+
+}
+
+#endif  // AKASH_SECURITY_BIG_INTEGER_FIXED_BIG_INTEGER_H_
@@ -9,16 +9,37 @@
 
 #include <cstdint>
 
+#if defined(AKASH_BIG_INTEGER_64BIT_DIGIT) && !defined(__SIZEOF_INT128__)
+#include "akash/security/big_integer/uint128.h"
+#endif
+
+// 定义 AKASH_BIG_INTEGER_64BIT_DIGIT 后，大数使用 64 位的 Digit 和 128 位的 Word。
+// 基仍为 2^(Digit 位数 - 4)，即 2^60，每个 Digit 保留 4 位用于进位检测，
+// 数组单元数约为默认情况的一半，乘法次数约为四分之一。
+// 支持 unsigned __int128 的编译器（GCC、Clang、clang-cl）直接使用它作为 Word，
+// 否则（如 MSVC 的 cl）使用 UInt128。
 
 namespace utl {
 
     class IntArray {
     public:
+#ifdef AKASH_BIG_INTEGER_64BIT_DIGIT
+        // 数组单元的数据类型
+        using Digit = uint64_t;
+
+        // 双精度类型（以 Digit 为单精度）
+#ifdef __SIZEOF_INT128__
+        using Word = unsigned __int128;
+#else
+        using Word = UInt128;
+#endif
+#else
         // 数组单元的数据类型
         using Digit = uint32_t;
 
         // 双精度类型（以 Digit 为单精度）
         using Word = uint64_t;
+#endif
 
 
         IntArray();
@@ -0,0 +1,205 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_BIG_INTEGER_UINT128_H_
+#define AKASH_SECURITY_BIG_INTEGER_UINT128_H_
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#define AKASH_UINT128_MSVC_X64
+#endif
+
+
+namespace utl {
+
+    // 128 位无符号整数，供没有 unsigned __int128 的编译器（如 MSVC 的 cl）作为大数的 Word 使用。
+    // 只实现 BigInteger 和 FixedBigInteger 用到的运算；
+    // x64 上乘法和进位借助 _umul128、_addcarry_u64 等内建函数，其他平台使用可移植实现。
+    // 到 uint64_t 的转换是显式的，以免与内建运算符产生二义性。
+    class UInt128 {
+    public:
+        constexpr UInt128()
+            : lo_(0), hi_(0) {}
+        constexpr UInt128(uint64_t v)
+            : lo_(v), hi_(0) {}
+        constexpr UInt128(uint64_t hi, uint64_t lo)
+            : lo_(lo), hi_(hi) {}
+
+        explicit constexpr operator uint64_t() const { return lo_; }
+        explicit constexpr operator bool() const { return (lo_ | hi_) != 0; }
+
+        UInt128& operator+=(const UInt128& rhs) {
+#ifdef AKASH_UINT128_MSVC_X64
+            unsigned char c = _addcarry_u64(0, lo_, rhs.lo_, &lo_);
+            _addcarry_u64(c, hi_, rhs.hi_, &hi_);
+#else
+            uint64_t lo = lo_ + rhs.lo_;
+            hi_ += rhs.hi_ + (lo < lo_ ? 1 : 0);
+            lo_ = lo;
+#endif
+            return *this;
+        }
+
+        UInt128& operator-=(const UInt128& rhs) {
+#ifdef AKASH_UINT128_MSVC_X64
+            unsigned char b = _subborrow_u64(0, lo_, rhs.lo_, &lo_);
+            _subborrow_u64(b, hi_, rhs.hi_, &hi_);
+#else
+            uint64_t lo = lo_ - rhs.lo_;
+            hi_ -= rhs.hi_ + (lo > lo_ ? 1 : 0);
+            lo_ = lo;
+#endif
+            return *this;
+        }
+
+        UInt128& operator*=(const UInt128& rhs) {
+            uint64_t hi;
+            uint64_t lo = mul64(lo_, rhs.lo_, &hi);
+            hi_ = hi + lo_ * rhs.hi_ + hi_ * rhs.lo_;
+            lo_ = lo;
+            return *this;
+        }
+
+        UInt128& operator/=(const UInt128& rhs) {
+            UInt128 r;
+            divmod(*this, rhs, this, &r);
+            return *this;
+        }
+
+        UInt128& operator%=(const UInt128& rhs) {
+            UInt128 q;
+            divmod(*this, rhs, &q, this);
+            return *this;
+        }
+
+        UInt128& operator&=(const UInt128& rhs) {
+            lo_ &= rhs.lo_;
+            hi_ &= rhs.hi_;
+            return *this;
+        }
+
+        UInt128& operator|=(const UInt128& rhs) {
+            lo_ |= rhs.lo_;
+            hi_ |= rhs.hi_;
+            return *this;
+        }
+
+        UInt128& operator<<=(uint64_t s) {
+            if (s >= 128) {
+                lo_ = hi_ = 0;
+            } else if (s >= 64) {
+                hi_ = lo_ << (s - 64);
+                lo_ = 0;
+            } else if (s > 0) {
+                hi_ = (hi_ << s) | (lo_ >> (64 - s));
+                lo_ <<= s;
+            }
+            return *this;
+        }
+
+        UInt128& operator>>=(uint64_t s) {
+            if (s >= 128) {
+                lo_ = hi_ = 0;
+            } else if (s >= 64) {
+                lo_ = hi_ >> (s - 64);
+                hi_ = 0;
+            } else if (s > 0) {
+                lo_ = (lo_ >> s) | (hi_ << (64 - s));
+                hi_ >>= s;
+            }
+            return *this;
+        }
+
+        UInt128& operator++() { return *this += 1; }
+        UInt128& operator--() { return *this -= 1; }
+
+        friend UInt128 operator+(UInt128 l, const UInt128& r) { return l += r; }
+        friend UInt128 operator-(UInt128 l, const UInt128& r) { return l -= r; }
+        friend UInt128 operator*(UInt128 l, const UInt128& r) { return l *= r; }
+        friend UInt128 operator/(UInt128 l, const UInt128& r) { return l /= r; }
+        friend UInt128 operator%(UInt128 l, const UInt128& r) { return l %= r; }
+        friend UInt128 operator&(UInt128 l, const UInt128& r) { return l &= r; }
+        friend UInt128 operator|(UInt128 l, const UInt128& r) { return l |= r; }
+        friend UInt128 operator<<(UInt128 l, uint64_t s) { return l <<= s; }
+        friend UInt128 operator>>(UInt128 l, uint64_t s) { return l >>= s; }
+
+        friend bool operator==(const UInt128& l, const UInt128& r) {
+            return l.lo_ == r.lo_ && l.hi_ == r.hi_;
+        }
+        friend bool operator!=(const UInt128& l, const UInt128& r) { return !(l == r); }
+        friend bool operator<(const UInt128& l, const UInt128& r) {
+            return l.hi_ < r.hi_ || (l.hi_ == r.hi_ && l.lo_ < r.lo_);
+        }
+        friend bool operator>(const UInt128& l, const UInt128& r) { return r < l; }
+        friend bool operator<=(const UInt128& l, const UInt128& r) { return !(r < l); }
+        friend bool operator>=(const UInt128& l, const UInt128& r) { return !(l < r); }
+
+    private:
+        static uint64_t mul64(uint64_t a, uint64_t b, uint64_t* hi) {
+#ifdef AKASH_UINT128_MSVC_X64
+            return _umul128(a, b, hi);
+#else
+            uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+            uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+            uint64_t ll = a_lo * b_lo;
+            uint64_t lh = a_lo * b_hi;
+            uint64_t hl = a_hi * b_lo;
+            uint64_t hh = a_hi * b_hi;
+            uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+            *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+            return (mid << 32) | (ll & 0xFFFFFFFF);
+#endif
+        }
+
+        static void divmod(const UInt128& n, const UInt128& d, UInt128* q, UInt128* r) {
+            if (d.hi_ == 0) {
+                // 大数代码中的除数都不超过 64 位：先除高 64 位，余数小于除数，再除剩下的 128 位
+                uint64_t q_hi = n.hi_ / d.lo_;
+                uint64_t rem = n.hi_ % d.lo_;
+                uint64_t q_lo;
+#ifdef AKASH_UINT128_MSVC_X64
+                q_lo = _udiv128(rem, n.lo_, d.lo_, &rem);
+#else
+                q_lo = 0;
+                for (int i = 63; i >= 0; --i) {
+                    uint64_t top = rem >> 63;
+                    rem = (rem << 1) | ((n.lo_ >> i) & 1);
+                    if (top || rem >= d.lo_) {
+                        rem -= d.lo_;
+                        q_lo |= uint64_t(1) << i;
+                    }
+                }
+#endif
+                *q = UInt128(q_hi, q_lo);
+                *r = UInt128(rem);
+                return;
+            }
+
+            UInt128 quo;
+            UInt128 rem;
+            for (int i = 127; i >= 0; --i) {
+                uint64_t top = rem.hi_ >> 63;
+                rem <<= 1;
+                rem.lo_ |= (i >= 64 ? n.hi_ >> (i - 64) : n.lo_ >> i) & 1;
+                quo <<= 1;
+                if (top || rem >= d) {
+                    rem -= d;
+                    quo.lo_ |= 1;
+                }
+            }
+            *q = quo;
+            *r = rem;
+        }
+
+        uint64_t lo_;
+        uint64_t hi_;
+    };
+
+}
+
+#endif  // AKASH_SECURITY_BIG_INTEGER_UINT128_H_
@@ -10,9 +10,47 @@
 #include <cstring>
 
 #include "akash/security/big_integer/byte_string.h"
-#include "akash/security/crypto/aes.h"
+#include "akash/security/crypto/aesni.h"
+#include "akash/security/crypto/chacha20.h"
+#include "akash/security/crypto/poly1305.h"
 
 
+namespace {
+
+    // 右移 4 位时移出的位乘以 x^128 约减后的值，只影响最高 16 位
+    const uint64_t kLast4[16] = {
+        0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+        0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+    };
+
+    uint64_t load64BE(const uint8_t* in) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v = (v << 8) | in[i];
+        }
+        return v;
+    }
+
+    void store64BE(uint64_t v, uint8_t* out) {
+        for (int i = 7; i >= 0; --i) {
+            out[i] = uint8_t(v);
+            v >>= 8;
+        }
+    }
+
+    // 计数器块末尾 32 位 (大端) 加上 n，按 2^32 取模
+    void addCounter(uint8_t CB[16], size_t n) {
+        uint32_t c = (uint32_t(CB[12]) << 24) | (uint32_t(CB[13]) << 16) |
+            (uint32_t(CB[14]) << 8) | uint32_t(CB[15]);
+        c += uint32_t(n);
+        CB[12] = uint8_t(c >> 24);
+        CB[13] = uint8_t(c >> 16);
+        CB[14] = uint8_t(c >> 8);
+        CB[15] = uint8_t(c);
+    }
+
+}
+
 namespace akash {
 namespace crypto {
 
@@ -22,6 +60,21 @@ namespace crypto {
         uint8_t* C, uint8_t* T, size_t t)
     {
         assert(K && lk != 0);
+
+        AESKey key;
+        if (!key.init(K, uint32_t(lk))) {
+            assert(false);
+            return;
+        }
+        GCM_AE(key, IV, l_iv, P, lp, A, la, C, T, t);
+    }
+
+    void GCM::GCM_AE(
+        const AESKey& key, const uint8_t* IV, size_t l_iv,
+        const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+        uint8_t* C, uint8_t* T, size_t t)
+    {
+        assert(key.isValid());
         assert(IV && l_iv != 0);
         assert(P || lp == 0);
         assert(A || la == 0);
@@ -35,7 +88,7 @@ namespace crypto {
         uint8_t H[16];
         uint8_t i_tmp[16];
         std::memset(i_tmp, 0, 16);
-        CIPH(K, lk, i_tmp, H);
+        CIPH(key, i_tmp, H);
 
         uint8_t J0[16];
         if (l_iv == 12) {
@@ -59,7 +112,7 @@ namespace crypto {
         uint8_t J0_1[16];
         std::memcpy(J0_1, J0, 16);
         utl::ByteString::inc(J0_1, 16, 4, J0_1);
-        GCTR(K, lk, J0_1, P, lp, C);
+        GCTR(key, J0_1, P, lp, C);
 
         // C 的长度为 lp
         size_t u = 16 * ((lp + 15) / 16) - lp;
@@ -82,7 +135,7 @@ namespace crypto {
         delete[] X;
 
         uint8_t tmp[16];
-        GCTR(K, lk, J0, S, 16, tmp);
+        GCTR(key, J0, S, 16, tmp);
         std::memcpy(T, tmp, t);
     }
 
@@ -92,6 +145,21 @@ namespace crypto {
         const uint8_t* T, size_t t, uint8_t* P)
     {
         assert(K && lk != 0);
+
+        AESKey key;
+        if (!key.init(K, uint32_t(lk))) {
+            assert(false);
+            return false;
+        }
+        return GCM_AD(key, IV, l_iv, C, lc, A, la, T, t, P);
+    }
+
+    bool GCM::GCM_AD(
+        const AESKey& key, const uint8_t* IV, size_t l_iv,
+        const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+        const uint8_t* T, size_t t, uint8_t* P)
+    {
+        assert(key.isValid());
         assert(IV && l_iv != 0);
         assert(C || lc == 0);
         assert(A || la == 0);
@@ -105,7 +173,7 @@ namespace crypto {
         uint8_t H[16];
         uint8_t i_tmp[16];
         std::memset(i_tmp, 0, 16);
-        CIPH(K, lk, i_tmp, H);
+        CIPH(key, i_tmp, H);
 
         uint8_t J0[16];
         if (l_iv == 12) {
@@ -130,7 +198,7 @@ namespace crypto {
         uint8_t J0_1[16];
         std::memcpy(J0_1, J0, 16);
         utl::ByteString::inc(J0_1, 16, 4, J0_1);
-        GCTR(K, lk, J0_1, C, lc, P);
+        GCTR(key, J0_1, C, lc, P);
 
         size_t u = 16 * ((lc + 15) / 16) - lc;
         size_t v = 16 * ((la + 15) / 16) - la;
@@ -152,7 +220,7 @@ namespace crypto {
         delete[] X;
 
         uint8_t tmp[16];
-        GCTR(K, lk, J0, S, 16, tmp);
+        GCTR(key, J0, S, 16, tmp);
         if (std::memcmp(T, tmp, t) != 0) {
             return false;
         }
@@ -185,6 +253,13 @@ namespace crypto {
         size_t m = lx / 16;
         std::memset(r, 0, 16);
 
+        if (AES::getImpl() == AES::Impl::AESNI) {
+            uint8_t Htable[AESNI::kGHashTableSize];
+            AESNI::ghashInit(H, Htable);
+            AESNI::ghash(Htable, r, X, m * 16);
+            return;
+        }
+
         for (size_t i = 0; i < m; ++i) {
             utl::ByteString::exor(r, 16, X + i * 16, 16, r);
             product(r, H, r);
@@ -192,43 +267,616 @@ namespace crypto {
     }
 
     void GCM::GCTR(
-        const uint8_t* K, size_t lk,
+        const AESKey& key,
         const uint8_t ICB[16], const uint8_t* X, size_t lx, uint8_t* r)
     {
         if (lx == 0) {
             return;
         }
-        size_t n = (lx + 15) / 16;
+        AES::encryptCTR32(ICB, X, lx, r, key);
+    }
+
+    void GCM::CIPH(
+        const AESKey& key, const uint8_t CB[16], uint8_t* r)
+    {
+        AES::encrypt(CB, r, key);
+    }
 
-        size_t i;
-        uint8_t CB[16];
-        std::memcpy(CB, ICB, 16);
 
-        uint8_t* Yi = r;
-        for (i = 2; i <= n; ++i) {
-            uint8_t crypted[16];
-            CIPH(K, lk, CB, crypted);
 
-            std::memcpy(Yi, X + (i - 2) * 16, 16);
-            utl::ByteString::exor(Yi, 16, crypted, 16, Yi);
-            utl::ByteString::inc(CB, 16, 4, CB);
+    GCMContext::GCMContext() {}
 
-            Yi += 16;
+    bool GCMContext::init(const uint8_t* K, size_t lk) {
+        assert(K && lk != 0);
+
+        if (!key_.init(K, uint32_t(lk))) {
+            clear();
+            return false;
         }
 
-        uint8_t crypted[16];
-        CIPH(K, lk, CB, crypted);
+        uint8_t zero[16];
+        std::memset(zero, 0, 16);
+        AES::encrypt(zero, H_, key_);
+
+        // HH_[8]:HL_[8] 为 H 本身 (GCM 的位序中最高位表示 x^0)，
+        // 之后每右移一位相当于乘以 x
+        uint64_t vh = load64BE(H_);
+        uint64_t vl = load64BE(H_ + 8);
+        HH_[0] = 0; HL_[0] = 0;
+        HH_[8] = vh; HL_[8] = vl;
+        for (int i = 4; i > 0; i >>= 1) {
+            uint64_t T = (vl & 1) * 0xE100000000000000ull;
+            vl = (vh << 63) | (vl >> 1);
+            vh = (vh >> 1) ^ T;
+            HH_[i] = vh; HL_[i] = vl;
+        }
+        for (int i = 2; i <= 8; i *= 2) {
+            for (int j = 1; j < i; ++j) {
+                HH_[i + j] = HH_[i] ^ HH_[j];
+                HL_[i + j] = HL_[i] ^ HL_[j];
+            }
+        }
 
-        size_t rem = lx - (i - 2) * 16;
-        std::memcpy(Yi, X + (i - 2) * 16, rem);
-        utl::ByteString::exor(Yi, 16, crypted, rem, Yi);
+        static_assert(sizeof(Htable_) == AESNI::kGHashTableSize, "Htable_ size mismatch");
+        // 与 AES 使用同一种实现方式，初始化后不再改变
+        if (key_.getImpl() == AES::Impl::AESNI) {
+            AESNI::ghashInit(H_, Htable_);
+        }
+        return true;
     }
 
-    void GCM::CIPH(
-        const uint8_t* K, size_t lk, const uint8_t CB[16], uint8_t* r)
+    void GCMContext::clear() {
+        key_.clear();
+        std::memset(H_, 0, sizeof(H_));
+        std::memset(HL_, 0, sizeof(HL_));
+        std::memset(HH_, 0, sizeof(HH_));
+        std::memset(Htable_, 0, sizeof(Htable_));
+    }
+
+    bool GCMContext::isValid() const {
+        return key_.isValid();
+    }
+
+    void GCMContext::seal(
+        const uint8_t* IV, size_t l_iv,
+        const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+        uint8_t* C, uint8_t* T, size_t t) const
     {
-        AES::encrypt(CB, r, K, lk);
+        assert(isValid());
+        assert(P || lp == 0);
+        assert(A || la == 0);
+        assert(C || !P);
+
+        GCMStream stream(*this);
+        stream.init(IV, l_iv, true);
+        stream.updateAAD(A, la);
+        stream.update(P, lp, C);
+        stream.finish(T, t);
+    }
+
+    bool GCMContext::open(
+        const uint8_t* IV, size_t l_iv,
+        const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+        const uint8_t* T, size_t t, uint8_t* P) const
+    {
+        assert(isValid());
+        assert(C || lc == 0);
+        assert(A || la == 0);
+        assert(P || !C);
+
+        GCMStream stream(*this);
+        stream.init(IV, l_iv, false);
+        stream.updateAAD(A, la);
+        stream.update(C, lc, P);
+        if (!stream.verify(T, t)) {
+            if (lc != 0) {
+                std::memset(P, 0, lc);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void GCMContext::mulH(uint8_t Y[16]) const {
+        // 从最后一个字节开始，每次处理 4 位：Z = Z * x^4 + nibble * H
+        uint8_t lo = Y[15] & 0xF;
+        uint64_t zh = HH_[lo];
+        uint64_t zl = HL_[lo];
+
+        for (int i = 15; i >= 0; --i) {
+            lo = Y[i] & 0xF;
+            uint8_t hi = (Y[i] >> 4) & 0xF;
+
+            if (i != 15) {
+                uint8_t rem = uint8_t(zl & 0xF);
+                zl = (zh << 60) | (zl >> 4);
+                zh = (zh >> 4) ^ (kLast4[rem] << 48);
+                zh ^= HH_[lo];
+                zl ^= HL_[lo];
+            }
+
+            uint8_t rem = uint8_t(zl & 0xF);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (kLast4[rem] << 48);
+            zh ^= HH_[hi];
+            zl ^= HL_[hi];
+        }
+
+        store64BE(zh, Y);
+        store64BE(zl, Y + 8);
+    }
+
+    void GCMContext::ghash(uint8_t Y[16], const uint8_t* X, size_t lx) const {
+        size_t full = lx - lx % 16;
+        if (key_.getImpl() == AES::Impl::AESNI) {
+            AESNI::ghash(Htable_, Y, X, full);
+        } else {
+            for (size_t i = 0; i < full; i += 16) {
+                for (int j = 0; j < 16; ++j) {
+                    Y[j] ^= X[i + j];
+                }
+                mulH(Y);
+            }
+        }
+
+        if (full < lx) {
+            for (size_t j = 0; j < lx - full; ++j) {
+                Y[j] ^= X[full + j];
+            }
+            mulH(Y);
+        }
+    }
+
+    void GCMContext::computeJ0(const uint8_t* IV, size_t l_iv, uint8_t J0[16]) const {
+        if (l_iv == 12) {
+            std::memcpy(J0, IV, 12);
+            J0[12] = 0; J0[13] = 0; J0[14] = 0; J0[15] = 1;
+            return;
+        }
+
+        // J0 = GHASH(IV || 0^(s+64) || [len(IV)]64)
+        std::memset(J0, 0, 16);
+        ghash(J0, IV, l_iv);
+
+        uint8_t len_block[16];
+        std::memset(len_block, 0, 8);
+        utl::ByteString::len64(l_iv, len_block + 8);
+        ghash(J0, len_block, 16);
+    }
+
+
+    GCMStream::GCMStream(const GCMContext& ctx)
+        : ctx_(ctx) {}
+
+    void GCMStream::init(const uint8_t* IV, size_t l_iv, bool encrypt) {
+        assert(ctx_.isValid());
+        assert(IV && l_iv != 0);
+
+        ctx_.computeJ0(IV, l_iv, J0_);
+        std::memcpy(CB_, J0_, 16);
+        addCounter(CB_, 1);
+
+        ks_pos_ = 16;
+        std::memset(Y_, 0, 16);
+        buf_len_ = 0;
+        la_ = 0;
+        lc_ = 0;
+        encrypt_ = encrypt;
+        aad_done_ = false;
+    }
+
+    void GCMStream::updateAAD(const uint8_t* A, size_t la) {
+        assert(A || la == 0);
+        assert(!aad_done_);
+        if (la == 0) {
+            return;
+        }
+
+        absorb(A, la);
+        la_ += la;
+    }
+
+    void GCMStream::update(const uint8_t* in, size_t len, uint8_t* out) {
+        assert(in || len == 0);
+        assert(out || !in);
+
+        endAAD();
+        lc_ += len;
+
+        // 先用完上一次剩下的密钥流
+        while (len > 0 && ks_pos_ < 16) {
+            uint8_t c = *in++;
+            uint8_t o = c ^ ks_[ks_pos_++];
+            absorb(encrypt_ ? &o : &c, 1);
+            *out++ = o;
+            --len;
+        }
+
+        // 此时已对齐到块边界，buf_ 为空。
+        // 每段先加密再对密文计算 GHASH (解密时顺序相反)，段足够小，可留在 L1 缓存中
+        const size_t kChunkSize = 16 * 32;
+        while (len >= 16) {
+            size_t n = len - len % 16;
+            if (n > kChunkSize) {
+                n = kChunkSize;
+            }
+
+            if (!encrypt_) {
+                ctx_.ghash(Y_, in, n);
+            }
+            AES::encryptCTR32(CB_, in, n, out, ctx_.key_);
+            addCounter(CB_, n / 16);
+            if (encrypt_) {
+                ctx_.ghash(Y_, out, n);
+            }
+
+            in += n;
+            out += n;
+            len -= n;
+        }
+
+        if (len > 0) {
+            AES::encrypt(CB_, ks_, ctx_.key_);
+            addCounter(CB_, 1);
+            ks_pos_ = 0;
+
+            while (len > 0) {
+                uint8_t c = *in++;
+                uint8_t o = c ^ ks_[ks_pos_++];
+                absorb(encrypt_ ? &o : &c, 1);
+                *out++ = o;
+                --len;
+            }
+        }
+    }
+
+    void GCMStream::finish(uint8_t* T, size_t t) {
+        assert(T && t <= 16);
+
+        uint8_t S[16];
+        computeTag(S);
+        std::memcpy(T, S, t);
     }
 
+    bool GCMStream::verify(const uint8_t* T, size_t t) {
+        assert(T && t <= 16);
+
+        uint8_t S[16];
+        computeTag(S);
+
+        uint8_t diff = 0;
+        for (size_t i = 0; i < t; ++i) {
+            diff |= S[i] ^ T[i];
+        }
+        return diff == 0;
+    }
+
+    void GCMStream::absorb(const uint8_t* X, size_t lx) {
+        if (buf_len_ > 0) {
+            size_t n = 16 - buf_len_;
+            if (n > lx) {
+                n = lx;
+            }
+            std::memcpy(buf_ + buf_len_, X, n);
+            buf_len_ += n;
+            X += n;
+            lx -= n;
+
+            if (buf_len_ < 16) {
+                return;
+            }
+            ctx_.ghash(Y_, buf_, 16);
+            buf_len_ = 0;
+        }
+
+        size_t full = lx - lx % 16;
+        if (full > 0) {
+            ctx_.ghash(Y_, X, full);
+        }
+        std::memcpy(buf_, X + full, lx - full);
+        buf_len_ = lx - full;
+    }
+
+    void GCMStream::flushBlock() {
+        if (buf_len_ > 0) {
+            std::memset(buf_ + buf_len_, 0, 16 - buf_len_);
+            ctx_.ghash(Y_, buf_, 16);
+            buf_len_ = 0;
+        }
+    }
+
+    void GCMStream::endAAD() {
+        if (!aad_done_) {
+            flushBlock();
+            aad_done_ = true;
+        }
+    }
+
+    void GCMStream::computeTag(uint8_t S[16]) {
+        endAAD();
+        flushBlock();
+
+        uint8_t len_block[16];
+        utl::ByteString::len64(la_, len_block);
+        utl::ByteString::len64(lc_, len_block + 8);
+        ctx_.ghash(Y_, len_block, 16);
+
+        AES::encryptCTR32(J0_, Y_, 16, S, ctx_.key_);
+    }
+
+
+    ChaCha20Poly1305::ChaCha20Poly1305() {}
+
+    bool ChaCha20Poly1305::init(const uint8_t* K, size_t lk) {
+        assert(K);
+        if (lk != kKeySize) {
+            clear();
+            return false;
+        }
+        std::memcpy(key_, K, kKeySize);
+        is_valid_ = true;
+        return true;
+    }
+
+    void ChaCha20Poly1305::clear() {
+        std::memset(key_, 0, sizeof(key_));
+        is_valid_ = false;
+    }
+
+    bool ChaCha20Poly1305::isValid() const {
+        return is_valid_;
+    }
+
+    void ChaCha20Poly1305::seal(
+        const uint8_t N[kNonceSize],
+        const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+        uint8_t* C, uint8_t T[kTagSize]) const
+    {
+        assert(isValid());
+        assert(N && T);
+        assert(P || lp == 0);
+        assert(A || la == 0);
+        assert(C || !P);
+
+        process(N, P, lp, A, la, C, true, T);
+    }
+
+    bool ChaCha20Poly1305::open(
+        const uint8_t N[kNonceSize],
+        const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+        const uint8_t T[kTagSize], uint8_t* P) const
+    {
+        assert(isValid());
+        assert(N && T);
+        assert(C || lc == 0);
+        assert(A || la == 0);
+        assert(P || !C);
+
+        uint8_t S[kTagSize];
+        process(N, C, lc, A, la, P, false, S);
+
+        uint8_t diff = 0;
+        for (size_t i = 0; i < kTagSize; ++i) {
+            diff |= S[i] ^ T[i];
+        }
+        if (diff != 0) {
+            if (lc != 0) {
+                std::memset(P, 0, lc);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void ChaCha20Poly1305::process(
+        const uint8_t N[kNonceSize],
+        const uint8_t* in, size_t len, const uint8_t* A, size_t la,
+        uint8_t* out, bool encrypt, uint8_t T[kTagSize]) const
+    {
+        // Section 2.6，一次性密钥为计数器 0 的密钥流的前 32 字节
+        uint8_t otk[ChaCha20::kBlockSize];
+        ChaCha20::block(key_, 0, N, otk);
+
+        Poly1305 poly;
+        poly.init(otk);
+        if (la != 0) {
+            poly.update(A, la);
+            poly.padToBlock();
+        }
+
+        // 每段先加密再对密文计算 MAC (解密时顺序相反)，段的长度为块长度的整数倍
+        const size_t kChunkSize = ChaCha20::kBlockSize * 8;
+        uint32_t counter = 1;
+        size_t remaining = len;
+        while (remaining > 0) {
+            size_t n = remaining < kChunkSize ? remaining : kChunkSize;
+            if (encrypt) {
+                ChaCha20::encrypt(key_, counter, N, in, n, out);
+                poly.update(out, n);
+            } else {
+                poly.update(in, n);
+                ChaCha20::encrypt(key_, counter, N, in, n, out);
+            }
+            counter += uint32_t(n / ChaCha20::kBlockSize);
+            in += n;
+            out += n;
+            remaining -= n;
+        }
+        poly.padToBlock();
+
+        uint8_t lens[16];
+        for (int i = 0; i < 8; ++i) {
+            lens[i] = uint8_t(uint64_t(la) >> (8 * i));
+            lens[8 + i] = uint8_t(uint64_t(len) >> (8 * i));
+        }
+        poly.update(lens, 16);
+        poly.finish(T);
+    }
+
+
+    CCMContext::CCMContext() {}
+
+    bool CCMContext::init(const uint8_t* K, size_t lk) {
+        assert(K && lk != 0);
+
+        if (!key_.init(K, uint32_t(lk))) {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+    void CCMContext::clear() {
+        key_.clear();
+    }
+
+    bool CCMContext::isValid() const {
+        return key_.isValid();
+    }
+
+    void CCMContext::seal(
+        const uint8_t* N, size_t ln,
+        const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+        uint8_t* C, uint8_t* T, size_t t) const
+    {
+        assert(isValid());
+        assert(N && T);
+        assert(P || lp == 0);
+        assert(A || la == 0);
+        assert(C || !P);
+
+        uint8_t S[16];
+        process(N, ln, P, lp, A, la, C, true, t, S);
+        std::memcpy(T, S, t);
+    }
+
+    bool CCMContext::open(
+        const uint8_t* N, size_t ln,
+        const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+        const uint8_t* T, size_t t, uint8_t* P) const
+    {
+        assert(isValid());
+        assert(N && T);
+        assert(C || lc == 0);
+        assert(A || la == 0);
+        assert(P || !C);
+
+        uint8_t S[16];
+        process(N, ln, C, lc, A, la, P, false, t, S);
+
+        uint8_t diff = 0;
+        for (size_t i = 0; i < t; ++i) {
+            diff |= S[i] ^ T[i];
+        }
+        if (diff != 0) {
+            if (lc != 0) {
+                std::memset(P, 0, lc);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void CCMContext::process(
+        const uint8_t* N, size_t ln,
+        const uint8_t* in, size_t len, const uint8_t* A, size_t la,
+        uint8_t* out, bool encrypt, size_t t, uint8_t S[16]) const
+    {
+        assert(ln >= 7 && ln <= 13);
+        assert(t >= 4 && t <= 16 && t % 2 == 0);
+
+        // 长度字段 Q 占 q 字节，计数器也占 q 字节。
+        // len < 2^(8q) 保证计数器不会溢出到 nonce 中，因此可以直接使用 inc32
+        size_t q = 15 - ln;
+        assert(q >= 8 || uint64_t(len) < (uint64_t(1) << (8 * q)));
+        assert(uint64_t(len) < (uint64_t(1) << 36));
+
+        // A.2.1 B0 = Flags || N || Q
+        uint8_t Y[16];
+        Y[0] = uint8_t(((la > 0) ? 0x40 : 0) | (((t - 2) / 2) << 3) | (q - 1));
+        std::memcpy(Y + 1, N, ln);
+        uint64_t Q = len;
+        for (size_t i = 0; i < q; ++i) {
+            Y[15 - i] = uint8_t(Q);
+            Q >>= 8;
+        }
+        AES::encrypt(Y, Y, key_);
+
+        // A.2.2 AAD 前面加上其长度的编码，整体以 0 补齐到块长度
+        if (la > 0) {
+            uint8_t block[16];
+            size_t pos;
+            if (la < 0xFF00) {
+                block[0] = uint8_t(la >> 8);
+                block[1] = uint8_t(la);
+                pos = 2;
+            } else if (uint64_t(la) <= 0xFFFFFFFFu) {
+                block[0] = 0xFF;
+                block[1] = 0xFE;
+                for (int i = 0; i < 4; ++i) {
+                    block[2 + i] = uint8_t(uint64_t(la) >> (8 * (3 - i)));
+                }
+                pos = 6;
+            } else {
+                block[0] = 0xFF;
+                block[1] = 0xFF;
+                store64BE(uint64_t(la), block + 2);
+                pos = 10;
+            }
+
+            while (la > 0) {
+                size_t n = 16 - pos;
+                if (n > la) {
+                    n = la;
+                }
+                std::memcpy(block + pos, A, n);
+                pos += n;
+                A += n;
+                la -= n;
+                if (pos == 16 || la == 0) {
+                    for (size_t i = 0; i < pos; ++i) {
+                        Y[i] ^= block[i];
+                    }
+                    AES::encrypt(Y, Y, key_);
+                    pos = 0;
+                }
+            }
+        }
+
+        // A.3 Ctr_i = Flags || N || [i]q，载荷从 Ctr1 开始
+        uint8_t CB[16];
+        CB[0] = uint8_t(q - 1);
+        std::memcpy(CB + 1, N, ln);
+        std::memset(CB + 1 + ln, 0, q);
+        addCounter(CB, 1);
+
+        size_t full = len - len % 16;
+        if (full > 0) {
+            AES::encryptCCM(CB, Y, in, full, out, encrypt, key_);
+            addCounter(CB, full / 16);
+        }
+
+        // 最后不完整的块，明文以 0 补齐后计入 MAC
+        size_t rem = len - full;
+        if (rem > 0) {
+            uint8_t ks[16];
+            AES::encrypt(CB, ks, key_);
+            for (size_t i = 0; i < rem; ++i) {
+                uint8_t p = encrypt ? in[full + i] : uint8_t(in[full + i] ^ ks[i]);
+                out[full + i] = in[full + i] ^ ks[i];
+                Y[i] ^= p;
+            }
+            AES::encrypt(Y, Y, key_);
+        }
+
+        // T = MSB_t(Y) ^ MSB_t(CIPH(Ctr0))
+        uint8_t S0[16];
+        std::memset(CB + 16 - q, 0, q);
+        AES::encrypt(CB, S0, key_);
+        for (int i = 0; i < 16; ++i) {
+            S[i] = Y[i] ^ S0[i];
+        }
+    }
+
+}
 }
-}
\ No newline at end of file
@@ -7,14 +7,18 @@
 #ifndef AKASH_SECURITY_CRYPTO_AEAD_H_
 #define AKASH_SECURITY_CRYPTO_AEAD_H_
 
+#include <cstddef>
 #include <cstdint>
 
+#include "akash/security/crypto/aes.h"
+
 
 namespace akash {
 namespace crypto {
 
     // NIST Special Publication 800-38D
     // Based on AES.
+    // AES 使用 AESNI 实现时，GCTR 与 GHASH 改用 AES-NI 和 PCLMULQDQ 指令。
     class GCM {
     public:
         /**
@@ -47,6 +51,19 @@ namespace crypto {
             const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
             const uint8_t* T, size_t t, uint8_t* P);
 
+        /**
+         * 使用已扩展的 AES 密钥加密/解密，其余参数同上。
+         * 同一密钥多次调用时可避免重复扩展密钥。
+         */
+        static void GCM_AE(
+            const AESKey& key, const uint8_t* IV, size_t l_iv,
+            const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+            uint8_t* C, uint8_t* T, size_t t);
+        static bool GCM_AD(
+            const AESKey& key, const uint8_t* IV, size_t l_iv,
+            const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+            const uint8_t* T, size_t t, uint8_t* P);
+
     private:
         static const uint64_t kLenPMin = 0;
         static const uint64_t kLenPMax = (uint64_t(1) << 39) - 256;
@@ -72,23 +89,235 @@ namespace crypto {
 
         /**
          * 计算 X 的 GCTR 值，其中使用 AES 加密/解密。
-         * K 指向 AES Key，不能为空指针。lk 必须为可用的密钥长度。
+         * key 为已扩展的 AES 密钥。
          * 块 ICB 的长度固定。
          * X 可以为空指针，但同时 lx 必须为 0。
          * r 的长度应等于 lx。
          */
         static void GCTR(
-            const uint8_t* K, size_t lk,
+            const AESKey& key,
             const uint8_t ICB[16], const uint8_t* X, size_t lx, uint8_t* r);
 
         /**
          * 块加密/解密。使用 AES。
-         * K 指向 AES Key，不能为空指针。lk 必须为可用的密钥长度。
+         * key 为已扩展的 AES 密钥。
          * 块 CB 的长度固定，r 的长度应等于该长度。
          */
         static void CIPH(
-            const uint8_t* K, size_t lk, const uint8_t CB[16], uint8_t* r);
+            const AESKey& key, const uint8_t CB[16], uint8_t* r);
+
+    };
+
+    // 同一密钥多次使用的 GCM，例如 TLS 中每个 epoch 的流量密钥。
+    // 初始化时扩展 AES 密钥，并计算 H = CIPH(0) 以及 GHASH 使用的
+    // 4 位 Shoup 查找表，之后每次 seal/open 不再重复这些计算。
+    // 初始化时 AES 的实现方式为 AESNI 时，GHASH 改用 PCLMULQDQ 指令，之后不随 AES::setImpl 改变。
+    class GCMContext {
+    public:
+        GCMContext();
+
+        /**
+         * 使用 AES 密钥初始化。
+         * K 指向 AES Key，不能为空指针。lk 不是可用的密钥长度时返回 false。
+         */
+        bool init(const uint8_t* K, size_t lk);
+        void clear();
+        bool isValid() const;
+
+        /**
+         * 加密，参数含义同 GCM::GCM_AE。C 可以与 P 相同。
+         */
+        void seal(
+            const uint8_t* IV, size_t l_iv,
+            const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+            uint8_t* C, uint8_t* T, size_t t) const;
+
+        /**
+         * 解密，参数含义同 GCM::GCM_AD。P 可以与 C 相同。
+         * 解密与校验在同一遍中完成，校验失败时返回 false，并将 P 清零。
+         */
+        bool open(
+            const uint8_t* IV, size_t l_iv,
+            const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+            const uint8_t* T, size_t t, uint8_t* P) const;
+
+    private:
+        friend class GCMStream;
+
+        // Y = Y * H
+        void mulH(uint8_t Y[16]) const;
+        // 将 X 按块累积到 Y 上，最后不完整的块以 0 补齐
+        void ghash(uint8_t Y[16], const uint8_t* X, size_t lx) const;
+        void computeJ0(const uint8_t* IV, size_t l_iv, uint8_t J0[16]) const;
+
+        AESKey key_;
+        uint8_t H_[16];
+        // Shoup 表：HH_[i]:HL_[i] = i * H，i 为 4 位的多项式
+        uint64_t HL_[16];
+        uint64_t HH_[16];
+        // PCLMULQDQ 使用的 H 的幂，key_ 不使用 AESNI 时不计算也不使用
+        uint8_t Htable_[16 * 4];
+    };
+
+    // 单条消息的流式 GCM 加密/解密，不分配堆内存。
+    // 依次调用 init、updateAAD (可多次)、update (可多次)、finish/verify。
+    // update 将 CTR 与 GHASH 按小段交替进行，数据只需经过一遍缓存；
+    // 分散在多个缓冲区中的数据依次调用 update 即可。
+    // ctx 在使用期间必须保持有效。
+    class GCMStream {
+    public:
+        explicit GCMStream(const GCMContext& ctx);
+
+        /**
+         * 开始一条新的消息。IV 为初始向量，不能为空指针。
+         * encrypt 为 true 时 update 执行加密，否则执行解密。
+         */
+        void init(const uint8_t* IV, size_t l_iv, bool encrypt);
+
+        /**
+         * 追加 AAD，必须在第一次 update 之前调用。
+         */
+        void updateAAD(const uint8_t* A, size_t la);
+
+        /**
+         * 加密/解密 len 字节，out 的长度应等于 len，可以与 in 相同。
+         */
+        void update(const uint8_t* in, size_t len, uint8_t* out);
+
+        /**
+         * 输出长度为 t 的认证标签，t 不应大于块长度。
+         */
+        void finish(uint8_t* T, size_t t);
+
+        /**
+         * 用于解密。计算认证标签并与 T 的前 t 字节比较，比较时间与内容无关。
+         */
+        bool verify(const uint8_t* T, size_t t);
+
+    private:
+        // 将 X 计入 GHASH，不足一块的部分暂存在 buf_ 中
+        void absorb(const uint8_t* X, size_t lx);
+        // 将 buf_ 中不完整的块补 0 后计入 GHASH
+        void flushBlock();
+        // 结束 AAD，开始处理密文
+        void endAAD();
+        void computeTag(uint8_t S[16]);
+
+        const GCMContext& ctx_;
+        uint8_t J0_[16];
+        // 下一个要加密的计数器块
+        uint8_t CB_[16];
+        // 当前的密钥流块，ks_pos_ 为已使用的字节数
+        uint8_t ks_[16];
+        size_t ks_pos_ = 16;
+        uint8_t Y_[16];
+        uint8_t buf_[16];
+        size_t buf_len_ = 0;
+        size_t la_ = 0;
+        size_t lc_ = 0;
+        bool encrypt_ = true;
+        bool aad_done_ = false;
+    };
+
+    // RFC 8439 中的 ChaCha20-Poly1305。
+    // 密钥为 32 字节，nonce 为 12 字节，标签为 16 字节。
+    // 加密与 MAC 按小段交替进行，不分配堆内存。
+    class ChaCha20Poly1305 {
+    public:
+        static const size_t kKeySize = 32;
+        static const size_t kNonceSize = 12;
+        static const size_t kTagSize = 16;
+
+        ChaCha20Poly1305();
+
+        /**
+         * K 指向密钥，不能为空指针。lk 不等于 kKeySize 时返回 false。
+         */
+        bool init(const uint8_t* K, size_t lk);
+        void clear();
+        bool isValid() const;
+
+        /**
+         * 加密。N 为 nonce，不能为空指针。
+         * P 为待加密的明文，可以为空指针，但同时 lp 必须为 0。
+         * A 为额外的已认证数据 (AAD)，可以为空指针，但同时 la 必须为 0。
+         * C 为密文，长度应等于 lp，可以与 P 相同。
+         * T 为认证标签，长度为 kTagSize。
+         */
+        void seal(
+            const uint8_t N[kNonceSize],
+            const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+            uint8_t* C, uint8_t T[kTagSize]) const;
+
+        /**
+         * 解密，参数含义同 seal。P 可以与 C 相同。
+         * 标签不匹配时返回 false，并将 P 清零。
+         */
+        bool open(
+            const uint8_t N[kNonceSize],
+            const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+            const uint8_t T[kTagSize], uint8_t* P) const;
+
+    private:
+        // 计算 Poly1305 标签，encrypt 为 true 时同时加密 in 并写入 out
+        void process(
+            const uint8_t N[kNonceSize],
+            const uint8_t* in, size_t len, const uint8_t* A, size_t la,
+            uint8_t* out, bool encrypt, uint8_t T[kTagSize]) const;
+
+        uint8_t key_[kKeySize];
+        bool is_valid_ = false;
+    };
+
+    // NIST Special Publication 800-38C
+    // 同一密钥多次使用的 CCM，初始化时扩展一次 AES 密钥。
+    // nonce 长度为 7~13 字节，标签长度为 4~16 之间的偶数，
+    // TLS 中 CCM 使用 16 字节标签，CCM_8 使用 8 字节标签。
+    // CTR 与 CBC-MAC 在同一遍中完成；AES 使用 AESNI 实现时两条链交错执行。
+    class CCMContext {
+    public:
+        CCMContext();
+
+        /**
+         * 使用 AES 密钥初始化。
+         * K 指向 AES Key，不能为空指针。lk 不是可用的密钥长度时返回 false。
+         */
+        bool init(const uint8_t* K, size_t lk);
+        void clear();
+        bool isValid() const;
+
+        /**
+         * 加密。N 为 nonce，不能为空指针，ln 为其长度。
+         * P 为待加密的明文，可以为空指针，但同时 lp 必须为 0。
+         * lp 必须小于 2^(8q)，其中 q = 15 - ln。
+         * A 为额外的已认证数据 (AAD)，可以为空指针，但同时 la 必须为 0。
+         * C 为密文，长度应等于 lp，可以与 P 相同。
+         * T 为认证标签，长度为 t。
+         */
+        void seal(
+            const uint8_t* N, size_t ln,
+            const uint8_t* P, size_t lp, const uint8_t* A, size_t la,
+            uint8_t* C, uint8_t* T, size_t t) const;
+
+        /**
+         * 解密，参数含义同 seal。P 可以与 C 相同。
+         * 标签不匹配时返回 false，并将 P 清零。
+         */
+        bool open(
+            const uint8_t* N, size_t ln,
+            const uint8_t* C, size_t lc, const uint8_t* A, size_t la,
+            const uint8_t* T, size_t t, uint8_t* P) const;
+
+    private:
+        /**
+         * 计算 MAC 的同时加密/解密，S 为 CBC-MAC 与 Ctr0 密钥流异或后的完整块。
+         */
+        void process(
+            const uint8_t* N, size_t ln,
+            const uint8_t* in, size_t len, const uint8_t* A, size_t la,
+            uint8_t* out, bool encrypt, size_t t, uint8_t S[16]) const;
 
+        AESKey key_;
     };
 
 }
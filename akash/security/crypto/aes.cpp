@@ -7,7 +7,11 @@
 #include "aes.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstring>
+
+#include "akash/security/crypto/aesni.h"
 
 
 static const uint8_t SBox[16][16] = {
@@ -50,75 +54,558 @@ static const uint8_t InvSBox[16][16] = {
 /*f*/ {0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d},
 };
 
+namespace {
+
+    // 只在 AESKey::init 时读取，运算过程中使用密钥保存的实现方式。
+    // 没有 AES-NI 时默认使用位切片实现，TTable 的查表会通过缓存时序泄露密钥
+    std::atomic<akash::crypto::AES::Impl> impl_(
+        akash::crypto::AESNI::isSupported() ?
+        akash::crypto::AES::Impl::AESNI : akash::crypto::AES::Impl::Bitsliced);
+
+    uint32_t load32LE(const uint8_t* in) {
+        return uint32_t(in[0]) |
+            (uint32_t(in[1]) << 8) |
+            (uint32_t(in[2]) << 16) |
+            (uint32_t(in[3]) << 24);
+    }
+
+    void store32LE(uint32_t v, uint8_t* out) {
+        out[0] = uint8_t(v);
+        out[1] = uint8_t(v >> 8);
+        out[2] = uint8_t(v >> 16);
+        out[3] = uint8_t(v >> 24);
+    }
+
+    uint32_t swap32(uint32_t v) {
+        return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+    }
+
+
+    // 以下的位切片实现参考 BearSSL 中的 aes_ct64。
+    // 8 个 uint64_t 组成 4 个块的位平面，q[i] 保存所有字节的第 i 位。
+
+    void swapBits(uint64_t cl, uint64_t ch, int s, uint64_t* x, uint64_t* y) {
+        uint64_t a = *x;
+        uint64_t b = *y;
+        *x = (a & cl) | ((b & cl) << s);
+        *y = ((a & ch) >> s) | (b & ch);
+    }
+
+    // 在字节表示与位平面表示之间转换，该操作是自逆的
+    void ortho(uint64_t q[8]) {
+        for (int i = 0; i < 8; i += 2) {
+            swapBits(0x5555555555555555, 0xAAAAAAAAAAAAAAAA, 1, &q[i], &q[i + 1]);
+        }
+
+        swapBits(0x3333333333333333, 0xCCCCCCCCCCCCCCCC, 2, &q[0], &q[2]);
+        swapBits(0x3333333333333333, 0xCCCCCCCCCCCCCCCC, 2, &q[1], &q[3]);
+        swapBits(0x3333333333333333, 0xCCCCCCCCCCCCCCCC, 2, &q[4], &q[6]);
+        swapBits(0x3333333333333333, 0xCCCCCCCCCCCCCCCC, 2, &q[5], &q[7]);
+
+        for (int i = 0; i < 4; ++i) {
+            swapBits(0x0F0F0F0F0F0F0F0F, 0xF0F0F0F0F0F0F0F0, 4, &q[i], &q[i + 4]);
+        }
+    }
+
+    // 将一个块 (4 个小端序字) 分散到 q0 和 q1 中
+    void interleaveIn(const uint32_t w[4], uint64_t* q0, uint64_t* q1) {
+        uint64_t x[4];
+        for (int i = 0; i < 4; ++i) {
+            x[i] = w[i];
+            x[i] |= (x[i] << 16);
+            x[i] &= 0x0000FFFF0000FFFF;
+            x[i] |= (x[i] << 8);
+            x[i] &= 0x00FF00FF00FF00FF;
+        }
+        *q0 = x[0] | (x[2] << 8);
+        *q1 = x[1] | (x[3] << 8);
+    }
+
+    void interleaveOut(uint64_t q0, uint64_t q1, uint32_t w[4]) {
+        uint64_t x[4];
+        x[0] = q0 & 0x00FF00FF00FF00FF;
+        x[1] = q1 & 0x00FF00FF00FF00FF;
+        x[2] = (q0 >> 8) & 0x00FF00FF00FF00FF;
+        x[3] = (q1 >> 8) & 0x00FF00FF00FF00FF;
+        for (int i = 0; i < 4; ++i) {
+            x[i] |= (x[i] >> 8);
+            x[i] &= 0x0000FFFF0000FFFF;
+            w[i] = uint32_t(x[i]) | uint32_t(x[i] >> 16);
+        }
+    }
+
+    // S 盒的布尔电路 (Boyar-Peralta)，113 个门
+    void bitsliceSBox(uint64_t q[8]) {
+        uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+        uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+        uint64_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+        uint64_t y20, y21;
+        uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+        uint64_t z10, z11, z12, z13, z14, z15, z16, z17;
+        uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+        uint64_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+        uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+        uint64_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+        uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+        uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+        uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+        uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+        x0 = q[7];
+        x1 = q[6];
+        x2 = q[5];
+        x3 = q[4];
+        x4 = q[3];
+        x5 = q[2];
+        x6 = q[1];
+        x7 = q[0];
+
+        // 顶部线性变换
+        y14 = x3 ^ x5;
+        y13 = x0 ^ x6;
+        y9 = x0 ^ x3;
+        y8 = x0 ^ x5;
+        t0 = x1 ^ x2;
+        y1 = t0 ^ x7;
+        y4 = y1 ^ x3;
+        y12 = y13 ^ y14;
+        y2 = y1 ^ x0;
+        y5 = y1 ^ x6;
+        y3 = y5 ^ y8;
+        t1 = x4 ^ y12;
+        y15 = t1 ^ x5;
+        y20 = t1 ^ x1;
+        y6 = y15 ^ x7;
+        y10 = y15 ^ t0;
+        y11 = y20 ^ y9;
+        y7 = x7 ^ y11;
+        y17 = y10 ^ y11;
+        y19 = y10 ^ y8;
+        y16 = t0 ^ y11;
+        y21 = y13 ^ y16;
+        y18 = x0 ^ y16;
+
+        // 非线性部分
+        t2 = y12 & y15;
+        t3 = y3 & y6;
+        t4 = t3 ^ t2;
+        t5 = y4 & x7;
+        t6 = t5 ^ t2;
+        t7 = y13 & y16;
+        t8 = y5 & y1;
+        t9 = t8 ^ t7;
+        t10 = y2 & y7;
+        t11 = t10 ^ t7;
+        t12 = y9 & y11;
+        t13 = y14 & y17;
+        t14 = t13 ^ t12;
+        t15 = y8 & y10;
+        t16 = t15 ^ t12;
+        t17 = t4 ^ t14;
+        t18 = t6 ^ t16;
+        t19 = t9 ^ t14;
+        t20 = t11 ^ t16;
+        t21 = t17 ^ y20;
+        t22 = t18 ^ y19;
+        t23 = t19 ^ y21;
+        t24 = t20 ^ y18;
+
+        t25 = t21 ^ t22;
+        t26 = t21 & t23;
+        t27 = t24 ^ t26;
+        t28 = t25 & t27;
+        t29 = t28 ^ t22;
+        t30 = t23 ^ t24;
+        t31 = t22 ^ t26;
+        t32 = t31 & t30;
+        t33 = t32 ^ t24;
+        t34 = t23 ^ t33;
+        t35 = t27 ^ t33;
+        t36 = t24 & t35;
+        t37 = t36 ^ t34;
+        t38 = t27 ^ t36;
+        t39 = t29 & t38;
+        t40 = t25 ^ t39;
+
+        t41 = t40 ^ t37;
+        t42 = t29 ^ t33;
+        t43 = t29 ^ t40;
+        t44 = t33 ^ t37;
+        t45 = t42 ^ t41;
+        z0 = t44 & y15;
+        z1 = t37 & y6;
+        z2 = t33 & x7;
+        z3 = t43 & y16;
+        z4 = t40 & y1;
+        z5 = t29 & y7;
+        z6 = t42 & y11;
+        z7 = t45 & y17;
+        z8 = t41 & y10;
+        z9 = t44 & y12;
+        z10 = t37 & y3;
+        z11 = t33 & y4;
+        z12 = t43 & y13;
+        z13 = t40 & y5;
+        z14 = t29 & y2;
+        z15 = t42 & y9;
+        z16 = t45 & y14;
+        z17 = t41 & y8;
+
+        // 底部线性变换
+        t46 = z15 ^ z16;
+        t47 = z10 ^ z11;
+        t48 = z5 ^ z13;
+        t49 = z9 ^ z10;
+        t50 = z2 ^ z12;
+        t51 = z2 ^ z5;
+        t52 = z7 ^ z8;
+        t53 = z0 ^ z3;
+        t54 = z6 ^ z7;
+        t55 = z16 ^ z17;
+        t56 = z12 ^ t48;
+        t57 = t50 ^ t53;
+        t58 = z4 ^ t46;
+        t59 = z3 ^ t54;
+        t60 = t46 ^ t57;
+        t61 = z14 ^ t57;
+        t62 = t52 ^ t58;
+        t63 = t49 ^ t58;
+        t64 = z4 ^ t59;
+        t65 = t61 ^ t62;
+        t66 = z1 ^ t63;
+        s0 = t59 ^ t63;
+        s6 = t56 ^ ~t62;
+        s7 = t48 ^ ~t60;
+        t67 = t64 ^ t65;
+        s3 = t53 ^ t66;
+        s4 = t51 ^ t66;
+        s5 = t47 ^ t65;
+        s1 = t64 ^ ~s3;
+        s2 = t55 ^ ~t67;
+
+        q[7] = s0;
+        q[6] = s1;
+        q[5] = s2;
+        q[4] = s3;
+        q[3] = s4;
+        q[2] = s5;
+        q[1] = s6;
+        q[0] = s7;
+    }
+
+    void bitsliceShiftRows(uint64_t q[8]) {
+        for (int i = 0; i < 8; ++i) {
+            uint64_t x = q[i];
+            q[i] = (x & 0x000000000000FFFF) |
+                ((x & 0x00000000FFF00000) >> 4) |
+                ((x & 0x00000000000F0000) << 12) |
+                ((x & 0x0000FF0000000000) >> 8) |
+                ((x & 0x000000FF00000000) << 8) |
+                ((x & 0xF000000000000000) >> 12) |
+                ((x & 0x0FFF000000000000) << 4);
+        }
+    }
+
+    uint64_t rotr32(uint64_t x) {
+        return (x << 32) | (x >> 32);
+    }
+
+    void bitsliceMixColumns(uint64_t q[8]) {
+        uint64_t r[8];
+        for (int i = 0; i < 8; ++i) {
+            r[i] = (q[i] >> 16) | (q[i] << 48);
+        }
+
+        uint64_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+        uint64_t q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+        q[0] = q7 ^ r[7] ^ r[0] ^ rotr32(q0 ^ r[0]);
+        q[1] = q0 ^ r[0] ^ q7 ^ r[7] ^ r[1] ^ rotr32(q1 ^ r[1]);
+        q[2] = q1 ^ r[1] ^ r[2] ^ rotr32(q2 ^ r[2]);
+        q[3] = q2 ^ r[2] ^ q7 ^ r[7] ^ r[3] ^ rotr32(q3 ^ r[3]);
+        q[4] = q3 ^ r[3] ^ q7 ^ r[7] ^ r[4] ^ rotr32(q4 ^ r[4]);
+        q[5] = q4 ^ r[4] ^ r[5] ^ rotr32(q5 ^ r[5]);
+        q[6] = q5 ^ r[5] ^ r[6] ^ rotr32(q6 ^ r[6]);
+        q[7] = q6 ^ r[6] ^ r[7] ^ rotr32(q7 ^ r[7]);
+    }
+
+    void bitsliceAddRoundKey(uint64_t q[8], const uint64_t* sk) {
+        for (int i = 0; i < 8; ++i) {
+            q[i] ^= sk[i];
+        }
+    }
+
+    // 旧接口每次调用都传入原始密钥。缓存同一线程最近一次扩展的密钥，
+    // 用同一个密钥连续调用时不再重复扩展
+    const akash::crypto::AESKey* getCachedKey(const uint8_t* key, uint32_t length) {
+        struct Cache {
+            uint8_t key[32];
+            uint32_t length = 0;
+            akash::crypto::AESKey expanded;
+        };
+        thread_local Cache cache;
+
+        if (length > sizeof(cache.key)) {
+            return nullptr;
+        }
+
+        // 比较时不提前退出
+        uint8_t diff = 0;
+        if (length == cache.length) {
+            for (uint32_t i = 0; i < length; ++i) {
+                diff |= cache.key[i] ^ key[i];
+            }
+        }
+        if (!cache.expanded.isValid() || length != cache.length || diff != 0 ||
+            cache.expanded.getImpl() != akash::crypto::AES::getImpl())
+        {
+            if (!cache.expanded.init(key, length)) {
+                cache.length = 0;
+                return nullptr;
+            }
+            std::memcpy(cache.key, key, length);
+            cache.length = length;
+        }
+        return &cache.expanded;
+    }
+
+}
+
 namespace akash {
 namespace crypto {
 
+    void AES::setImpl(Impl impl) {
+        if (impl == Impl::AESNI && !AESNI::isSupported()) {
+            return;
+        }
+        impl_.store(impl, std::memory_order_relaxed);
+    }
+
+    AES::Impl AES::getImpl() {
+        return impl_.load(std::memory_order_relaxed);
+    }
+
     void AES::encrypt(
         const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
         const uint8_t* key, uint32_t length)
     {
-        uint32_t Nr = getNr(length / 4, Nb);
-        switch (Nr) {
-        case 10:
-        {
-            uint32_t key_exp[Nb * (10 + 1)];
-            keyExpansion(key, length, key_exp);
-            encrypt(in, out, key_exp, Nr);
-            break;
-        }
-        case 12:
-        {
-            uint32_t key_exp[Nb * (12 + 1)];
-            keyExpansion(key, length, key_exp);
-            encrypt(in, out, key_exp, Nr);
-            break;
-        }
-        case 14:
-        {
-            uint32_t key_exp[Nb * (14 + 1)];
-            keyExpansion(key, length, key_exp);
-            encrypt(in, out, key_exp, Nr);
-            break;
+        encryptBlocks(in, out, 1, key, length);
+    }
+
+    void AES::decrypt(
+        const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
+        const uint8_t* key, uint32_t length)
+    {
+        auto k = getCachedKey(key, length);
+        if (!k) {
+            assert(false);
+            return;
         }
-        default:
+        decryptBlocks(in, out, 1, *k);
+    }
+
+    void AES::encryptBlocks(
+        const uint8_t* in, uint8_t* out, size_t count,
+        const uint8_t* key, uint32_t length)
+    {
+        auto k = getCachedKey(key, length);
+        if (!k) {
             assert(false);
-            break;
+            return;
         }
+        encryptBlocks(in, out, count, *k);
+    }
+
+    void AES::encrypt(
+        const uint8_t in[4 * Nb], uint8_t out[4 * Nb], const AESKey& key)
+    {
+        encryptBlocks(in, out, 1, key);
     }
 
     void AES::decrypt(
-        const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
-        const uint8_t* key, uint32_t length)
+        const uint8_t in[4 * Nb], uint8_t out[4 * Nb], const AESKey& key)
     {
-        uint32_t Nr = getNr(length / 4, Nb);
-        switch (Nr) {
-        case 10:
-        {
-            uint32_t key_exp[Nb * (10 + 1)];
-            keyExpansion(key, length, key_exp);
-            decrypt(in, out, key_exp, Nr);
+        decryptBlocks(in, out, 1, key);
+    }
+
+    void AES::encryptBlocks(
+        const uint8_t* in, uint8_t* out, size_t count, const AESKey& key)
+    {
+        assert(key.isValid());
+        uint32_t Nr = key.Nr_;
+
+        switch (key.impl_) {
+        case Impl::Reference:
+            for (size_t i = 0; i < count; ++i) {
+                encrypt(in + i * 4 * Nb, out + i * 4 * Nb, key.w_, Nr);
+            }
             break;
-        }
-        case 12:
-        {
-            uint32_t key_exp[Nb * (12 + 1)];
-            keyExpansion(key, length, key_exp);
-            decrypt(in, out, key_exp, Nr);
+
+        case Impl::TTable:
+            for (size_t i = 0; i < count; ++i) {
+                encryptTTable(in + i * 4 * Nb, out + i * 4 * Nb, key.w_, Nr);
+            }
             break;
-        }
-        case 14:
-        {
-            uint32_t key_exp[Nb * (14 + 1)];
-            keyExpansion(key, length, key_exp);
-            decrypt(in, out, key_exp, Nr);
+
+        case Impl::Bitsliced:
+            for (size_t i = 0; i < count; i += 4) {
+                size_t n = count - i < 4 ? count - i : 4;
+                encryptBitsliced(in + i * 4 * Nb, out + i * 4 * Nb, n, key.sk_, Nr);
+            }
             break;
-        }
+
+        case Impl::AESNI:
+            AESNI::encryptBlocks(key.rk_, Nr, in, out, count);
+            break;
+
         default:
             assert(false);
             break;
         }
     }
 
+    void AES::decryptBlocks(
+        const uint8_t* in, uint8_t* out, size_t count, const AESKey& key)
+    {
+        assert(key.isValid());
+        uint32_t Nr = key.Nr_;
+
+        if (key.impl_ == Impl::AESNI) {
+            AESNI::decryptBlocks(key.drk_, Nr, in, out, count);
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            decrypt(in + i * 4 * Nb, out + i * 4 * Nb, key.w_, Nr);
+        }
+    }
+
+    void AES::encryptCTR32(
+        const uint8_t ICB[4 * Nb], const uint8_t* in, size_t len, uint8_t* out,
+        const AESKey& key)
+    {
+        assert(key.isValid());
+
+        if (key.impl_ == Impl::AESNI) {
+            AESNI::ctr32(key.rk_, key.Nr_, ICB, in, len, out);
+            return;
+        }
+
+        // 每次生成 8 个计数器块，一起加密后再与输入异或
+        const size_t kBatch = 8;
+        uint8_t CB[4 * Nb * kBatch];
+        uint8_t ks[4 * Nb * kBatch];
+
+        uint32_t ctr = bytesToUInt32(ICB + 12);
+        while (len > 0) {
+            size_t n = (len + 15) / 16;
+            if (n > kBatch) {
+                n = kBatch;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                std::memcpy(CB + i * 16, ICB, 12);
+                CB[i * 16 + 12] = uint8_t(ctr >> 24);
+                CB[i * 16 + 13] = uint8_t(ctr >> 16);
+                CB[i * 16 + 14] = uint8_t(ctr >> 8);
+                CB[i * 16 + 15] = uint8_t(ctr);
+                ++ctr;
+            }
+            encryptBlocks(CB, ks, n, key);
+
+            size_t m = len < n * 16 ? len : n * 16;
+            for (size_t i = 0; i < m; ++i) {
+                out[i] = in[i] ^ ks[i];
+            }
+            in += m;
+            out += m;
+            len -= m;
+        }
+    }
+
+    void AES::encryptCCM(
+        const uint8_t ICB[4 * Nb], uint8_t Y[4 * Nb],
+        const uint8_t* in, size_t len, uint8_t* out, bool encrypt,
+        const AESKey& key)
+    {
+        assert(key.isValid());
+        assert(len % 16 == 0);
+
+        if (key.impl_ == Impl::AESNI) {
+            AESNI::ccm(key.rk_, key.Nr_, ICB, Y, in, len, out, encrypt);
+            return;
+        }
+
+        // CBC-MAC 只能逐块计算。位切片实现一次加密 4 个块的开销与 1 个块相同，
+        // 因此每次计算 MAC 时用同一次调用的其余 3 个位置生成之后的 CTR 密钥流。
+        // 所有块都通过 encryptBlocks 使用密钥确定的实现方式
+        const size_t kLanes = 4;
+        uint8_t batch[4 * Nb * kLanes];
+        // 已生成但未使用的密钥流，从开头依次使用
+        uint8_t ks[4 * Nb * kLanes];
+        size_t ks_count = 0;
+
+        uint32_t ctr = bytesToUInt32(ICB + 12);
+        auto fillCounters = [&](uint8_t* dst, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                std::memcpy(dst + i * 16, ICB, 12);
+                dst[i * 16 + 12] = uint8_t(ctr >> 24);
+                dst[i * 16 + 13] = uint8_t(ctr >> 16);
+                dst[i * 16 + 14] = uint8_t(ctr >> 8);
+                dst[i * 16 + 15] = uint8_t(ctr);
+                ++ctr;
+            }
+        };
+
+        size_t blocks = len / 16;
+        for (size_t b = 0; b < blocks; ++b) {
+            uint8_t P[4 * Nb];
+            if (encrypt) {
+                std::memcpy(P, in + b * 16, 16);
+            } else {
+                // 解密时需要先得到明文，才能计算 MAC
+                if (ks_count == 0) {
+                    size_t n = std::min(blocks - b, kLanes);
+                    fillCounters(ks, n);
+                    encryptBlocks(ks, ks, n, key);
+                    ks_count = n;
+                }
+                for (size_t j = 0; j < 16; ++j) {
+                    P[j] = in[b * 16 + j] ^ ks[j];
+                }
+                std::memmove(ks, ks + 16, (ks_count - 1) * 16);
+                --ks_count;
+            }
+
+            // 第 0 个位置为 MAC，其余位置为尚未生成的密钥流
+            for (size_t j = 0; j < 16; ++j) {
+                batch[j] = Y[j] ^ P[j];
+            }
+            size_t pending = blocks - b - (encrypt ? 0 : 1);
+            size_t extra = 0;
+            if (pending > ks_count) {
+                extra = std::min(pending - ks_count, kLanes - std::max(ks_count, size_t(1)));
+            }
+            fillCounters(batch + 16, extra);
+            encryptBlocks(batch, batch, 1 + extra, key);
+
+            std::memcpy(Y, batch, 16);
+            std::memcpy(ks + ks_count * 16, batch + 16, extra * 16);
+            ks_count += extra;
+
+            if (encrypt) {
+                for (size_t j = 0; j < 16; ++j) {
+                    out[b * 16 + j] = P[j] ^ ks[j];
+                }
+                std::memmove(ks, ks + 16, (ks_count - 1) * 16);
+                --ks_count;
+            } else {
+                std::memcpy(out + b * 16, P, 16);
+            }
+        }
+
+        std::memset(ks, 0, sizeof(ks));
+        std::memset(batch, 0, sizeof(batch));
+    }
+
     void AES::encrypt(
         const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
         const uint32_t* w, uint32_t Nr)
@@ -185,6 +672,110 @@ namespace crypto {
         }
     }
 
+    void AES::encryptTTable(
+        const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
+        const uint32_t* w, uint32_t Nr)
+    {
+        // Te0[x] = (2·S[x], S[x], S[x], 3·S[x])，Te1~Te3 依次循环右移 8 位。
+        // 一轮中每列的 SubBytes、ShiftRows 和 MixColumns 变为 4 次查表和异或
+        struct Tables {
+            uint32_t Te[4][256];
+        };
+        static const Tables tables = [] {
+            Tables t;
+            for (int i = 0; i < 256; ++i) {
+                uint8_t s = getSBoxSubByte(uint8_t(i));
+                uint32_t v = (uint32_t(multi2(s)) << 24) |
+                    (uint32_t(s) << 16) |
+                    (uint32_t(s) << 8) |
+                    uint32_t(multi3(s));
+                t.Te[0][i] = v;
+                t.Te[1][i] = (v >> 8) | (v << 24);
+                t.Te[2][i] = (v >> 16) | (v << 16);
+                t.Te[3][i] = (v >> 24) | (v << 8);
+            }
+            return t;
+        }();
+
+        auto Te0 = tables.Te[0];
+        auto Te1 = tables.Te[1];
+        auto Te2 = tables.Te[2];
+        auto Te3 = tables.Te[3];
+
+        uint32_t s0 = bytesToUInt32(in) ^ w[0];
+        uint32_t s1 = bytesToUInt32(in + 4) ^ w[1];
+        uint32_t s2 = bytesToUInt32(in + 8) ^ w[2];
+        uint32_t s3 = bytesToUInt32(in + 12) ^ w[3];
+
+        uint32_t t0, t1, t2, t3;
+        for (uint32_t r = 1; r < Nr; ++r) {
+            const uint32_t* rk = w + r * Nb;
+            t0 = Te0[s0 >> 24] ^ Te1[(s1 >> 16) & 0xFF] ^ Te2[(s2 >> 8) & 0xFF] ^ Te3[s3 & 0xFF] ^ rk[0];
+            t1 = Te0[s1 >> 24] ^ Te1[(s2 >> 16) & 0xFF] ^ Te2[(s3 >> 8) & 0xFF] ^ Te3[s0 & 0xFF] ^ rk[1];
+            t2 = Te0[s2 >> 24] ^ Te1[(s3 >> 16) & 0xFF] ^ Te2[(s0 >> 8) & 0xFF] ^ Te3[s1 & 0xFF] ^ rk[2];
+            t3 = Te0[s3 >> 24] ^ Te1[(s0 >> 16) & 0xFF] ^ Te2[(s1 >> 8) & 0xFF] ^ Te3[s2 & 0xFF] ^ rk[3];
+            s0 = t0;
+            s1 = t1;
+            s2 = t2;
+            s3 = t3;
+        }
+
+        // 最后一轮没有 MixColumns
+        const uint32_t* rk = w + Nr * Nb;
+        uint32_t s[4] = { s0, s1, s2, s3 };
+        for (int c = 0; c < 4; ++c) {
+            uint32_t v =
+                (uint32_t(getSBoxSubByte(uint8_t(s[c] >> 24))) << 24) |
+                (uint32_t(getSBoxSubByte(uint8_t(s[(c + 1) % 4] >> 16))) << 16) |
+                (uint32_t(getSBoxSubByte(uint8_t(s[(c + 2) % 4] >> 8))) << 8) |
+                uint32_t(getSBoxSubByte(uint8_t(s[(c + 3) % 4])));
+            v ^= rk[c];
+            out[c * 4] = uint8_t(v >> 24);
+            out[c * 4 + 1] = uint8_t(v >> 16);
+            out[c * 4 + 2] = uint8_t(v >> 8);
+            out[c * 4 + 3] = uint8_t(v);
+        }
+    }
+
+    void AES::encryptBitsliced(
+        const uint8_t* in, uint8_t* out, size_t count,
+        const uint64_t* sk, uint32_t Nr)
+    {
+        assert(count <= 4);
+
+        // 不足 4 块时以 0 填充
+        uint32_t w[16] = { 0 };
+        for (size_t i = 0; i < count * 4; ++i) {
+            w[i] = load32LE(in + i * 4);
+        }
+
+        uint64_t q[8];
+        for (int i = 0; i < 4; ++i) {
+            interleaveIn(w + i * 4, &q[i], &q[i + 4]);
+        }
+        ortho(q);
+
+        bitsliceAddRoundKey(q, sk);
+        for (uint32_t r = 1; r < Nr; ++r) {
+            bitsliceSBox(q);
+            bitsliceShiftRows(q);
+            bitsliceMixColumns(q);
+            bitsliceAddRoundKey(q, sk + r * 8);
+        }
+        bitsliceSBox(q);
+        bitsliceShiftRows(q);
+        bitsliceAddRoundKey(q, sk + Nr * 8);
+
+        ortho(q);
+        for (int i = 0; i < 4; ++i) {
+            interleaveOut(q[i], q[i + 4], w + i * 4);
+        }
+
+        for (size_t i = 0; i < count * 4; ++i) {
+            store32LE(w[i], out + i * 4);
+        }
+    }
+
     void AES::subBytes(Context* context) {
         for (int i = 0; i < 4 * Nb; ++i) {
             context->state[i] = getSBoxSubByte(context->state[i]);
@@ -342,6 +933,24 @@ namespace crypto {
         }
     }
 
+    void AES::keyExpansionBitsliced(
+        const uint32_t* w, uint32_t Nr, uint64_t* sk)
+    {
+        // 将每轮的轮密钥当作 4 个相同的块转换为位平面
+        for (uint32_t r = 0; r <= Nr; ++r) {
+            uint32_t rk[4];
+            for (int i = 0; i < 4; ++i) {
+                rk[i] = swap32(w[r * Nb + i]);
+            }
+
+            uint64_t* q = sk + r * 8;
+            interleaveIn(rk, &q[0], &q[4]);
+            q[1] = q[2] = q[3] = q[0];
+            q[5] = q[6] = q[7] = q[4];
+            ortho(q);
+        }
+    }
+
     uint8_t AES::getSBoxSubByte(uint8_t org) {
         uint8_t x = (org >> 4) & 0xF;
         uint8_t y = org & 0xF;
@@ -375,11 +984,12 @@ namespace crypto {
     }
 
     uint32_t AES::subWord(uint32_t word) {
-        uint32_t result = 0;
-        for (int i = 0; i < 4; ++i) {
-            result |= (static_cast<uint32_t>(getSBoxSubByte((word >> i * 8) & 0xFF)) << i * 8);
-        }
-        return result;
+        // 使用位切片的 S 盒，密钥扩展时不以密钥字节为下标查表
+        uint64_t q[8] = { word };
+        ortho(q);
+        bitsliceSBox(q);
+        ortho(q);
+        return uint32_t(q[0]);
     }
 
     uint32_t AES::rotWord(uint32_t word) {
@@ -441,5 +1051,50 @@ namespace crypto {
         }
     }
 
+
+    AESKey::AESKey() {}
+
+    AESKey::AESKey(const uint8_t* key, uint32_t length) {
+        init(key, length);
+    }
+
+    bool AESKey::init(const uint8_t* key, uint32_t length) {
+        uint32_t Nr = AES::getNr(length / 4, AES::Nb);
+        if (Nr == 0 || length % 4 != 0) {
+            clear();
+            return false;
+        }
+
+        AES::keyExpansion(key, length, w_);
+        AES::keyExpansionBitsliced(w_, Nr, sk_);
+        if (AESNI::isSupported()) {
+            AESNI::keyExpansion(key, length, rk_);
+            AESNI::decryptKeyExpansion(rk_, Nr, drk_);
+        }
+        Nr_ = Nr;
+        impl_ = AES::getImpl();
+        return true;
+    }
+
+    void AESKey::clear() {
+        Nr_ = 0;
+        std::memset(w_, 0, sizeof(w_));
+        std::memset(sk_, 0, sizeof(sk_));
+        std::memset(rk_, 0, sizeof(rk_));
+        std::memset(drk_, 0, sizeof(drk_));
+    }
+
+    bool AESKey::isValid() const {
+        return Nr_ != 0;
+    }
+
+    uint32_t AESKey::getNr() const {
+        return Nr_;
+    }
+
+    AES::Impl AESKey::getImpl() const {
+        return impl_;
+    }
+
 }
 }
\ No newline at end of file
@@ -7,19 +7,45 @@
 #ifndef AKASH_SECURITY_CRYPTO_AES_H_
 #define AKASH_SECURITY_CRYPTO_AES_H_
 
+#include <cstddef>
 #include <cstdint>
 
 
 namespace akash {
 namespace crypto {
 
+    class AESKey;
+
     // 根据 FIPS PUB 197 实现的 AES 算法。
     // 支持 128bit、192bit 和 256bit 密钥。
     class AES {
     public:
+        // 加密的实现方式
+        enum class Impl {
+            // 按照 FIPS PUB 197 逐字节计算，作为参考实现
+            Reference,
+            // 将 SubBytes、ShiftRows 和 MixColumns 合并为 4 张 32 位查找表
+            TTable,
+            // 位切片，一次处理 4 个块，不查表，执行时间与数据无关
+            Bitsliced,
+            // 使用 AES-NI 指令，仅在支持的 x86-64 CPU 上可用
+            AESNI,
+        };
+
         // 状态矩阵的列数
         static const uint32_t Nb = 4;
 
+        // 设置之后初始化的 AESKey 使用的实现方式。启动时若 CPU 支持 AES-NI 则默认为 AESNI，
+        // 否则为执行时间与数据无关的 Bitsliced；TTable 较快但会通过缓存时序泄露密钥，只在显式设置时使用。
+        // CPU 不支持时设置 AESNI 无效。
+        // 实现方式在 AESKey::init 时确定，已初始化的密钥 (以及 GCMContext 等) 不受之后设置的影响，
+        // 因此其他线程可以同时使用已有的密钥；通常只在启动时或测试中设置。
+        // 解密在 AESNI 下使用 AES-NI，其他情况使用参考实现。
+        // GCM 在 AESNI 下同时使用 PCLMULQDQ 计算 GHASH。
+        static void setImpl(Impl impl);
+        static Impl getImpl();
+
+        // 以下三个函数缓存当前线程最近一次扩展的密钥，用同一个密钥连续调用时只扩展一次
         static void encrypt(
             const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
             const uint8_t* key, uint32_t length);
@@ -27,10 +53,52 @@ namespace crypto {
             const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
             const uint8_t* key, uint32_t length);
 
+        // 对 count 个连续的块分别加密
+        static void encryptBlocks(
+            const uint8_t* in, uint8_t* out, size_t count,
+            const uint8_t* key, uint32_t length);
+
+        // 以下函数使用已扩展的密钥，不再重复扩展。key 必须已初始化
+        static void encrypt(
+            const uint8_t in[4 * Nb], uint8_t out[4 * Nb], const AESKey& key);
+        static void decrypt(
+            const uint8_t in[4 * Nb], uint8_t out[4 * Nb], const AESKey& key);
+        static void encryptBlocks(
+            const uint8_t* in, uint8_t* out, size_t count, const AESKey& key);
+        static void decryptBlocks(
+            const uint8_t* in, uint8_t* out, size_t count, const AESKey& key);
+
+        // CTR 模式加密/解密。计数器为 ICB 末尾 32 位 (大端)，每块按 inc32 递增。
+        // len 可以不是块长度的整数倍，out 可以与 in 相同
+        static void encryptCTR32(
+            const uint8_t ICB[4 * Nb], const uint8_t* in, size_t len, uint8_t* out,
+            const AESKey& key);
+
+        // CCM 使用的 CTR 加密/解密与 CBC-MAC 合并为一遍。
+        // 计数器同 encryptCTR32，Y 为 CBC-MAC 的当前值，对明文计算。
+        // encrypt 为 true 时 in 为明文，否则 in 为密文。
+        // len 必须为块长度的整数倍，out 可以与 in 相同
+        static void encryptCCM(
+            const uint8_t ICB[4 * Nb], uint8_t Y[4 * Nb],
+            const uint8_t* in, size_t len, uint8_t* out, bool encrypt,
+            const AESKey& key);
+
     private:
+        friend class AESKey;
+
+        // 最大轮数 (256bit 密钥)
+        static const uint32_t kMaxNr = 14;
+
         static void encrypt(
             const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
             const uint32_t* w, uint32_t Nr);
+        static void encryptTTable(
+            const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
+            const uint32_t* w, uint32_t Nr);
+        // 一次最多处理 4 个块，sk 为位切片形式的轮密钥
+        static void encryptBitsliced(
+            const uint8_t* in, uint8_t* out, size_t count,
+            const uint64_t* sk, uint32_t Nr);
         static void decrypt(
             const uint8_t in[4 * Nb], uint8_t out[4 * Nb],
             const uint32_t* w, uint32_t Nr);
@@ -50,6 +118,9 @@ namespace crypto {
         static void addRoundKey(Context* context, const uint32_t* w);
         static void keyExpansion(
             const uint8_t* key, uint32_t length, uint32_t* out);
+        // 将扩展后的密钥转换为位切片形式，每轮 8 个 uint64_t
+        static void keyExpansionBitsliced(
+            const uint32_t* w, uint32_t Nr, uint64_t* sk);
 
         static uint8_t getSBoxSubByte(uint8_t org);
         static uint8_t getInvSBoxSubByte(uint8_t org);
@@ -65,6 +136,38 @@ namespace crypto {
         static uint8_t pow2(uint8_t exp);
     };
 
+    // 扩展后的 AES 密钥。
+    // 保存各实现方式需要的加密轮密钥以及解密轮密钥，初始化一次后可重复使用。
+    class AESKey {
+    public:
+        AESKey();
+        AESKey(const uint8_t* key, uint32_t length);
+
+        // 扩展密钥。length 不是可用的密钥长度时返回 false
+        bool init(const uint8_t* key, uint32_t length);
+        // 清除保存的轮密钥
+        void clear();
+
+        bool isValid() const;
+        uint32_t getNr() const;
+        // 初始化时确定的实现方式
+        AES::Impl getImpl() const;
+
+    private:
+        friend class AES;
+
+        // 轮数，为 0 时表示未初始化
+        uint32_t Nr_ = 0;
+        AES::Impl impl_ = AES::Impl::Reference;
+        // FIPS PUB 197 中的 w[]，参考实现和 TTable 使用，解密时逆序使用
+        uint32_t w_[AES::Nb * (AES::kMaxNr + 1)];
+        // 位切片形式的轮密钥
+        uint64_t sk_[8 * (AES::kMaxNr + 1)];
+        // AES-NI 的加密和解密轮密钥，CPU 不支持时不使用
+        uint8_t rk_[4 * AES::Nb * (AES::kMaxNr + 1)];
+        uint8_t drk_[4 * AES::Nb * (AES::kMaxNr + 1)];
+    };
+
 }
 }
 
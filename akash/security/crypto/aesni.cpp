@@ -0,0 +1,511 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/crypto/aesni.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "akash/security/crypto/cpu_features.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AKASH_AESNI_X64
+#endif
+
+#ifdef AKASH_AESNI_X64
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AESNI_TARGET
+#else
+#include <immintrin.h>
+#define AESNI_TARGET __attribute__((target("aes,pclmul,ssse3")))
+#endif
+#endif
+
+
+#ifdef AKASH_AESNI_X64
+namespace {
+
+    AESNI_TARGET inline __m128i bswap128(__m128i v) {
+        return _mm_shuffle_epi8(
+            v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    }
+
+    // 小端序字的 SubWord，X1 位置的结果位于第 0 个双字
+    AESNI_TARGET inline uint32_t subWord(uint32_t w) {
+        __m128i t = _mm_aeskeygenassist_si128(_mm_set_epi32(0, 0, int(w), 0), 0);
+        return uint32_t(_mm_cvtsi128_si32(t));
+    }
+
+    AESNI_TARGET inline void loadKeys(
+        const uint8_t* rk, uint32_t Nr, __m128i k[15])
+    {
+        for (uint32_t i = 0; i <= Nr; ++i) {
+            k[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rk + 16 * i));
+        }
+    }
+
+    AESNI_TARGET inline __m128i encrypt1(const __m128i k[15], uint32_t Nr, __m128i b) {
+        b = _mm_xor_si128(b, k[0]);
+        for (uint32_t r = 1; r < Nr; ++r) {
+            b = _mm_aesenc_si128(b, k[r]);
+        }
+        return _mm_aesenclast_si128(b, k[Nr]);
+    }
+
+    // 8 个块交错执行，隐藏 aesenc 的延迟
+    AESNI_TARGET inline void encrypt8(const __m128i k[15], uint32_t Nr, __m128i b[8]) {
+        for (int j = 0; j < 8; ++j) {
+            b[j] = _mm_xor_si128(b[j], k[0]);
+        }
+        for (uint32_t r = 1; r < Nr; ++r) {
+            for (int j = 0; j < 8; ++j) {
+                b[j] = _mm_aesenc_si128(b[j], k[r]);
+            }
+        }
+        for (int j = 0; j < 8; ++j) {
+            b[j] = _mm_aesenclast_si128(b[j], k[Nr]);
+        }
+    }
+
+    AESNI_TARGET inline __m128i decrypt1(const __m128i k[15], uint32_t Nr, __m128i b) {
+        b = _mm_xor_si128(b, k[0]);
+        for (uint32_t r = 1; r < Nr; ++r) {
+            b = _mm_aesdec_si128(b, k[r]);
+        }
+        return _mm_aesdeclast_si128(b, k[Nr]);
+    }
+
+    AESNI_TARGET inline void decrypt8(const __m128i k[15], uint32_t Nr, __m128i b[8]) {
+        for (int j = 0; j < 8; ++j) {
+            b[j] = _mm_xor_si128(b[j], k[0]);
+        }
+        for (uint32_t r = 1; r < Nr; ++r) {
+            for (int j = 0; j < 8; ++j) {
+                b[j] = _mm_aesdec_si128(b[j], k[r]);
+            }
+        }
+        for (int j = 0; j < 8; ++j) {
+            b[j] = _mm_aesdeclast_si128(b[j], k[Nr]);
+        }
+    }
+
+    // 两个互不依赖的块交错执行
+    AESNI_TARGET inline void encrypt2(
+        const __m128i k[15], uint32_t Nr, __m128i* a, __m128i* b)
+    {
+        *a = _mm_xor_si128(*a, k[0]);
+        *b = _mm_xor_si128(*b, k[0]);
+        for (uint32_t r = 1; r < Nr; ++r) {
+            *a = _mm_aesenc_si128(*a, k[r]);
+            *b = _mm_aesenc_si128(*b, k[r]);
+        }
+        *a = _mm_aesenclast_si128(*a, k[Nr]);
+        *b = _mm_aesenclast_si128(*b, k[Nr]);
+    }
+
+    // 以下的 GHASH 参考 Intel 白皮书《Intel Carry-Less Multiplication
+    // Instruction and its Usage for Computing the GCM Mode》。
+    // 块在进入运算前整体反转字节序，此时 GCM 的位反射序只差一位左移。
+
+    // 256 位无约减乘积 hi:lo = a * b
+    AESNI_TARGET inline void clmul(
+        __m128i a, __m128i b, __m128i* lo, __m128i* hi)
+    {
+        __m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+        __m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+        __m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+        __m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+        t1 = _mm_xor_si128(t1, t2);
+        *lo = _mm_xor_si128(t0, _mm_slli_si128(t1, 8));
+        *hi = _mm_xor_si128(t3, _mm_srli_si128(t1, 8));
+    }
+
+    // 将 hi:lo 左移一位后对 x^128 + x^7 + x^2 + x + 1 约减。
+    // 二者都是线性运算，多个乘积可以先异或再统一约减
+    AESNI_TARGET inline __m128i reduce(__m128i lo, __m128i hi) {
+        __m128i t7 = _mm_srli_epi32(lo, 31);
+        __m128i t8 = _mm_srli_epi32(hi, 31);
+        lo = _mm_slli_epi32(lo, 1);
+        hi = _mm_slli_epi32(hi, 1);
+        __m128i t9 = _mm_srli_si128(t7, 12);
+        t8 = _mm_slli_si128(t8, 4);
+        t7 = _mm_slli_si128(t7, 4);
+        lo = _mm_or_si128(lo, t7);
+        hi = _mm_or_si128(hi, t8);
+        hi = _mm_or_si128(hi, t9);
+
+        t7 = _mm_slli_epi32(lo, 31);
+        t8 = _mm_slli_epi32(lo, 30);
+        t9 = _mm_slli_epi32(lo, 25);
+        t7 = _mm_xor_si128(t7, t8);
+        t7 = _mm_xor_si128(t7, t9);
+        t8 = _mm_srli_si128(t7, 4);
+        t7 = _mm_slli_si128(t7, 12);
+        lo = _mm_xor_si128(lo, t7);
+
+        __m128i t2 = _mm_srli_epi32(lo, 1);
+        __m128i t4 = _mm_srli_epi32(lo, 2);
+        __m128i t5 = _mm_srli_epi32(lo, 7);
+        t2 = _mm_xor_si128(t2, t4);
+        t2 = _mm_xor_si128(t2, t5);
+        t2 = _mm_xor_si128(t2, t8);
+        lo = _mm_xor_si128(lo, t2);
+        return _mm_xor_si128(hi, lo);
+    }
+
+    AESNI_TARGET inline __m128i gfmul(__m128i a, __m128i b) {
+        __m128i lo, hi;
+        clmul(a, b, &lo, &hi);
+        return reduce(lo, hi);
+    }
+
+
+    AESNI_TARGET uint32_t keyExpansionImpl(
+        const uint8_t* key, uint32_t length, uint8_t* rk)
+    {
+        uint32_t Nk = length / 4;
+        if (length % 4 != 0 || (Nk != 4 && Nk != 6 && Nk != 8)) {
+            return 0;
+        }
+        uint32_t Nr = Nk + 6;
+
+        // 按小端序保存字，RotWord 对应循环右移 8 位
+        uint32_t w[4 * 15];
+        std::memcpy(w, key, length);
+
+        uint32_t rcon = 1;
+        for (uint32_t i = Nk; i < 4 * (Nr + 1); ++i) {
+            uint32_t t = w[i - 1];
+            if (i % Nk == 0) {
+                t = subWord(t);
+                t = ((t >> 8) | (t << 24)) ^ rcon;
+                rcon = (rcon << 1) ^ ((rcon >> 7) * 0x11B);
+            } else if (Nk > 6 && i % Nk == 4) {
+                t = subWord(t);
+            }
+            w[i] = w[i - Nk] ^ t;
+        }
+
+        std::memcpy(rk, w, 16 * (Nr + 1));
+        return Nr;
+    }
+
+    AESNI_TARGET void encryptBlocksImpl(
+        const uint8_t* rk, uint32_t Nr,
+        const uint8_t* in, uint8_t* out, size_t count)
+    {
+        __m128i k[15];
+        loadKeys(rk, Nr, k);
+
+        auto src = reinterpret_cast<const __m128i*>(in);
+        auto dst = reinterpret_cast<__m128i*>(out);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i b[8];
+            for (int j = 0; j < 8; ++j) {
+                b[j] = _mm_loadu_si128(src + i + j);
+            }
+            encrypt8(k, Nr, b);
+            for (int j = 0; j < 8; ++j) {
+                _mm_storeu_si128(dst + i + j, b[j]);
+            }
+        }
+        for (; i < count; ++i) {
+            _mm_storeu_si128(dst + i, encrypt1(k, Nr, _mm_loadu_si128(src + i)));
+        }
+    }
+
+    AESNI_TARGET void decryptKeyExpansionImpl(
+        const uint8_t* rk, uint32_t Nr, uint8_t* drk)
+    {
+        // 轮密钥逆序，中间各轮再经过 InvMixColumns
+        auto src = reinterpret_cast<const __m128i*>(rk);
+        auto dst = reinterpret_cast<__m128i*>(drk);
+        _mm_storeu_si128(dst, _mm_loadu_si128(src + Nr));
+        for (uint32_t i = 1; i < Nr; ++i) {
+            _mm_storeu_si128(dst + i, _mm_aesimc_si128(_mm_loadu_si128(src + Nr - i)));
+        }
+        _mm_storeu_si128(dst + Nr, _mm_loadu_si128(src));
+    }
+
+    AESNI_TARGET void decryptBlocksImpl(
+        const uint8_t* drk, uint32_t Nr,
+        const uint8_t* in, uint8_t* out, size_t count)
+    {
+        __m128i k[15];
+        loadKeys(drk, Nr, k);
+
+        auto src = reinterpret_cast<const __m128i*>(in);
+        auto dst = reinterpret_cast<__m128i*>(out);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i b[8];
+            for (int j = 0; j < 8; ++j) {
+                b[j] = _mm_loadu_si128(src + i + j);
+            }
+            decrypt8(k, Nr, b);
+            for (int j = 0; j < 8; ++j) {
+                _mm_storeu_si128(dst + i + j, b[j]);
+            }
+        }
+        for (; i < count; ++i) {
+            _mm_storeu_si128(dst + i, decrypt1(k, Nr, _mm_loadu_si128(src + i)));
+        }
+    }
+
+    AESNI_TARGET void ctr32Impl(
+        const uint8_t* rk, uint32_t Nr, const uint8_t ICB[16],
+        const uint8_t* in, size_t len, uint8_t* out)
+    {
+        __m128i k[15];
+        loadKeys(rk, Nr, k);
+
+        // 反转后计数器位于第 0 个双字，可以直接用 paddd 完成 inc32
+        __m128i ctr = bswap128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ICB)));
+        const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+
+        for (; len >= 16 * 8; len -= 16 * 8) {
+            __m128i b[8];
+            for (int j = 0; j < 8; ++j) {
+                b[j] = bswap128(ctr);
+                ctr = _mm_add_epi32(ctr, one);
+            }
+            encrypt8(k, Nr, b);
+            for (int j = 0; j < 8; ++j) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + j);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + j, _mm_xor_si128(x, b[j]));
+            }
+            in += 16 * 8;
+            out += 16 * 8;
+        }
+
+        for (; len >= 16; len -= 16) {
+            __m128i b = encrypt1(k, Nr, bswap128(ctr));
+            ctr = _mm_add_epi32(ctr, one);
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_xor_si128(x, b));
+            in += 16;
+            out += 16;
+        }
+
+        if (len > 0) {
+            uint8_t ks[16];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(ks), encrypt1(k, Nr, bswap128(ctr)));
+            for (size_t i = 0; i < len; ++i) {
+                out[i] = in[i] ^ ks[i];
+            }
+        }
+    }
+
+    AESNI_TARGET void ccmImpl(
+        const uint8_t* rk, uint32_t Nr, const uint8_t ICB[16], uint8_t Y[16],
+        const uint8_t* in, size_t len, uint8_t* out, bool encrypt)
+    {
+        __m128i k[15];
+        loadKeys(rk, Nr, k);
+
+        __m128i ctr = bswap128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ICB)));
+        const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Y));
+
+        auto src = reinterpret_cast<const __m128i*>(in);
+        auto dst = reinterpret_cast<__m128i*>(out);
+        size_t count = len / 16;
+
+        if (encrypt) {
+            // 同一块的 CBC-MAC 与密钥流互不依赖
+            for (size_t i = 0; i < count; ++i) {
+                __m128i p = _mm_loadu_si128(src + i);
+                __m128i ks = bswap128(ctr);
+                ctr = _mm_add_epi32(ctr, one);
+                y = _mm_xor_si128(y, p);
+                encrypt2(k, Nr, &y, &ks);
+                _mm_storeu_si128(dst + i, _mm_xor_si128(p, ks));
+            }
+        } else if (count > 0) {
+            // 明文依赖密钥流，因此第 i 块的 CBC-MAC 与第 i + 1 块的密钥流交错
+            __m128i ks = encrypt1(k, Nr, bswap128(ctr));
+            ctr = _mm_add_epi32(ctr, one);
+            for (size_t i = 0; i < count; ++i) {
+                __m128i p = _mm_xor_si128(_mm_loadu_si128(src + i), ks);
+                _mm_storeu_si128(dst + i, p);
+                y = _mm_xor_si128(y, p);
+                if (i + 1 < count) {
+                    ks = bswap128(ctr);
+                    ctr = _mm_add_epi32(ctr, one);
+                    encrypt2(k, Nr, &y, &ks);
+                } else {
+                    y = encrypt1(k, Nr, y);
+                }
+            }
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Y), y);
+    }
+
+    // Htable 中按字节反转后的 H^1 ~ H^4 依次存放
+    AESNI_TARGET void ghashInitImpl(const uint8_t H[16], uint8_t* Htable) {
+        auto dst = reinterpret_cast<__m128i*>(Htable);
+        __m128i h1 = bswap128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(H)));
+        __m128i h = h1;
+        _mm_storeu_si128(dst, h);
+        for (int i = 1; i < 4; ++i) {
+            h = gfmul(h, h1);
+            _mm_storeu_si128(dst + i, h);
+        }
+    }
+
+    AESNI_TARGET void ghashImpl(
+        const uint8_t* Htable, uint8_t Y[16], const uint8_t* X, size_t lx)
+    {
+        auto table = reinterpret_cast<const __m128i*>(Htable);
+        __m128i h1 = _mm_loadu_si128(table + 0);
+        __m128i y = bswap128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Y)));
+        auto src = reinterpret_cast<const __m128i*>(X);
+
+        // 4 块聚合：Y' = (Y ^ X1)H^4 ^ X2H^3 ^ X3H^2 ^ X4H，只约减一次
+        if (lx >= 16 * 4) {
+            __m128i h2 = _mm_loadu_si128(table + 1);
+            __m128i h3 = _mm_loadu_si128(table + 2);
+            __m128i h4 = _mm_loadu_si128(table + 3);
+
+            for (; lx >= 16 * 4; lx -= 16 * 4) {
+                __m128i x0 = _mm_xor_si128(y, bswap128(_mm_loadu_si128(src + 0)));
+                __m128i x1 = bswap128(_mm_loadu_si128(src + 1));
+                __m128i x2 = bswap128(_mm_loadu_si128(src + 2));
+                __m128i x3 = bswap128(_mm_loadu_si128(src + 3));
+
+                __m128i lo, hi, l, h;
+                clmul(x0, h4, &lo, &hi);
+                clmul(x1, h3, &l, &h);
+                lo = _mm_xor_si128(lo, l); hi = _mm_xor_si128(hi, h);
+                clmul(x2, h2, &l, &h);
+                lo = _mm_xor_si128(lo, l); hi = _mm_xor_si128(hi, h);
+                clmul(x3, h1, &l, &h);
+                lo = _mm_xor_si128(lo, l); hi = _mm_xor_si128(hi, h);
+                y = reduce(lo, hi);
+
+                src += 4;
+            }
+        }
+
+        for (; lx >= 16; lx -= 16) {
+            y = gfmul(_mm_xor_si128(y, bswap128(_mm_loadu_si128(src))), h1);
+            ++src;
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Y), bswap128(y));
+    }
+
+}
+#endif
+
+namespace akash {
+namespace crypto {
+
+    bool AESNI::isSupported() {
+        return CPUFeatures::hasAESNI() &&
+            CPUFeatures::hasPCLMULQDQ() &&
+            CPUFeatures::hasSSSE3();
+    }
+
+    uint32_t AESNI::keyExpansion(
+        const uint8_t* key, uint32_t length, uint8_t rk[kMaxRoundKeySize])
+    {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        return keyExpansionImpl(key, length, rk);
+#else
+        assert(false);
+        return 0;
+#endif
+    }
+
+    void AESNI::encryptBlocks(
+        const uint8_t* rk, uint32_t Nr,
+        const uint8_t* in, uint8_t* out, size_t count)
+    {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        encryptBlocksImpl(rk, Nr, in, out, count);
+#else
+        assert(false);
+#endif
+    }
+
+    void AESNI::decryptKeyExpansion(
+        const uint8_t* rk, uint32_t Nr, uint8_t drk[kMaxRoundKeySize])
+    {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        decryptKeyExpansionImpl(rk, Nr, drk);
+#else
+        assert(false);
+#endif
+    }
+
+    void AESNI::decryptBlocks(
+        const uint8_t* drk, uint32_t Nr,
+        const uint8_t* in, uint8_t* out, size_t count)
+    {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        decryptBlocksImpl(drk, Nr, in, out, count);
+#else
+        assert(false);
+#endif
+    }
+
+    void AESNI::ctr32(
+        const uint8_t* rk, uint32_t Nr, const uint8_t ICB[16],
+        const uint8_t* in, size_t len, uint8_t* out)
+    {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        ctr32Impl(rk, Nr, ICB, in, len, out);
+#else
+        assert(false);
+#endif
+    }
+
+    void AESNI::ccm(
+        const uint8_t* rk, uint32_t Nr, const uint8_t ICB[16], uint8_t Y[16],
+        const uint8_t* in, size_t len, uint8_t* out, bool encrypt)
+    {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        assert(len % 16 == 0);
+        ccmImpl(rk, Nr, ICB, Y, in, len, out, encrypt);
+#else
+        assert(false);
+#endif
+    }
+
+    void AESNI::ghashInit(const uint8_t H[16], uint8_t Htable[kGHashTableSize]) {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        ghashInitImpl(H, Htable);
+#else
+        assert(false);
+#endif
+    }
+
+    void AESNI::ghash(
+        const uint8_t Htable[kGHashTableSize], uint8_t Y[16], const uint8_t* X, size_t lx)
+    {
+#ifdef AKASH_AESNI_X64
+        assert(isSupported());
+        ghashImpl(Htable, Y, X, lx);
+#else
+        assert(false);
+#endif
+    }
+
+}
+}
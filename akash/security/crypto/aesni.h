@@ -0,0 +1,74 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_AESNI_H_
+#define AKASH_SECURITY_CRYPTO_AESNI_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace akash {
+namespace crypto {
+
+    // 使用 AES-NI 和 PCLMULQDQ 指令实现的 AES 加密、CTR 和 GHASH。
+    // 仅在 x86-64 上可用，调用其他函数前必须先确认 isSupported() 返回 true。
+    // 轮密钥按字节保存，与 FIPS PUB 197 中 w[] 的字节序一致。
+    class AESNI {
+    public:
+        // 轮密钥的最大字节数 (256bit 密钥，15 个轮密钥)
+        static const size_t kMaxRoundKeySize = 16 * 15;
+        // GHASH 预计算表的字节数
+        static const size_t kGHashTableSize = 16 * 4;
+
+        // CPU 是否支持 AES-NI、PCLMULQDQ 和 SSSE3
+        static bool isSupported();
+
+        // 扩展密钥，返回轮数。length 不是可用的密钥长度时返回 0
+        static uint32_t keyExpansion(
+            const uint8_t* key, uint32_t length, uint8_t rk[kMaxRoundKeySize]);
+
+        // 对 count 个连续的块分别加密，每次交错处理 8 个块
+        static void encryptBlocks(
+            const uint8_t* rk, uint32_t Nr,
+            const uint8_t* in, uint8_t* out, size_t count);
+
+        // 由加密轮密钥生成等价逆密码 (Equivalent Inverse Cipher) 使用的解密轮密钥
+        static void decryptKeyExpansion(
+            const uint8_t* rk, uint32_t Nr, uint8_t drk[kMaxRoundKeySize]);
+
+        // 使用解密轮密钥对 count 个连续的块分别解密，每次交错处理 8 个块
+        static void decryptBlocks(
+            const uint8_t* drk, uint32_t Nr,
+            const uint8_t* in, uint8_t* out, size_t count);
+
+        // CTR 模式加密/解密。计数器为 ICB 末尾 32 位 (大端)，按 inc32 递增。
+        // len 可以不是块长度的整数倍，out 可以与 in 相同
+        static void ctr32(
+            const uint8_t* rk, uint32_t Nr, const uint8_t ICB[16],
+            const uint8_t* in, size_t len, uint8_t* out);
+
+        // CCM 使用的 CTR 与 CBC-MAC，两条 AES 链交错执行，数据只经过一遍。
+        // 计数器与 ctr32 相同，Y 为 CBC-MAC 的当前值，对明文计算。
+        // encrypt 为 true 时 in 为明文，否则 in 为密文。
+        // len 必须为块长度的整数倍，out 可以与 in 相同
+        static void ccm(
+            const uint8_t* rk, uint32_t Nr, const uint8_t ICB[16], uint8_t Y[16],
+            const uint8_t* in, size_t len, uint8_t* out, bool encrypt);
+
+        // 计算 GHASH 使用的 H、H^2、H^3 和 H^4，同一个 H 只需计算一次
+        static void ghashInit(const uint8_t H[16], uint8_t Htable[kGHashTableSize]);
+
+        // 将 X 中完整的块依次累积到 Y 上：Y = (Y ^ Xi) * H。
+        // Htable 由 ghashInit 生成，lx 不足一块的部分被忽略
+        static void ghash(
+            const uint8_t Htable[kGHashTableSize], uint8_t Y[16], const uint8_t* X, size_t lx);
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_AESNI_H_
@@ -0,0 +1,321 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/crypto/chacha20.h"
+
+#include "akash/security/crypto/cpu_features.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AKASH_CHACHA_X64
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+
+namespace {
+
+    akash::crypto::ChaCha20::Impl detectImpl() {
+        using akash::crypto::CPUFeatures;
+        using Impl = akash::crypto::ChaCha20::Impl;
+        if (CPUFeatures::hasAVX2()) {
+            return Impl::AVX2;
+        }
+        if (CPUFeatures::hasSSE2()) {
+            return Impl::SSE2;
+        }
+        return Impl::Scalar;
+    }
+
+    akash::crypto::ChaCha20::Impl impl_ = detectImpl();
+
+    uint32_t load32LE(const uint8_t* in) {
+        return uint32_t(in[0]) |
+            (uint32_t(in[1]) << 8) |
+            (uint32_t(in[2]) << 16) |
+            (uint32_t(in[3]) << 24);
+    }
+
+    uint32_t rotl32(uint32_t v, int n) {
+        return (v << n) | (v >> (32 - n));
+    }
+
+    void quarterRound(uint32_t x[16], int a, int b, int c, int d) {
+        x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 8);
+        x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 7);
+    }
+
+#ifdef AKASH_CHACHA_X64
+
+    // 以下为多块实现：x[i] 的各个分量分别属于不同的块，
+    // 计数器按分量依次加 0, 1, 2, ...，轮函数与标量实现完全相同。
+
+    template <int N>
+    inline __m128i rotl128(__m128i v) {
+        return _mm_or_si128(_mm_slli_epi32(v, N), _mm_srli_epi32(v, 32 - N));
+    }
+
+    inline void quarterRound4(__m128i x[16], int a, int b, int c, int d) {
+        x[a] = _mm_add_epi32(x[a], x[b]); x[d] = rotl128<16>(_mm_xor_si128(x[d], x[a]));
+        x[c] = _mm_add_epi32(x[c], x[d]); x[b] = rotl128<12>(_mm_xor_si128(x[b], x[c]));
+        x[a] = _mm_add_epi32(x[a], x[b]); x[d] = rotl128<8>(_mm_xor_si128(x[d], x[a]));
+        x[c] = _mm_add_epi32(x[c], x[d]); x[b] = rotl128<7>(_mm_xor_si128(x[b], x[c]));
+    }
+
+    // 生成 4 个块的密钥流并与 in 异或
+    void xorBlocks4(const uint32_t state[16], const uint8_t* in, uint8_t* out) {
+        __m128i x[16];
+        __m128i orig[16];
+        for (int i = 0; i < 16; ++i) {
+            x[i] = _mm_set1_epi32(int(state[i]));
+        }
+        x[12] = _mm_add_epi32(x[12], _mm_set_epi32(3, 2, 1, 0));
+        for (int i = 0; i < 16; ++i) {
+            orig[i] = x[i];
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            quarterRound4(x, 0, 4, 8, 12);
+            quarterRound4(x, 1, 5, 9, 13);
+            quarterRound4(x, 2, 6, 10, 14);
+            quarterRound4(x, 3, 7, 11, 15);
+            quarterRound4(x, 0, 5, 10, 15);
+            quarterRound4(x, 1, 6, 11, 12);
+            quarterRound4(x, 2, 7, 8, 13);
+            quarterRound4(x, 3, 4, 9, 14);
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            x[i] = _mm_add_epi32(x[i], orig[i]);
+        }
+
+        // 每 4 个字做一次 4x4 转置，得到各个块中连续的 16 字节
+        for (int g = 0; g < 4; ++g) {
+            __m128i t0 = _mm_unpacklo_epi32(x[4 * g + 0], x[4 * g + 1]);
+            __m128i t1 = _mm_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+            __m128i t2 = _mm_unpackhi_epi32(x[4 * g + 0], x[4 * g + 1]);
+            __m128i t3 = _mm_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+
+            __m128i b[4];
+            b[0] = _mm_unpacklo_epi64(t0, t1);
+            b[1] = _mm_unpackhi_epi64(t0, t1);
+            b[2] = _mm_unpacklo_epi64(t2, t3);
+            b[3] = _mm_unpackhi_epi64(t2, t3);
+
+            for (int k = 0; k < 4; ++k) {
+                size_t off = 64 * k + 16 * g;
+                __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + off));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + off), _mm_xor_si128(m, b[k]));
+            }
+        }
+    }
+
+    template <int N>
+    AVX2_TARGET inline __m256i rotl256(__m256i v) {
+        return _mm256_or_si256(_mm256_slli_epi32(v, N), _mm256_srli_epi32(v, 32 - N));
+    }
+
+    // 循环左移 16 位和 8 位正好是字节的重排
+    AVX2_TARGET inline __m256i rotl256_16(__m256i v) {
+        const __m256i shuf = _mm256_set_epi8(
+            13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+            13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+        return _mm256_shuffle_epi8(v, shuf);
+    }
+
+    AVX2_TARGET inline __m256i rotl256_8(__m256i v) {
+        const __m256i shuf = _mm256_set_epi8(
+            14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+            14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+        return _mm256_shuffle_epi8(v, shuf);
+    }
+
+    AVX2_TARGET inline void quarterRound8(__m256i x[16], int a, int b, int c, int d) {
+        x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = rotl256_16(_mm256_xor_si256(x[d], x[a]));
+        x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = rotl256<12>(_mm256_xor_si256(x[b], x[c]));
+        x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = rotl256_8(_mm256_xor_si256(x[d], x[a]));
+        x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = rotl256<7>(_mm256_xor_si256(x[b], x[c]));
+    }
+
+    // 生成 8 个块的密钥流并与 in 异或
+    AVX2_TARGET void xorBlocks8(const uint32_t state[16], const uint8_t* in, uint8_t* out) {
+        __m256i x[16];
+        __m256i orig[16];
+        for (int i = 0; i < 16; ++i) {
+            x[i] = _mm256_set1_epi32(int(state[i]));
+        }
+        x[12] = _mm256_add_epi32(x[12], _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        for (int i = 0; i < 16; ++i) {
+            orig[i] = x[i];
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            quarterRound8(x, 0, 4, 8, 12);
+            quarterRound8(x, 1, 5, 9, 13);
+            quarterRound8(x, 2, 6, 10, 14);
+            quarterRound8(x, 3, 7, 11, 15);
+            quarterRound8(x, 0, 5, 10, 15);
+            quarterRound8(x, 1, 6, 11, 12);
+            quarterRound8(x, 2, 7, 8, 13);
+            quarterRound8(x, 3, 4, 9, 14);
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            x[i] = _mm256_add_epi32(x[i], orig[i]);
+        }
+
+        // unpack 只在 128 位的半边内进行：低半边得到块 0~3，高半边得到块 4~7
+        for (int g = 0; g < 4; ++g) {
+            __m256i t0 = _mm256_unpacklo_epi32(x[4 * g + 0], x[4 * g + 1]);
+            __m256i t1 = _mm256_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+            __m256i t2 = _mm256_unpackhi_epi32(x[4 * g + 0], x[4 * g + 1]);
+            __m256i t3 = _mm256_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+
+            __m256i b[4];
+            b[0] = _mm256_unpacklo_epi64(t0, t1);
+            b[1] = _mm256_unpackhi_epi64(t0, t1);
+            b[2] = _mm256_unpacklo_epi64(t2, t3);
+            b[3] = _mm256_unpackhi_epi64(t2, t3);
+
+            for (int k = 0; k < 4; ++k) {
+                size_t lo = 64 * k + 16 * g;
+                size_t hi = 64 * (k + 4) + 16 * g;
+                __m128i m0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + lo));
+                __m128i m1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + hi));
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(out + lo),
+                    _mm_xor_si128(m0, _mm256_castsi256_si128(b[k])));
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(out + hi),
+                    _mm_xor_si128(m1, _mm256_extracti128_si256(b[k], 1)));
+            }
+        }
+    }
+
+#endif
+
+}
+
+namespace akash {
+namespace crypto {
+
+    void ChaCha20::setImpl(Impl impl) {
+        if (impl == Impl::AVX2 && !CPUFeatures::hasAVX2()) {
+            return;
+        }
+        if (impl == Impl::SSE2 && !CPUFeatures::hasSSE2()) {
+            return;
+        }
+        impl_ = impl;
+    }
+
+    ChaCha20::Impl ChaCha20::getImpl() {
+        return impl_;
+    }
+
+    void ChaCha20::block(
+        const uint8_t key[kKeySize], uint32_t counter,
+        const uint8_t nonce[kNonceSize], uint8_t out[kBlockSize])
+    {
+        uint32_t state[16];
+        initState(key, counter, nonce, state);
+        blockScalar(state, out);
+    }
+
+    void ChaCha20::encrypt(
+        const uint8_t key[kKeySize], uint32_t counter,
+        const uint8_t nonce[kNonceSize],
+        const uint8_t* in, size_t len, uint8_t* out)
+    {
+        uint32_t state[16];
+        initState(key, counter, nonce, state);
+
+#ifdef AKASH_CHACHA_X64
+        if (impl_ == Impl::AVX2) {
+            for (; len >= 8 * kBlockSize; len -= 8 * kBlockSize) {
+                xorBlocks8(state, in, out);
+                state[12] += 8;
+                in += 8 * kBlockSize;
+                out += 8 * kBlockSize;
+            }
+        }
+        if (impl_ == Impl::AVX2 || impl_ == Impl::SSE2) {
+            for (; len >= 4 * kBlockSize; len -= 4 * kBlockSize) {
+                xorBlocks4(state, in, out);
+                state[12] += 4;
+                in += 4 * kBlockSize;
+                out += 4 * kBlockSize;
+            }
+        }
+#endif
+
+        uint8_t ks[kBlockSize];
+        while (len > 0) {
+            blockScalar(state, ks);
+            ++state[12];
+
+            size_t n = len < kBlockSize ? len : kBlockSize;
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = in[i] ^ ks[i];
+            }
+            in += n;
+            out += n;
+            len -= n;
+        }
+    }
+
+    void ChaCha20::initState(
+        const uint8_t key[kKeySize], uint32_t counter,
+        const uint8_t nonce[kNonceSize], uint32_t state[16])
+    {
+        // "expand 32-byte k"
+        state[0] = 0x61707865;
+        state[1] = 0x3320646e;
+        state[2] = 0x79622d32;
+        state[3] = 0x6b206574;
+        for (int i = 0; i < 8; ++i) {
+            state[4 + i] = load32LE(key + 4 * i);
+        }
+        state[12] = counter;
+        for (int i = 0; i < 3; ++i) {
+            state[13 + i] = load32LE(nonce + 4 * i);
+        }
+    }
+
+    void ChaCha20::blockScalar(const uint32_t state[16], uint8_t out[kBlockSize]) {
+        uint32_t x[16];
+        for (int i = 0; i < 16; ++i) {
+            x[i] = state[i];
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            quarterRound(x, 0, 4, 8, 12);
+            quarterRound(x, 1, 5, 9, 13);
+            quarterRound(x, 2, 6, 10, 14);
+            quarterRound(x, 3, 7, 11, 15);
+            quarterRound(x, 0, 5, 10, 15);
+            quarterRound(x, 1, 6, 11, 12);
+            quarterRound(x, 2, 7, 8, 13);
+            quarterRound(x, 3, 4, 9, 14);
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            uint32_t v = x[i] + state[i];
+            out[4 * i + 0] = uint8_t(v);
+            out[4 * i + 1] = uint8_t(v >> 8);
+            out[4 * i + 2] = uint8_t(v >> 16);
+            out[4 * i + 3] = uint8_t(v >> 24);
+        }
+    }
+
+}
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_CHACHA20_H_
+#define AKASH_SECURITY_CRYPTO_CHACHA20_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace akash {
+namespace crypto {
+
+    // RFC 8439 中的 ChaCha20 流密码，32 位块计数器，96 位 nonce。
+    class ChaCha20 {
+    public:
+        // 密钥流的实现方式
+        enum class Impl {
+            // 逐块计算的可移植实现
+            Scalar,
+            // 每个 SSE2 寄存器保存 4 个块的同一个字，一次处理 4 个块
+            SSE2,
+            // 同上，使用 AVX2 一次处理 8 个块
+            AVX2,
+        };
+
+        static const size_t kKeySize = 32;
+        static const size_t kNonceSize = 12;
+        static const size_t kBlockSize = 64;
+
+        // 设置使用的实现方式。启动时选择 CPU 支持的最快实现，
+        // 设置为 CPU 不支持的实现时无效。
+        static void setImpl(Impl impl);
+        static Impl getImpl();
+
+        // 生成计数器为 counter 的密钥流块
+        static void block(
+            const uint8_t key[kKeySize], uint32_t counter,
+            const uint8_t nonce[kNonceSize], uint8_t out[kBlockSize]);
+
+        // 从计数器 counter 开始生成密钥流，并与 in 异或写入 out。
+        // out 的长度应等于 len，可以与 in 相同
+        static void encrypt(
+            const uint8_t key[kKeySize], uint32_t counter,
+            const uint8_t nonce[kNonceSize],
+            const uint8_t* in, size_t len, uint8_t* out);
+
+    private:
+        static void initState(
+            const uint8_t key[kKeySize], uint32_t counter,
+            const uint8_t nonce[kNonceSize], uint32_t state[16]);
+        static void blockScalar(const uint32_t state[16], uint8_t out[kBlockSize]);
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_CHACHA20_H_
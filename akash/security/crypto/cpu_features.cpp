@@ -0,0 +1,133 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/crypto/cpu_features.h"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AKASH_CPU_X64
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+namespace {
+
+#ifdef AKASH_CPU_X64
+    void cpuid(uint32_t leaf, uint32_t sub, uint32_t regs[4]) {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuidex(info, int(leaf), int(sub));
+        for (int i = 0; i < 4; ++i) {
+            regs[i] = uint32_t(info[i]);
+        }
+#else
+        __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    uint64_t xgetbv0() {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (uint64_t(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+}
+
+namespace akash {
+namespace crypto {
+
+    bool CPUFeatures::hasSSE2() {
+        return getFlags().sse2;
+    }
+
+    bool CPUFeatures::hasSSSE3() {
+        return getFlags().ssse3;
+    }
+
+    bool CPUFeatures::hasSSE41() {
+        return getFlags().sse41;
+    }
+
+    bool CPUFeatures::hasAESNI() {
+        return getFlags().aesni;
+    }
+
+    bool CPUFeatures::hasPCLMULQDQ() {
+        return getFlags().pclmulqdq;
+    }
+
+    bool CPUFeatures::hasAVX2() {
+        return getFlags().avx2;
+    }
+
+    bool CPUFeatures::hasAVX512F() {
+        return getFlags().avx512f;
+    }
+
+    bool CPUFeatures::hasAVX512VL() {
+        return getFlags().avx512vl;
+    }
+
+    bool CPUFeatures::hasSHA() {
+        return getFlags().sha;
+    }
+
+    const CPUFeatures::Flags& CPUFeatures::getFlags() {
+        static const Flags flags = detect();
+        return flags;
+    }
+
+    CPUFeatures::Flags CPUFeatures::detect() {
+        Flags flags;
+#ifdef AKASH_CPU_X64
+        uint32_t regs[4];
+        cpuid(0, 0, regs);
+        uint32_t max_leaf = regs[0];
+        if (max_leaf < 1) {
+            return flags;
+        }
+
+        cpuid(1, 0, regs);
+        uint32_t ecx = regs[2];
+        uint32_t edx = regs[3];
+        flags.sse2 = (edx >> 26) & 1;
+        flags.ssse3 = (ecx >> 9) & 1;
+        flags.sse41 = (ecx >> 19) & 1;
+        flags.aesni = (ecx >> 25) & 1;
+        flags.pclmulqdq = (ecx >> 1) & 1;
+
+        // AVX 需要操作系统通过 XSAVE 保存 XMM 和 YMM 状态
+        bool osxsave = (ecx >> 27) & 1;
+        bool avx = (ecx >> 28) & 1;
+        uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+        bool ymm = (xcr0 & 0x6) == 0x6;
+        // opmask、ZMM0~15 的高 256 位以及 ZMM16~31
+        bool zmm = ymm && (xcr0 & 0xE0) == 0xE0;
+
+        if (max_leaf >= 7) {
+            cpuid(7, 0, regs);
+            uint32_t ebx = regs[1];
+            flags.avx2 = avx && ymm && ((ebx >> 5) & 1);
+            flags.avx512f = zmm && ((ebx >> 16) & 1);
+            flags.avx512vl = flags.avx512f && ((ebx >> 31) & 1);
+            flags.sha = (ebx >> 29) & 1;
+        }
+#endif
+        return flags;
+    }
+
+}
+}
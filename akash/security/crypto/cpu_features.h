@@ -0,0 +1,51 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_CPU_FEATURES_H_
+#define AKASH_SECURITY_CRYPTO_CPU_FEATURES_H_
+
+
+namespace akash {
+namespace crypto {
+
+    // 通过 CPUID 检测的 x86-64 指令集扩展，用于在运行时选择实现。
+    // 只在第一次查询时检测。非 x86-64 平台上均返回 false。
+    class CPUFeatures {
+    public:
+        static bool hasSSE2();
+        static bool hasSSSE3();
+        static bool hasSSE41();
+        static bool hasAESNI();
+        static bool hasPCLMULQDQ();
+        // 同时检查操作系统是否保存 YMM 寄存器
+        static bool hasAVX2();
+        // 同时检查操作系统是否保存 ZMM 寄存器和掩码寄存器
+        static bool hasAVX512F();
+        // AVX-512 指令用于 128/256 位寄存器
+        static bool hasAVX512VL();
+        static bool hasSHA();
+
+    private:
+        struct Flags {
+            bool sse2 = false;
+            bool ssse3 = false;
+            bool sse41 = false;
+            bool aesni = false;
+            bool pclmulqdq = false;
+            bool avx2 = false;
+            bool avx512f = false;
+            bool avx512vl = false;
+            bool sha = false;
+        };
+
+        static const Flags& getFlags();
+        static Flags detect();
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_CPU_FEATURES_H_
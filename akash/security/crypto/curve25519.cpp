@@ -0,0 +1,304 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/crypto/curve25519.h"
+
+#include <random>
+
+#include "akash/security/crypto/uint128.h"
+
+
+namespace {
+
+    const uint64_t kMask51 = (uint64_t(1) << 51) - 1;
+
+    // (A - 2) / 4
+    const uint32_t kA24 = 121665;
+
+    uint64_t load64LE(const uint8_t* in) {
+        uint64_t r = 0;
+        for (int i = 7; i >= 0; --i) {
+            r = (r << 8) | in[i];
+        }
+        return r;
+    }
+
+    void store64LE(uint64_t v, uint8_t* out) {
+        for (int i = 0; i < 8; ++i) {
+            out[i] = uint8_t(v >> (i * 8));
+        }
+    }
+
+    // 进位一轮，2^255 ≡ 19 (mod p)
+    void carryReduce(uint64_t t[5]) {
+        t[1] += t[0] >> 51; t[0] &= kMask51;
+        t[2] += t[1] >> 51; t[1] &= kMask51;
+        t[3] += t[2] >> 51; t[2] &= kMask51;
+        t[4] += t[3] >> 51; t[3] &= kMask51;
+        t[0] += 19 * (t[4] >> 51); t[4] &= kMask51;
+    }
+
+}
+
+namespace akash {
+namespace crypto {
+
+    void Curve25519::generateKey(uint8_t priv[kKeySize], uint8_t pub[kKeySize]) {
+        std::random_device rd;
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (size_t i = 0; i < kKeySize; ++i) {
+            priv[i] = uint8_t(dist(rd));
+        }
+
+        uint8_t base[kKeySize] = { 9 };
+        X25519(pub, priv, base);
+    }
+
+    bool Curve25519::X25519(
+        uint8_t out[kKeySize], const uint8_t scalar[kKeySize], const uint8_t u[kKeySize])
+    {
+        uint8_t k[kKeySize];
+        for (size_t i = 0; i < kKeySize; ++i) {
+            k[i] = scalar[i];
+        }
+        k[0] &= 248;
+        k[31] &= 127;
+        k[31] |= 64;
+
+        Felem x1;
+        feFromBytes(u, &x1);
+
+        Felem x2 = { { 1, 0, 0, 0, 0 } };
+        Felem z2 = { { 0, 0, 0, 0, 0 } };
+        Felem x3 = x1;
+        Felem z3 = { { 1, 0, 0, 0, 0 } };
+        uint64_t swap = 0;
+
+        Felem A, AA, B, BB, E, C, D, DA, CB, t;
+        for (int i = 254; i >= 0; --i) {
+            uint64_t kt = (k[i >> 3] >> (i & 7)) & 1;
+            swap ^= kt;
+            feCSwap(swap, &x2, &x3);
+            feCSwap(swap, &z2, &z3);
+            swap = kt;
+
+            feAdd(x2, z2, &A);
+            feSqr(A, &AA);
+            feSub(x2, z2, &B);
+            feSqr(B, &BB);
+            feSub(AA, BB, &E);
+            feAdd(x3, z3, &C);
+            feSub(x3, z3, &D);
+            feMul(D, A, &DA);
+            feMul(C, B, &CB);
+
+            // x3 = (DA + CB)^2
+            feAdd(DA, CB, &t);
+            feSqr(t, &x3);
+
+            // z3 = x1 * (DA - CB)^2
+            feSub(DA, CB, &t);
+            feSqr(t, &t);
+            feMul(x1, t, &z3);
+
+            // x2 = AA * BB
+            feMul(AA, BB, &x2);
+
+            // z2 = E * (AA + a24 * E)
+            feMulSmall(E, kA24, &t);
+            feAdd(AA, t, &t);
+            feMul(E, t, &z2);
+        }
+
+        feCSwap(swap, &x2, &x3);
+        feCSwap(swap, &z2, &z3);
+
+        feInv(z2, &z2);
+        feMul(x2, z2, &x2);
+        feToBytes(x2, out);
+
+        uint8_t nonzero = 0;
+        for (size_t i = 0; i < kKeySize; ++i) {
+            nonzero |= out[i];
+        }
+        return nonzero != 0;
+    }
+
+    void Curve25519::feFromBytes(const uint8_t in[kKeySize], Felem* out) {
+        // 最高位被忽略
+        out->v[0] = load64LE(in) & kMask51;
+        out->v[1] = (load64LE(in + 6) >> 3) & kMask51;
+        out->v[2] = (load64LE(in + 12) >> 6) & kMask51;
+        out->v[3] = (load64LE(in + 19) >> 1) & kMask51;
+        out->v[4] = (load64LE(in + 24) >> 12) & kMask51;
+    }
+
+    void Curve25519::feToBytes(const Felem& in, uint8_t out[kKeySize]) {
+        uint64_t t[5];
+        for (int i = 0; i < 5; ++i) {
+            t[i] = in.v[i];
+        }
+
+        // 两轮进位后 t 位于 [0, 2^255 - 1]
+        carryReduce(t);
+        carryReduce(t);
+
+        // 加 19 后再进位，t 位于 [19, 2^255 - 1]，且比实际值大 19
+        t[0] += 19;
+        carryReduce(t);
+
+        // 加上 2^255 - 19，t 位于 [2^255, 2^256 - 20]，去掉 2^255 即得到 [0, p) 中的值
+        t[0] += (uint64_t(1) << 51) - 19;
+        t[1] += (uint64_t(1) << 51) - 1;
+        t[2] += (uint64_t(1) << 51) - 1;
+        t[3] += (uint64_t(1) << 51) - 1;
+        t[4] += (uint64_t(1) << 51) - 1;
+
+        t[1] += t[0] >> 51; t[0] &= kMask51;
+        t[2] += t[1] >> 51; t[1] &= kMask51;
+        t[3] += t[2] >> 51; t[2] &= kMask51;
+        t[4] += t[3] >> 51; t[3] &= kMask51;
+        t[4] &= kMask51;
+
+        store64LE(t[0] | (t[1] << 51), out);
+        store64LE((t[1] >> 13) | (t[2] << 38), out + 8);
+        store64LE((t[2] >> 26) | (t[3] << 25), out + 16);
+        store64LE((t[3] >> 39) | (t[4] << 12), out + 24);
+    }
+
+    void Curve25519::feAdd(const Felem& a, const Felem& b, Felem* r) {
+        for (int i = 0; i < 5; ++i) {
+            r->v[i] = a.v[i] + b.v[i];
+        }
+    }
+
+    void Curve25519::feSub(const Felem& a, const Felem& b, Felem* r) {
+        // a + 2p - b，要求 b 的各分量不超过 52 位
+        r->v[0] = a.v[0] + 0xFFFFFFFFFFFDA - b.v[0];
+        r->v[1] = a.v[1] + 0xFFFFFFFFFFFFE - b.v[1];
+        r->v[2] = a.v[2] + 0xFFFFFFFFFFFFE - b.v[2];
+        r->v[3] = a.v[3] + 0xFFFFFFFFFFFFE - b.v[3];
+        r->v[4] = a.v[4] + 0xFFFFFFFFFFFFE - b.v[4];
+    }
+
+    void Curve25519::feMul(const Felem& a, const Felem& b, Felem* r) {
+        uint64_t a0 = a.v[0], a1 = a.v[1], a2 = a.v[2], a3 = a.v[3], a4 = a.v[4];
+        uint64_t b0 = b.v[0], b1 = b.v[1], b2 = b.v[2], b3 = b.v[3], b4 = b.v[4];
+
+        // 超过 2^255 的部分乘以 19 折回低位
+        uint64_t b1_19 = b1 * 19, b2_19 = b2 * 19, b3_19 = b3 * 19, b4_19 = b4 * 19;
+
+        UInt128 t0 = mul64(a0, b0) + mul64(a1, b4_19) + mul64(a2, b3_19) + mul64(a3, b2_19) + mul64(a4, b1_19);
+        UInt128 t1 = mul64(a0, b1) + mul64(a1, b0) + mul64(a2, b4_19) + mul64(a3, b3_19) + mul64(a4, b2_19);
+        UInt128 t2 = mul64(a0, b2) + mul64(a1, b1) + mul64(a2, b0) + mul64(a3, b4_19) + mul64(a4, b3_19);
+        UInt128 t3 = mul64(a0, b3) + mul64(a1, b2) + mul64(a2, b1) + mul64(a3, b0) + mul64(a4, b4_19);
+        UInt128 t4 = mul64(a0, b4) + mul64(a1, b3) + mul64(a2, b2) + mul64(a3, b1) + mul64(a4, b0);
+
+        uint64_t r0, r1, r2, r3, r4;
+        r0 = uint64_t(t0) & kMask51; t1 += uint64_t(t0 >> 51);
+        r1 = uint64_t(t1) & kMask51; t2 += uint64_t(t1 >> 51);
+        r2 = uint64_t(t2) & kMask51; t3 += uint64_t(t2 >> 51);
+        r3 = uint64_t(t3) & kMask51; t4 += uint64_t(t3 >> 51);
+        r4 = uint64_t(t4) & kMask51;
+        r0 += uint64_t(t4 >> 51) * 19;
+        r1 += r0 >> 51; r0 &= kMask51;
+
+        r->v[0] = r0; r->v[1] = r1; r->v[2] = r2; r->v[3] = r3; r->v[4] = r4;
+    }
+
+    void Curve25519::feMulSmall(const Felem& a, uint32_t b, Felem* r) {
+        UInt128 t0 = mul64(a.v[0], b);
+        UInt128 t1 = mul64(a.v[1], b);
+        UInt128 t2 = mul64(a.v[2], b);
+        UInt128 t3 = mul64(a.v[3], b);
+        UInt128 t4 = mul64(a.v[4], b);
+
+        uint64_t r0, r1, r2, r3, r4;
+        r0 = uint64_t(t0) & kMask51; t1 += uint64_t(t0 >> 51);
+        r1 = uint64_t(t1) & kMask51; t2 += uint64_t(t1 >> 51);
+        r2 = uint64_t(t2) & kMask51; t3 += uint64_t(t2 >> 51);
+        r3 = uint64_t(t3) & kMask51; t4 += uint64_t(t3 >> 51);
+        r4 = uint64_t(t4) & kMask51;
+        r0 += uint64_t(t4 >> 51) * 19;
+        r1 += r0 >> 51; r0 &= kMask51;
+
+        r->v[0] = r0; r->v[1] = r1; r->v[2] = r2; r->v[3] = r3; r->v[4] = r4;
+    }
+
+    void Curve25519::feSqr(const Felem& a, Felem* r) {
+        uint64_t a0 = a.v[0], a1 = a.v[1], a2 = a.v[2], a3 = a.v[3], a4 = a.v[4];
+
+        uint64_t d0 = a0 * 2;
+        uint64_t d1 = a1 * 2;
+        uint64_t d2_19 = a2 * 2 * 19;
+        uint64_t a4_19 = a4 * 19;
+        uint64_t d4_19 = a4_19 * 2;
+
+        UInt128 t0 = mul64(a0, a0) + mul64(d4_19, a1) + mul64(d2_19, a3);
+        UInt128 t1 = mul64(d0, a1) + mul64(d4_19, a2) + mul64(a3, a3 * 19);
+        UInt128 t2 = mul64(d0, a2) + mul64(a1, a1) + mul64(d4_19, a3);
+        UInt128 t3 = mul64(d0, a3) + mul64(d1, a2) + mul64(a4, a4_19);
+        UInt128 t4 = mul64(d0, a4) + mul64(d1, a3) + mul64(a2, a2);
+
+        uint64_t r0, r1, r2, r3, r4;
+        r0 = uint64_t(t0) & kMask51; t1 += uint64_t(t0 >> 51);
+        r1 = uint64_t(t1) & kMask51; t2 += uint64_t(t1 >> 51);
+        r2 = uint64_t(t2) & kMask51; t3 += uint64_t(t2 >> 51);
+        r3 = uint64_t(t3) & kMask51; t4 += uint64_t(t3 >> 51);
+        r4 = uint64_t(t4) & kMask51;
+        r0 += uint64_t(t4 >> 51) * 19;
+        r1 += r0 >> 51; r0 &= kMask51;
+
+        r->v[0] = r0; r->v[1] = r1; r->v[2] = r2; r->v[3] = r3; r->v[4] = r4;
+    }
+
+    void Curve25519::feSqrN(const Felem& a, int n, Felem* r) {
+        feSqr(a, r);
+        for (int i = 1; i < n; ++i) {
+            feSqr(*r, r);
+        }
+    }
+
+    void Curve25519::feInv(const Felem& a, Felem* r) {
+        // a^(p-2) = a^(2^255 - 21)
+        Felem z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+        feSqr(a, &z2);                  // 2
+        feSqrN(z2, 2, &t);              // 8
+        feMul(t, a, &z9);               // 9
+        feMul(z9, z2, &z11);            // 11
+        feSqr(z11, &t);                 // 22
+        feMul(t, z9, &z2_5_0);          // 2^5 - 2^0
+
+        feSqrN(z2_5_0, 5, &t);
+        feMul(t, z2_5_0, &z2_10_0);     // 2^10 - 2^0
+        feSqrN(z2_10_0, 10, &t);
+        feMul(t, z2_10_0, &z2_20_0);    // 2^20 - 2^0
+        feSqrN(z2_20_0, 20, &t);
+        feMul(t, z2_20_0, &t);          // 2^40 - 2^0
+        feSqrN(t, 10, &t);
+        feMul(t, z2_10_0, &z2_50_0);    // 2^50 - 2^0
+        feSqrN(z2_50_0, 50, &t);
+        feMul(t, z2_50_0, &z2_100_0);   // 2^100 - 2^0
+        feSqrN(z2_100_0, 100, &t);
+        feMul(t, z2_100_0, &t);         // 2^200 - 2^0
+        feSqrN(t, 50, &t);
+        feMul(t, z2_50_0, &t);          // 2^250 - 2^0
+        feSqrN(t, 5, &t);               // 2^255 - 2^5
+        feMul(t, z11, r);               // 2^255 - 21
+    }
+
+    void Curve25519::feCSwap(uint64_t swap, Felem* a, Felem* b) {
+        uint64_t mask = uint64_t(0) - swap;
+        for (int i = 0; i < 5; ++i) {
+            uint64_t x = (a->v[i] ^ b->v[i]) & mask;
+            a->v[i] ^= x;
+            b->v[i] ^= x;
+        }
+    }
+
+}
+}
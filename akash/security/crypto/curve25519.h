@@ -0,0 +1,57 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_CURVE25519_H_
+#define AKASH_SECURITY_CRYPTO_CURVE25519_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace akash {
+namespace crypto {
+
+    // RFC 7748 中的 X25519 函数。
+    // 域元素使用 5 个 51 位分量表示，加减法不立即约减，
+    // 求逆使用固定的加法链，整个阶梯运算不根据私钥进行分支。
+    // ECDP::X25519 保留为通用的参考实现。
+    class Curve25519 {
+    public:
+        // 标量与 u 坐标的字节数，小端序
+        static const size_t kKeySize = 32;
+
+        // 生成随机私钥，并计算 pub = X25519(priv, 9)
+        static void generateKey(uint8_t priv[kKeySize], uint8_t pub[kKeySize]);
+
+        // out = X25519(scalar, u)
+        // 标量在内部按照 RFC 7748 进行截断，u 的最高位被忽略。
+        // 结果为全 0 时（u 为小阶点）返回 false
+        static bool X25519(
+            uint8_t out[kKeySize], const uint8_t scalar[kKeySize], const uint8_t u[kKeySize]);
+
+    private:
+        // v[0] + v[1]*2^51 + v[2]*2^102 + v[3]*2^153 + v[4]*2^204
+        // 各分量允许略微超过 51 位
+        struct Felem {
+            uint64_t v[5];
+        };
+
+        static void feFromBytes(const uint8_t in[kKeySize], Felem* out);
+        static void feToBytes(const Felem& in, uint8_t out[kKeySize]);
+        static void feAdd(const Felem& a, const Felem& b, Felem* r);
+        static void feSub(const Felem& a, const Felem& b, Felem* r);
+        static void feMul(const Felem& a, const Felem& b, Felem* r);
+        static void feMulSmall(const Felem& a, uint32_t b, Felem* r);
+        static void feSqr(const Felem& a, Felem* r);
+        static void feSqrN(const Felem& a, int n, Felem* r);
+        static void feInv(const Felem& a, Felem* r);
+        static void feCSwap(uint64_t swap, Felem* a, Felem* b);
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_CURVE25519_H_
@@ -0,0 +1,282 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/crypto/curve448.h"
+
+#include <random>
+
+#include "akash/security/crypto/uint128.h"
+
+
+namespace {
+
+    const uint64_t kMask56 = (uint64_t(1) << 56) - 1;
+
+    // p = 2^448 - 2^224 - 1
+    const uint64_t kP[8] = {
+        kMask56, kMask56, kMask56, kMask56,
+        kMask56 - 1, kMask56, kMask56, kMask56 };
+
+    // (A - 2) / 4
+    const uint32_t kA24 = 39081;
+
+    // c[0..14] 为未约减的乘积，约减后写入 r。
+    // 2^448 ≡ 2^224 + 1，第 k 列 (k >= 8) 加到第 k-8 列和第 k-4 列
+    void reduceWide(akash::crypto::UInt128 c[15], uint64_t r[8]) {
+        using akash::crypto::UInt128;
+
+        // 从高往低折叠，k-4 >= 8 的部分会在之后继续被折叠
+        for (int k = 14; k >= 8; --k) {
+            c[k - 8] += c[k];
+            c[k - 4] += c[k];
+        }
+
+        for (int i = 0; i < 7; ++i) {
+            r[i] = uint64_t(c[i]) & kMask56;
+            c[i + 1] += c[i] >> 56;
+        }
+        r[7] = uint64_t(c[7]) & kMask56;
+
+        UInt128 top = c[7] >> 56;
+        UInt128 t0 = top + UInt128(r[0]);
+        UInt128 t4 = top + UInt128(r[4]);
+        r[0] = uint64_t(t0) & kMask56;
+        r[1] += uint64_t(t0 >> 56);
+        r[4] = uint64_t(t4) & kMask56;
+        r[5] += uint64_t(t4 >> 56);
+    }
+
+}
+
+namespace akash {
+namespace crypto {
+
+    void Curve448::generateKey(uint8_t priv[kKeySize], uint8_t pub[kKeySize]) {
+        std::random_device rd;
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (size_t i = 0; i < kKeySize; ++i) {
+            priv[i] = uint8_t(dist(rd));
+        }
+
+        uint8_t base[kKeySize] = { 5 };
+        X448(pub, priv, base);
+    }
+
+    bool Curve448::X448(
+        uint8_t out[kKeySize], const uint8_t scalar[kKeySize], const uint8_t u[kKeySize])
+    {
+        uint8_t k[kKeySize];
+        for (size_t i = 0; i < kKeySize; ++i) {
+            k[i] = scalar[i];
+        }
+        k[0] &= 252;
+        k[55] |= 128;
+
+        Felem x1;
+        feFromBytes(u, &x1);
+
+        Felem x2 = { { 1, 0, 0, 0, 0, 0, 0, 0 } };
+        Felem z2 = { { 0, 0, 0, 0, 0, 0, 0, 0 } };
+        Felem x3 = x1;
+        Felem z3 = { { 1, 0, 0, 0, 0, 0, 0, 0 } };
+        uint64_t swap = 0;
+
+        Felem A, AA, B, BB, E, C, D, DA, CB, t;
+        for (int i = 447; i >= 0; --i) {
+            uint64_t kt = (k[i >> 3] >> (i & 7)) & 1;
+            swap ^= kt;
+            feCSwap(swap, &x2, &x3);
+            feCSwap(swap, &z2, &z3);
+            swap = kt;
+
+            feAdd(x2, z2, &A);
+            feSqr(A, &AA);
+            feSub(x2, z2, &B);
+            feSqr(B, &BB);
+            feSub(AA, BB, &E);
+            feAdd(x3, z3, &C);
+            feSub(x3, z3, &D);
+            feMul(D, A, &DA);
+            feMul(C, B, &CB);
+
+            // x3 = (DA + CB)^2
+            feAdd(DA, CB, &t);
+            feSqr(t, &x3);
+
+            // z3 = x1 * (DA - CB)^2
+            feSub(DA, CB, &t);
+            feSqr(t, &t);
+            feMul(x1, t, &z3);
+
+            // x2 = AA * BB
+            feMul(AA, BB, &x2);
+
+            // z2 = E * (AA + a24 * E)
+            feMulSmall(E, kA24, &t);
+            feAdd(AA, t, &t);
+            feMul(E, t, &z2);
+        }
+
+        feCSwap(swap, &x2, &x3);
+        feCSwap(swap, &z2, &z3);
+
+        feInv(z2, &z2);
+        feMul(x2, z2, &x2);
+        feToBytes(x2, out);
+
+        uint8_t nonzero = 0;
+        for (size_t i = 0; i < kKeySize; ++i) {
+            nonzero |= out[i];
+        }
+        return nonzero != 0;
+    }
+
+    void Curve448::feFromBytes(const uint8_t in[kKeySize], Felem* out) {
+        // 每个分量正好 7 个字节
+        for (int i = 0; i < 8; ++i) {
+            uint64_t v = 0;
+            for (int j = 6; j >= 0; --j) {
+                v = (v << 8) | in[i * 7 + j];
+            }
+            out->v[i] = v;
+        }
+    }
+
+    void Curve448::feToBytes(const Felem& in, uint8_t out[kKeySize]) {
+        uint64_t t[8];
+        for (int i = 0; i < 8; ++i) {
+            t[i] = in.v[i];
+        }
+
+        for (int n = 0; n < 2; ++n) {
+            for (int i = 0; i < 7; ++i) {
+                t[i + 1] += t[i] >> 56;
+                t[i] &= kMask56;
+            }
+            uint64_t top = t[7] >> 56;
+            t[7] &= kMask56;
+            t[0] += top;
+            t[4] += top;
+        }
+
+        // 此时 t < 2p。先减去 p，结果为负时再加回
+        int64_t borrow = 0;
+        for (int i = 0; i < 8; ++i) {
+            borrow += int64_t(t[i]) - int64_t(kP[i]);
+            t[i] = uint64_t(borrow) & kMask56;
+            borrow >>= 56;
+        }
+
+        uint64_t mask = uint64_t(borrow);
+        uint64_t carry = 0;
+        for (int i = 0; i < 8; ++i) {
+            carry += t[i] + (kP[i] & mask);
+            t[i] = carry & kMask56;
+            carry >>= 56;
+        }
+
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 7; ++j) {
+                out[i * 7 + j] = uint8_t(t[i] >> (j * 8));
+            }
+        }
+    }
+
+    void Curve448::feAdd(const Felem& a, const Felem& b, Felem* r) {
+        for (int i = 0; i < 8; ++i) {
+            r->v[i] = a.v[i] + b.v[i];
+        }
+    }
+
+    void Curve448::feSub(const Felem& a, const Felem& b, Felem* r) {
+        // a + 2p - b，要求 b 的各分量不超过 57 位
+        for (int i = 0; i < 8; ++i) {
+            r->v[i] = a.v[i] + 2 * kP[i] - b.v[i];
+        }
+    }
+
+    void Curve448::feMul(const Felem& a, const Felem& b, Felem* r) {
+        UInt128 c[15] = {};
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                c[i + j] += mul64(a.v[i], b.v[j]);
+            }
+        }
+        reduceWide(c, r->v);
+    }
+
+    void Curve448::feMulSmall(const Felem& a, uint32_t b, Felem* r) {
+        UInt128 c[15] = {};
+        for (int i = 0; i < 8; ++i) {
+            c[i] = mul64(a.v[i], b);
+        }
+        reduceWide(c, r->v);
+    }
+
+    void Curve448::feSqr(const Felem& a, Felem* r) {
+        UInt128 c[15] = {};
+        for (int i = 0; i < 8; ++i) {
+            c[2 * i] += mul64(a.v[i], a.v[i]);
+            uint64_t d = a.v[i] * 2;
+            for (int j = i + 1; j < 8; ++j) {
+                c[i + j] += mul64(d, a.v[j]);
+            }
+        }
+        reduceWide(c, r->v);
+    }
+
+    void Curve448::feSqrN(const Felem& a, int n, Felem* r) {
+        feSqr(a, r);
+        for (int i = 1; i < n; ++i) {
+            feSqr(*r, r);
+        }
+    }
+
+    void Curve448::feInv(const Felem& a, Felem* r) {
+        // a^(p-2) = a^(2^448 - 2^224 - 3)
+        // 记 xn = a^(2^n - 1)，p-2 = (2^223 - 1) * 2^225 + (2^222 - 1) * 2^2 + 1
+        Felem x2, x3, x6, x12, x24, x30, x48, x96, x192, x222, t;
+
+        feSqr(a, &t);
+        feMul(t, a, &x2);
+        feSqr(x2, &t);
+        feMul(t, a, &x3);
+        feSqrN(x3, 3, &t);
+        feMul(t, x3, &x6);
+        feSqrN(x6, 6, &t);
+        feMul(t, x6, &x12);
+        feSqrN(x12, 12, &t);
+        feMul(t, x12, &x24);
+        feSqrN(x24, 6, &t);
+        feMul(t, x6, &x30);
+        feSqrN(x24, 24, &t);
+        feMul(t, x24, &x48);
+        feSqrN(x48, 48, &t);
+        feMul(t, x48, &x96);
+        feSqrN(x96, 96, &t);
+        feMul(t, x96, &x192);
+        feSqrN(x192, 30, &t);
+        feMul(t, x30, &x222);
+        feSqr(x222, &t);
+        feMul(t, a, &t);                // x223
+
+        feSqrN(t, 223, &t);
+        feMul(t, x222, &t);
+        feSqrN(t, 2, &t);
+        feMul(t, a, r);
+    }
+
+    void Curve448::feCSwap(uint64_t swap, Felem* a, Felem* b) {
+        uint64_t mask = uint64_t(0) - swap;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t x = (a->v[i] ^ b->v[i]) & mask;
+            a->v[i] ^= x;
+            b->v[i] ^= x;
+        }
+    }
+
+}
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_CURVE448_H_
+#define AKASH_SECURITY_CRYPTO_CURVE448_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace akash {
+namespace crypto {
+
+    // RFC 7748 中的 X448 函数。
+    // 域元素使用 8 个 56 位分量表示，利用 p = 2^448 - 2^224 - 1 的形式，
+    // 2^448 ≡ 2^224 + 1，高位只需加回到两个位置即可完成约减。
+    // ECDP::X448 保留为通用的参考实现。
+    class Curve448 {
+    public:
+        // 标量与 u 坐标的字节数，小端序
+        static const size_t kKeySize = 56;
+
+        // 生成随机私钥，并计算 pub = X448(priv, 5)
+        static void generateKey(uint8_t priv[kKeySize], uint8_t pub[kKeySize]);
+
+        // out = X448(scalar, u)
+        // 标量在内部按照 RFC 7748 进行截断。
+        // 结果为全 0 时（u 为小阶点）返回 false
+        static bool X448(
+            uint8_t out[kKeySize], const uint8_t scalar[kKeySize], const uint8_t u[kKeySize]);
+
+    private:
+        // sum(v[i] * 2^(56i))，各分量允许略微超过 56 位
+        struct Felem {
+            uint64_t v[8];
+        };
+
+        static void feFromBytes(const uint8_t in[kKeySize], Felem* out);
+        static void feToBytes(const Felem& in, uint8_t out[kKeySize]);
+        static void feAdd(const Felem& a, const Felem& b, Felem* r);
+        static void feSub(const Felem& a, const Felem& b, Felem* r);
+        static void feMul(const Felem& a, const Felem& b, Felem* r);
+        static void feMulSmall(const Felem& a, uint32_t b, Felem* r);
+        static void feSqr(const Felem& a, Felem* r);
+        static void feSqrN(const Felem& a, int n, Felem* r);
+        static void feInv(const Felem& a, Felem* r);
+        static void feCSwap(uint64_t swap, Felem* a, Felem* b);
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_CURVE448_H_
@@ -6,6 +6,55 @@
 
 #include "akash/security/crypto/ecdp.h"
 
+#include "akash/security/big_integer/fixed_big_integer.h"
+
+
+namespace {
+
+    // 足以容纳 secp521r1 的坐标，点运算过程中不进行堆分配
+    using FixedInt = utl::FixedBigInteger<521>;
+
+    // (x2, y2) = (x1, y1) + (x2, y2)
+    void addPointFixed(
+        const FixedInt& p, const FixedInt& a,
+        const FixedInt& x1, const FixedInt& y1,
+        FixedInt* x2, FixedInt* y2)
+    {
+        bool equal = (x1 == *x2) && (y1 == *y2);
+        FixedInt lambda;
+        if (equal) {
+            FixedInt de(y1);
+            de.mul2().mod(p);
+            de = de.invmod(p);
+
+            // 每次乘法之后都取模，使中间结果不超过两倍的位数
+            FixedInt no(x1);
+            no.exp2().mod(p).mul(3).add(a).mod(p).mul(de).mod(p);
+            lambda = no;
+        } else {
+            FixedInt de(*x2);
+            de.sub(x1);
+            if (de.isMinus()) {
+                de.add(p);
+            }
+            de = de.invmod(p);
+
+            FixedInt no(*y2);
+            no.sub(y1).mul(de).modP(p);
+            lambda = no;
+        }
+
+        FixedInt xr(lambda);
+        xr.exp2().sub(x1).sub(*x2).modP(p);
+
+        FixedInt yr(x1);
+        yr.sub(xr).mul(lambda).sub(y1).modP(p);
+
+        *x2 = xr;
+        *y2 = yr;
+    }
+
+}
 
 namespace akash {
 namespace crypto {
@@ -219,54 +268,37 @@ namespace crypto {
         const utl::BigInteger& x1, const utl::BigInteger& y1,
         utl::BigInteger* x2, utl::BigInteger* y2)
     {
-        bool equal = (x1 == *x2) && (y1 == *y2);
-        utl::BigInteger lambda;
-        if (equal) {
-            utl::BigInteger de(y1);
-            de.mul2();
-            de = de.invmod(p);
-
-            utl::BigInteger no(x1);
-            no.exp2().mul(3).add(a).mul(de).mod(p);
-            lambda = no;
-        } else {
-            utl::BigInteger de(*x2);
-            de.sub(x1);
-            if (de.isMinus()) {
-                de.add(p);
-            }
-            de = de.invmod(p);
-
-            utl::BigInteger no(*y2);
-            no.sub(y1).mul(de).modP(p);
-            lambda = no;
-        }
-
-        utl::BigInteger xr(lambda);
-        xr.exp2().sub(x1).sub(*x2).modP(p);
-
-        utl::BigInteger yr(x1);
-        yr.sub(xr).mul(lambda).sub(y1).modP(p);
-
-        *x2 = std::move(xr);
-        *y2 = std::move(yr);
+        auto rx = FixedInt::fromBigInteger(*x2);
+        auto ry = FixedInt::fromBigInteger(*y2);
+        addPointFixed(
+            FixedInt::fromBigInteger(p), FixedInt::fromBigInteger(a),
+            FixedInt::fromBigInteger(x1), FixedInt::fromBigInteger(y1), &rx, &ry);
+
+        *x2 = rx.toBigInteger();
+        *y2 = ry.toBigInteger();
     }
 
     void ECDP::mulPoint(
         const utl::BigInteger& p, const utl::BigInteger& a,
         const utl::BigInteger& d, utl::BigInteger* x, utl::BigInteger* y)
     {
-        utl::BigInteger rx(*x), ry(*y);
+        // 只在进出时与 BigInteger 转换
+        auto fp = FixedInt::fromBigInteger(p);
+        auto fa = FixedInt::fromBigInteger(a);
+        auto x1 = FixedInt::fromBigInteger(*x);
+        auto y1 = FixedInt::fromBigInteger(*y);
+
+        FixedInt rx(x1), ry(y1);
         int count = d.getBitCount();
         for (int i = count - 2; i >= 0; --i) {
-            addPoint(p, a, rx, ry, &rx, &ry);
+            addPointFixed(fp, fa, rx, ry, &rx, &ry);
             if (d.getBit(i)) {
-                addPoint(p, a, *x, *y, &rx, &ry);
+                addPointFixed(fp, fa, x1, y1, &rx, &ry);
             }
         }
 
-        *x = std::move(rx);
-        *y = std::move(ry);
+        *x = rx.toBigInteger();
+        *y = ry.toBigInteger();
     }
 
     bool ECDP::verifyPoint(
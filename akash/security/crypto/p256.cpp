@@ -0,0 +1,666 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/crypto/p256.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+    // p = 2^256 - 2^224 + 2^192 + 2^96 - 1，小端序
+    const uint32_t kP[8] = {
+        0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000,
+        0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF };
+
+    // p - 2，求逆时使用的指数
+    const uint32_t kPm2[8] = {
+        0xFFFFFFFD, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000,
+        0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF };
+
+    const uint32_t kB[8] = {
+        0x27D2604B, 0x3BCE3C3E, 0xCC53B0F6, 0x651D06B0,
+        0x769886BC, 0xB3EBBD55, 0xAA3A93E7, 0x5AC635D8 };
+
+    const uint32_t kGx[8] = {
+        0xD898C296, 0xF4A13945, 0x2DEB33A0, 0x77037D81,
+        0x63A440F2, 0xF8BCE6E5, 0xE12C4247, 0x6B17D1F2 };
+
+    const uint32_t kGy[8] = {
+        0x37BF51F5, 0xCBB64068, 0x6B315ECE, 0x2BCE3357,
+        0x7C0F9E16, 0x8EE7EB4A, 0xFE1A7F9B, 0x4FE342E2 };
+
+    // 基点的阶 n，大端序
+    const uint8_t kN[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xBC, 0xE6, 0xFA, 0xAD, 0xA7, 0x17, 0x9E, 0x84,
+        0xF3, 0xB9, 0xCA, 0xC2, 0xFC, 0x63, 0x25, 0x51 };
+
+    const int kWindowBits = 5;
+    // ceil(257 / 5)，Booth 编码可能向最高位进一
+    const int kWindowCount = 52;
+    // 窗口值的绝对值范围为 [0, 16]
+    const int kTableSize = 16;
+
+    // a == b 时返回全 1，否则返回全 0
+    uint32_t eqMask(uint32_t a, uint32_t b) {
+        uint64_t t = uint64_t(a ^ b) - 1;
+        return uint32_t(0) - uint32_t(t >> 63);
+    }
+
+    // 取出第 i 个窗口：从第 5i-1 位开始的 6 位，k 为 33 字节小端序
+    uint32_t getWindow(const uint8_t* k, int i) {
+        if (i == 0) {
+            return (uint32_t(k[0]) << 1) & 0x3F;
+        }
+        int bit = i * kWindowBits - 1;
+        uint32_t w = k[bit / 8] | (uint32_t(k[bit / 8 + 1]) << 8);
+        return (w >> (bit % 8)) & 0x3F;
+    }
+
+    // 将 6 位窗口值转换为带符号的数字，返回 (|d| << 1) | sign
+    uint32_t boothRecode(uint32_t in) {
+        uint32_t s = ~((in >> 5) - 1);
+        uint32_t d = (1 << 6) - in - 1;
+        d = (d & s) | (in & ~s);
+        d = (d >> 1) + (d & 1);
+        return (d << 1) + (s & 1);
+    }
+
+}
+
+namespace akash {
+namespace crypto {
+
+    bool P256::generateKey(uint8_t priv[kScalarSize], uint8_t pub[kPointSize]) {
+        std::random_device rd;
+        std::uniform_int_distribution<int> dist(0, 255);
+
+        do {
+            for (size_t i = 0; i < kScalarSize; ++i) {
+                priv[i] = uint8_t(dist(rd));
+            }
+        } while (!isValidScalar(priv));
+
+        return computePublicKey(priv, pub);
+    }
+
+    bool P256::computePublicKey(const uint8_t priv[kScalarSize], uint8_t pub[kPointSize]) {
+        if (!isValidScalar(priv)) {
+            return false;
+        }
+
+        Point r;
+        scalarMulBase(priv, &r);
+
+        AffinePoint ar;
+        pointToAffine(r, &ar);
+        encodePoint(ar, pub);
+        return true;
+    }
+
+    bool P256::ECDH(
+        const uint8_t priv[kScalarSize], const uint8_t peer[kPointSize],
+        uint8_t secret[kScalarSize])
+    {
+        if (!isValidScalar(priv) || !verifyPoint(peer)) {
+            return false;
+        }
+
+        AffinePoint p;
+        feFromBytes(peer + 1, &p.x);
+        feFromBytes(peer + 1 + kScalarSize, &p.y);
+
+        Point r;
+        scalarMul(priv, p, &r);
+        if (feIsZero(r.Z)) {
+            return false;
+        }
+
+        AffinePoint ar;
+        pointToAffine(r, &ar);
+        feToBytes(ar.x, secret);
+        return true;
+    }
+
+    bool P256::verifyPoint(const uint8_t pt[kPointSize]) {
+        if (pt[0] != 0x04) {
+            return false;
+        }
+
+        AffinePoint p;
+        if (!feFromBytes(pt + 1, &p.x) ||
+            !feFromBytes(pt + 1 + kScalarSize, &p.y))
+        {
+            return false;
+        }
+        return isOnCurve(p);
+    }
+
+    bool P256::feFromBytes(const uint8_t in[kScalarSize], Felem* out) {
+        for (int i = 0; i < 8; ++i) {
+            const uint8_t* b = in + (7 - i) * 4;
+            out->v[i] = (uint32_t(b[0]) << 24) |
+                (uint32_t(b[1]) << 16) |
+                (uint32_t(b[2]) << 8) |
+                uint32_t(b[3]);
+        }
+
+        // in < p 当且仅当 in - p 产生借位
+        uint64_t borrow = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t t = uint64_t(out->v[i]) - kP[i] - borrow;
+            borrow = (t >> 32) & 1;
+        }
+        return borrow != 0;
+    }
+
+    void P256::feToBytes(const Felem& in, uint8_t out[kScalarSize]) {
+        for (int i = 0; i < 8; ++i) {
+            uint8_t* b = out + (7 - i) * 4;
+            b[0] = uint8_t(in.v[i] >> 24);
+            b[1] = uint8_t(in.v[i] >> 16);
+            b[2] = uint8_t(in.v[i] >> 8);
+            b[3] = uint8_t(in.v[i]);
+        }
+    }
+
+    void P256::feAdd(const Felem& a, const Felem& b, Felem* r) {
+        uint32_t sum[8];
+        uint64_t carry = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t t = uint64_t(a.v[i]) + b.v[i] + carry;
+            sum[i] = uint32_t(t);
+            carry = t >> 32;
+        }
+
+        uint32_t diff[8];
+        uint64_t borrow = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t t = uint64_t(sum[i]) - kP[i] - borrow;
+            diff[i] = uint32_t(t);
+            borrow = (t >> 32) & 1;
+        }
+
+        // 有进位或相减无借位时，sum >= p
+        uint32_t mask = uint32_t(0) - uint32_t(carry | (borrow ^ 1));
+        for (int i = 0; i < 8; ++i) {
+            r->v[i] = (diff[i] & mask) | (sum[i] & ~mask);
+        }
+    }
+
+    void P256::feSub(const Felem& a, const Felem& b, Felem* r) {
+        uint32_t diff[8];
+        uint64_t borrow = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t t = uint64_t(a.v[i]) - b.v[i] - borrow;
+            diff[i] = uint32_t(t);
+            borrow = (t >> 32) & 1;
+        }
+
+        // 有借位时加回 p
+        uint32_t mask = uint32_t(0) - uint32_t(borrow);
+        uint64_t carry = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t t = uint64_t(diff[i]) + (kP[i] & mask) + carry;
+            r->v[i] = uint32_t(t);
+            carry = t >> 32;
+        }
+    }
+
+    void P256::feMul(const Felem& a, const Felem& b, Felem* r) {
+        uint32_t c[16] = { 0 };
+        for (int i = 0; i < 8; ++i) {
+            uint64_t carry = 0;
+            for (int j = 0; j < 8; ++j) {
+                uint64_t t = uint64_t(a.v[i]) * b.v[j] + c[i + j] + carry;
+                c[i + j] = uint32_t(t);
+                carry = t >> 32;
+            }
+            c[i + 8] = uint32_t(carry);
+        }
+        feReduce(c, r);
+    }
+
+    void P256::feSqr(const Felem& a, Felem* r) {
+        feMul(a, a, r);
+    }
+
+    void P256::feInv(const Felem& a, Felem* r) {
+        // a^(p-2)，指数是公开的，可以按位分支
+        Felem t = { { 1, 0, 0, 0, 0, 0, 0, 0 } };
+        for (int i = 255; i >= 0; --i) {
+            feSqr(t, &t);
+            if ((kPm2[i / 32] >> (i % 32)) & 1) {
+                feMul(t, a, &t);
+            }
+        }
+        *r = t;
+    }
+
+    void P256::feReduce(const uint32_t c[16], Felem* r) {
+        // FIPS 186-4 D.2.3:
+        // T + 2*S1 + 2*S2 + S3 + S4 - D1 - D2 - D3 - D4
+        // 按字展开后逐字累加，每个累加值的范围约为 [-4*2^32, 7*2^32]
+        int64_t c0 = c[0], c1 = c[1], c2 = c[2], c3 = c[3];
+        int64_t c4 = c[4], c5 = c[5], c6 = c[6], c7 = c[7];
+        int64_t c8 = c[8], c9 = c[9], c10 = c[10], c11 = c[11];
+        int64_t c12 = c[12], c13 = c[13], c14 = c[14], c15 = c[15];
+
+        int64_t acc[8];
+        acc[0] = c0 + c8 + c9 - c11 - c12 - c13 - c14;
+        acc[1] = c1 + c9 + c10 - c12 - c13 - c14 - c15;
+        acc[2] = c2 + c10 + c11 - c13 - c14 - c15;
+        acc[3] = c3 + 2 * c11 + 2 * c12 + c13 - c15 - c8 - c9;
+        acc[4] = c4 + 2 * c12 + 2 * c13 + c14 - c9 - c10;
+        acc[5] = c5 + 2 * c13 + 2 * c14 + c15 - c10 - c11;
+        acc[6] = c6 + 3 * c14 + 2 * c15 + c13 - c8 - c9;
+        acc[7] = c7 + 3 * c15 + c8 - c10 - c11 - c12 - c13;
+
+        uint32_t w[8];
+        int64_t carry = 0;
+        for (int i = 0; i < 8; ++i) {
+            carry += acc[i];
+            w[i] = uint32_t(carry);
+            carry >>= 32;
+        }
+
+        // 2^256 ≡ 2^224 - 2^192 - 2^96 + 1 (mod p)
+        // 将溢出的部分折回低位。第一次折叠后溢出至多为 ±1，
+        // 第二次之后为 0，为保持常数时间固定执行三次
+        for (int n = 0; n < 3; ++n) {
+            int64_t t = carry;
+            const int64_t fold[8] = { t, 0, 0, -t, 0, 0, -t, t };
+            carry = 0;
+            for (int i = 0; i < 8; ++i) {
+                carry += int64_t(w[i]) + fold[i];
+                w[i] = uint32_t(carry);
+                carry >>= 32;
+            }
+        }
+
+        // 此时 w < 2^256 < 2p
+        uint32_t diff[8];
+        uint64_t borrow = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t t = uint64_t(w[i]) - kP[i] - borrow;
+            diff[i] = uint32_t(t);
+            borrow = (t >> 32) & 1;
+        }
+
+        uint32_t mask = uint32_t(0) - uint32_t(borrow);
+        for (int i = 0; i < 8; ++i) {
+            r->v[i] = (w[i] & mask) | (diff[i] & ~mask);
+        }
+    }
+
+    uint32_t P256::feIsZero(const Felem& a) {
+        uint32_t x = 0;
+        for (int i = 0; i < 8; ++i) {
+            x |= a.v[i];
+        }
+        return eqMask(x, 0);
+    }
+
+    void P256::feSelect(uint32_t mask, const Felem& a, Felem* r) {
+        for (int i = 0; i < 8; ++i) {
+            r->v[i] = (a.v[i] & mask) | (r->v[i] & ~mask);
+        }
+    }
+
+    void P256::pointDouble(const Point& a, Point* r) {
+        // dbl-2001-b，a = -3
+        // https://hyperelliptic.org/EFD/g1p/auto-shortw-jacobian-3.html
+        Felem delta, gamma, beta, alpha, t0, t1;
+        feSqr(a.Z, &delta);
+        feSqr(a.Y, &gamma);
+        feMul(a.X, gamma, &beta);
+
+        // alpha = 3 * (X1 - delta) * (X1 + delta)
+        feSub(a.X, delta, &t0);
+        feAdd(a.X, delta, &t1);
+        feMul(t0, t1, &t0);
+        feAdd(t0, t0, &alpha);
+        feAdd(alpha, t0, &alpha);
+
+        Point out;
+
+        // Z3 = (Y1 + Z1)^2 - gamma - delta
+        feAdd(a.Y, a.Z, &t0);
+        feSqr(t0, &t0);
+        feSub(t0, gamma, &t0);
+        feSub(t0, delta, &out.Z);
+
+        // X3 = alpha^2 - 8 * beta
+        Felem beta4, beta8;
+        feAdd(beta, beta, &beta4);
+        feAdd(beta4, beta4, &beta4);
+        feAdd(beta4, beta4, &beta8);
+        feSqr(alpha, &out.X);
+        feSub(out.X, beta8, &out.X);
+
+        // Y3 = alpha * (4 * beta - X3) - 8 * gamma^2
+        feSub(beta4, out.X, &t0);
+        feMul(alpha, t0, &out.Y);
+        feSqr(gamma, &t1);
+        feAdd(t1, t1, &t1);
+        feAdd(t1, t1, &t1);
+        feAdd(t1, t1, &t1);
+        feSub(out.Y, t1, &out.Y);
+
+        *r = out;
+    }
+
+    void P256::pointAdd(const Point& a, const Point& b, Point* r) {
+        // add-2007-bl
+        Felem z1z1, z2z2, u1, u2, s1, s2, h, rr, i, j, v, t;
+        feSqr(a.Z, &z1z1);
+        feSqr(b.Z, &z2z2);
+        feMul(a.X, z2z2, &u1);
+        feMul(b.X, z1z1, &u2);
+        feMul(a.Y, b.Z, &s1);
+        feMul(s1, z2z2, &s1);
+        feMul(b.Y, a.Z, &s2);
+        feMul(s2, z1z1, &s2);
+        feSub(u2, u1, &h);
+        feSub(s2, s1, &rr);
+
+        uint32_t a_inf = feIsZero(a.Z);
+        uint32_t b_inf = feIsZero(b.Z);
+        // 两点相同时公式不适用，改用倍点的结果。
+        // 是否相同取决于秘密数据，因此总是计算倍点，最后用掩码选择
+        uint32_t same = feIsZero(h) & feIsZero(rr) & ~a_inf & ~b_inf;
+        Point doubled;
+        pointDouble(a, &doubled);
+
+        // I = (2 * H)^2, J = H * I, r = 2 * (S2 - S1), V = U1 * I
+        feAdd(h, h, &i);
+        feSqr(i, &i);
+        feMul(h, i, &j);
+        feAdd(rr, rr, &rr);
+        feMul(u1, i, &v);
+
+        Point out;
+
+        // X3 = r^2 - J - 2 * V
+        feSqr(rr, &out.X);
+        feSub(out.X, j, &out.X);
+        feSub(out.X, v, &out.X);
+        feSub(out.X, v, &out.X);
+
+        // Y3 = r * (V - X3) - 2 * S1 * J
+        feSub(v, out.X, &t);
+        feMul(rr, t, &out.Y);
+        feMul(s1, j, &t);
+        feAdd(t, t, &t);
+        feSub(out.Y, t, &out.Y);
+
+        // Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) * H
+        feAdd(a.Z, b.Z, &t);
+        feSqr(t, &t);
+        feSub(t, z1z1, &t);
+        feSub(t, z2z2, &t);
+        feMul(t, h, &out.Z);
+
+        // 任一点为无穷远点时取另一点
+        feSelect(a_inf, b.X, &out.X);
+        feSelect(a_inf, b.Y, &out.Y);
+        feSelect(a_inf, b.Z, &out.Z);
+        feSelect(b_inf, a.X, &out.X);
+        feSelect(b_inf, a.Y, &out.Y);
+        feSelect(b_inf, a.Z, &out.Z);
+        feSelect(same, doubled.X, &out.X);
+        feSelect(same, doubled.Y, &out.Y);
+        feSelect(same, doubled.Z, &out.Z);
+
+        *r = out;
+    }
+
+    void P256::pointAddMixed(const Point& a, const AffinePoint& b, uint32_t b_inf, Point* r) {
+        // madd-2007-bl，Z2 = 1
+        Felem z1z1, u2, s2, h, hh, rr, i, j, v, t;
+        feSqr(a.Z, &z1z1);
+        feMul(b.x, z1z1, &u2);
+        feMul(b.y, a.Z, &s2);
+        feMul(s2, z1z1, &s2);
+        feSub(u2, a.X, &h);
+        feSub(s2, a.Y, &rr);
+
+        uint32_t a_inf = feIsZero(a.Z);
+        uint32_t same = feIsZero(h) & feIsZero(rr) & ~a_inf & ~b_inf;
+        Point doubled;
+        pointDouble(a, &doubled);
+
+        // HH = H^2, I = 4 * HH, J = H * I, r = 2 * (S2 - Y1), V = X1 * I
+        feSqr(h, &hh);
+        feAdd(hh, hh, &i);
+        feAdd(i, i, &i);
+        feMul(h, i, &j);
+        feAdd(rr, rr, &rr);
+        feMul(a.X, i, &v);
+
+        Point out;
+
+        // X3 = r^2 - J - 2 * V
+        feSqr(rr, &out.X);
+        feSub(out.X, j, &out.X);
+        feSub(out.X, v, &out.X);
+        feSub(out.X, v, &out.X);
+
+        // Y3 = r * (V - X3) - 2 * Y1 * J
+        feSub(v, out.X, &t);
+        feMul(rr, t, &out.Y);
+        feMul(a.Y, j, &t);
+        feAdd(t, t, &t);
+        feSub(out.Y, t, &out.Y);
+
+        // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+        feAdd(a.Z, h, &t);
+        feSqr(t, &t);
+        feSub(t, z1z1, &t);
+        feSub(t, hh, &out.Z);
+
+        const Felem one = { { 1, 0, 0, 0, 0, 0, 0, 0 } };
+        feSelect(a_inf, b.x, &out.X);
+        feSelect(a_inf, b.y, &out.Y);
+        feSelect(a_inf, one, &out.Z);
+        feSelect(b_inf, a.X, &out.X);
+        feSelect(b_inf, a.Y, &out.Y);
+        feSelect(b_inf, a.Z, &out.Z);
+        feSelect(same, doubled.X, &out.X);
+        feSelect(same, doubled.Y, &out.Y);
+        feSelect(same, doubled.Z, &out.Z);
+
+        *r = out;
+    }
+
+    void P256::pointToAffine(const Point& a, AffinePoint* r) {
+        Felem zinv, zinv2;
+        feInv(a.Z, &zinv);
+        feSqr(zinv, &zinv2);
+        feMul(a.X, zinv2, &r->x);
+        feMul(zinv2, zinv, &zinv2);
+        feMul(a.Y, zinv2, &r->y);
+    }
+
+    void P256::scalarMul(const uint8_t k[kScalarSize], const AffinePoint& p, Point* r) {
+        uint8_t k_le[kScalarSize + 1];
+        for (size_t i = 0; i < kScalarSize; ++i) {
+            k_le[i] = k[kScalarSize - 1 - i];
+        }
+        k_le[kScalarSize] = 0;
+
+        // table[i] = (i + 1) * P
+        const Felem one = { { 1, 0, 0, 0, 0, 0, 0, 0 } };
+        Point table[kTableSize];
+        table[0].X = p.x;
+        table[0].Y = p.y;
+        table[0].Z = one;
+        pointDouble(table[0], &table[1]);
+        for (int i = 2; i < kTableSize; ++i) {
+            pointAdd(table[i - 1], table[0], &table[i]);
+        }
+
+        const Felem zero = { { 0 } };
+        Point acc = { zero, zero, zero };
+        for (int i = kWindowCount - 1; i >= 0; --i) {
+            for (int j = 0; j < kWindowBits; ++j) {
+                pointDouble(acc, &acc);
+            }
+
+            uint32_t wv = boothRecode(getWindow(k_le, i));
+            uint32_t sign = wv & 1;
+            uint32_t digit = wv >> 1;
+
+            // 扫描整张表，不按秘密数据寻址
+            Point t = { zero, zero, zero };
+            for (int j = 0; j < kTableSize; ++j) {
+                uint32_t mask = eqMask(digit, uint32_t(j + 1));
+                feSelect(mask, table[j].X, &t.X);
+                feSelect(mask, table[j].Y, &t.Y);
+                feSelect(mask, table[j].Z, &t.Z);
+            }
+
+            Felem neg_y;
+            feSub(zero, t.Y, &neg_y);
+            feSelect(uint32_t(0) - sign, neg_y, &t.Y);
+
+            pointAdd(acc, t, &acc);
+        }
+
+        *r = acc;
+    }
+
+    void P256::scalarMulBase(const uint8_t k[kScalarSize], Point* r) {
+        uint8_t k_le[kScalarSize + 1];
+        for (size_t i = 0; i < kScalarSize; ++i) {
+            k_le[i] = k[kScalarSize - 1 - i];
+        }
+        k_le[kScalarSize] = 0;
+
+        // k * G = sum(d_i * 2^(5i) * G)，每个窗口各有一张表，不需要倍点
+        auto table = getBaseTable();
+
+        const Felem zero = { { 0 } };
+        Point acc = { zero, zero, zero };
+        for (int i = 0; i < kWindowCount; ++i) {
+            uint32_t wv = boothRecode(getWindow(k_le, i));
+            uint32_t sign = wv & 1;
+            uint32_t digit = wv >> 1;
+
+            auto row = table + i * kTableSize;
+            AffinePoint t = { zero, zero };
+            for (int j = 0; j < kTableSize; ++j) {
+                uint32_t mask = eqMask(digit, uint32_t(j + 1));
+                feSelect(mask, row[j].x, &t.x);
+                feSelect(mask, row[j].y, &t.y);
+            }
+
+            Felem neg_y;
+            feSub(zero, t.y, &neg_y);
+            feSelect(uint32_t(0) - sign, neg_y, &t.y);
+
+            pointAddMixed(acc, t, eqMask(digit, 0), &acc);
+        }
+
+        *r = acc;
+    }
+
+    bool P256::isValidScalar(const uint8_t k[kScalarSize]) {
+        // 0 < k < n
+        uint32_t borrow = 0;
+        uint32_t nonzero = 0;
+        for (int i = int(kScalarSize) - 1; i >= 0; --i) {
+            uint32_t t = uint32_t(k[i]) - kN[i] - borrow;
+            borrow = (t >> 8) & 1;
+            nonzero |= k[i];
+        }
+        return (borrow & ~eqMask(nonzero, 0) & 1) != 0;
+    }
+
+    bool P256::isOnCurve(const AffinePoint& p) {
+        // y^2 = x^3 - 3x + b
+        Felem y2, x3, t, b;
+        feSqr(p.y, &y2);
+        feSqr(p.x, &x3);
+        feMul(x3, p.x, &x3);
+        feAdd(p.x, p.x, &t);
+        feAdd(t, p.x, &t);
+        feSub(x3, t, &x3);
+        std::memcpy(b.v, kB, sizeof(kB));
+        feAdd(x3, b, &x3);
+
+        uint32_t diff = 0;
+        for (int i = 0; i < 8; ++i) {
+            diff |= y2.v[i] ^ x3.v[i];
+        }
+        return diff == 0;
+    }
+
+    void P256::encodePoint(const AffinePoint& p, uint8_t out[kPointSize]) {
+        out[0] = 0x04;
+        feToBytes(p.x, out + 1);
+        feToBytes(p.y, out + 1 + kScalarSize);
+    }
+
+    const P256::AffinePoint* P256::getBaseTable() {
+        // table[i * 16 + j] = (j + 1) * 2^(5i) * G，仿射坐标
+        static const std::vector<AffinePoint> table = [] {
+            std::vector<AffinePoint> result(kWindowCount * kTableSize);
+
+            const Felem one = { { 1, 0, 0, 0, 0, 0, 0, 0 } };
+            Point base;
+            std::memcpy(base.X.v, kGx, sizeof(kGx));
+            std::memcpy(base.Y.v, kGy, sizeof(kGy));
+            base.Z = one;
+
+            for (int i = 0; i < kWindowCount; ++i) {
+                Point row[kTableSize];
+                row[0] = base;
+                pointDouble(row[0], &row[1]);
+                for (int j = 2; j < kTableSize; ++j) {
+                    pointAdd(row[j - 1], row[0], &row[j]);
+                }
+
+                // 批量求逆：prod[j] = Z0 * Z1 * ... * Zj
+                Felem prod[kTableSize];
+                prod[0] = row[0].Z;
+                for (int j = 1; j < kTableSize; ++j) {
+                    feMul(prod[j - 1], row[j].Z, &prod[j]);
+                }
+
+                Felem inv;
+                feInv(prod[kTableSize - 1], &inv);
+                for (int j = kTableSize - 1; j >= 0; --j) {
+                    Felem zinv, zinv2;
+                    if (j > 0) {
+                        feMul(inv, prod[j - 1], &zinv);
+                        feMul(inv, row[j].Z, &inv);
+                    } else {
+                        zinv = inv;
+                    }
+
+                    auto& out = result[i * kTableSize + j];
+                    feSqr(zinv, &zinv2);
+                    feMul(row[j].X, zinv2, &out.x);
+                    feMul(zinv2, zinv, &zinv2);
+                    feMul(row[j].Y, zinv2, &out.y);
+                }
+
+                // 16 * base * 2 = 2^5 * base
+                pointDouble(row[kTableSize - 1], &base);
+            }
+            return result;
+        }();
+
+        return table.data();
+    }
+
+}
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_P256_H_
+#define AKASH_SECURITY_CRYPTO_P256_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace akash {
+namespace crypto {
+
+    // secp256r1 (NIST P-256) 的专用实现，用于 ECDHE。
+    // 域元素使用 8 个 32 位字表示，模约减采用 FIPS 186-4 D.2.3 中的快速约减；
+    // 点使用 Jacobian 坐标，任意点的标量乘法使用带符号的 5 位窗口（Booth 编码），
+    // 基点的标量乘法使用预计算表，无需倍点运算。
+    // 与私钥有关的运算不会根据秘密数据进行分支或查表寻址。
+    class P256 {
+    public:
+        // 标量（私钥）与共享密钥的字节数，大端序
+        static const size_t kScalarSize = 32;
+        // 未压缩格式的点：0x04 || X || Y
+        static const size_t kPointSize = 1 + 2 * kScalarSize;
+
+        // 生成 [1, n-1] 范围内的随机私钥及对应的公钥
+        static bool generateKey(uint8_t priv[kScalarSize], uint8_t pub[kPointSize]);
+
+        // pub = priv * G
+        static bool computePublicKey(const uint8_t priv[kScalarSize], uint8_t pub[kPointSize]);
+
+        // secret = (priv * peer).x
+        // peer 不在曲线上或结果为无穷远点时返回 false
+        static bool ECDH(
+            const uint8_t priv[kScalarSize], const uint8_t peer[kPointSize],
+            uint8_t secret[kScalarSize]);
+
+        static bool verifyPoint(const uint8_t pt[kPointSize]);
+
+    private:
+        // 小端序，每个字 32 位，值位于 [0, p)
+        struct Felem {
+            uint32_t v[8];
+        };
+
+        // Jacobian 坐标：(X/Z^2, Y/Z^3)，Z 为 0 时表示无穷远点
+        struct Point {
+            Felem X, Y, Z;
+        };
+
+        struct AffinePoint {
+            Felem x, y;
+        };
+
+        // 值不小于 p 时返回 false
+        static bool feFromBytes(const uint8_t in[kScalarSize], Felem* out);
+        static void feToBytes(const Felem& in, uint8_t out[kScalarSize]);
+        static void feAdd(const Felem& a, const Felem& b, Felem* r);
+        static void feSub(const Felem& a, const Felem& b, Felem* r);
+        static void feMul(const Felem& a, const Felem& b, Felem* r);
+        static void feSqr(const Felem& a, Felem* r);
+        static void feInv(const Felem& a, Felem* r);
+        static void feReduce(const uint32_t c[16], Felem* r);
+        // 全 1 或全 0
+        static uint32_t feIsZero(const Felem& a);
+        static void feSelect(uint32_t mask, const Felem& a, Felem* r);
+
+        static void pointDouble(const Point& a, Point* r);
+        static void pointAdd(const Point& a, const Point& b, Point* r);
+        static void pointAddMixed(const Point& a, const AffinePoint& b, uint32_t b_inf, Point* r);
+        static void pointToAffine(const Point& a, AffinePoint* r);
+
+        static void scalarMul(const uint8_t k[kScalarSize], const AffinePoint& p, Point* r);
+        static void scalarMulBase(const uint8_t k[kScalarSize], Point* r);
+
+        static bool isValidScalar(const uint8_t k[kScalarSize]);
+        static bool isOnCurve(const AffinePoint& p);
+        static void encodePoint(const AffinePoint& p, uint8_t out[kPointSize]);
+
+        static const AffinePoint* getBaseTable();
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_P256_H_
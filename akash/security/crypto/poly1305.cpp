@@ -0,0 +1,193 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/crypto/poly1305.h"
+
+#include <cstring>
+
+#include "akash/security/crypto/uint128.h"
+
+
+namespace {
+
+    const uint64_t kMask44 = (uint64_t(1) << 44) - 1;
+    const uint64_t kMask42 = (uint64_t(1) << 42) - 1;
+
+    uint64_t load64LE(const uint8_t* in) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i) {
+            v = (v << 8) | in[i];
+        }
+        return v;
+    }
+
+    void store64LE(uint64_t v, uint8_t* out) {
+        for (int i = 0; i < 8; ++i) {
+            out[i] = uint8_t(v);
+            v >>= 8;
+        }
+    }
+
+}
+
+namespace akash {
+namespace crypto {
+
+    Poly1305::Poly1305() {}
+
+    void Poly1305::init(const uint8_t key[kKeySize]) {
+        uint64_t t0 = load64LE(key);
+        uint64_t t1 = load64LE(key + 8);
+
+        // r &= 0x0ffffffc0ffffffc0ffffffc0fffffff
+        r_[0] = t0 & 0xffc0fffffff;
+        r_[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+        r_[2] = (t1 >> 24) & 0x00ffffffc0f;
+
+        h_[0] = 0;
+        h_[1] = 0;
+        h_[2] = 0;
+
+        pad_[0] = load64LE(key + 16);
+        pad_[1] = load64LE(key + 24);
+        buf_len_ = 0;
+    }
+
+    void Poly1305::update(const uint8_t* msg, size_t len) {
+        if (buf_len_ > 0) {
+            size_t n = 16 - buf_len_;
+            if (n > len) {
+                n = len;
+            }
+            std::memcpy(buf_ + buf_len_, msg, n);
+            buf_len_ += n;
+            msg += n;
+            len -= n;
+
+            if (buf_len_ < 16) {
+                return;
+            }
+            blocks(buf_, 16, uint64_t(1) << 40);
+            buf_len_ = 0;
+        }
+
+        size_t full = len - len % 16;
+        if (full > 0) {
+            blocks(msg, full, uint64_t(1) << 40);
+        }
+        std::memcpy(buf_, msg + full, len - full);
+        buf_len_ = len - full;
+    }
+
+    void Poly1305::padToBlock() {
+        if (buf_len_ > 0) {
+            std::memset(buf_ + buf_len_, 0, 16 - buf_len_);
+            blocks(buf_, 16, uint64_t(1) << 40);
+            buf_len_ = 0;
+        }
+    }
+
+    void Poly1305::finish(uint8_t tag[kTagSize]) {
+        // 最后不完整的块后面补 1，再补 0 到 16 字节
+        if (buf_len_ > 0) {
+            buf_[buf_len_] = 1;
+            std::memset(buf_ + buf_len_ + 1, 0, 16 - buf_len_ - 1);
+            blocks(buf_, 16, 0);
+            buf_len_ = 0;
+        }
+
+        uint64_t h0 = h_[0];
+        uint64_t h1 = h_[1];
+        uint64_t h2 = h_[2];
+
+        // 完全进位
+        uint64_t c;
+        c = h1 >> 44; h1 &= kMask44;
+        h2 += c; c = h2 >> 42; h2 &= kMask42;
+        h0 += c * 5; c = h0 >> 44; h0 &= kMask44;
+        h1 += c; c = h1 >> 44; h1 &= kMask44;
+        h2 += c; c = h2 >> 42; h2 &= kMask42;
+        h0 += c * 5; c = h0 >> 44; h0 &= kMask44;
+        h1 += c;
+
+        // g = h + 5 - 2^130，g 非负时 h >= p，取 g
+        uint64_t g0 = h0 + 5; c = g0 >> 44; g0 &= kMask44;
+        uint64_t g1 = h1 + c; c = g1 >> 44; g1 &= kMask44;
+        uint64_t g2 = h2 + c - (uint64_t(1) << 42);
+
+        uint64_t mask = (g2 >> 63) - 1;
+        g0 &= mask;
+        g1 &= mask;
+        g2 &= mask;
+        mask = ~mask;
+        h0 = (h0 & mask) | g0;
+        h1 = (h1 & mask) | g1;
+        h2 = (h2 & mask) | g2;
+
+        // h = (h + s) mod 2^128
+        uint64_t t0 = pad_[0];
+        uint64_t t1 = pad_[1];
+        h0 += t0 & kMask44; c = h0 >> 44; h0 &= kMask44;
+        h1 += (((t0 >> 44) | (t1 << 20)) & kMask44) + c; c = h1 >> 44; h1 &= kMask44;
+        h2 += ((t1 >> 24) & kMask42) + c; h2 &= kMask42;
+
+        store64LE(h0 | (h1 << 44), tag);
+        store64LE((h1 >> 20) | (h2 << 24), tag + 8);
+    }
+
+    void Poly1305::mac(
+        const uint8_t key[kKeySize], const uint8_t* msg, size_t len, uint8_t tag[kTagSize])
+    {
+        Poly1305 poly;
+        poly.init(key);
+        poly.update(msg, len);
+        poly.finish(tag);
+    }
+
+    void Poly1305::blocks(const uint8_t* msg, size_t len, uint64_t hibit) {
+        uint64_t r0 = r_[0];
+        uint64_t r1 = r_[1];
+        uint64_t r2 = r_[2];
+
+        // 2^130 ≡ 5 (mod p)，高位分量的乘积折回低位时乘以 5 * 2^2
+        uint64_t s1 = r1 * (5 << 2);
+        uint64_t s2 = r2 * (5 << 2);
+
+        uint64_t h0 = h_[0];
+        uint64_t h1 = h_[1];
+        uint64_t h2 = h_[2];
+
+        for (; len >= 16; len -= 16) {
+            uint64_t t0 = load64LE(msg);
+            uint64_t t1 = load64LE(msg + 8);
+
+            h0 += t0 & kMask44;
+            h1 += ((t0 >> 44) | (t1 << 20)) & kMask44;
+            h2 += ((t1 >> 24) & kMask42) | hibit;
+
+            UInt128 d0 = mul64(h0, r0) + mul64(h1, s2) + mul64(h2, s1);
+            UInt128 d1 = mul64(h0, r1) + mul64(h1, r0) + mul64(h2, s2);
+            UInt128 d2 = mul64(h0, r2) + mul64(h1, r1) + mul64(h2, r0);
+
+            uint64_t c;
+            c = uint64_t(d0 >> 44); h0 = uint64_t(d0) & kMask44;
+            d1 += UInt128(c);
+            c = uint64_t(d1 >> 44); h1 = uint64_t(d1) & kMask44;
+            d2 += UInt128(c);
+            c = uint64_t(d2 >> 42); h2 = uint64_t(d2) & kMask42;
+            h0 += c * 5; c = h0 >> 44; h0 &= kMask44;
+            h1 += c;
+
+            msg += 16;
+        }
+
+        h_[0] = h0;
+        h_[1] = h1;
+        h_[2] = h2;
+    }
+
+}
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_POLY1305_H_
+#define AKASH_SECURITY_CRYPTO_POLY1305_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace akash {
+namespace crypto {
+
+    // RFC 8439 中的 Poly1305 一次性认证码。
+    // 累加器与 r 各用 3 个 64 位分量 (44 + 44 + 42 位) 表示，
+    // 分量乘积使用 128 位整数，每块只需 9 次乘法。
+    class Poly1305 {
+    public:
+        static const size_t kKeySize = 32;
+        static const size_t kTagSize = 16;
+
+        Poly1305();
+
+        // 使用 32 字节的一次性密钥 (r || s) 开始计算
+        void init(const uint8_t key[kKeySize]);
+        // 追加消息，可多次调用
+        void update(const uint8_t* msg, size_t len);
+        // 在不足 16 字节的位置补 0，用于 AEAD 中的 pad16
+        void padToBlock();
+        void finish(uint8_t tag[kTagSize]);
+
+        // tag = Poly1305(key, msg)
+        static void mac(
+            const uint8_t key[kKeySize], const uint8_t* msg, size_t len, uint8_t tag[kTagSize]);
+
+    private:
+        // hibit 为 2^128 在最高分量中的位置，最后不完整的块为 0
+        void blocks(const uint8_t* msg, size_t len, uint64_t hibit);
+
+        uint64_t r_[3];
+        uint64_t h_[3];
+        uint64_t pad_[2];
+        uint8_t buf_[16];
+        size_t buf_len_ = 0;
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_POLY1305_H_
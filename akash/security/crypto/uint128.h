@@ -0,0 +1,94 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_CRYPTO_UINT128_H_
+#define AKASH_SECURITY_CRYPTO_UINT128_H_
+
+#include <cstdint>
+
+#if !defined(__SIZEOF_INT128__) && defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+
+namespace akash {
+namespace crypto {
+
+    // 域运算中用于累加 64x64 位乘积的无符号 128 位整数。
+    // 只提供 +、>> 和截断为 uint64_t 的操作。
+#ifdef __SIZEOF_INT128__
+    using UInt128 = unsigned __int128;
+
+    inline UInt128 mul64(uint64_t a, uint64_t b) {
+        return UInt128(a) * b;
+    }
+#else
+    class UInt128 {
+    public:
+        UInt128()
+            : lo_(0), hi_(0) {}
+        UInt128(uint64_t v)
+            : lo_(v), hi_(0) {}
+        UInt128(uint64_t hi, uint64_t lo)
+            : lo_(lo), hi_(hi) {}
+
+        UInt128& operator+=(const UInt128& rhs) {
+            lo_ += rhs.lo_;
+            hi_ += rhs.hi_ + (lo_ < rhs.lo_ ? 1 : 0);
+            return *this;
+        }
+
+        UInt128 operator+(const UInt128& rhs) const {
+            UInt128 r(*this);
+            r += rhs;
+            return r;
+        }
+
+        UInt128 operator>>(int n) const {
+            if (n == 0) {
+                return *this;
+            }
+            if (n >= 64) {
+                return UInt128(0, hi_ >> (n - 64));
+            }
+            return UInt128(hi_ >> n, (lo_ >> n) | (hi_ << (64 - n)));
+        }
+
+        explicit operator uint64_t() const {
+            return lo_;
+        }
+
+    private:
+        uint64_t lo_;
+        uint64_t hi_;
+    };
+
+    inline UInt128 mul64(uint64_t a, uint64_t b) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        uint64_t hi;
+        uint64_t lo = _umul128(a, b, &hi);
+        return UInt128(hi, lo);
+#else
+        uint64_t a_lo = uint32_t(a), a_hi = a >> 32;
+        uint64_t b_lo = uint32_t(b), b_hi = b >> 32;
+
+        uint64_t ll = a_lo * b_lo;
+        uint64_t lh = a_lo * b_hi;
+        uint64_t hl = a_hi * b_lo;
+        uint64_t hh = a_hi * b_hi;
+
+        uint64_t mid = (ll >> 32) + uint32_t(lh) + uint32_t(hl);
+        uint64_t lo = (mid << 32) | uint32_t(ll);
+        uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        return UInt128(hi, lo);
+#endif
+    }
+#endif
+
+}
+}
+
+#endif  // AKASH_SECURITY_CRYPTO_UINT128_H_
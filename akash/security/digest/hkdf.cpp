@@ -143,6 +143,50 @@ namespace digest {
     int HKDF::hkdfExpand(
         SHAVersion which, const uint8_t prk[], int prk_len,
         const unsigned char *info, int info_len, uint8_t okm[], int okm_len)
+    {
+        if (info_len < 0 && info) return shaBadParam;
+        if (okm_len <= 0) return shaBadParam;
+        if (!okm) return shaBadParam;
+
+        int hash_len = USHA::USHAHashSize(which);
+        if (prk_len < hash_len) return shaBadParam;
+
+        HMACKey key;
+        int ret = key.init(which, prk, prk_len);
+        if (ret != shaSuccess) return ret;
+        return hkdfExpand(key, info, info_len, okm, okm_len);
+    }
+
+    /*
+     *  hkdfExpand
+     *
+     *  Description:
+     *      This function will perform HKDF expansion with the
+     *      pseudo-random key given as a precomputed HMAC key.
+     *      The key may be reused for any number of expansions.
+     *
+     *  Parameters:
+     *      prk: [in]
+     *          The pseudo-random key, see HMACKey::init.
+     *      info[ ]: [in]
+     *          The optional context and application specific information.
+     *          If info == NULL or a zero-length string, it is ignored.
+     *      info_len: [in]
+     *          The length of the optional context and application specific
+     *          information.  (Ignored if info == NULL.)
+     *      okm[ ]: [out]
+     *          Where the HKDF is to be stored.
+     *      okm_len: [in]
+     *          The length of the buffer to hold okm.
+     *          okm_len must be <= 255 * USHAHashSize(which_sha)
+     *
+     *  Returns:
+     *      sha Error Code.
+     *
+     */
+    int HKDF::hkdfExpand(
+        const HMACKey& prk,
+        const unsigned char *info, int info_len, uint8_t okm[], int okm_len)
     {
         unsigned char T[USHA::kMaxHashSize];
 
@@ -155,8 +199,7 @@ namespace digest {
         if (okm_len <= 0) return shaBadParam;
         if (!okm) return shaBadParam;
 
-        int hash_len = USHA::USHAHashSize(which);
-        if (prk_len < hash_len) return shaBadParam;
+        int hash_len = USHA::USHAHashSize(prk.getVersion());
         int N = okm_len / hash_len;
         if ((okm_len % hash_len) != 0) N++;
         if (N > 255) return shaBadParam;
@@ -166,7 +209,7 @@ namespace digest {
         for (int i = 1; i <= N; i++) {
             HMAC hmac;
             unsigned char c = i;
-            int ret = hmac.init(which, prk, prk_len) ||
+            int ret = hmac.init(prk) ||
                 hmac.update(T, Tlen) ||
                 hmac.update(info, info_len) ||
                 hmac.update(&c, 1) ||
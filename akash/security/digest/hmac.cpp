@@ -50,12 +50,44 @@ namespace digest {
             hmac.result(digest);
     }
 
+    /*
+     *  calculate
+     *
+     *  Description:
+     *      This function will compute an HMAC message digest
+     *      under a precomputed key.
+     *
+     *  Parameters:
+     *      key: [in]
+     *          The precomputed key, see HMACKey::init.
+     *      message_array[ ]: [in]
+     *          An array of octets representing the message.
+     *      length: [in]
+     *          The length of the message in message_array.
+     *      digest[ ]: [out]
+     *          Where the digest is to be returned.
+     *
+     *  Returns:
+     *      sha Error Code.
+     *
+     */
+    int HMAC::calculate(
+        const HMACKey& key,
+        const unsigned char* message_array, int length,
+        uint8_t digest[USHA::kMaxHashSize])
+    {
+        HMAC hmac;
+        return hmac.init(key) ||
+            hmac.update(message_array, length) ||
+            hmac.result(digest);
+    }
+
     /*
      *  init
      *
      *  Description:
-     *      This function will initialize the hmacContext in preparation
-     *      for computing a new HMAC message digest.
+     *      This function will precompute the inner and outer hash
+     *      states of an HMAC key.
      *
      *  Parameters:
      *      which: [in]
@@ -69,18 +101,19 @@ namespace digest {
      *      sha Error Code.
      *
      */
-    int HMAC::init(SHAVersion which, const unsigned char* key, int key_len) {
+    int HMACKey::init(SHAVersion which, const unsigned char* key, int key_len) {
         int i;
 
         /* inner padding - key XORd with ipad */
         unsigned char k_ipad[USHA::kMaxMsgBlockSize];
 
+        /* outer padding - key XORd with opad */
+        unsigned char k_opad[USHA::kMaxMsgBlockSize];
+
         /* temporary buffer when keylen > blocksize */
         unsigned char tempkey[USHA::kMaxHashSize];
-        context_.computed = false;
-        context_.corrupted = shaSuccess;
 
-        int blocksize = context_.blockSize = USHA::USHABlockSize(which);
+        int blocksize = USHA::USHABlockSize(which);
         int hashsize = context_.hashSize = USHA::USHAHashSize(which);
         context_.which_sha = which;
 
@@ -93,7 +126,7 @@ namespace digest {
             int err = usha.init(which) ||
                 usha.update(key, key_len) ||
                 usha.result(tempkey);
-            if (err != shaSuccess) return err;
+            if (err != shaSuccess) return context_.corrupted = err;
 
             key = tempkey;
             key_len = hashsize;
@@ -113,22 +146,85 @@ namespace digest {
          /* store key into the pads, XOR'd with ipad and opad values */
         for (i = 0; i < key_len; i++) {
             k_ipad[i] = key[i] ^ 0x36;
-            context_.k_opad[i] = key[i] ^ 0x5c;
+            k_opad[i] = key[i] ^ 0x5c;
         }
         /* remaining pad bytes are '\0' XOR'd with ipad and opad values */
         for (; i < blocksize; i++) {
             k_ipad[i] = 0x36;
-            context_.k_opad[i] = 0x5c;
+            k_opad[i] = 0x5c;
         }
 
-        /* perform inner hash */
-        /* init context for 1st pass */
-        int ret = context_.sha.init(which) ||
-            /* and start with inner pad */
-            context_.sha.update(k_ipad, blocksize);
+        /* hash the pads once, each MAC starts from these states */
+        int ret = context_.inner.init(which) ||
+            context_.inner.update(k_ipad, blocksize) ||
+            context_.outer.init(which) ||
+            context_.outer.update(k_opad, blocksize);
         return context_.corrupted = ret;
     }
 
+    SHAVersion HMACKey::getVersion() const {
+        return context_.which_sha;
+    }
+
+    /*
+     *  init
+     *
+     *  Description:
+     *      This function will initialize the hmacContext in preparation
+     *      for computing a new HMAC message digest.
+     *
+     *  Parameters:
+     *      which: [in]
+     *          One of SHA1, SHA224, SHA256, SHA384, SHA512
+     *      key[ ]: [in]
+     *          The secret shared key.
+     *      key_len: [in]
+     *          The length of the secret shared key.
+     *
+     *  Returns:
+     *      sha Error Code.
+     *
+     */
+    int HMAC::init(SHAVersion which, const unsigned char* key, int key_len) {
+        HMACKey hmac_key;
+        int ret = hmac_key.init(which, key, key_len);
+        if (ret != shaSuccess) {
+            context_.computed = false;
+            return context_.corrupted = ret;
+        }
+        return init(hmac_key);
+    }
+
+    /*
+     *  init
+     *
+     *  Description:
+     *      This function will initialize the hmacContext from a
+     *      precomputed key.  The key may be used for any number
+     *      of contexts.
+     *
+     *  Parameters:
+     *      key: [in]
+     *          The precomputed key, see HMACKey::init.
+     *
+     *  Returns:
+     *      sha Error Code.
+     *
+     */
+    int HMAC::init(const HMACKey& key) {
+        context_.computed = false;
+        if (key.context_.corrupted) {
+            return context_.corrupted = key.context_.corrupted;
+        }
+
+        context_.which_sha = key.context_.which_sha;
+        context_.hashSize = key.context_.hashSize;
+        /* inner and outer pads are already hashed */
+        context_.sha = key.context_.inner;
+        context_.outer_sha = key.context_.outer;
+        return context_.corrupted = shaSuccess;
+    }
+
     /*
      *  update
      *
@@ -203,17 +299,11 @@ namespace digest {
         /* (Use digest here as a temporary buffer.) */
         int ret = context_.sha.result(digest) ||
 
-            /* perform outer SHA */
-            /* init context for 2nd pass */
-            context_.sha.init(context_.which_sha) ||
-
-            /* start with outer pad */
-            context_.sha.update(context_.k_opad, context_.blockSize) ||
-
+            /* perform outer SHA, the outer pad is already input */
             /* then results of 1st hash */
-            context_.sha.update(digest, context_.hashSize) ||
+            context_.outer_sha.update(digest, context_.hashSize) ||
             /* finish up 2nd pass */
-            context_.sha.result(digest);
+            context_.outer_sha.result(digest);
 
         context_.computed = true;
         return context_.corrupted = ret;
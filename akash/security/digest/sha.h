@@ -7,6 +7,7 @@
 #ifndef AKASH_SECURITY_DIGEST_SHA1_H_
 #define AKASH_SECURITY_DIGEST_SHA1_H_
 
+#include <cstddef>
 #include <cstdint>
 
 
@@ -42,16 +43,16 @@ namespace digest {
         SHA1() = default;
 
         void init();
-        int update(const uint8_t* bytes, unsigned int length);
+        int update(const uint8_t* bytes, size_t length);
         int finalBits(uint8_t bits, unsigned int length);
         int result(uint8_t msg_digest[kHashSize]);
+        int peekResult(uint8_t msg_digest[kHashSize]) const;
 
     private:
         struct Context {
             uint32_t intermediate_hash[kHashSize / 4]; // Message Digest
 
-            uint32_t length_high;               // Message length in bits
-            uint32_t length_low;                // Message length in bits
+            uint64_t length;                    // Message length in bits
 
             int_least16_t msg_block_index;      // Message_Block array index
                                                 // 512-bit message blocks
@@ -79,16 +80,16 @@ namespace digest {
         SHA224() = default;
 
         void init();
-        int update(const uint8_t* bytes, unsigned int length);
+        int update(const uint8_t* bytes, size_t length);
         int finalBits(uint8_t bits, unsigned int length);
         int result(uint8_t msg_digest[kHashSize]);
+        int peekResult(uint8_t msg_digest[kHashSize]) const;
 
     private:
         struct Context {
             uint32_t intermediate_hash[kLargeHashSize / 4]; // Message Digest
 
-            uint32_t length_high;               // Message length in bits
-            uint32_t length_low;                // Message length in bits
+            uint64_t length;                    // Message length in bits
 
             int_least16_t msg_block_index;      // Message_Block array index
                                                 // 512-bit message blocks
@@ -114,16 +115,16 @@ namespace digest {
         SHA256() = default;
 
         void init();
-        int update(const uint8_t* bytes, unsigned int length);
+        int update(const uint8_t* bytes, size_t length);
         int finalBits(uint8_t bits, unsigned int length);
         int result(uint8_t msg_digest[kHashSize]);
+        int peekResult(uint8_t msg_digest[kHashSize]) const;
 
     private:
         struct Context {
             uint32_t intermediate_hash[kHashSize / 4]; // Message Digest
 
-            uint32_t length_high;               // Message length in bits
-            uint32_t length_low;                // Message length in bits
+            uint64_t length;                    // Message length in bits
 
             int_least16_t msg_block_index;      // Message_Block array index
                                                 // 512-bit message blocks
@@ -150,9 +151,10 @@ namespace digest {
         SHA384() = default;
 
         void init();
-        int update(const uint8_t* bytes, unsigned int length);
+        int update(const uint8_t* bytes, size_t length);
         int finalBits(uint8_t bits, unsigned int length);
         int result(uint8_t msg_digest[kHashSize]);
+        int peekResult(uint8_t msg_digest[kHashSize]) const;
 
     private:
         struct Context {
@@ -184,9 +186,10 @@ namespace digest {
         SHA512() = default;
 
         void init();
-        int update(const uint8_t* bytes, unsigned int length);
+        int update(const uint8_t* bytes, size_t length);
         int finalBits(uint8_t bits, unsigned int length);
         int result(uint8_t msg_digest[kHashSize]);
+        int peekResult(uint8_t msg_digest[kHashSize]) const;
 
     private:
         struct Context {
@@ -217,9 +220,10 @@ namespace digest {
         USHA() = default;
 
         int init(SHAVersion which);
-        int update(const uint8_t* bytes, unsigned int length);
+        int update(const uint8_t* bytes, size_t length);
         int finalBits(uint8_t bits, unsigned int length);
         int result(uint8_t msg_digest[kMaxHashSize]);
+        int peekResult(uint8_t msg_digest[kMaxHashSize]) const;
 
         static int USHABlockSize(SHAVersion which);
         static int USHAHashSize(SHAVersion which);
@@ -242,6 +246,34 @@ namespace digest {
     };
 
 
+    class HMACKey {
+    public:
+        HMACKey() = default;
+
+        /*
+         * Precomputed key for HMAC, RFC 2104, for all SHAs.
+         * The hash states after the blocks K XOR ipad and K XOR opad
+         * are computed once, so that each MAC under the same key
+         * saves two compressions.
+         */
+        int init(SHAVersion which, const unsigned char* key, int key_len);
+        SHAVersion getVersion() const;
+
+    private:
+        friend class HMAC;
+
+        struct Context {
+            SHAVersion which_sha = SHAVersion::SHA256;
+            int hashSize;               // hash size of SHA being used
+            USHA inner;                 // hash state after K XOR ipad
+            USHA outer;                 // hash state after K XOR opad
+            int corrupted = shaStateError;  // init() not called yet
+        };
+
+        Context context_;
+    };
+
+
     class HMAC {
     public:
         HMAC() = default;
@@ -258,6 +290,11 @@ namespace digest {
             const unsigned char* key,      // pointer to authentication key
             int key_len,                   // length of authentication key
             uint8_t digest[USHA::kMaxHashSize]); // caller digest to fill in
+        static int calculate(
+            const HMACKey& key,
+            const unsigned char* text,
+            int text_len,
+            uint8_t digest[USHA::kMaxHashSize]);
 
         /*
          * HMAC Keyed-Hashing for Message Authentication, RFC 2104,
@@ -265,6 +302,7 @@ namespace digest {
          * This interface allows any length of text input to be used.
          */
         int init(SHAVersion which, const unsigned char* key, int key_len);
+        int init(const HMACKey& key);
         int update(const unsigned char* text, int text_len);
         int finalBits(uint8_t bits, unsigned int bit_count);
         int result(uint8_t digest[USHA::kMaxHashSize]);
@@ -273,10 +311,8 @@ namespace digest {
         struct Context {
             SHAVersion which_sha;
             int hashSize;               // hash size of SHA being used
-            int blockSize;              // block size of SHA being used
             USHA sha;
-            unsigned char k_opad[USHA::kMaxMsgBlockSize];
-            // outer padding - key XORd with opad
+            USHA outer_sha;             // outer hash, K XOR opad already input
             bool computed;              // Is the MAC computed?
             int corrupted;              // Cumulative corruption code
         };
@@ -306,6 +342,10 @@ namespace digest {
             SHAVersion which, const uint8_t prk[],
             int prk_len, const unsigned char* info,
             int info_len, uint8_t okm[], int okm_len);
+        // prk given as a precomputed HMAC key, reusable across expansions
+        static int hkdfExpand(
+            const HMACKey& prk, const unsigned char* info,
+            int info_len, uint8_t okm[], int okm_len);
 
         /*
          * HKDF HMAC-based Extract-and-Expand Key Derivation Function,
@@ -4,16 +4,14 @@
 // This program is licensed under GPLv3 license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <cstring>
+
 #include "akash/security/digest/sha.h"
+#include "akash/security/digest/sha_block.h"
 
 #include "sha_private.h"
 
-/*
- *  Define the SHA1 circular left shift macro
- */
-#define SHA1_ROTL(bits,word) \
-                (((word) << (bits)) | ((word) >> (32-(bits))))
-
 
 namespace akash {
 namespace digest {
@@ -31,7 +29,7 @@ namespace digest {
      */
     void SHA1::init()
     {
-        context_.length_high = context_.length_low = 0;
+        context_.length = 0;
         context_.msg_block_index = 0;
 
         /* Initial Hash Values: FIPS 180-3 section 5.3.1 */
@@ -63,22 +61,42 @@ namespace digest {
      *      sha Error Code.
      *
      */
-    int SHA1::update(const uint8_t* bytes, unsigned length) {
+    int SHA1::update(const uint8_t* bytes, size_t length) {
         if (!length) return shaSuccess;
         if (!bytes) return shaNull;
         if (context_.corrupted) return context_.corrupted;
         if (context_.computed) return context_.corrupted = shaStateError;
+        if (!SHAAddBytes64(&context_.length, length))
+            return context_.corrupted = shaInputTooLong;
 
-        while (length--) {
-            context_.msg_block[context_.msg_block_index++] = *bytes;
-
-            if ((SHAAddLength32(context_, 8) == shaSuccess) &&
-                (context_.msg_block_index == kMsgBlockSize))
-                processMessageBlock(&context_);
+        /*
+         * Fill up the partially buffered block first
+         */
+        if (context_.msg_block_index > 0) {
+            size_t n = std::min(length, size_t(kMsgBlockSize - context_.msg_block_index));
+            std::memcpy(context_.msg_block + context_.msg_block_index, bytes, n);
+            context_.msg_block_index += int_least16_t(n);
+            bytes += n;
+            length -= n;
+
+            if (context_.msg_block_index < kMsgBlockSize)
+                return context_.corrupted;
+            processMessageBlock(&context_);
+        }
 
-            bytes++;
+        /*
+         * Whole blocks are compressed straight from the caller's buffer
+         */
+        size_t count = length / kMsgBlockSize;
+        if (count > 0) {
+            SHABlock::sha1(context_.intermediate_hash, bytes, count);
+            bytes += count * kMsgBlockSize;
+            length -= count * kMsgBlockSize;
         }
 
+        std::memcpy(context_.msg_block, bytes, length);
+        context_.msg_block_index = int_least16_t(length);
+
         return context_.corrupted;
     }
 
@@ -119,7 +137,8 @@ namespace digest {
         if (context_.computed) return context_.corrupted = shaStateError;
         if (length >= 8) return context_.corrupted = shaBadParam;
 
-        SHAAddLength32(context_, length);
+        if (!SHAAddBits64(&context_.length, length))
+            return context_.corrupted = shaInputTooLong;
         finalize(&context_, uint8_t((bits & masks[length]) | markbit[length]));
 
         return context_.corrupted;
@@ -156,6 +175,27 @@ namespace digest {
         return shaSuccess;
     }
 
+    /*
+     * peekResult
+     *
+     * Description:
+     *   This function will return the message digest of the octets
+     *   input so far, without finalizing the context.  More input
+     *   may follow.
+     *
+     * Parameters:
+     *   msg_digest[ ]: [out]
+     *     Where the digest is returned.
+     *
+     * Returns:
+     *   sha Error Code.
+     *
+     */
+    int SHA1::peekResult(uint8_t msg_digest[kHashSize]) const {
+        SHA1 snapshot(*this);
+        return snapshot.result(msg_digest);
+    }
+
     /*
      * processMessageBlock
      *
@@ -171,80 +211,11 @@ namespace digest {
      *   Nothing.
      *
      * Comments:
-     *   Many of the variable names in this code, especially the
-     *   single character names, were used because those were the
-     *   names used in the Secure Hash Standard.
+     *   The compression function is implemented in SHABlock,
+     *   which selects SHA-NI or AVX2 at runtime.
      */
     void SHA1::processMessageBlock(Context* context) {
-        /* Constants defined in FIPS 180-3, section 4.2.1 */
-        const uint32_t K[4] = {
-            0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
-        };
-        int        t;               /* Loop counter */
-        uint32_t   temp;            /* Temporary word value */
-        uint32_t   W[80];           /* Word sequence */
-
-        /*
-         * Initialize the first 16 words in the array W
-         */
-        for (t = 0; t < 16; t++) {
-            W[t] = static_cast<uint32_t>(context->msg_block[t * 4]) << 24;
-            W[t] |= static_cast<uint32_t>(context->msg_block[t * 4 + 1]) << 16;
-            W[t] |= static_cast<uint32_t>(context->msg_block[t * 4 + 2]) << 8;
-            W[t] |= static_cast<uint32_t>(context->msg_block[t * 4 + 3]);
-        }
-
-        for (t = 16; t < 80; t++)
-            W[t] = SHA1_ROTL(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
-
-        // Word buffers
-        uint32_t A = context->intermediate_hash[0];
-        uint32_t B = context->intermediate_hash[1];
-        uint32_t C = context->intermediate_hash[2];
-        uint32_t D = context->intermediate_hash[3];
-        uint32_t E = context->intermediate_hash[4];
-
-        for (t = 0; t < 20; t++) {
-            temp = SHA1_ROTL(5, A) + SHA_Ch(B, C, D) + E + W[t] + K[0];
-            E = D;
-            D = C;
-            C = SHA1_ROTL(30, B);
-            B = A;
-            A = temp;
-        }
-
-        for (t = 20; t < 40; t++) {
-            temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + K[1];
-            E = D;
-            D = C;
-            C = SHA1_ROTL(30, B);
-            B = A;
-            A = temp;
-        }
-
-        for (t = 40; t < 60; t++) {
-            temp = SHA1_ROTL(5, A) + SHA_Maj(B, C, D) + E + W[t] + K[2];
-            E = D;
-            D = C;
-            C = SHA1_ROTL(30, B);
-            B = A;
-            A = temp;
-        }
-
-        for (t = 60; t < 80; t++) {
-            temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + K[3];
-            E = D;
-            D = C;
-            C = SHA1_ROTL(30, B);
-            B = A;
-            A = temp;
-        }
-
-        context->intermediate_hash[0] += A;
-        context->intermediate_hash[1] += B;
-        context->intermediate_hash[2] += C;
-        context->intermediate_hash[3] += D;
-        context->intermediate_hash[4] += E;
+        SHABlock::sha1(context->intermediate_hash, context->msg_block, 1);
         context->msg_block_index = 0;
     }
 
@@ -272,8 +243,7 @@ namespace digest {
         /* message may be sensitive, clear it out */
         for (int i = 0; i < kMsgBlockSize; ++i)
             context->msg_block[i] = 0;
-        context->length_high = 0;     /* and clear length */
-        context->length_low = 0;
+        context->length = 0;         /* and clear length */
         context->computed = true;
     }
 
@@ -322,14 +292,14 @@ namespace digest {
         /*
          * Store the message length as the last 8 octets
          */
-        context->msg_block[56] = static_cast<uint8_t>(context->length_high >> 24);
-        context->msg_block[57] = static_cast<uint8_t>(context->length_high >> 16);
-        context->msg_block[58] = static_cast<uint8_t>(context->length_high >> 8);
-        context->msg_block[59] = static_cast<uint8_t>(context->length_high);
-        context->msg_block[60] = static_cast<uint8_t>(context->length_low >> 24);
-        context->msg_block[61] = static_cast<uint8_t>(context->length_low >> 16);
-        context->msg_block[62] = static_cast<uint8_t>(context->length_low >> 8);
-        context->msg_block[63] = static_cast<uint8_t>(context->length_low);
+        context->msg_block[56] = uint8_t(context->length >> 56);
+        context->msg_block[57] = uint8_t(context->length >> 48);
+        context->msg_block[58] = uint8_t(context->length >> 40);
+        context->msg_block[59] = uint8_t(context->length >> 32);
+        context->msg_block[60] = uint8_t(context->length >> 24);
+        context->msg_block[61] = uint8_t(context->length >> 16);
+        context->msg_block[62] = uint8_t(context->length >> 8);
+        context->msg_block[63] = uint8_t(context->length);
 
         processMessageBlock(context);
     }
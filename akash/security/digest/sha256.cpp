@@ -4,27 +4,14 @@
 // This program is licensed under GPLv3 license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <cstring>
+
 #include "akash/security/digest/sha.h"
+#include "akash/security/digest/sha_block.h"
 
 #include "sha_private.h"
 
-/* Define the SHA shift, rotate left, and rotate right macros */
-#define SHA256_SHR(bits,word)      ((word) >> (bits))
-#define SHA256_ROTL(bits,word)                         \
-  (((word) << (bits)) | ((word) >> (32-(bits))))
-#define SHA256_ROTR(bits,word)                         \
-  (((word) >> (bits)) | ((word) << (32-(bits))))
-
-/* Define the SHA SIGMA and sigma macros */
-#define SHA256_SIGMA0(word)   \
-  (SHA256_ROTR( 2,word) ^ SHA256_ROTR(13,word) ^ SHA256_ROTR(22,word))
-#define SHA256_SIGMA1(word)   \
-  (SHA256_ROTR( 6,word) ^ SHA256_ROTR(11,word) ^ SHA256_ROTR(25,word))
-#define SHA256_sigma0(word)   \
-  (SHA256_ROTR( 7,word) ^ SHA256_ROTR(18,word) ^ SHA256_SHR( 3,word))
-#define SHA256_sigma1(word)   \
-  (SHA256_ROTR(17,word) ^ SHA256_ROTR(19,word) ^ SHA256_SHR(10,word))
-
 
 namespace akash {
 namespace digest {
@@ -38,7 +25,7 @@ namespace digest {
      *
      */
     void SHA256::init() {
-        context_.length_high = context_.length_low = 0;
+        context_.length = 0;
         context_.msg_block_index = 0;
 
         context_.intermediate_hash[0] = 0x6A09E667;
@@ -71,25 +58,43 @@ namespace digest {
      * Returns:
      *   sha Error Code.
      */
-    int SHA256::update(const uint8_t* bytes, unsigned int length) {
+    int SHA256::update(const uint8_t* bytes, size_t length) {
         if (!length) return shaSuccess;
         if (!bytes) return shaNull;
         if (context_.corrupted) return context_.corrupted;
         if (context_.computed) return context_.corrupted = shaStateError;
+        if (!SHAAddBytes64(&context_.length, length))
+            return context_.corrupted = shaInputTooLong;
 
-        while (length--) {
-            context_.msg_block[context_.msg_block_index++] =
-                *bytes;
-
-            if ((SHAAddLength32(context_, 8) == shaSuccess) &&
-                (context_.msg_block_index == kMsgBlockSize))
-                processMessageBlock(&context_);
+        /*
+         * Fill up the partially buffered block first
+         */
+        if (context_.msg_block_index > 0) {
+            size_t n = std::min(length, size_t(kMsgBlockSize - context_.msg_block_index));
+            std::memcpy(context_.msg_block + context_.msg_block_index, bytes, n);
+            context_.msg_block_index += int_least16_t(n);
+            bytes += n;
+            length -= n;
+
+            if (context_.msg_block_index < kMsgBlockSize)
+                return context_.corrupted;
+            processMessageBlock(&context_);
+        }
 
-            bytes++;
+        /*
+         * Whole blocks are compressed straight from the caller's buffer
+         */
+        size_t count = length / kMsgBlockSize;
+        if (count > 0) {
+            SHABlock::sha256(context_.intermediate_hash, bytes, count);
+            bytes += count * kMsgBlockSize;
+            length -= count * kMsgBlockSize;
         }
 
-        return context_.corrupted;
+        std::memcpy(context_.msg_block, bytes, length);
+        context_.msg_block_index = int_least16_t(length);
 
+        return context_.corrupted;
     }
 
     /*
@@ -128,7 +133,8 @@ namespace digest {
         if (context_.computed) return context_.corrupted = shaStateError;
         if (length >= 8) return context_.corrupted = shaBadParam;
 
-        SHAAddLength32(context_, length);
+        if (!SHAAddBits64(&context_.length, length))
+            return context_.corrupted = shaInputTooLong;
         finalize(&context_, uint8_t((bits & masks[length]) | markbit[length]));
 
         return context_.corrupted;
@@ -164,6 +170,27 @@ namespace digest {
         return shaSuccess;
     }
 
+    /*
+     * peekResult
+     *
+     * Description:
+     *   This function will return the message digest of the octets
+     *   input so far, without finalizing the context.  More input
+     *   may follow.
+     *
+     * Parameters:
+     *   msg_digest[ ]: [out]
+     *     Where the digest is returned.
+     *
+     * Returns:
+     *   sha Error Code.
+     *
+     */
+    int SHA256::peekResult(uint8_t msg_digest[kHashSize]) const {
+        SHA256 snapshot(*this);
+        return snapshot.result(msg_digest);
+    }
+
     /*
      * processMessageBlock
      *
@@ -179,75 +206,11 @@ namespace digest {
      *   Nothing.
      *
      * Comments:
-     *   Many of the variable names in this code, especially the
-     *   single character names, were used because those were the
-     *   names used in the Secure Hash Standard.
+     *   The compression function is implemented in SHABlock,
+     *   which selects SHA-NI or AVX2 at runtime.
      */
     void SHA256::processMessageBlock(Context* context) {
-        /* Constants defined in FIPS 180-3, section 4.2.2 */
-        static const uint32_t K[64] = {
-            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
-            0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
-            0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
-            0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-            0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
-            0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
-            0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
-            0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
-            0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
-            0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
-            0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-            0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-        };
-        int        t, t4;                   /* Loop counter */
-        uint32_t   W[64];                   /* Word sequence */
-
-        /*
-         * Initialize the first 16 words in the array W
-         */
-        for (t = t4 = 0; t < 16; t++, t4 += 4)
-            W[t] = (uint32_t(context->msg_block[t4]) << 24) |
-            (uint32_t(context->msg_block[t4 + 1]) << 16) |
-            (uint32_t(context->msg_block[t4 + 2]) << 8) |
-            (uint32_t(context->msg_block[t4 + 3]));
-        for (t = 16; t < 64; t++)
-            W[t] = SHA256_sigma1(W[t - 2]) + W[t - 7] +
-            SHA256_sigma0(W[t - 15]) + W[t - 16];
-
-        /* Word buffers */
-        uint32_t A = context->intermediate_hash[0];
-        uint32_t B = context->intermediate_hash[1];
-        uint32_t C = context->intermediate_hash[2];
-        uint32_t D = context->intermediate_hash[3];
-        uint32_t E = context->intermediate_hash[4];
-        uint32_t F = context->intermediate_hash[5];
-        uint32_t G = context->intermediate_hash[6];
-        uint32_t H = context->intermediate_hash[7];
-
-        for (t = 0; t < 64; t++) {
-            /* Temporary word value */
-            uint32_t temp1 = H + SHA256_SIGMA1(E) + SHA_Ch(E, F, G) + K[t] + W[t];
-            uint32_t temp2 = SHA256_SIGMA0(A) + SHA_Maj(A, B, C);
-            H = G;
-            G = F;
-            F = E;
-            E = D + temp1;
-            D = C;
-            C = B;
-            B = A;
-            A = temp1 + temp2;
-        }
-
-        context->intermediate_hash[0] += A;
-        context->intermediate_hash[1] += B;
-        context->intermediate_hash[2] += C;
-        context->intermediate_hash[3] += D;
-        context->intermediate_hash[4] += E;
-        context->intermediate_hash[5] += F;
-        context->intermediate_hash[6] += G;
-        context->intermediate_hash[7] += H;
-
+        SHABlock::sha256(context->intermediate_hash, context->msg_block, 1);
         context->msg_block_index = 0;
     }
 
@@ -274,8 +237,7 @@ namespace digest {
         /* message may be sensitive, so clear it out */
         for (int i = 0; i < kMsgBlockSize; ++i)
             context->msg_block[i] = 0;
-        context->length_high = 0;     /* and clear length */
-        context->length_low = 0;
+        context->length = 0;         /* and clear length */
         context->computed = true;
     }
 
@@ -324,14 +286,14 @@ namespace digest {
         /*
          * Store the message length as the last 8 octets
          */
-        context->msg_block[56] = static_cast<uint8_t>(context->length_high >> 24);
-        context->msg_block[57] = static_cast<uint8_t>(context->length_high >> 16);
-        context->msg_block[58] = static_cast<uint8_t>(context->length_high >> 8);
-        context->msg_block[59] = static_cast<uint8_t>(context->length_high);
-        context->msg_block[60] = static_cast<uint8_t>(context->length_low >> 24);
-        context->msg_block[61] = static_cast<uint8_t>(context->length_low >> 16);
-        context->msg_block[62] = static_cast<uint8_t>(context->length_low >> 8);
-        context->msg_block[63] = static_cast<uint8_t>(context->length_low);
+        context->msg_block[56] = uint8_t(context->length >> 56);
+        context->msg_block[57] = uint8_t(context->length >> 48);
+        context->msg_block[58] = uint8_t(context->length >> 40);
+        context->msg_block[59] = uint8_t(context->length >> 32);
+        context->msg_block[60] = uint8_t(context->length >> 24);
+        context->msg_block[61] = uint8_t(context->length >> 16);
+        context->msg_block[62] = uint8_t(context->length >> 8);
+        context->msg_block[63] = uint8_t(context->length);
 
         processMessageBlock(context);
     }
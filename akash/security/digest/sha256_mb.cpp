@@ -0,0 +1,457 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/digest/sha256_mb.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "akash/security/crypto/cpu_features.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AKASH_SHA_MB_X64
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#define AVX512_TARGET
+#define FLATTEN
+#else
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define AVX512_TARGET __attribute__((target("avx512f")))
+// 将向量类型的各个运算内联到带有 target 属性的入口函数中
+#define FLATTEN __attribute__((flatten))
+#endif
+#endif
+
+
+namespace {
+
+    using akash::digest::SHA256MB;
+
+    // FIPS 180-3, section 4.2.2
+    const uint32_t kK[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+        0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+        0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+        0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+        0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+        0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+        0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+        0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+        0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    const uint32_t kH0[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+    };
+
+    uint32_t load32BE(const uint8_t* in) {
+        return (uint32_t(in[0]) << 24) |
+            (uint32_t(in[1]) << 16) |
+            (uint32_t(in[2]) << 8) |
+            uint32_t(in[3]);
+    }
+
+    // 以下的向量类型提供压缩函数需要的运算，每个分量对应一个 lane
+    struct VScalar {
+        static const size_t kLanes = 1;
+        uint32_t v;
+
+        static VScalar load(const uint32_t* p) { return { *p }; }
+        static void store(uint32_t* p, VScalar a) { *p = a.v; }
+        static VScalar set1(uint32_t x) { return { x }; }
+        static VScalar add(VScalar a, VScalar b) { return { a.v + b.v }; }
+        static VScalar bxor(VScalar a, VScalar b) { return { a.v ^ b.v }; }
+        static VScalar band(VScalar a, VScalar b) { return { a.v & b.v }; }
+        static VScalar bandnot(VScalar a, VScalar b) { return { ~a.v & b.v }; }
+        template <int n>
+        static VScalar shr(VScalar a) { return { a.v >> n }; }
+        template <int n>
+        static VScalar ror(VScalar a) { return { (a.v >> n) | (a.v << (32 - n)) }; }
+    };
+
+#ifdef AKASH_SHA_MB_X64
+
+    struct V128 {
+        static const size_t kLanes = 4;
+        __m128i v;
+
+        static V128 load(const uint32_t* p) {
+            return { _mm_load_si128(reinterpret_cast<const __m128i*>(p)) };
+        }
+        static void store(uint32_t* p, V128 a) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(p), a.v);
+        }
+        static V128 set1(uint32_t x) { return { _mm_set1_epi32(int(x)) }; }
+        static V128 add(V128 a, V128 b) { return { _mm_add_epi32(a.v, b.v) }; }
+        static V128 bxor(V128 a, V128 b) { return { _mm_xor_si128(a.v, b.v) }; }
+        static V128 band(V128 a, V128 b) { return { _mm_and_si128(a.v, b.v) }; }
+        static V128 bandnot(V128 a, V128 b) { return { _mm_andnot_si128(a.v, b.v) }; }
+        template <int n>
+        static V128 shr(V128 a) { return { _mm_srli_epi32(a.v, n) }; }
+        template <int n>
+        static V128 ror(V128 a) {
+            return { _mm_or_si128(_mm_srli_epi32(a.v, n), _mm_slli_epi32(a.v, 32 - n)) };
+        }
+    };
+
+    struct V256 {
+        static const size_t kLanes = 8;
+        __m256i v;
+
+        AVX2_TARGET static V256 load(const uint32_t* p) {
+            return { _mm256_load_si256(reinterpret_cast<const __m256i*>(p)) };
+        }
+        AVX2_TARGET static void store(uint32_t* p, V256 a) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(p), a.v);
+        }
+        AVX2_TARGET static V256 set1(uint32_t x) { return { _mm256_set1_epi32(int(x)) }; }
+        AVX2_TARGET static V256 add(V256 a, V256 b) { return { _mm256_add_epi32(a.v, b.v) }; }
+        AVX2_TARGET static V256 bxor(V256 a, V256 b) { return { _mm256_xor_si256(a.v, b.v) }; }
+        AVX2_TARGET static V256 band(V256 a, V256 b) { return { _mm256_and_si256(a.v, b.v) }; }
+        AVX2_TARGET static V256 bandnot(V256 a, V256 b) { return { _mm256_andnot_si256(a.v, b.v) }; }
+        template <int n>
+        AVX2_TARGET static V256 shr(V256 a) { return { _mm256_srli_epi32(a.v, n) }; }
+        template <int n>
+        AVX2_TARGET static V256 ror(V256 a) {
+            return { _mm256_or_si256(_mm256_srli_epi32(a.v, n), _mm256_slli_epi32(a.v, 32 - n)) };
+        }
+    };
+
+    struct V512 {
+        static const size_t kLanes = 16;
+        __m512i v;
+
+        AVX512_TARGET static V512 load(const uint32_t* p) {
+            return { _mm512_load_si512(p) };
+        }
+        AVX512_TARGET static void store(uint32_t* p, V512 a) {
+            _mm512_store_si512(p, a.v);
+        }
+        AVX512_TARGET static V512 set1(uint32_t x) { return { _mm512_set1_epi32(int(x)) }; }
+        AVX512_TARGET static V512 add(V512 a, V512 b) { return { _mm512_add_epi32(a.v, b.v) }; }
+        AVX512_TARGET static V512 bxor(V512 a, V512 b) { return { _mm512_xor_si512(a.v, b.v) }; }
+        AVX512_TARGET static V512 band(V512 a, V512 b) { return { _mm512_and_si512(a.v, b.v) }; }
+        // andnot 与移位使用全 1 掩码的 maskz 形式，生成的指令与不带掩码的相同。
+        // GCC 的不带掩码形式以未初始化的向量作为源操作数，会产生 -Wmaybe-uninitialized 警告
+        AVX512_TARGET static V512 bandnot(V512 a, V512 b) { return { _mm512_maskz_andnot_epi32(__mmask16(-1), a.v, b.v) }; }
+        template <int n>
+        AVX512_TARGET static V512 shr(V512 a) { return { _mm512_maskz_srli_epi32(__mmask16(-1), a.v, n) }; }
+        // AVX-512F 有循环移位指令
+        template <int n>
+        AVX512_TARGET static V512 ror(V512 a) { return { _mm512_maskz_ror_epi32(__mmask16(-1), a.v, n) }; }
+    };
+
+#endif
+
+    /**
+     * 各 lane 同时压缩 n 个块。
+     * state 中第 i 个字的各 lane 连续存放，ptrs[j] 为第 j 个 lane 的数据，
+     * 为空指针时该 lane 以 0 作为输入，其结果不会被使用。
+     */
+    template <class V>
+    void compress(uint32_t* state, const uint8_t* const* ptrs, size_t n) {
+        const size_t L = V::kLanes;
+        alignas(64) uint32_t w[16 * L];
+
+        V s[8];
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::load(state + i * L);
+        }
+
+        for (size_t b = 0; b < n; ++b) {
+            // 转置：w[t * L + j] 为第 j 个 lane 的 W[t]
+            for (size_t j = 0; j < L; ++j) {
+                const uint8_t* p = ptrs[j];
+                if (p) {
+                    p += b * SHA256MB::kMsgBlockSize;
+                    for (size_t t = 0; t < 16; ++t) {
+                        w[t * L + j] = load32BE(p + 4 * t);
+                    }
+                } else {
+                    for (size_t t = 0; t < 16; ++t) {
+                        w[t * L + j] = 0;
+                    }
+                }
+            }
+
+            V W[16];
+            V A = s[0], B = s[1], C = s[2], D = s[3];
+            V E = s[4], F = s[5], G = s[6], H = s[7];
+
+            for (int t = 0; t < 64; ++t) {
+                V Wt;
+                if (t < 16) {
+                    Wt = V::load(w + t * L);
+                } else {
+                    // W 只保留最近的 16 个字
+                    V w2 = W[(t - 2) & 15];
+                    V w15 = W[(t - 15) & 15];
+                    V sigma1 = V::bxor(V::bxor(V::template ror<17>(w2), V::template ror<19>(w2)), V::template shr<10>(w2));
+                    V sigma0 = V::bxor(V::bxor(V::template ror<7>(w15), V::template ror<18>(w15)), V::template shr<3>(w15));
+                    Wt = V::add(V::add(sigma1, W[(t - 7) & 15]), V::add(sigma0, W[t & 15]));
+                }
+                W[t & 15] = Wt;
+
+                V SIGMA1 = V::bxor(V::bxor(V::template ror<6>(E), V::template ror<11>(E)), V::template ror<25>(E));
+                V ch = V::bxor(V::band(E, F), V::bandnot(E, G));
+                V temp1 = V::add(V::add(V::add(H, SIGMA1), V::add(ch, V::set1(kK[t]))), Wt);
+
+                V SIGMA0 = V::bxor(V::bxor(V::template ror<2>(A), V::template ror<13>(A)), V::template ror<22>(A));
+                V maj = V::bxor(V::band(A, V::bxor(B, C)), V::band(B, C));
+                V temp2 = V::add(SIGMA0, maj);
+
+                H = G;
+                G = F;
+                F = E;
+                E = V::add(D, temp1);
+                D = C;
+                C = B;
+                B = A;
+                A = V::add(temp1, temp2);
+            }
+
+            s[0] = V::add(s[0], A); s[1] = V::add(s[1], B);
+            s[2] = V::add(s[2], C); s[3] = V::add(s[3], D);
+            s[4] = V::add(s[4], E); s[5] = V::add(s[5], F);
+            s[6] = V::add(s[6], G); s[7] = V::add(s[7], H);
+        }
+
+        for (int i = 0; i < 8; ++i) {
+            V::store(state + i * L, s[i]);
+        }
+    }
+
+    void compressScalar(uint32_t* state, const uint8_t* const* ptrs, size_t n) {
+        compress<VScalar>(state, ptrs, n);
+    }
+
+#ifdef AKASH_SHA_MB_X64
+    void compressSSE2(uint32_t* state, const uint8_t* const* ptrs, size_t n) {
+        compress<V128>(state, ptrs, n);
+    }
+
+    AVX2_TARGET FLATTEN
+    void compressAVX2(uint32_t* state, const uint8_t* const* ptrs, size_t n) {
+        compress<V256>(state, ptrs, n);
+    }
+
+    AVX512_TARGET FLATTEN
+    void compressAVX512(uint32_t* state, const uint8_t* const* ptrs, size_t n) {
+        compress<V512>(state, ptrs, n);
+    }
+#endif
+
+    bool isSupported(SHA256MB::Impl impl) {
+        using akash::crypto::CPUFeatures;
+        switch (impl) {
+        case SHA256MB::Impl::Scalar: return true;
+#ifdef AKASH_SHA_MB_X64
+        case SHA256MB::Impl::SSE2:   return CPUFeatures::hasSSE2();
+        case SHA256MB::Impl::AVX2:   return CPUFeatures::hasAVX2();
+        case SHA256MB::Impl::AVX512: return CPUFeatures::hasAVX512F();
+#endif
+        default: return false;
+        }
+    }
+
+    SHA256MB::Impl detectImpl() {
+        if (isSupported(SHA256MB::Impl::AVX512)) {
+            return SHA256MB::Impl::AVX512;
+        }
+        if (isSupported(SHA256MB::Impl::AVX2)) {
+            return SHA256MB::Impl::AVX2;
+        }
+        if (isSupported(SHA256MB::Impl::SSE2)) {
+            return SHA256MB::Impl::SSE2;
+        }
+        return SHA256MB::Impl::Scalar;
+    }
+
+    SHA256MB::Impl default_impl_ = detectImpl();
+
+}
+
+namespace akash {
+namespace digest {
+
+    void SHA256MB::setImpl(Impl impl) {
+        if (!isSupported(impl)) {
+            return;
+        }
+        default_impl_ = impl;
+    }
+
+    SHA256MB::Impl SHA256MB::getImpl() {
+        return default_impl_;
+    }
+
+    size_t SHA256MB::getLaneCount(Impl impl) {
+        switch (impl) {
+        case Impl::SSE2:   return 4;
+        case Impl::AVX2:   return 8;
+        case Impl::AVX512: return 16;
+        default:           return 1;
+        }
+    }
+
+    SHA256MB::SHA256MB()
+        : impl_(default_impl_),
+          lane_count_(getLaneCount(default_impl_))
+    {
+        std::memset(state_, 0, sizeof(state_));
+    }
+
+    size_t SHA256MB::submit(const uint8_t* data, size_t length, uint8_t digest[kHashSize]) {
+        assert(data || length == 0);
+        assert(digest);
+
+        size_t completed = 0;
+        while (busy_count_ == lane_count_) {
+            completed += step();
+        }
+
+        for (size_t i = 0; i < lane_count_; ++i) {
+            if (!lanes_[i].busy) {
+                assign(i, data, length, digest);
+                break;
+            }
+        }
+        return completed;
+    }
+
+    size_t SHA256MB::flush() {
+        size_t completed = 0;
+        while (busy_count_ > 0) {
+            completed += step();
+        }
+        return completed;
+    }
+
+    size_t SHA256MB::getPendingCount() const {
+        return busy_count_;
+    }
+
+    void SHA256MB::hash(
+        const uint8_t* const data[], const size_t lengths[], size_t count,
+        uint8_t (*digests)[kHashSize])
+    {
+        SHA256MB mb;
+        for (size_t i = 0; i < count; ++i) {
+            mb.submit(data[i], lengths[i], digests[i]);
+        }
+        mb.flush();
+    }
+
+    size_t SHA256MB::step() {
+        assert(busy_count_ > 0);
+
+        // 推进到最早结束当前段的 lane 为止
+        size_t n = 0;
+        const uint8_t* ptrs[kMaxLanes];
+        for (size_t i = 0; i < lane_count_; ++i) {
+            const auto& lane = lanes_[i];
+            if (lane.busy) {
+                assert(lane.blocks > 0);
+                if (n == 0 || lane.blocks < n) {
+                    n = lane.blocks;
+                }
+                ptrs[i] = lane.data;
+            } else {
+                ptrs[i] = nullptr;
+            }
+        }
+
+        switch (impl_) {
+#ifdef AKASH_SHA_MB_X64
+        case Impl::SSE2:   compressSSE2(state_, ptrs, n); break;
+        case Impl::AVX2:   compressAVX2(state_, ptrs, n); break;
+        case Impl::AVX512: compressAVX512(state_, ptrs, n); break;
+#endif
+        default:           compressScalar(state_, ptrs, n); break;
+        }
+
+        size_t completed = 0;
+        for (size_t i = 0; i < lane_count_; ++i) {
+            auto& lane = lanes_[i];
+            if (!lane.busy) {
+                continue;
+            }
+
+            lane.data += n * kMsgBlockSize;
+            lane.blocks -= n;
+            if (lane.blocks > 0) {
+                continue;
+            }
+            if (lane.tail_blocks > 0) {
+                lane.data = lane.tail;
+                lane.blocks = lane.tail_blocks;
+                lane.tail_blocks = 0;
+                continue;
+            }
+            retire(i);
+            ++completed;
+        }
+        return completed;
+    }
+
+    void SHA256MB::assign(size_t index, const uint8_t* data, size_t length, uint8_t* digest) {
+        auto& lane = lanes_[index];
+        size_t full = length / kMsgBlockSize;
+        size_t rem = length % kMsgBlockSize;
+
+        // 填充：0x80，补 0，最后 8 字节为消息的位数
+        size_t tail_size = (rem < kMsgBlockSize - 8) ? kMsgBlockSize : 2 * kMsgBlockSize;
+        if (rem > 0) {
+            std::memcpy(lane.tail, data + full * kMsgBlockSize, rem);
+        }
+        lane.tail[rem] = 0x80;
+        std::memset(lane.tail + rem + 1, 0, tail_size - rem - 1);
+        uint64_t bits = uint64_t(length) << 3;
+        for (int i = 0; i < 8; ++i) {
+            lane.tail[tail_size - 1 - i] = uint8_t(bits >> (8 * i));
+        }
+
+        if (full > 0) {
+            lane.data = data;
+            lane.blocks = full;
+            lane.tail_blocks = tail_size / kMsgBlockSize;
+        } else {
+            lane.data = lane.tail;
+            lane.blocks = tail_size / kMsgBlockSize;
+            lane.tail_blocks = 0;
+        }
+        lane.digest = digest;
+        lane.busy = true;
+
+        for (int i = 0; i < 8; ++i) {
+            state_[i * lane_count_ + index] = kH0[i];
+        }
+        ++busy_count_;
+    }
+
+    void SHA256MB::retire(size_t index) {
+        auto& lane = lanes_[index];
+        for (int i = 0; i < kHashSize; ++i) {
+            lane.digest[i] = uint8_t(state_[(i >> 2) * lane_count_ + index] >> 8 * (3 - (i & 0x03)));
+        }
+
+        // 消息可能是敏感数据
+        std::memset(lane.tail, 0, sizeof(lane.tail));
+        lane.data = nullptr;
+        lane.digest = nullptr;
+        lane.busy = false;
+        --busy_count_;
+    }
+
+}
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_DIGEST_SHA256_MB_H_
+#define AKASH_SECURITY_DIGEST_SHA256_MB_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "akash/security/digest/sha.h"
+
+
+namespace akash {
+namespace digest {
+
+    /**
+     * 多缓冲区 SHA-256。
+     * 同时计算多条相互独立的消息的摘要：每条消息占用向量寄存器中的一个 lane，
+     * 各 lane 同步执行压缩函数。适用于大量较短的消息，例如握手记录、
+     * HMAC 的内外层以及证书指纹。
+     *
+     * 任务通过 submit 提交，所有 lane 都被占用时处理到至少一个任务完成为止；
+     * flush 处理剩余的任务，空闲的 lane 不读取数据。
+     * 各 lane 每次推进相同的块数，因此长度相近的消息效率最高。
+     */
+    class SHA256MB {
+    public:
+        // 压缩函数的实现方式，lane 数依次为 1、4、8、16
+        enum class Impl {
+            Scalar,
+            SSE2,
+            AVX2,
+            AVX512,
+        };
+
+        static const int kHashSize = SHA256::kHashSize;
+        static const int kMsgBlockSize = SHA256::kMsgBlockSize;
+        static const size_t kMaxLanes = 16;
+
+        // 设置使用的实现方式。启动时选择 CPU 支持的最快实现，
+        // 设置为 CPU 不支持的实现时无效。只影响之后创建的对象
+        static void setImpl(Impl impl);
+        static Impl getImpl();
+        static size_t getLaneCount(Impl impl);
+
+        SHA256MB();
+
+        /**
+         * 提交一条消息。data 可以为空指针，但同时 length 必须为 0。
+         * data 和 digest 在任务完成前必须保持有效。
+         * 返回值为本次调用中完成的任务数。
+         */
+        size_t submit(const uint8_t* data, size_t length, uint8_t digest[kHashSize]);
+
+        /**
+         * 完成所有已提交的任务，返回值为完成的任务数。
+         */
+        size_t flush();
+
+        // 已提交但尚未完成的任务数
+        size_t getPendingCount() const;
+
+        /**
+         * 计算 count 条消息的摘要。
+         * data[i] 指向长度为 lengths[i] 的消息，摘要写入 digests[i]。
+         */
+        static void hash(
+            const uint8_t* const data[], const size_t lengths[], size_t count,
+            uint8_t (*digests)[kHashSize]);
+
+    private:
+        struct Lane {
+            // 当前段中下一个块及剩余的块数
+            const uint8_t* data = nullptr;
+            size_t blocks = 0;
+            // 消息末尾不完整的块及填充，占 1 或 2 块，在消息之后处理
+            uint8_t tail[2 * kMsgBlockSize];
+            size_t tail_blocks = 0;
+            uint8_t* digest = nullptr;
+            bool busy = false;
+        };
+
+        // 所有忙碌的 lane 同时推进若干块，返回完成的任务数
+        size_t step();
+        void assign(size_t index, const uint8_t* data, size_t length, uint8_t* digest);
+        void retire(size_t index);
+
+        Impl impl_;
+        size_t lane_count_;
+        size_t busy_count_ = 0;
+        // state_[i * lane_count_ + j] 为第 j 个 lane 的第 i 个字
+        alignas(64) uint32_t state_[8 * kMaxLanes];
+        Lane lanes_[kMaxLanes];
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_DIGEST_SHA256_MB_H_
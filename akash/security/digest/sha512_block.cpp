@@ -0,0 +1,373 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/digest/sha512_block.h"
+
+#include "akash/security/crypto/cpu_features.h"
+
+#include "sha_private.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AKASH_SHA512_BLOCK_X64
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#define AVX512_TARGET
+#define FLATTEN
+#else
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define AVX512_TARGET __attribute__((target("avx2,avx512f,avx512vl")))
+// 将向量类型的各个运算内联到带有 target 属性的入口函数中
+#define FLATTEN __attribute__((flatten))
+#endif
+#endif
+
+/* Define the SHA shift, rotate left and rotate right macros */
+#define SHA512_SHR(bits,word)  (((uint64_t)(word)) >> (bits))
+#define SHA512_ROTR(bits,word) ((((uint64_t)(word)) >> (bits)) | \
+                                (((uint64_t)(word)) << (64-(bits))))
+
+/*
+ * Define the SHA SIGMA and sigma macros
+ *
+ *  SHA512_ROTR(28,word) ^ SHA512_ROTR(34,word) ^ SHA512_ROTR(39,word)
+ */
+#define SHA512_SIGMA0(word)   \
+ (SHA512_ROTR(28,word) ^ SHA512_ROTR(34,word) ^ SHA512_ROTR(39,word))
+#define SHA512_SIGMA1(word)   \
+ (SHA512_ROTR(14,word) ^ SHA512_ROTR(18,word) ^ SHA512_ROTR(41,word))
+#define SHA512_sigma0(word)   \
+ (SHA512_ROTR( 1,word) ^ SHA512_ROTR( 8,word) ^ SHA512_SHR( 7,word))
+#define SHA512_sigma1(word)   \
+ (SHA512_ROTR(19,word) ^ SHA512_ROTR(61,word) ^ SHA512_SHR( 6,word))
+
+
+namespace {
+
+    using akash::digest::SHA512Block;
+
+    /* Constants defined in FIPS 180-3, section 4.2.3 */
+    alignas(32) const uint64_t kK512[80] = {
+        0x428A2F98D728AE22ull, 0x7137449123EF65CDull, 0xB5C0FBCFEC4D3B2Full,
+        0xE9B5DBA58189DBBCull, 0x3956C25BF348B538ull, 0x59F111F1B605D019ull,
+        0x923F82A4AF194F9Bull, 0xAB1C5ED5DA6D8118ull, 0xD807AA98A3030242ull,
+        0x12835B0145706FBEull, 0x243185BE4EE4B28Cull, 0x550C7DC3D5FFB4E2ull,
+        0x72BE5D74F27B896Full, 0x80DEB1FE3B1696B1ull, 0x9BDC06A725C71235ull,
+        0xC19BF174CF692694ull, 0xE49B69C19EF14AD2ull, 0xEFBE4786384F25E3ull,
+        0x0FC19DC68B8CD5B5ull, 0x240CA1CC77AC9C65ull, 0x2DE92C6F592B0275ull,
+        0x4A7484AA6EA6E483ull, 0x5CB0A9DCBD41FBD4ull, 0x76F988DA831153B5ull,
+        0x983E5152EE66DFABull, 0xA831C66D2DB43210ull, 0xB00327C898FB213Full,
+        0xBF597FC7BEEF0EE4ull, 0xC6E00BF33DA88FC2ull, 0xD5A79147930AA725ull,
+        0x06CA6351E003826Full, 0x142929670A0E6E70ull, 0x27B70A8546D22FFCull,
+        0x2E1B21385C26C926ull, 0x4D2C6DFC5AC42AEDull, 0x53380D139D95B3DFull,
+        0x650A73548BAF63DEull, 0x766A0ABB3C77B2A8ull, 0x81C2C92E47EDAEE6ull,
+        0x92722C851482353Bull, 0xA2BFE8A14CF10364ull, 0xA81A664BBC423001ull,
+        0xC24B8B70D0F89791ull, 0xC76C51A30654BE30ull, 0xD192E819D6EF5218ull,
+        0xD69906245565A910ull, 0xF40E35855771202Aull, 0x106AA07032BBD1B8ull,
+        0x19A4C116B8D2D0C8ull, 0x1E376C085141AB53ull, 0x2748774CDF8EEB99ull,
+        0x34B0BCB5E19B48A8ull, 0x391C0CB3C5C95A63ull, 0x4ED8AA4AE3418ACBull,
+        0x5B9CCA4F7763E373ull, 0x682E6FF3D6B2B8A3ull, 0x748F82EE5DEFB2FCull,
+        0x78A5636F43172F60ull, 0x84C87814A1F0AB72ull, 0x8CC702081A6439ECull,
+        0x90BEFFFA23631E28ull, 0xA4506CEBDE82BDE9ull, 0xBEF9A3F7B2C67915ull,
+        0xC67178F2E372532Bull, 0xCA273ECEEA26619Cull, 0xD186B8C721C0C207ull,
+        0xEADA7DD6CDE0EB1Eull, 0xF57D4F7FEE6ED178ull, 0x06F067AA72176FBAull,
+        0x0A637DC5A2C898A6ull, 0x113F9804BEF90DAEull, 0x1B710B35131C471Bull,
+        0x28DB77F523047D84ull, 0x32CAAB7B40C72493ull, 0x3C9EBE0A15C9BEBCull,
+        0x431D67C49C100D4Cull, 0x4CC5D4BECB3E42B6ull, 0x597F299CFC657E2Aull,
+        0x5FCB6FAB3AD6FAECull, 0x6C44198C4A475817ull
+    };
+
+    uint64_t load64BE(const uint8_t* in) {
+        return (uint64_t(in[0]) << 56) |
+            (uint64_t(in[1]) << 48) |
+            (uint64_t(in[2]) << 40) |
+            (uint64_t(in[3]) << 32) |
+            (uint64_t(in[4]) << 24) |
+            (uint64_t(in[5]) << 16) |
+            (uint64_t(in[6]) << 8) |
+            uint64_t(in[7]);
+    }
+
+    /*
+     * Many of the variable names in this code, especially the
+     * single character names, were used because those were the
+     * names used in the Secure Hash Standard.
+     */
+    void sha512Reference(uint64_t state[8], const uint8_t* data, size_t count) {
+        int        t;                       /* Loop counter */
+        uint64_t   W[80];                   /* Word sequence */
+
+        for (; count > 0; --count, data += 128) {
+            /*
+             * Initialize the first 16 words in the array W
+             */
+            for (t = 0; t < 16; t++)
+                W[t] = load64BE(data + t * 8);
+            for (t = 16; t < 80; t++)
+                W[t] = SHA512_sigma1(W[t - 2]) + W[t - 7] +
+                SHA512_sigma0(W[t - 15]) + W[t - 16];
+
+            /* Word buffers */
+            uint64_t A = state[0];
+            uint64_t B = state[1];
+            uint64_t C = state[2];
+            uint64_t D = state[3];
+            uint64_t E = state[4];
+            uint64_t F = state[5];
+            uint64_t G = state[6];
+            uint64_t H = state[7];
+
+            for (t = 0; t < 80; t++) {
+                /* Temporary word value */
+                uint64_t temp1 = H + SHA512_SIGMA1(E) + SHA_Ch(E, F, G) + kK512[t] + W[t];
+                uint64_t temp2 = SHA512_SIGMA0(A) + SHA_Maj(A, B, C);
+                H = G;
+                G = F;
+                F = E;
+                E = D + temp1;
+                D = C;
+                C = B;
+                B = A;
+                A = temp1 + temp2;
+            }
+
+            state[0] += A;
+            state[1] += B;
+            state[2] += C;
+            state[3] += D;
+            state[4] += E;
+            state[5] += F;
+            state[6] += G;
+            state[7] += H;
+        }
+    }
+
+#ifdef AKASH_SHA512_BLOCK_X64
+
+    /*
+     * 向量实现：每个 128 位通道保存一个块的 2 个字，两个块的消息扩展同时计算，
+     * 并预先加上轮常量。wk[g] 的低 2 个字属于第一个块，高 2 个字属于第二个块。
+     * 轮函数依次对两个块执行。
+     */
+
+    struct V256 {
+        __m256i v;
+
+        AVX2_TARGET static V256 load2(const uint8_t* b0, const uint8_t* b1) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b0));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1));
+            __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            return { _mm256_shuffle_epi8(x, _mm256_set_epi8(
+                8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7)) };
+        }
+        // 两个通道使用相同的常量
+        AVX2_TARGET static V256 loadK(const uint64_t* k) {
+            return { _mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(k))) };
+        }
+        AVX2_TARGET static void store(uint64_t* p, V256 a) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(p), a.v);
+        }
+        AVX2_TARGET static V256 add(V256 a, V256 b) { return { _mm256_add_epi64(a.v, b.v) }; }
+        // 每个通道内 hi:lo 中间的两个字
+        AVX2_TARGET static V256 align(V256 hi, V256 lo) { return { _mm256_alignr_epi8(hi.v, lo.v, 8) }; }
+        template <int n>
+        AVX2_TARGET static V256 shr(V256 a) { return { _mm256_srli_epi64(a.v, n) }; }
+        template <int n>
+        AVX2_TARGET static V256 ror(V256 a) {
+            return { _mm256_or_si256(_mm256_srli_epi64(a.v, n), _mm256_slli_epi64(a.v, 64 - n)) };
+        }
+        AVX2_TARGET static V256 xor3(V256 a, V256 b, V256 c) {
+            return { _mm256_xor_si256(_mm256_xor_si256(a.v, b.v), c.v) };
+        }
+    };
+
+    struct V256VL {
+        __m256i v;
+
+        AVX512_TARGET static V256VL load2(const uint8_t* b0, const uint8_t* b1) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b0));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1));
+            __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            return { _mm256_shuffle_epi8(x, _mm256_set_epi8(
+                8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7)) };
+        }
+        // 两个通道使用相同的常量
+        AVX512_TARGET static V256VL loadK(const uint64_t* k) {
+            return { _mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(k))) };
+        }
+        AVX512_TARGET static void store(uint64_t* p, V256VL a) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(p), a.v);
+        }
+        AVX512_TARGET static V256VL add(V256VL a, V256VL b) { return { _mm256_add_epi64(a.v, b.v) }; }
+        // 每个通道内 hi:lo 中间的两个字
+        AVX512_TARGET static V256VL align(V256VL hi, V256VL lo) { return { _mm256_alignr_epi8(hi.v, lo.v, 8) }; }
+        template <int n>
+        AVX512_TARGET static V256VL shr(V256VL a) { return { _mm256_srli_epi64(a.v, n) }; }
+        // AVX-512VL 提供 64 位循环移位指令
+        template <int n>
+        AVX512_TARGET static V256VL ror(V256VL a) { return { _mm256_ror_epi64(a.v, n) }; }
+        // 三个数的异或由一条三元逻辑指令完成
+        AVX512_TARGET static V256VL xor3(V256VL a, V256VL b, V256VL c) {
+            return { _mm256_ternarylogic_epi64(a.v, b.v, c.v, 0x96) };
+        }
+    };
+
+    // 轮函数展开，每轮只改变两个变量，其余变量通过轮换参数的位置代替赋值
+#define SHA512_ROUND(a, b, c, d, e, f, g, h, t)  {  \
+    uint64_t temp1 = h + SHA512_SIGMA1(e) + SHA_Ch(e, f, g) + wk[(t) >> 1][lane + ((t) & 1)];  \
+    d += temp1;  \
+    h = temp1 + SHA512_SIGMA0(a) + SHA_Maj(a, b, c);  }
+
+    void sha512RoundsWK(uint64_t state[8], const uint64_t (*wk)[4], int lane) {
+        uint64_t A = state[0];
+        uint64_t B = state[1];
+        uint64_t C = state[2];
+        uint64_t D = state[3];
+        uint64_t E = state[4];
+        uint64_t F = state[5];
+        uint64_t G = state[6];
+        uint64_t H = state[7];
+
+        for (int t = 0; t < 80; t += 8) {
+            SHA512_ROUND(A, B, C, D, E, F, G, H, t)
+            SHA512_ROUND(H, A, B, C, D, E, F, G, t + 1)
+            SHA512_ROUND(G, H, A, B, C, D, E, F, t + 2)
+            SHA512_ROUND(F, G, H, A, B, C, D, E, t + 3)
+            SHA512_ROUND(E, F, G, H, A, B, C, D, t + 4)
+            SHA512_ROUND(D, E, F, G, H, A, B, C, t + 5)
+            SHA512_ROUND(C, D, E, F, G, H, A, B, t + 6)
+            SHA512_ROUND(B, C, D, E, F, G, H, A, t + 7)
+        }
+
+        state[0] += A;
+        state[1] += B;
+        state[2] += C;
+        state[3] += D;
+        state[4] += E;
+        state[5] += F;
+        state[6] += G;
+        state[7] += H;
+    }
+
+    template <class V>
+    void sha512Vec(uint64_t state[8], const uint8_t* data, size_t count) {
+        alignas(32) uint64_t wk[40][4];
+
+        while (count > 0) {
+            // 只剩一个块时两个通道计算同一个块
+            const uint8_t* b0 = data;
+            const uint8_t* b1 = count > 1 ? data + 128 : data;
+
+            V X[40];
+            for (int g = 0; g < 8; ++g) {
+                X[g] = V::load2(b0 + 16 * g, b1 + 16 * g);
+            }
+
+            // 每组 2 个字：W[t-15..t-14] 和 W[t-7..t-6] 由相邻两组拼接得到；
+            // sigma1 只依赖上一组的 W[t-2] 和 W[t-1]，组内没有依赖
+            for (int g = 8; g < 40; ++g) {
+                V w15 = V::align(X[g - 7], X[g - 8]);
+                V w2 = X[g - 1];
+                V s0 = V::xor3(V::template ror<1>(w15), V::template ror<8>(w15), V::template shr<7>(w15));
+                V s1 = V::xor3(V::template ror<19>(w2), V::template ror<61>(w2), V::template shr<6>(w2));
+                X[g] = V::add(
+                    V::add(X[g - 8], s0),
+                    V::add(V::align(X[g - 3], X[g - 4]), s1));
+            }
+
+            for (int g = 0; g < 40; ++g) {
+                V::store(wk[g], V::add(X[g], V::loadK(kK512 + 2 * g)));
+            }
+
+            sha512RoundsWK(state, wk, 0);
+            if (count == 1) {
+                break;
+            }
+            sha512RoundsWK(state, wk, 2);
+            data += 256;
+            count -= 2;
+        }
+    }
+
+    AVX2_TARGET FLATTEN
+    void sha512AVX2(uint64_t state[8], const uint8_t* data, size_t count) {
+        sha512Vec<V256>(state, data, count);
+    }
+
+    AVX512_TARGET FLATTEN
+    void sha512AVX512(uint64_t state[8], const uint8_t* data, size_t count) {
+        sha512Vec<V256VL>(state, data, count);
+    }
+
+#endif
+
+    using CompressFunc = void (*)(uint64_t state[8], const uint8_t* data, size_t count);
+
+    bool isSupported(SHA512Block::Impl impl) {
+        using akash::crypto::CPUFeatures;
+        switch (impl) {
+        case SHA512Block::Impl::Reference: return true;
+#ifdef AKASH_SHA512_BLOCK_X64
+        case SHA512Block::Impl::AVX2:
+            return CPUFeatures::hasAVX2();
+        case SHA512Block::Impl::AVX512:
+            return CPUFeatures::hasAVX2() && CPUFeatures::hasAVX512VL();
+#endif
+        default: return false;
+        }
+    }
+
+    SHA512Block::Impl detectImpl() {
+        if (isSupported(SHA512Block::Impl::AVX512)) {
+            return SHA512Block::Impl::AVX512;
+        }
+        if (isSupported(SHA512Block::Impl::AVX2)) {
+            return SHA512Block::Impl::AVX2;
+        }
+        return SHA512Block::Impl::Reference;
+    }
+
+    CompressFunc getCompressFunc(SHA512Block::Impl impl) {
+        switch (impl) {
+#ifdef AKASH_SHA512_BLOCK_X64
+        case SHA512Block::Impl::AVX512: return sha512AVX512;
+        case SHA512Block::Impl::AVX2:   return sha512AVX2;
+#endif
+        default:                        return sha512Reference;
+        }
+    }
+
+    SHA512Block::Impl impl_ = detectImpl();
+    CompressFunc compress_ = getCompressFunc(impl_);
+
+}
+
+namespace akash {
+namespace digest {
+
+    void SHA512Block::setImpl(Impl impl) {
+        if (!isSupported(impl)) {
+            return;
+        }
+        impl_ = impl;
+        compress_ = getCompressFunc(impl);
+    }
+
+    SHA512Block::Impl SHA512Block::getImpl() {
+        return impl_;
+    }
+
+    void SHA512Block::compress(uint64_t state[8], const uint8_t* data, size_t count) {
+        compress_(state, data, count);
+    }
+
+}
+}
@@ -0,0 +1,596 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/security/digest/sha_block.h"
+
+#include "akash/security/crypto/cpu_features.h"
+
+#include "sha_private.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AKASH_SHA_BLOCK_X64
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#define SHANI_TARGET
+#else
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#endif
+
+/*
+ *  Define the SHA1 circular left shift macro
+ */
+#define SHA1_ROTL(bits,word) \
+                (((word) << (bits)) | ((word) >> (32-(bits))))
+
+/* Define the SHA shift, rotate left, and rotate right macros */
+#define SHA256_SHR(bits,word)      ((word) >> (bits))
+#define SHA256_ROTR(bits,word)                         \
+  (((word) >> (bits)) | ((word) << (32-(bits))))
+
+/* Define the SHA SIGMA and sigma macros */
+#define SHA256_SIGMA0(word)   \
+  (SHA256_ROTR( 2,word) ^ SHA256_ROTR(13,word) ^ SHA256_ROTR(22,word))
+#define SHA256_SIGMA1(word)   \
+  (SHA256_ROTR( 6,word) ^ SHA256_ROTR(11,word) ^ SHA256_ROTR(25,word))
+#define SHA256_sigma0(word)   \
+  (SHA256_ROTR( 7,word) ^ SHA256_ROTR(18,word) ^ SHA256_SHR( 3,word))
+#define SHA256_sigma1(word)   \
+  (SHA256_ROTR(17,word) ^ SHA256_ROTR(19,word) ^ SHA256_SHR(10,word))
+
+
+namespace {
+
+    using akash::digest::SHABlock;
+
+    /* Constants defined in FIPS 180-3, section 4.2.1 */
+    const uint32_t kK1[4] = {
+        0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
+    };
+
+    /* Constants defined in FIPS 180-3, section 4.2.2 */
+    alignas(16) const uint32_t kK256[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+        0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+        0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+        0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+        0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+        0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+        0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+        0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+        0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    uint32_t load32BE(const uint8_t* in) {
+        return (uint32_t(in[0]) << 24) |
+            (uint32_t(in[1]) << 16) |
+            (uint32_t(in[2]) << 8) |
+            uint32_t(in[3]);
+    }
+
+    /*
+     * 以下为参考实现，与 RFC 6234 中的 SHA1ProcessMessageBlock 和
+     * SHA224_256ProcessMessageBlock 相同。
+     */
+    void sha1Reference(uint32_t state[5], const uint8_t* data, size_t count) {
+        int        t;               /* Loop counter */
+        uint32_t   temp;            /* Temporary word value */
+        uint32_t   W[80];           /* Word sequence */
+
+        for (; count > 0; --count, data += 64) {
+            /*
+             * Initialize the first 16 words in the array W
+             */
+            for (t = 0; t < 16; t++)
+                W[t] = load32BE(data + t * 4);
+
+            for (t = 16; t < 80; t++)
+                W[t] = SHA1_ROTL(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
+
+            // Word buffers
+            uint32_t A = state[0];
+            uint32_t B = state[1];
+            uint32_t C = state[2];
+            uint32_t D = state[3];
+            uint32_t E = state[4];
+
+            for (t = 0; t < 20; t++) {
+                temp = SHA1_ROTL(5, A) + SHA_Ch(B, C, D) + E + W[t] + kK1[0];
+                E = D;
+                D = C;
+                C = SHA1_ROTL(30, B);
+                B = A;
+                A = temp;
+            }
+
+            for (t = 20; t < 40; t++) {
+                temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + kK1[1];
+                E = D;
+                D = C;
+                C = SHA1_ROTL(30, B);
+                B = A;
+                A = temp;
+            }
+
+            for (t = 40; t < 60; t++) {
+                temp = SHA1_ROTL(5, A) + SHA_Maj(B, C, D) + E + W[t] + kK1[2];
+                E = D;
+                D = C;
+                C = SHA1_ROTL(30, B);
+                B = A;
+                A = temp;
+            }
+
+            for (t = 60; t < 80; t++) {
+                temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + kK1[3];
+                E = D;
+                D = C;
+                C = SHA1_ROTL(30, B);
+                B = A;
+                A = temp;
+            }
+
+            state[0] += A;
+            state[1] += B;
+            state[2] += C;
+            state[3] += D;
+            state[4] += E;
+        }
+    }
+
+    void sha256Reference(uint32_t state[8], const uint8_t* data, size_t count) {
+        int        t;                       /* Loop counter */
+        uint32_t   W[64];                   /* Word sequence */
+
+        for (; count > 0; --count, data += 64) {
+            /*
+             * Initialize the first 16 words in the array W
+             */
+            for (t = 0; t < 16; t++)
+                W[t] = load32BE(data + t * 4);
+            for (t = 16; t < 64; t++)
+                W[t] = SHA256_sigma1(W[t - 2]) + W[t - 7] +
+                SHA256_sigma0(W[t - 15]) + W[t - 16];
+
+            /* Word buffers */
+            uint32_t A = state[0];
+            uint32_t B = state[1];
+            uint32_t C = state[2];
+            uint32_t D = state[3];
+            uint32_t E = state[4];
+            uint32_t F = state[5];
+            uint32_t G = state[6];
+            uint32_t H = state[7];
+
+            for (t = 0; t < 64; t++) {
+                /* Temporary word value */
+                uint32_t temp1 = H + SHA256_SIGMA1(E) + SHA_Ch(E, F, G) + kK256[t] + W[t];
+                uint32_t temp2 = SHA256_SIGMA0(A) + SHA_Maj(A, B, C);
+                H = G;
+                G = F;
+                F = E;
+                E = D + temp1;
+                D = C;
+                C = B;
+                B = A;
+                A = temp1 + temp2;
+            }
+
+            state[0] += A;
+            state[1] += B;
+            state[2] += C;
+            state[3] += D;
+            state[4] += E;
+            state[5] += F;
+            state[6] += G;
+            state[7] += H;
+        }
+    }
+
+#ifdef AKASH_SHA_BLOCK_X64
+
+    /*
+     * AVX2 实现：每个 128 位通道保存一个块的 4 个字，两个块的消息扩展同时计算，
+     * 并预先加上轮常量。wk[g] 的低 4 个字属于第一个块，高 4 个字属于第二个块。
+     * 轮函数依次对两个块执行。
+     */
+
+    AVX2_TARGET inline __m256i bswap32x8(__m256i x) {
+        return _mm256_shuffle_epi8(x, _mm256_set_epi8(
+            12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+            12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3));
+    }
+
+    AVX2_TARGET inline __m256i load2(const uint8_t* b0, const uint8_t* b1) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b0));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1));
+        return bswap32x8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1));
+    }
+
+    AVX2_TARGET inline __m256i rotr32x8(__m256i x, int n) {
+        return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+    }
+
+    AVX2_TARGET inline __m256i sigma0x8(__m256i x) {
+        return _mm256_xor_si256(
+            _mm256_xor_si256(rotr32x8(x, 7), rotr32x8(x, 18)), _mm256_srli_epi32(x, 3));
+    }
+
+    AVX2_TARGET inline __m256i sigma1x8(__m256i x) {
+        return _mm256_xor_si256(
+            _mm256_xor_si256(rotr32x8(x, 17), rotr32x8(x, 19)), _mm256_srli_epi32(x, 10));
+    }
+
+    // 轮函数展开，每轮只改变两个变量，其余变量通过轮换参数的位置代替赋值
+#define SHA1_ROUND(a, b, c, d, e, f, t)  \
+    e += SHA1_ROTL(5, a) + f(b, c, d) + wk[(t) >> 2][lane + ((t) & 3)];  \
+    b = SHA1_ROTL(30, b);
+
+#define SHA1_ROUND5(f, t)  \
+    SHA1_ROUND(A, B, C, D, E, f, t)  \
+    SHA1_ROUND(E, A, B, C, D, f, t + 1)  \
+    SHA1_ROUND(D, E, A, B, C, f, t + 2)  \
+    SHA1_ROUND(C, D, E, A, B, f, t + 3)  \
+    SHA1_ROUND(B, C, D, E, A, f, t + 4)
+
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, t)  {  \
+    uint32_t temp1 = h + SHA256_SIGMA1(e) + SHA_Ch(e, f, g) + wk[(t) >> 2][lane + ((t) & 3)];  \
+    d += temp1;  \
+    h = temp1 + SHA256_SIGMA0(a) + SHA_Maj(a, b, c);  }
+
+    void sha1RoundsWK(uint32_t state[5], const uint32_t (*wk)[8], int lane) {
+        uint32_t A = state[0];
+        uint32_t B = state[1];
+        uint32_t C = state[2];
+        uint32_t D = state[3];
+        uint32_t E = state[4];
+
+        for (int t = 0; t < 20; t += 5) {
+            SHA1_ROUND5(SHA_Ch, t)
+        }
+        for (int t = 20; t < 40; t += 5) {
+            SHA1_ROUND5(SHA_Parity, t)
+        }
+        for (int t = 40; t < 60; t += 5) {
+            SHA1_ROUND5(SHA_Maj, t)
+        }
+        for (int t = 60; t < 80; t += 5) {
+            SHA1_ROUND5(SHA_Parity, t)
+        }
+
+        state[0] += A;
+        state[1] += B;
+        state[2] += C;
+        state[3] += D;
+        state[4] += E;
+    }
+
+    void sha256RoundsWK(uint32_t state[8], const uint32_t (*wk)[8], int lane) {
+        uint32_t A = state[0];
+        uint32_t B = state[1];
+        uint32_t C = state[2];
+        uint32_t D = state[3];
+        uint32_t E = state[4];
+        uint32_t F = state[5];
+        uint32_t G = state[6];
+        uint32_t H = state[7];
+
+        for (int t = 0; t < 64; t += 8) {
+            SHA256_ROUND(A, B, C, D, E, F, G, H, t)
+            SHA256_ROUND(H, A, B, C, D, E, F, G, t + 1)
+            SHA256_ROUND(G, H, A, B, C, D, E, F, t + 2)
+            SHA256_ROUND(F, G, H, A, B, C, D, E, t + 3)
+            SHA256_ROUND(E, F, G, H, A, B, C, D, t + 4)
+            SHA256_ROUND(D, E, F, G, H, A, B, C, t + 5)
+            SHA256_ROUND(C, D, E, F, G, H, A, B, t + 6)
+            SHA256_ROUND(B, C, D, E, F, G, H, A, t + 7)
+        }
+
+        state[0] += A;
+        state[1] += B;
+        state[2] += C;
+        state[3] += D;
+        state[4] += E;
+        state[5] += F;
+        state[6] += G;
+        state[7] += H;
+    }
+
+    AVX2_TARGET void sha1AVX2(uint32_t state[5], const uint8_t* data, size_t count) {
+        alignas(32) uint32_t wk[20][8];
+
+        while (count > 0) {
+            // 只剩一个块时两个通道计算同一个块
+            const uint8_t* b0 = data;
+            const uint8_t* b1 = count > 1 ? data + 64 : data;
+
+            __m256i X[20];
+            for (int g = 0; g < 4; ++g) {
+                X[g] = load2(b0 + 16 * g, b1 + 16 * g);
+            }
+
+            // W[t] = ROTL1(W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16])。
+            // 同一组中的 W[t+3] 依赖 W[t]，先以 0 代替，再异或上 ROTL1(W[t])
+            for (int g = 4; g < 20; ++g) {
+                __m256i t = _mm256_xor_si256(
+                    _mm256_xor_si256(X[g - 4], _mm256_alignr_epi8(X[g - 3], X[g - 4], 8)),
+                    _mm256_xor_si256(X[g - 2], _mm256_srli_si256(X[g - 1], 4)));
+                t = _mm256_or_si256(_mm256_slli_epi32(t, 1), _mm256_srli_epi32(t, 31));
+                __m256i w0 = _mm256_slli_si256(t, 12);
+                t = _mm256_xor_si256(t, _mm256_or_si256(_mm256_slli_epi32(w0, 1), _mm256_srli_epi32(w0, 31)));
+                X[g] = t;
+            }
+
+            for (int g = 0; g < 20; ++g) {
+                __m256i k = _mm256_set1_epi32(int(kK1[g / 5]));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(wk[g]), _mm256_add_epi32(X[g], k));
+            }
+
+            sha1RoundsWK(state, wk, 0);
+            if (count == 1) {
+                break;
+            }
+            sha1RoundsWK(state, wk, 4);
+            data += 128;
+            count -= 2;
+        }
+    }
+
+    AVX2_TARGET void sha256AVX2(uint32_t state[8], const uint8_t* data, size_t count) {
+        alignas(32) uint32_t wk[16][8];
+
+        while (count > 0) {
+            const uint8_t* b0 = data;
+            const uint8_t* b1 = count > 1 ? data + 64 : data;
+
+            __m256i X[16];
+            for (int g = 0; g < 4; ++g) {
+                X[g] = load2(b0 + 16 * g, b1 + 16 * g);
+            }
+
+            // 每组 4 个字：W[t-15..t-12] 和 W[t-7..t-4] 由相邻两组拼接得到；
+            // sigma1 依赖 W[t-2] 和 W[t-1]，分两次计算低 2 个字和高 2 个字
+            for (int g = 4; g < 16; ++g) {
+                __m256i t = _mm256_add_epi32(
+                    _mm256_add_epi32(X[g - 4], sigma0x8(_mm256_alignr_epi8(X[g - 3], X[g - 4], 4))),
+                    _mm256_alignr_epi8(X[g - 1], X[g - 2], 4));
+                t = _mm256_add_epi32(t, sigma1x8(_mm256_srli_si256(X[g - 1], 8)));
+                t = _mm256_add_epi32(t, sigma1x8(_mm256_slli_si256(t, 8)));
+                X[g] = t;
+            }
+
+            for (int g = 0; g < 16; ++g) {
+                __m256i k = _mm256_broadcastsi128_si256(
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(kK256 + 4 * g)));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(wk[g]), _mm256_add_epi32(X[g], k));
+            }
+
+            sha256RoundsWK(state, wk, 0);
+            if (count == 1) {
+                break;
+            }
+            sha256RoundsWK(state, wk, 4);
+            data += 128;
+            count -= 2;
+        }
+    }
+
+    /*
+     * SHA-NI 实现，参考 Intel 白皮书《Intel SHA Extensions》。
+     * 每组处理 4 轮，M[g % 4] 保存该组的 4 个字，后续组的消息在轮函数间隙中计算。
+     */
+
+    template <int g>
+    SHANI_TARGET inline void sha1Group(
+        __m128i& ABCD, __m128i& E0, __m128i& E1, __m128i M[4], const uint8_t* data, __m128i mask)
+    {
+        if (g < 4) {
+            M[g] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * g)), mask);
+        }
+
+        // E0 为本组的 E，E1 在本组中保存轮函数之前的 ABCD，用于计算下一组的 E
+        if (g == 0) {
+            E0 = _mm_add_epi32(E0, M[0]);
+        } else {
+            E0 = _mm_sha1nexte_epu32(E1, M[g & 3]);
+        }
+        if (g >= 3 && g <= 18) {
+            M[(g + 1) & 3] = _mm_sha1msg2_epu32(M[(g + 1) & 3], M[g & 3]);
+        }
+        E1 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, g / 5);
+        if (g >= 1 && g <= 16) {
+            M[(g - 1) & 3] = _mm_sha1msg1_epu32(M[(g - 1) & 3], M[g & 3]);
+        }
+        if (g >= 2 && g <= 17) {
+            M[(g - 2) & 3] = _mm_xor_si128(M[(g - 2) & 3], M[g & 3]);
+        }
+    }
+
+    SHANI_TARGET void sha1SHANI(uint32_t state[5], const uint8_t* data, size_t count) {
+        const __m128i mask = _mm_set_epi64x(0x0001020304050607ll, 0x08090a0b0c0d0e0fll);
+
+        __m128i ABCD = _mm_shuffle_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+        __m128i E = _mm_set_epi32(int(state[4]), 0, 0, 0);
+
+        for (; count > 0; --count, data += 64) {
+            __m128i ABCD_save = ABCD;
+            __m128i E_save = E;
+            __m128i M[4];
+            __m128i E0 = E, E1;
+
+            sha1Group<0>(ABCD, E0, E1, M, data, mask);
+            sha1Group<1>(ABCD, E0, E1, M, data, mask);
+            sha1Group<2>(ABCD, E0, E1, M, data, mask);
+            sha1Group<3>(ABCD, E0, E1, M, data, mask);
+            sha1Group<4>(ABCD, E0, E1, M, data, mask);
+            sha1Group<5>(ABCD, E0, E1, M, data, mask);
+            sha1Group<6>(ABCD, E0, E1, M, data, mask);
+            sha1Group<7>(ABCD, E0, E1, M, data, mask);
+            sha1Group<8>(ABCD, E0, E1, M, data, mask);
+            sha1Group<9>(ABCD, E0, E1, M, data, mask);
+            sha1Group<10>(ABCD, E0, E1, M, data, mask);
+            sha1Group<11>(ABCD, E0, E1, M, data, mask);
+            sha1Group<12>(ABCD, E0, E1, M, data, mask);
+            sha1Group<13>(ABCD, E0, E1, M, data, mask);
+            sha1Group<14>(ABCD, E0, E1, M, data, mask);
+            sha1Group<15>(ABCD, E0, E1, M, data, mask);
+            sha1Group<16>(ABCD, E0, E1, M, data, mask);
+            sha1Group<17>(ABCD, E0, E1, M, data, mask);
+            sha1Group<18>(ABCD, E0, E1, M, data, mask);
+            sha1Group<19>(ABCD, E0, E1, M, data, mask);
+
+            E = _mm_sha1nexte_epu32(E1, E_save);
+            ABCD = _mm_add_epi32(ABCD, ABCD_save);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(ABCD, 0x1B));
+        state[4] = uint32_t(_mm_extract_epi32(E, 3));
+    }
+
+    template <int g>
+    SHANI_TARGET inline void sha256Group(
+        __m128i& S0, __m128i& S1, __m128i M[4], const uint8_t* data, __m128i mask)
+    {
+        if (g < 4) {
+            M[g] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * g)), mask);
+        }
+
+        __m128i msg = _mm_add_epi32(
+            M[g & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(kK256 + 4 * g)));
+        S1 = _mm_sha256rnds2_epu32(S1, S0, msg);
+        if (g >= 3 && g <= 14) {
+            __m128i t = _mm_alignr_epi8(M[g & 3], M[(g - 1) & 3], 4);
+            M[(g + 1) & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(M[(g + 1) & 3], t), M[g & 3]);
+        }
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        S0 = _mm_sha256rnds2_epu32(S0, S1, msg);
+        if (g >= 1 && g <= 12) {
+            M[(g - 1) & 3] = _mm_sha256msg1_epu32(M[(g - 1) & 3], M[g & 3]);
+        }
+    }
+
+    SHANI_TARGET void sha256SHANI(uint32_t state[8], const uint8_t* data, size_t count) {
+        const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+
+        // 指令使用的状态排列为 ABEF 和 CDGH
+        __m128i t = _mm_shuffle_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+        __m128i S1 = _mm_shuffle_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+        __m128i S0 = _mm_alignr_epi8(t, S1, 8);
+        S1 = _mm_blend_epi16(S1, t, 0xF0);
+
+        for (; count > 0; --count, data += 64) {
+            __m128i S0_save = S0;
+            __m128i S1_save = S1;
+            __m128i M[4];
+
+            sha256Group<0>(S0, S1, M, data, mask);
+            sha256Group<1>(S0, S1, M, data, mask);
+            sha256Group<2>(S0, S1, M, data, mask);
+            sha256Group<3>(S0, S1, M, data, mask);
+            sha256Group<4>(S0, S1, M, data, mask);
+            sha256Group<5>(S0, S1, M, data, mask);
+            sha256Group<6>(S0, S1, M, data, mask);
+            sha256Group<7>(S0, S1, M, data, mask);
+            sha256Group<8>(S0, S1, M, data, mask);
+            sha256Group<9>(S0, S1, M, data, mask);
+            sha256Group<10>(S0, S1, M, data, mask);
+            sha256Group<11>(S0, S1, M, data, mask);
+            sha256Group<12>(S0, S1, M, data, mask);
+            sha256Group<13>(S0, S1, M, data, mask);
+            sha256Group<14>(S0, S1, M, data, mask);
+            sha256Group<15>(S0, S1, M, data, mask);
+
+            S0 = _mm_add_epi32(S0, S0_save);
+            S1 = _mm_add_epi32(S1, S1_save);
+        }
+
+        t = _mm_shuffle_epi32(S0, 0x1B);
+        S1 = _mm_shuffle_epi32(S1, 0xB1);
+        S0 = _mm_blend_epi16(t, S1, 0xF0);
+        S1 = _mm_alignr_epi8(S1, t, 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), S0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), S1);
+    }
+
+#endif
+
+    bool isSupported(SHABlock::Impl impl) {
+        using akash::crypto::CPUFeatures;
+        switch (impl) {
+        case SHABlock::Impl::Reference: return true;
+#ifdef AKASH_SHA_BLOCK_X64
+        case SHABlock::Impl::AVX2:
+            return CPUFeatures::hasAVX2();
+        case SHABlock::Impl::SHANI:
+            return CPUFeatures::hasSHA() && CPUFeatures::hasSSE41() && CPUFeatures::hasSSSE3();
+#endif
+        default: return false;
+        }
+    }
+
+    SHABlock::Impl detectImpl() {
+        if (isSupported(SHABlock::Impl::SHANI)) {
+            return SHABlock::Impl::SHANI;
+        }
+        if (isSupported(SHABlock::Impl::AVX2)) {
+            return SHABlock::Impl::AVX2;
+        }
+        return SHABlock::Impl::Reference;
+    }
+
+    SHABlock::Impl impl_ = detectImpl();
+
+}
+
+namespace akash {
+namespace digest {
+
+    void SHABlock::setImpl(Impl impl) {
+        if (!isSupported(impl)) {
+            return;
+        }
+        impl_ = impl;
+    }
+
+    SHABlock::Impl SHABlock::getImpl() {
+        return impl_;
+    }
+
+    void SHABlock::sha1(uint32_t state[5], const uint8_t* data, size_t count) {
+        switch (impl_) {
+#ifdef AKASH_SHA_BLOCK_X64
+        case Impl::SHANI: sha1SHANI(state, data, count); break;
+        case Impl::AVX2:  sha1AVX2(state, data, count); break;
+#endif
+        default:          sha1Reference(state, data, count); break;
+        }
+    }
+
+    void SHABlock::sha256(uint32_t state[8], const uint8_t* data, size_t count) {
+        switch (impl_) {
+#ifdef AKASH_SHA_BLOCK_X64
+        case Impl::SHANI: sha256SHANI(state, data, count); break;
+        case Impl::AVX2:  sha256AVX2(state, data, count); break;
+#endif
+        default:          sha256Reference(state, data, count); break;
+        }
+    }
+
+}
+}
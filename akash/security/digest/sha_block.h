@@ -0,0 +1,46 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SECURITY_DIGEST_SHA_BLOCK_H_
+#define AKASH_SECURITY_DIGEST_SHA_BLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace akash {
+namespace digest {
+
+    /**
+     * SHA-1 与 SHA-224/SHA-256 的压缩函数。
+     * 依次压缩 data 中连续的 count 个 64 字节的块，state 为中间哈希值。
+     * SHA-224 与 SHA-256 只有初始值和输出长度不同，使用同一个压缩函数。
+     */
+    class SHABlock {
+    public:
+        // 压缩函数的实现方式
+        enum class Impl {
+            // RFC 6234 中的参考实现
+            Reference,
+            // 使用 AVX2 同时计算两个块的消息扩展，轮函数仍为标量运算
+            AVX2,
+            // 使用 SHA 扩展指令 (SHA-NI)
+            SHANI,
+        };
+
+        // 设置使用的实现方式。启动时选择 CPU 支持的最快实现，
+        // 设置为 CPU 不支持的实现时无效。
+        static void setImpl(Impl impl);
+        static Impl getImpl();
+
+        static void sha1(uint32_t state[5], const uint8_t* data, size_t count);
+        static void sha256(uint32_t state[8], const uint8_t* data, size_t count);
+    };
+
+}
+}
+
+#endif  // AKASH_SECURITY_DIGEST_SHA_BLOCK_H_
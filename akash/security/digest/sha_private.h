@@ -7,6 +7,7 @@
 #ifndef SHA_PRIVATE_H_
 #define SHA_PRIVATE_H_
 
+#include <cstddef>
 #include <cstdint>
 
 
@@ -31,25 +32,60 @@
 
 #define SHA_Parity(x, y, z)  ((x) ^ (y) ^ (z))
 
+/*
+ * Add "length" bits to the 64-bit message length.
+ * Returns false when overflow has occurred.
+ */
+inline bool SHAAddBits64(uint64_t* total, uint64_t length) {
+    uint64_t sum = *total + length;
+    if (sum < *total) return false;
+    *total = sum;
+    return true;
+}
+
+/*
+ * Add "length" bytes to the 64-bit message length, in bits.
+ */
+inline bool SHAAddBytes64(uint64_t* total, size_t length) {
+    if (uint64_t(length) >> 61) return false;
+    return SHAAddBits64(total, uint64_t(length) << 3);
+}
+
+/*
+ * Add "length" bytes to the 128-bit message length high:low, in bits.
+ * Returns false when overflow has occurred.
+ */
+inline bool SHAAddBytes128(uint64_t* high, uint64_t* low, size_t length) {
+    uint64_t bits = uint64_t(length) << 3;
+    uint64_t sum_low = *low + bits;
+    uint64_t sum_high = *high + (uint64_t(length) >> 61) + (sum_low < bits ? 1 : 0);
+    if (sum_high < *high) return false;
+    *high = sum_high;
+    *low = sum_low;
+    return true;
+}
+
+/*
+ * Add "length" bits to the 128-bit message length high:low.
+ * Returns false when overflow has occurred.
+ */
+inline bool SHAAddBits128(uint64_t* high, uint64_t* low, uint64_t length) {
+    uint64_t sum_low = *low + length;
+    uint64_t sum_high = *high + (sum_low < length ? 1 : 0);
+    if (sum_high < *high) return false;
+    *high = sum_high;
+    *low = sum_low;
+    return true;
+}
+
 /*
  * Add "length" to the length.
  * Set Corrupted when overflow has occurred.
  */
-static uint32_t addTemp32;
-#define SHAAddLength32(context, length)                     \
-    (addTemp32 = (context).length_low,                      \
-     (context).corrupted =                                  \
-        (((context).length_low += (length)) < addTemp32) && \
-        (++(context).length_high == 0) ? shaInputTooLong    \
-                                        : (context).corrupted)
-
-static uint64_t addTemp64;
-#define SHAAddLength64(context, length)                     \
-    (addTemp64 = (context).length_low,                      \
-     (context).corrupted =                                  \
-        (((context).length_low += (length)) < addTemp64) && \
-        (++(context).length_high == 0) ? shaInputTooLong    \
-                                        : (context).corrupted)
+#define SHAAddLength64(context, length)                                        \
+    ((context).corrupted =                                                     \
+        SHAAddBits128(&(context).length_high, &(context).length_low, (length)) \
+            ? (context).corrupted : shaInputTooLong)
 
 
 #endif  // SHA_PRIVATE_H_
\ No newline at end of file
@@ -58,7 +58,7 @@ namespace digest {
      *      sha Error Code.
      *
      */
-    int USHA::update(const uint8_t* bytes, unsigned int length) {
+    int USHA::update(const uint8_t* bytes, size_t length) {
         switch (context_.which_sha) {
         case SHAVersion::SHA1:
             return context_.ctx.sha1.update(bytes, length);
@@ -140,6 +140,27 @@ namespace digest {
         }
     }
 
+    /*
+     * peekResult
+     *
+     * Description:
+     *   This function will return the message digest of the octets
+     *   input so far, without finalizing the context.  More input
+     *   may follow.
+     *
+     * Parameters:
+     *   msg_digest[ ]: [out]
+     *     Where the digest is returned.
+     *
+     * Returns:
+     *   sha Error Code.
+     *
+     */
+    int USHA::peekResult(uint8_t msg_digest[kMaxHashSize]) const {
+        USHA snapshot(*this);
+        return snapshot.result(msg_digest);
+    }
+
     /*
      * USHABlockSize
      *
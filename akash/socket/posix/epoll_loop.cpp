@@ -0,0 +1,81 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/socket/posix/epoll_loop.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "utils/log.h"
+
+
+namespace akash {
+namespace posix {
+
+    // static
+    EpollLoop* EpollLoop::current() {
+        thread_local EpollLoop loop;
+        return &loop;
+    }
+
+    EpollLoop::EpollLoop() {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ == -1) {
+            LOG(Log::ERR) << "Failed to create epoll: " << errno;
+        }
+    }
+
+    EpollLoop::~EpollLoop() {
+        if (epoll_fd_ != -1) {
+            ::close(epoll_fd_);
+        }
+    }
+
+    bool EpollLoop::isValid() const {
+        return epoll_fd_ != -1;
+    }
+
+    bool EpollLoop::add(int fd, Watcher* watcher) {
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = watcher;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            LOG(Log::ERR) << "Failed to add fd to epoll: " << errno;
+            return false;
+        }
+        return true;
+    }
+
+    void EpollLoop::remove(int fd) {
+        // 早于 2.6.9 的内核要求 event 不为空
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ev);
+    }
+
+    bool EpollLoop::poll(int timeout_ms) {
+        epoll_event events[kMaxEvents];
+        int count = ::epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+        if (count == -1) {
+            if (errno == EINTR) {
+                return true;
+            }
+            LOG(Log::ERR) << "Failed to wait epoll: " << errno;
+            return false;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            static_cast<Watcher*>(events[i].data.ptr)->onEvents(events[i].events);
+        }
+        return true;
+    }
+
+}
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SOCKET_POSIX_EPOLL_LOOP_H_
+#define AKASH_SOCKET_POSIX_EPOLL_LOOP_H_
+
+#include <cstdint>
+
+
+namespace akash {
+namespace posix {
+
+    // 每个线程一个的 epoll 实例。
+    // 同一线程中创建的所有 socket 都注册到这里，以边缘触发方式监听读写事件，
+    // 任意一个 socket 等待时都会把收到的事件分发给各自的 Watcher，
+    // 因此一个线程可以同时处理多个连接。
+    class EpollLoop {
+    public:
+        class Watcher {
+        public:
+            virtual ~Watcher() = default;
+            // events 为 EPOLLIN、EPOLLOUT 等的组合
+            virtual void onEvents(uint32_t events) = 0;
+        };
+
+        // 当前线程的实例，第一次调用时创建
+        static EpollLoop* current();
+
+        EpollLoop();
+        ~EpollLoop();
+
+        bool isValid() const;
+
+        /**
+         * 以边缘触发方式监听 fd 的读、写和挂断事件。
+         * fd 必须为非阻塞的，Watcher 在调用 remove 之前必须保持有效。
+         */
+        bool add(int fd, Watcher* watcher);
+        void remove(int fd);
+
+        /**
+         * 等待事件并分发，timeout_ms 为 -1 时一直等待。
+         * 返回 false 表示 epoll_wait 出错。
+         */
+        bool poll(int timeout_ms);
+
+    private:
+        EpollLoop(const EpollLoop&) = delete;
+        EpollLoop& operator=(const EpollLoop&) = delete;
+
+        static const int kMaxEvents = 64;
+
+        int epoll_fd_;
+    };
+
+}
+}
+
+#endif  // AKASH_SOCKET_POSIX_EPOLL_LOOP_H_
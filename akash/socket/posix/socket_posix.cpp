@@ -0,0 +1,400 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/socket/posix/socket_posix.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "akash/socket/posix/socket_utils.h"
+#include "utils/log.h"
+
+
+namespace akash {
+namespace posix {
+
+    // SocketClient
+    SocketClientPosix::SocketClientPosix()
+        : socket_(-1),
+          loop_(EpollLoop::current()) {
+    }
+
+    SocketClientPosix::~SocketClientPosix() {
+        close();
+    }
+
+    bool SocketClientPosix::connect(const std::string& ip, uint16_t port) {
+        sockaddr_storage addr;
+        socklen_t addr_len;
+        if (!parseIpAddr(ip, port, &addr, &addr_len)) {
+            return false;
+        }
+        return connect(reinterpret_cast<sockaddr*>(&addr), addr_len);
+    }
+
+    bool SocketClientPosix::connectByHost(const std::string& host, uint16_t port) {
+        // 依次尝试每个地址
+        return connectEachAddr(host, port, [this](const sockaddr* addr, socklen_t addr_len) {
+            if (connect(addr, addr_len)) {
+                return true;
+            }
+            close();
+            return false;
+        });
+    }
+
+    bool SocketClientPosix::connect(const sockaddr* addr, socklen_t addr_len) {
+        if (!loop_->isValid()) {
+            LOG(Log::ERR) << "Invalid epoll.";
+            return false;
+        }
+
+        if (socket_ != -1) {
+            LOG(Log::ERR) << "This client is already connected!";
+            return false;
+        }
+
+        socket_ = createTcpSocket(addr->sa_family, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket_ == -1) {
+            return false;
+        }
+
+        readable_ = writable_ = false;
+        if (!loop_->add(socket_, this)) {
+            close();
+            return false;
+        }
+
+        if (::connect(socket_, addr, addr_len) == -1) {
+            if (errno != EINPROGRESS) {
+                LOG(Log::ERR) << "Failed to connect: " << errno;
+                close();
+                return false;
+            }
+
+            // 连接完成时 socket 变为可写
+            if (!wait(WaitType::SEND)) {
+                close();
+                return false;
+            }
+
+            int error = 0;
+            socklen_t error_len = sizeof(error);
+            if (::getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error, &error_len) == -1 || error != 0) {
+                LOG(Log::ERR) << "Failed to connect: " << error;
+                close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool SocketClientPosix::send(const std::string& buf) {
+        SocketBuffer sb;
+        sb.data = reinterpret_cast<const uint8_t*>(buf.data());
+        sb.length = buf.length();
+        return send(&sb, 1);
+    }
+
+    bool SocketClientPosix::send(const SocketBuffer* bufs, size_t count) {
+        if (socket_ == -1) {
+            LOG(Log::ERR) << "Invalid socket.";
+            return false;
+        }
+
+        // 每次最多提交 kMaxBufs 段，部分写入时从中断处继续
+        const size_t kMaxBufs = 64;
+        iovec iov[kMaxBufs];
+        size_t offset = 0;
+
+        while (count > 0) {
+            size_t n = std::min(count, kMaxBufs);
+            for (size_t i = 0; i < n; ++i) {
+                iov[i].iov_base = const_cast<uint8_t*>(bufs[i].data);
+                iov[i].iov_len = bufs[i].length;
+            }
+            iov[0].iov_base = static_cast<uint8_t*>(iov[0].iov_base) + offset;
+            iov[0].iov_len -= offset;
+
+            msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = n;
+
+            auto bytes_sent = ::sendmsg(socket_, &msg, MSG_NOSIGNAL);
+            if (bytes_sent == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    writable_ = false;
+                    if (!wait(WaitType::SEND)) {
+                        return false;
+                    }
+                    continue;
+                }
+                LOG(Log::ERR) << "Failed to send: " << errno;
+                return false;
+            }
+
+            // 跳过已发送的部分
+            skipSentBuffers(&bufs, &count, &offset, size_t(bytes_sent));
+        }
+        return true;
+    }
+
+    bool SocketClientPosix::recv(int length, std::string* buf) {
+        return recvLength(this, length, buf);
+    }
+
+    bool SocketClientPosix::recv(std::string* buf) {
+        return recvUntilClosed(this, buf);
+    }
+
+    bool SocketClientPosix::recv(uint8_t* buf, size_t length, size_t* received) {
+        if (socket_ == -1) {
+            LOG(Log::ERR) << "Invalid socket.";
+            return false;
+        }
+
+        for (;;) {
+            auto bytes_revd = ::recv(socket_, buf, std::min(length, size_t(INT_MAX)), 0);
+            if (bytes_revd > 0) {
+                *received = size_t(bytes_revd);
+                return true;
+            }
+            if (bytes_revd == 0) {
+                LOG(Log::INFO) << "Connection closed";
+                *received = 0;
+                return true;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                readable_ = false;
+                if (!wait(WaitType::RECV)) {
+                    return false;
+                }
+                continue;
+            }
+            LOG(Log::ERR) << "Failed to recv: " << errno;
+            return false;
+        }
+    }
+
+    bool SocketClientPosix::shutdown() {
+        if (socket_ != -1) {
+            if (::shutdown(socket_, SHUT_WR) == -1) {
+                LOG(Log::ERR) << "Failed to shutdown: " << errno;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SocketClientPosix::close() {
+        if (socket_ != -1) {
+            loop_->remove(socket_);
+            ::close(socket_);
+            socket_ = -1;
+        }
+    }
+
+    void SocketClientPosix::onEvents(uint32_t events) {
+        if (events & (EPOLLIN | EPOLLRDHUP)) {
+            readable_ = true;
+        }
+        if (events & EPOLLOUT) {
+            writable_ = true;
+        }
+        if (events & (EPOLLHUP | EPOLLERR)) {
+            // 读写时会得到具体的错误
+            readable_ = writable_ = true;
+        }
+    }
+
+    bool SocketClientPosix::wait(WaitType type) {
+        bool& ready = (type == WaitType::SEND) ? writable_ : readable_;
+        while (!ready) {
+            if (!loop_->poll(-1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    // SocketServer
+    SocketServerPosix::SocketServerPosix()
+        : server_socket_(-1),
+          accept_socket_(-1),
+          loop_(EpollLoop::current()) {
+    }
+
+    SocketServerPosix::~SocketServerPosix() {
+        close();
+    }
+
+    bool SocketServerPosix::wait(const std::string& ip, uint16_t port) {
+        if (!loop_->isValid()) {
+            LOG(Log::ERR) << "Invalid epoll.";
+            return false;
+        }
+
+        if (server_socket_ != -1) {
+            LOG(Log::ERR) << "This server socket is already created!";
+            return false;
+        }
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (::inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+            LOG(Log::ERR) << "Failed to convert ip addr: " << ip;
+            return false;
+        }
+
+        server_socket_ = createTcpSocket(AF_INET, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (server_socket_ == -1) {
+            return false;
+        }
+
+        int on = 1;
+        ::setsockopt(server_socket_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        if (::bind(server_socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            LOG(Log::ERR) << "Failed to bind: " << errno;
+            close();
+            return false;
+        }
+
+        if (::listen(server_socket_, SOMAXCONN) == -1) {
+            LOG(Log::ERR) << "Failed to listen: " << errno;
+            close();
+            return false;
+        }
+
+        if (!loop_->add(server_socket_, this)) {
+            close();
+            return false;
+        }
+
+        for (;;) {
+            // 接受的连接继承监听 socket 的缓冲区大小
+            accept_socket_ = ::accept4(server_socket_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (accept_socket_ != -1) {
+                break;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                acceptable_ = false;
+                while (!acceptable_) {
+                    if (!loop_->poll(-1)) {
+                        close();
+                        return false;
+                    }
+                }
+                continue;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            LOG(Log::ERR) << "Failed to accept: " << errno;
+            close();
+            return false;
+        }
+
+        setNoDelay(accept_socket_);
+        if (!loop_->add(accept_socket_, &accept_watcher_)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool SocketServerPosix::recv(std::string* buf) {
+        if (accept_socket_ == -1) {
+            LOG(Log::ERR) << "Invalid accept socket!";
+            return false;
+        }
+
+        char recv_buf[kRecvChunkSize];
+        for (;;) {
+            auto bytes_revd = ::recv(accept_socket_, recv_buf, kRecvChunkSize, 0);
+            if (bytes_revd > 0) {
+                buf->assign(recv_buf, bytes_revd);
+                return true;
+            }
+            if (bytes_revd == 0) {
+                LOG(Log::INFO) << "Connection closed";
+                return false;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                accept_watcher_.readable = false;
+                while (!accept_watcher_.readable) {
+                    if (!loop_->poll(-1)) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+            LOG(Log::ERR) << "Failed to recv: " << errno;
+            return false;
+        }
+    }
+
+    void SocketServerPosix::close() {
+        if (server_socket_ != -1) {
+            loop_->remove(server_socket_);
+            ::close(server_socket_);
+            server_socket_ = -1;
+        }
+        if (accept_socket_ != -1) {
+            loop_->remove(accept_socket_);
+            ::close(accept_socket_);
+            accept_socket_ = -1;
+        }
+    }
+
+    void SocketServerPosix::onEvents(uint32_t events) {
+        if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            acceptable_ = true;
+        }
+    }
+
+    void SocketServerPosix::AcceptWatcher::onEvents(uint32_t events) {
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            readable = true;
+        }
+    }
+
+
+    // 不需要初始化。写入已关闭的连接时使用 MSG_NOSIGNAL，不会产生 SIGPIPE
+    void initializeSocket() {}
+
+    void unInitializeSocket() {}
+
+    bool isSocketInitialized() {
+        return true;
+    }
+
+}
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SOCKET_POSIX_SOCKET_POSIX_H_
+#define AKASH_SOCKET_POSIX_SOCKET_POSIX_H_
+
+#include <sys/socket.h>
+
+#include "akash/socket/socket.h"
+#include "akash/socket/posix/epoll_loop.h"
+
+
+namespace akash {
+namespace posix {
+
+    // 非阻塞 socket，注册到当前线程的 EpollLoop 中。
+    // 接口的语义与 Windows 的实现相同：读写在 EAGAIN 时等待 epoll 通知后继续，
+    // 等待期间同一线程中其他连接的事件也会被记录下来。
+    // 必须在创建它的线程中使用和销毁。
+    class SocketClientPosix : public SocketClient, public EpollLoop::Watcher {
+    public:
+        SocketClientPosix();
+        ~SocketClientPosix();
+
+        bool connect(const std::string& ip, uint16_t port) override;
+        bool connectByHost(const std::string& host, uint16_t port) override;
+        bool send(const std::string& buf) override;
+        bool send(const SocketBuffer* bufs, size_t count) override;
+        bool recv(int length, std::string* buf) override;
+        bool recv(std::string* buf) override;
+        bool recv(uint8_t* buf, size_t length, size_t* received) override;
+
+        bool shutdown() override;
+        void close() override;
+
+        // EpollLoop::Watcher
+        void onEvents(uint32_t events) override;
+
+    private:
+        enum class WaitType {
+            SEND,
+            RECV,
+        };
+
+        bool connect(const sockaddr* addr, socklen_t addr_len);
+        bool wait(WaitType type);
+
+        int socket_;
+        EpollLoop* loop_;
+        // 边缘触发：只有在读写返回 EAGAIN 之后才清除
+        bool readable_ = false;
+        bool writable_ = false;
+    };
+
+    class SocketServerPosix : public SocketServer, public EpollLoop::Watcher {
+    public:
+        SocketServerPosix();
+        ~SocketServerPosix();
+
+        bool wait(const std::string& ip, uint16_t port) override;
+        bool recv(std::string* buf) override;
+
+        // EpollLoop::Watcher
+        void onEvents(uint32_t events) override;
+
+    private:
+        // 接受的连接使用另一个 Watcher
+        class AcceptWatcher : public EpollLoop::Watcher {
+        public:
+            void onEvents(uint32_t events) override;
+
+            bool readable = false;
+        };
+
+        // 关闭监听 socket 和接受的连接
+        void close();
+
+        int server_socket_;
+        int accept_socket_;
+        EpollLoop* loop_;
+        bool acceptable_ = false;
+        AcceptWatcher accept_watcher_;
+    };
+
+    void initializeSocket();
+    void unInitializeSocket();
+    bool isSocketInitialized();
+
+}
+}
+
+#endif  // AKASH_SOCKET_POSIX_SOCKET_POSIX_H_
@@ -0,0 +1,320 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/socket/posix/socket_uring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "akash/socket/posix/socket_utils.h"
+#include "utils/log.h"
+
+
+namespace {
+
+    // 与 UringEngine 一次请求的上限相同
+    const size_t kMaxBufs = 64;
+
+}
+
+namespace akash {
+namespace posix {
+
+    SocketClientUring::SocketClientUring()
+        : socket_(-1),
+          engine_(UringEngine::current()) {
+        std::memset(&addr_, 0, sizeof(addr_));
+    }
+
+    SocketClientUring::~SocketClientUring() {
+        close();
+    }
+
+    bool SocketClientUring::connect(const std::string& ip, uint16_t port) {
+        sockaddr_storage addr;
+        socklen_t addr_len;
+        if (!parseIpAddr(ip, port, &addr, &addr_len)) {
+            return false;
+        }
+        return connect(reinterpret_cast<sockaddr*>(&addr), addr_len);
+    }
+
+    bool SocketClientUring::connectByHost(const std::string& host, uint16_t port) {
+        return connectEachAddr(host, port, [this](const sockaddr* addr, socklen_t addr_len) {
+            if (connect(addr, addr_len)) {
+                return true;
+            }
+            close();
+            return false;
+        });
+    }
+
+    bool SocketClientUring::connect(const sockaddr* addr, socklen_t addr_len) {
+        if (!engine_->isValid()) {
+            LOG(Log::ERR) << "Invalid io_uring.";
+            return false;
+        }
+
+        if (socket_ != -1) {
+            LOG(Log::ERR) << "This client is already connected!";
+            return false;
+        }
+
+        // 请求由 io_uring 异步完成，socket 本身不需要非阻塞
+        socket_ = createTcpSocket(addr->sa_family, SOCK_CLOEXEC);
+        if (socket_ == -1) {
+            return false;
+        }
+
+        std::memcpy(&addr_, addr, std::min(size_t(addr_len), sizeof(addr_)));
+        if (!engine_->connect(socket_, reinterpret_cast<sockaddr*>(&addr_), addr_len, this)) {
+            LOG(Log::ERR) << "Failed to submit connect.";
+            close();
+            return false;
+        }
+
+        int result;
+        if (!wait(&result)) {
+            close();
+            return false;
+        }
+        if (result < 0) {
+            LOG(Log::ERR) << "Failed to connect: " << -result;
+            close();
+            return false;
+        }
+
+        recv_closed_ = false;
+        recv_error_ = 0;
+        if (!startRecv()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool SocketClientUring::send(const std::string& buf) {
+        SocketBuffer sb;
+        sb.data = reinterpret_cast<const uint8_t*>(buf.data());
+        sb.length = buf.length();
+        return send(&sb, 1);
+    }
+
+    bool SocketClientUring::send(const SocketBuffer* bufs, size_t count) {
+        if (socket_ == -1) {
+            LOG(Log::ERR) << "Invalid socket.";
+            return false;
+        }
+
+        // 每次最多提交 kMaxBufs 段，部分写入时从中断处继续
+        SocketBuffer segs[kMaxBufs];
+        size_t offset = 0;
+
+        while (count > 0) {
+            size_t n = std::min(count, kMaxBufs);
+            std::copy(bufs, bufs + n, segs);
+            segs[0].data += offset;
+            segs[0].length -= offset;
+
+            if (!engine_->send(socket_, segs, n, this)) {
+                LOG(Log::ERR) << "Failed to submit send.";
+                return false;
+            }
+
+            int result;
+            if (!wait(&result)) {
+                return false;
+            }
+            if (result == -EINTR || result == -EAGAIN) {
+                continue;
+            }
+            if (result < 0) {
+                LOG(Log::ERR) << "Failed to send: " << -result;
+                return false;
+            }
+
+            // 跳过已发送的部分
+            skipSentBuffers(&bufs, &count, &offset, size_t(result));
+        }
+        return true;
+    }
+
+    bool SocketClientUring::recv(int length, std::string* buf) {
+        return recvLength(this, length, buf);
+    }
+
+    bool SocketClientUring::recv(std::string* buf) {
+        return recvUntilClosed(this, buf);
+    }
+
+    bool SocketClientUring::recv(uint8_t* buf, size_t length, size_t* received) {
+        if (socket_ == -1) {
+            LOG(Log::ERR) << "Invalid socket.";
+            return false;
+        }
+
+        // 没有已收到的数据时才进入内核，一次可能收取多个缓冲区
+        while (chunks_.empty()) {
+            if (recv_closed_) {
+                LOG(Log::INFO) << "Connection closed";
+                *received = 0;
+                return true;
+            }
+            if (recv_error_ != 0) {
+                LOG(Log::ERR) << "Failed to recv: " << recv_error_;
+                return false;
+            }
+            // 多次接收可能被内核结束，重新开始
+            if (!recv_active_ && !startRecv()) {
+                return false;
+            }
+            // 缓冲区组可能被其他连接未读取的数据占满，这时不等待归还：
+            // 结束多次接收，直接接收到调用者的缓冲区，下次 recv 时再重新开始
+            if (engine_->isStarved(recv_op_)) {
+                engine_->cancel(recv_op_, this);
+                return recvDirect(buf, length, received);
+            }
+            if (!engine_->run(1)) {
+                return false;
+            }
+        }
+
+        // 从已收到的数据中复制，用完的缓冲区归还给内核
+        size_t total = 0;
+        while (total < length && !chunks_.empty()) {
+            auto& chunk = chunks_.front();
+            size_t n = std::min(length - total, chunk.length);
+            std::memcpy(buf + total, chunk.data, n);
+            chunk.data += n;
+            chunk.length -= n;
+            total += n;
+
+            if (chunk.length == 0) {
+                engine_->releaseRecvBuffer(chunk.buf_id);
+                chunks_.pop_front();
+            }
+        }
+
+        *received = total;
+        return true;
+    }
+
+    bool SocketClientUring::shutdown() {
+        if (socket_ != -1) {
+            if (::shutdown(socket_, SHUT_WR) == -1) {
+                LOG(Log::ERR) << "Failed to shutdown: " << errno;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SocketClientUring::close() {
+        if (socket_ == -1) {
+            return;
+        }
+
+        // 内核中的请求结束之前不能关闭 socket
+        if (recv_active_ && engine_->cancel(recv_op_, this)) {
+            while (recv_active_ && engine_->run(1)) {}
+        }
+        while (op_pending_ && engine_->run(1)) {}
+
+        for (const auto& chunk : chunks_) {
+            engine_->releaseRecvBuffer(chunk.buf_id);
+        }
+        chunks_.clear();
+
+        ::close(socket_);
+        socket_ = -1;
+    }
+
+    bool SocketClientUring::onRecv(int result, const uint8_t* data, uint16_t buf_id, bool more) {
+        if (!more) {
+            recv_active_ = false;
+        }
+
+        if (result > 0) {
+            // 读取完后再归还
+            Chunk chunk;
+            chunk.buf_id = buf_id;
+            chunk.data = data;
+            chunk.length = size_t(result);
+            chunks_.push_back(chunk);
+            return false;
+        }
+
+        if (result == 0) {
+            recv_closed_ = true;
+        } else if (result != -ECANCELED) {
+            recv_error_ = -result;
+        }
+        return true;
+    }
+
+    void SocketClientUring::onComplete(UringEngine::OpType type, int result) {
+        // 取消请求的结果通过 onRecv 得知
+        if (type == UringEngine::OpType::Cancel) {
+            return;
+        }
+        op_pending_ = false;
+        op_result_ = result;
+    }
+
+    bool SocketClientUring::startRecv() {
+        if (!engine_->recvMultishot(socket_, this, &recv_op_)) {
+            LOG(Log::ERR) << "Failed to submit recv.";
+            return false;
+        }
+        recv_active_ = true;
+        return true;
+    }
+
+    bool SocketClientUring::recvDirect(uint8_t* buf, size_t length, size_t* received) {
+        for (;;) {
+            if (!engine_->recv(socket_, buf, length, this)) {
+                LOG(Log::ERR) << "Failed to submit recv.";
+                return false;
+            }
+
+            int result;
+            if (!wait(&result)) {
+                return false;
+            }
+            if (result == -EINTR || result == -EAGAIN) {
+                continue;
+            }
+            if (result < 0) {
+                recv_error_ = -result;
+                LOG(Log::ERR) << "Failed to recv: " << recv_error_;
+                return false;
+            }
+            if (result == 0) {
+                recv_closed_ = true;
+                LOG(Log::INFO) << "Connection closed";
+            }
+
+            *received = size_t(result);
+            return true;
+        }
+    }
+
+    bool SocketClientUring::wait(int* result) {
+        op_pending_ = true;
+        while (op_pending_) {
+            if (!engine_->run(1)) {
+                return false;
+            }
+        }
+        *result = op_result_;
+        return true;
+    }
+
+}
+}
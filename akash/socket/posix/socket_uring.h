@@ -0,0 +1,79 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SOCKET_POSIX_SOCKET_URING_H_
+#define AKASH_SOCKET_POSIX_SOCKET_URING_H_
+
+#include <deque>
+
+#include <sys/socket.h>
+
+#include "akash/socket/socket.h"
+#include "akash/socket/posix/uring_engine.h"
+
+
+namespace akash {
+namespace posix {
+
+    // 基于当前线程 UringEngine 的 SocketClient。
+    // 连接后一直保持一个多次接收请求，内核收到的数据直接进入缓冲区组，
+    // recv 只在没有已收到的数据时才进入内核，因此 TLS 记录层连续读取多条记录时不需要每条一次系统调用。
+    // 缓冲区组由同一线程的所有连接共享，被占满时退回到直接接收到调用者缓冲区的单次接收。
+    // 等待期间同一线程中其他连接的完成事件也会被分发。
+    // 必须在创建它的线程中使用和销毁。
+    class SocketClientUring : public SocketClient, public UringEngine::Handler {
+    public:
+        SocketClientUring();
+        ~SocketClientUring();
+
+        bool connect(const std::string& ip, uint16_t port) override;
+        bool connectByHost(const std::string& host, uint16_t port) override;
+        bool send(const std::string& buf) override;
+        bool send(const SocketBuffer* bufs, size_t count) override;
+        bool recv(int length, std::string* buf) override;
+        bool recv(std::string* buf) override;
+        bool recv(uint8_t* buf, size_t length, size_t* received) override;
+
+        bool shutdown() override;
+        void close() override;
+
+        // UringEngine::Handler
+        bool onRecv(int result, const uint8_t* data, uint16_t buf_id, bool more) override;
+        void onComplete(UringEngine::OpType type, int result) override;
+
+    private:
+        // 已收到但还未读取的数据，位于缓冲区组中
+        struct Chunk {
+            uint16_t buf_id;
+            const uint8_t* data;
+            size_t length;
+        };
+
+        bool connect(const sockaddr* addr, socklen_t addr_len);
+        bool startRecv();
+        // 多次接收因缓冲区耗尽而暂停时，用单次接收直接读取到 buf
+        bool recvDirect(uint8_t* buf, size_t length, size_t* received);
+        bool wait(int* result);
+
+        int socket_;
+        UringEngine* engine_;
+        // 连接完成之前必须保持有效
+        sockaddr_storage addr_;
+
+        uint64_t recv_op_ = 0;
+        bool recv_active_ = false;
+        bool recv_closed_ = false;
+        int recv_error_ = 0;
+        std::deque<Chunk> chunks_;
+
+        bool op_pending_ = false;
+        int op_result_ = 0;
+    };
+
+}
+}
+
+#endif  // AKASH_SOCKET_POSIX_SOCKET_URING_H_
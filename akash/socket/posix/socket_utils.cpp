@@ -0,0 +1,138 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/socket/posix/socket_utils.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "utils/log.h"
+
+
+namespace akash {
+namespace posix {
+
+    void setNoDelay(int fd) {
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+
+    int createTcpSocket(int family, int flags) {
+        int fd = ::socket(family, SOCK_STREAM | flags, IPPROTO_TCP);
+        if (fd == -1) {
+            LOG(Log::ERR) << "Failed to create socket: " << errno;
+            return -1;
+        }
+
+        int size = kSocketBufferSize;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setNoDelay(fd);
+        return fd;
+    }
+
+    bool parseIpAddr(
+        const std::string& ip, uint16_t port, sockaddr_storage* addr, socklen_t* addr_len)
+    {
+        std::memset(addr, 0, sizeof(sockaddr_storage));
+
+        auto addr4 = reinterpret_cast<sockaddr_in*>(addr);
+        auto addr6 = reinterpret_cast<sockaddr_in6*>(addr);
+        if (::inet_pton(AF_INET, ip.c_str(), &addr4->sin_addr) == 1) {
+            addr4->sin_family = AF_INET;
+            addr4->sin_port = htons(port);
+            *addr_len = sizeof(sockaddr_in);
+        } else if (::inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr) == 1) {
+            addr6->sin6_family = AF_INET6;
+            addr6->sin6_port = htons(port);
+            *addr_len = sizeof(sockaddr_in6);
+        } else {
+            LOG(Log::ERR) << "Failed to convert ip addr: " << ip;
+            return false;
+        }
+        return true;
+    }
+
+    addrinfo* resolveHost(const std::string& host, uint16_t port) {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        addrinfo* addr_ret = nullptr;
+        auto result = ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addr_ret);
+        if (result != 0) {
+            LOG(Log::ERR) << "Failed to get addr info: " << result;
+            return nullptr;
+        }
+        if (!addr_ret) {
+            LOG(Log::ERR) << "No addr info";
+            return nullptr;
+        }
+        return addr_ret;
+    }
+
+    void skipSentBuffers(const SocketBuffer** bufs, size_t* count, size_t* offset, size_t sent) {
+        sent += *offset;
+        while (*count > 0 && sent >= (*bufs)->length) {
+            sent -= (*bufs)->length;
+            ++*bufs;
+            --*count;
+        }
+        *offset = sent;
+    }
+
+    bool recvLength(SocketClient* client, int length, std::string* buf) {
+        if (length <= 0) {
+            return true;
+        }
+
+        std::string response(length, 0);
+        size_t total = 0;
+        while (total < size_t(length)) {
+            size_t received;
+            if (!client->recv(reinterpret_cast<uint8_t*>(&response[total]), length - total, &received)) {
+                return false;
+            }
+            if (received == 0) {
+                break;
+            }
+            total += received;
+        }
+
+        response.resize(total);
+        *buf = std::move(response);
+        return true;
+    }
+
+    bool recvUntilClosed(SocketClient* client, std::string* buf) {
+        std::string response;
+        size_t total = 0;
+        for (;;) {
+            response.resize(total + kRecvChunkSize);
+
+            size_t received;
+            if (!client->recv(reinterpret_cast<uint8_t*>(&response[total]), kRecvChunkSize, &received)) {
+                return false;
+            }
+            if (received == 0) {
+                break;
+            }
+            total += received;
+        }
+
+        response.resize(total);
+        *buf = std::move(response);
+        return true;
+    }
+
+}
+}
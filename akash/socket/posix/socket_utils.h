@@ -0,0 +1,74 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SOCKET_POSIX_SOCKET_UTILS_H_
+#define AKASH_SOCKET_POSIX_SOCKET_UTILS_H_
+
+#include <string>
+
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include "akash/socket/socket.h"
+
+
+namespace akash {
+namespace posix {
+
+    // SocketClientPosix 和 SocketClientUring 共用的部分
+
+    // 内核会将设置的值加倍，上限为 net.core.rmem_max / wmem_max。
+    // 必须在 connect/listen 之前设置，才能协商足够大的窗口缩放因子。
+    const int kSocketBufferSize = 1024 * 1024;
+
+    // 每次 recv 至少读取的长度
+    const size_t kRecvChunkSize = 64 * 1024;
+
+    // 记录层已经将一个 flight 合并为一次写入，不需要 Nagle 算法
+    void setNoDelay(int fd);
+
+    // 创建 TCP socket，设置收发缓冲区大小和 TCP_NODELAY。
+    // flags 为额外的 SOCK_* 标志。失败时返回 -1。
+    int createTcpSocket(int family, int flags);
+
+    // 将 IPv4 或 IPv6 地址字符串和端口转换为 sockaddr
+    bool parseIpAddr(
+        const std::string& ip, uint16_t port, sockaddr_storage* addr, socklen_t* addr_len);
+
+    // 解析 host，返回的链表需要用 freeaddrinfo 释放。失败时返回 nullptr。
+    addrinfo* resolveHost(const std::string& host, uint16_t port);
+
+    // 解析 host 并依次用 connect(const sockaddr*, socklen_t) 尝试每个地址，直到成功为止
+    template <typename Fn>
+    bool connectEachAddr(const std::string& host, uint16_t port, Fn&& connect) {
+        auto addr_ret = resolveHost(host, port);
+        if (!addr_ret) {
+            return false;
+        }
+
+        bool connected = false;
+        for (auto ai = addr_ret; ai && !connected; ai = ai->ai_next) {
+            connected = connect(ai->ai_addr, socklen_t(ai->ai_addrlen));
+        }
+        ::freeaddrinfo(addr_ret);
+
+        return connected;
+    }
+
+    // 发送了 sent 字节后，跳过 bufs 中已发送完的段。
+    // offset 为第一段中已发送的字节数，调用前后都有效。
+    void skipSentBuffers(const SocketBuffer** bufs, size_t* count, size_t* offset, size_t sent);
+
+    // 通过 client->recv(uint8_t*, ...) 接收 length 字节，连接提前关闭时只返回已收到的部分
+    bool recvLength(SocketClient* client, int length, std::string* buf);
+
+    // 通过 client->recv(uint8_t*, ...) 接收数据，直到连接关闭
+    bool recvUntilClosed(SocketClient* client, std::string* buf);
+
+}
+}
+
+#endif  // AKASH_SOCKET_POSIX_SOCKET_UTILS_H_
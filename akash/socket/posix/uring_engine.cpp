@@ -0,0 +1,614 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/socket/posix/uring_engine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "utils/log.h"
+
+
+namespace {
+
+    int sysSetup(unsigned entries, io_uring_params* p) {
+        return int(::syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    int sysEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return int(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int sysRegister(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+        return int(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    // 与内核共享的队列指针
+    unsigned loadAcquire(const unsigned* p) {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    void storeRelease(unsigned* p, unsigned v) {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+
+    void storeRelease(uint16_t* p, uint16_t v) {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+
+}
+
+namespace akash {
+namespace posix {
+
+    // static
+    UringEngine* UringEngine::current() {
+        thread_local UringEngine engine;
+        thread_local bool initialized = false;
+        if (!initialized) {
+            // 64 个 32KB 的接收缓冲区，每个都能容纳一条最长的 TLS 记录
+            engine.init(256, 64, 32 * 1024, 16, 64 * 1024);
+            initialized = true;
+        }
+        return &engine;
+    }
+
+    UringEngine::UringEngine() {}
+
+    UringEngine::~UringEngine() {
+        destroy();
+    }
+
+    bool UringEngine::init(
+        unsigned entries,
+        unsigned recv_buf_count, size_t recv_buf_size,
+        unsigned send_buf_count, size_t send_buf_size)
+    {
+        if (isValid()) {
+            return false;
+        }
+        if (recv_buf_count == 0 || recv_buf_count > 32768 ||
+            (recv_buf_count & (recv_buf_count - 1)) != 0 ||
+            recv_buf_size == 0 || recv_buf_size > UINT32_MAX)
+        {
+            return false;
+        }
+
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CLAMP;
+        // 完成队列需要容纳多次接收产生的事件
+        params.flags |= IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+
+        ring_fd_ = sysSetup(entries, &params);
+        if (ring_fd_ < 0) {
+            LOG(Log::ERR) << "Failed to setup io_uring: " << errno;
+            ring_fd_ = -1;
+            return false;
+        }
+        if (!(params.features & IORING_FEAT_NODROP)) {
+            LOG(Log::ERR) << "io_uring is too old";
+            destroy();
+            return false;
+        }
+
+        // 提交队列与完成队列
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+
+        sq_ptr_ = ::mmap(
+            nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == MAP_FAILED) {
+            sq_ptr_ = nullptr;
+            destroy();
+            return false;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cq_ptr_ = sq_ptr_;
+        } else {
+            cq_ptr_ = ::mmap(
+                nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring_fd_, IORING_OFF_CQ_RING);
+            if (cq_ptr_ == MAP_FAILED) {
+                cq_ptr_ = nullptr;
+                destroy();
+                return false;
+            }
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(
+            nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            destroy();
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto sq = static_cast<uint8_t*>(sq_ptr_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_local_tail_ = *sq_tail_;
+        sq_pending_ = 0;
+
+        auto cq = static_cast<uint8_t*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // 接收缓冲区组，环需要按页对齐
+        buf_ring_size_ = recv_buf_count * sizeof(io_uring_buf);
+        void* ring = ::mmap(
+            nullptr, buf_ring_size_, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED) {
+            destroy();
+            return false;
+        }
+        buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+        buf_ring_->tail = 0;
+
+        io_uring_buf_reg reg;
+        std::memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+        reg.ring_entries = recv_buf_count;
+        reg.bgid = kBufGroup;
+        if (sysRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            LOG(Log::ERR) << "Failed to register buffer ring: " << errno;
+            ::munmap(buf_ring_, buf_ring_size_);
+            buf_ring_ = nullptr;
+            destroy();
+            return false;
+        }
+
+        recv_buf_count_ = recv_buf_count;
+        recv_buf_size_ = recv_buf_size;
+        recv_bufs_.reset(new uint8_t[recv_buf_count * recv_buf_size]);
+        for (unsigned i = 0; i < recv_buf_count; ++i) {
+            provideRecvBuffer(uint16_t(i));
+        }
+
+        // 注册发送缓冲区
+        if (send_buf_count > 0) {
+            send_bufs_.reset(new uint8_t[send_buf_count * send_buf_size]);
+            send_buf_used_.reset(new bool[send_buf_count]());
+
+            std::unique_ptr<iovec[]> iovs(new iovec[send_buf_count]);
+            for (unsigned i = 0; i < send_buf_count; ++i) {
+                iovs[i].iov_base = send_bufs_.get() + i * send_buf_size;
+                iovs[i].iov_len = send_buf_size;
+            }
+            if (sysRegister(ring_fd_, IORING_REGISTER_BUFFERS, iovs.get(), send_buf_count) < 0) {
+                LOG(Log::ERR) << "Failed to register buffers: " << errno;
+                destroy();
+                return false;
+            }
+            send_buf_count_ = send_buf_count;
+            send_buf_size_ = send_buf_size;
+        }
+
+        // 每个提交队列项最多对应一个进行中的请求
+        op_count_ = params.sq_entries + params.cq_entries;
+        ops_.reset(new Op[op_count_]);
+        free_ops_ = nullptr;
+        for (unsigned i = op_count_; i-- > 0;) {
+            ops_[i].generation = 0;
+            ops_[i].in_use = false;
+            ops_[i].next_free = free_ops_;
+            free_ops_ = &ops_[i];
+        }
+
+        return true;
+    }
+
+    void UringEngine::destroy() {
+        if (ring_fd_ != -1) {
+            // 关闭 fd 时内核取消所有进行中的请求并注销缓冲区
+            ::close(ring_fd_);
+            ring_fd_ = -1;
+        }
+        if (buf_ring_) {
+            ::munmap(buf_ring_, buf_ring_size_);
+            buf_ring_ = nullptr;
+        }
+        if (sqes_) {
+            ::munmap(sqes_, sqes_size_);
+            sqes_ = nullptr;
+        }
+        if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+            ::munmap(cq_ptr_, cq_size_);
+        }
+        cq_ptr_ = nullptr;
+        if (sq_ptr_) {
+            ::munmap(sq_ptr_, sq_size_);
+            sq_ptr_ = nullptr;
+        }
+
+        recv_bufs_.reset();
+        send_bufs_.reset();
+        send_buf_used_.reset();
+        ops_.reset();
+        free_ops_ = nullptr;
+        recv_buf_count_ = send_buf_count_ = 0;
+        op_count_ = starved_count_ = 0;
+    }
+
+    bool UringEngine::isValid() const {
+        return ring_fd_ != -1;
+    }
+
+    bool UringEngine::connect(
+        int fd, const sockaddr* addr, socklen_t addr_len, Handler* handler)
+    {
+        auto op = allocOp(OpType::Connect, fd, handler);
+        if (!op) {
+            return false;
+        }
+        auto sqe = getSqe();
+        if (!sqe) {
+            freeOp(op);
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_CONNECT;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(addr);
+        sqe->off = addr_len;
+        sqe->user_data = getUserData(op);
+        return true;
+    }
+
+    bool UringEngine::recvMultishot(int fd, Handler* handler, uint64_t* op_id) {
+        auto op = allocOp(OpType::Recv, fd, handler);
+        if (!op) {
+            return false;
+        }
+        if (!submitRecv(op)) {
+            freeOp(op);
+            return false;
+        }
+        *op_id = getUserData(op);
+        return true;
+    }
+
+    bool UringEngine::recv(int fd, uint8_t* buf, size_t length, Handler* handler) {
+        auto op = allocOp(OpType::RecvSingle, fd, handler);
+        if (!op) {
+            return false;
+        }
+        auto sqe = getSqe();
+        if (!sqe) {
+            freeOp(op);
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buf);
+        sqe->len = unsigned(std::min(length, size_t(UINT32_MAX)));
+        sqe->user_data = getUserData(op);
+        return true;
+    }
+
+    bool UringEngine::isStarved(uint64_t op_id) const {
+        auto op = findOp(op_id);
+        return op && op->type == OpType::Recv && op->starved;
+    }
+
+    bool UringEngine::send(int fd, const SocketBuffer* bufs, size_t count, Handler* handler) {
+        if (count == 0 || count > kMaxIov) {
+            return false;
+        }
+
+        auto op = allocOp(OpType::Send, fd, handler);
+        if (!op) {
+            return false;
+        }
+        auto sqe = getSqe();
+        if (!sqe) {
+            freeOp(op);
+            return false;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            op->iov[i].iov_base = const_cast<uint8_t*>(bufs[i].data);
+            op->iov[i].iov_len = bufs[i].length;
+        }
+        std::memset(&op->msg, 0, sizeof(op->msg));
+        op->msg.msg_iov = op->iov;
+        op->msg.msg_iovlen = count;
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&op->msg);
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = getUserData(op);
+        return true;
+    }
+
+    int UringEngine::acquireSendBuffer(uint8_t** buf, size_t* capacity) {
+        for (unsigned i = 0; i < send_buf_count_; ++i) {
+            if (!send_buf_used_[i]) {
+                send_buf_used_[i] = true;
+                *buf = send_bufs_.get() + i * send_buf_size_;
+                *capacity = send_buf_size_;
+                return int(i);
+            }
+        }
+        return -1;
+    }
+
+    bool UringEngine::sendFixed(int fd, int buf_index, size_t length, Handler* handler) {
+        if (buf_index < 0 || unsigned(buf_index) >= send_buf_count_ ||
+            !send_buf_used_[buf_index] || length > send_buf_size_)
+        {
+            return false;
+        }
+
+        auto op = allocOp(OpType::SendFixed, fd, handler);
+        if (!op) {
+            return false;
+        }
+        auto sqe = getSqe();
+        if (!sqe) {
+            freeOp(op);
+            return false;
+        }
+        op->buf_index = buf_index;
+
+        // 对 socket 的 WRITE_FIXED 等同于 send，使用注册的缓冲区
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(send_bufs_.get() + buf_index * send_buf_size_);
+        sqe->len = unsigned(length);
+        sqe->off = uint64_t(-1);
+        sqe->buf_index = uint16_t(buf_index);
+        sqe->user_data = getUserData(op);
+        return true;
+    }
+
+    bool UringEngine::cancel(uint64_t op_id, Handler* handler) {
+        auto target = findOp(op_id);
+        if (!target || target->type != OpType::Recv) {
+            return false;
+        }
+
+        // 暂停中的请求不在内核中，直接结束
+        if (target->starved) {
+            target->starved = false;
+            --starved_count_;
+            auto h = target->handler;
+            freeOp(target);
+            h->onRecv(-ECANCELED, nullptr, 0, false);
+            return true;
+        }
+
+        auto op = allocOp(OpType::Cancel, -1, handler);
+        if (!op) {
+            return false;
+        }
+        auto sqe = getSqe();
+        if (!sqe) {
+            freeOp(op);
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = op_id;
+        sqe->user_data = getUserData(op);
+        return true;
+    }
+
+    void UringEngine::releaseRecvBuffer(uint16_t buf_id) {
+        provideRecvBuffer(buf_id);
+
+        // 恢复因缓冲区耗尽而暂停的接收
+        if (starved_count_ > 0) {
+            for (unsigned i = 0; i < op_count_ && starved_count_ > 0; ++i) {
+                auto op = &ops_[i];
+                if (op->in_use && op->starved) {
+                    if (!submitRecv(op)) {
+                        break;
+                    }
+                    op->starved = false;
+                    --starved_count_;
+                }
+            }
+        }
+    }
+
+    bool UringEngine::run(unsigned wait_nr) {
+        if (!isValid()) {
+            return false;
+        }
+
+        for (;;) {
+            unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+            if (sq_pending_ > 0 || wait_nr > 0) {
+                int ret = sysEnter(ring_fd_, sq_pending_, wait_nr, flags);
+                if (ret < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    // 完成队列已满，先处理完成事件
+                    if (errno != EBUSY && errno != EAGAIN) {
+                        LOG(Log::ERR) << "Failed to enter io_uring: " << errno;
+                        return false;
+                    }
+                } else {
+                    sq_pending_ -= std::min(unsigned(ret), sq_pending_);
+                }
+            }
+            break;
+        }
+
+        unsigned head = *cq_head_;
+        unsigned tail = loadAcquire(cq_tail_);
+        while (head != tail) {
+            // 回调中可能提交新的请求，这里只读取已有的事件
+            io_uring_cqe cqe = cqes_[head & cq_mask_];
+            ++head;
+            storeRelease(cq_head_, head);
+            handleCqe(&cqe);
+            if (head == tail) {
+                tail = loadAcquire(cq_tail_);
+            }
+        }
+        return true;
+    }
+
+    io_uring_sqe* UringEngine::getSqe() {
+        unsigned head = loadAcquire(sq_head_);
+        if (sq_local_tail_ - head > sq_mask_) {
+            // 提交队列已满，先提交
+            int ret = sysEnter(ring_fd_, sq_pending_, 0, 0);
+            if (ret < 0) {
+                return nullptr;
+            }
+            sq_pending_ -= std::min(unsigned(ret), sq_pending_);
+            head = loadAcquire(sq_head_);
+            if (sq_local_tail_ - head > sq_mask_) {
+                return nullptr;
+            }
+        }
+
+        unsigned index = sq_local_tail_ & sq_mask_;
+        auto sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        ++sq_local_tail_;
+        ++sq_pending_;
+        // sqe 在返回之后才填写，但下次 io_uring_enter 之前内核不会读取
+        storeRelease(sq_tail_, sq_local_tail_);
+        return sqe;
+    }
+
+    UringEngine::Op* UringEngine::allocOp(OpType type, int fd, Handler* handler) {
+        if (!free_ops_) {
+            return nullptr;
+        }
+        auto op = free_ops_;
+        free_ops_ = op->next_free;
+
+        op->type = type;
+        op->handler = handler;
+        op->fd = fd;
+        op->buf_index = -1;
+        ++op->generation;
+        op->in_use = true;
+        op->starved = false;
+        op->next_free = nullptr;
+        return op;
+    }
+
+    void UringEngine::freeOp(Op* op) {
+        op->in_use = false;
+        op->handler = nullptr;
+        op->next_free = free_ops_;
+        free_ops_ = op;
+    }
+
+    uint64_t UringEngine::getUserData(const Op* op) const {
+        auto index = uint64_t(op - ops_.get());
+        return (uint64_t(op->generation) << 32) | index;
+    }
+
+    UringEngine::Op* UringEngine::findOp(uint64_t user_data) const {
+        auto index = uint32_t(user_data);
+        if (index >= op_count_) {
+            return nullptr;
+        }
+        auto op = &ops_[index];
+        if (!op->in_use || op->generation != uint32_t(user_data >> 32)) {
+            return nullptr;
+        }
+        return op;
+    }
+
+    bool UringEngine::submitRecv(Op* op) {
+        auto sqe = getSqe();
+        if (!sqe) {
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = op->fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufGroup;
+        sqe->user_data = getUserData(op);
+        return true;
+    }
+
+    void UringEngine::provideRecvBuffer(uint16_t buf_id) {
+        // 在 C++ 中 io_uring_buf_ring::bufs 前的空结构体占一个字节，偏移与内核不一致，
+        // 因此直接把环当作 io_uring_buf 数组
+        uint16_t tail = buf_ring_->tail;
+        auto buf = reinterpret_cast<io_uring_buf*>(buf_ring_) + (tail & (recv_buf_count_ - 1));
+        buf->addr = reinterpret_cast<uint64_t>(recv_bufs_.get() + buf_id * recv_buf_size_);
+        buf->len = uint32_t(recv_buf_size_);
+        buf->bid = buf_id;
+        storeRelease(&buf_ring_->tail, uint16_t(tail + 1));
+    }
+
+    void UringEngine::handleCqe(const io_uring_cqe* cqe) {
+        auto op = findOp(cqe->user_data);
+        if (!op) {
+            return;
+        }
+        auto handler = op->handler;
+
+        if (op->type != OpType::Recv) {
+            auto type = op->type;
+            if (type == OpType::SendFixed) {
+                send_buf_used_[op->buf_index] = false;
+            }
+            freeOp(op);
+            handler->onComplete(type, cqe->res);
+            return;
+        }
+
+        bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+        if (cqe->res == -ENOBUFS && !more) {
+            // 缓冲区耗尽，等待归还后重新开始
+            op->starved = true;
+            ++starved_count_;
+            return;
+        }
+        if (!more) {
+            freeOp(op);
+        }
+
+        if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+            auto buf_id = uint16_t(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            auto data = recv_bufs_.get() + buf_id * recv_buf_size_;
+            if (handler->onRecv(cqe->res, data, buf_id, more)) {
+                releaseRecvBuffer(buf_id);
+            }
+        } else {
+            handler->onRecv(cqe->res, nullptr, 0, more);
+        }
+    }
+
+}
+}
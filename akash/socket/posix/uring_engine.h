@@ -0,0 +1,202 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_SOCKET_POSIX_URING_ENGINE_H_
+#define AKASH_SOCKET_POSIX_URING_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "akash/socket/socket.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+
+namespace akash {
+namespace posix {
+
+    // 基于 io_uring 的异步 socket 引擎，每个线程一个。
+    // 请求先写入提交队列，run 时用一次 io_uring_enter 提交所有连接的请求并收取完成事件，
+    // 再通过 Handler 回调通知。
+    // 接收使用多次接收 (multishot recv)：一次请求持续接收，数据写入事先提供给内核的缓冲区组；
+    // 发送可以使用注册的固定缓冲区，内核不必每次映射用户内存。
+    // 直接使用系统调用，不依赖 liburing。需要 Linux 6.0 或更高版本。
+    class UringEngine {
+    public:
+        enum class OpType {
+            Connect,
+            Recv,
+            RecvSingle,
+            Send,
+            SendFixed,
+            Cancel,
+        };
+
+        class Handler {
+        public:
+            virtual ~Handler() = default;
+
+            /**
+             * 多次接收的结果。
+             * result > 0 时 data 为收到的数据，长度为 result，位于编号为 buf_id 的缓冲区中；
+             * result 为 0 表示连接已关闭；小于 0 时为 -errno。
+             * more 为 false 表示这次接收请求已经结束。
+             * 返回 true 时缓冲区立即归还给内核，否则处理完后调用 releaseRecvBuffer 归还。
+             */
+            virtual bool onRecv(int result, const uint8_t* data, uint16_t buf_id, bool more) = 0;
+
+            // 其他请求完成。result 为请求的结果，小于 0 时为 -errno
+            virtual void onComplete(OpType type, int result) = 0;
+        };
+
+        // 当前线程的实例，第一次调用时以默认参数初始化
+        static UringEngine* current();
+
+        UringEngine();
+        ~UringEngine();
+
+        /**
+         * entries 为提交队列的长度。
+         * 接收缓冲区组有 recv_buf_count 个 (2 的幂) 长度为 recv_buf_size 的缓冲区；
+         * 注册 send_buf_count 个长度为 send_buf_size 的发送缓冲区。
+         */
+        bool init(
+            unsigned entries,
+            unsigned recv_buf_count, size_t recv_buf_size,
+            unsigned send_buf_count, size_t send_buf_size);
+        void destroy();
+        bool isValid() const;
+
+        /**
+         * 连接。addr 在完成之前必须保持有效。
+         */
+        bool connect(int fd, const sockaddr* addr, socklen_t addr_len, Handler* handler);
+
+        /**
+         * 开始多次接收。成功时 *op 为该请求的标识，用于 cancel。
+         * 缓冲区耗尽时请求会暂停，有缓冲区归还后自动恢复。
+         */
+        bool recvMultishot(int fd, Handler* handler, uint64_t* op);
+
+        /**
+         * 单次接收，数据直接写入 buf，不使用缓冲区组。buf 在完成之前必须保持有效。
+         * 结果为收到的字节数，0 表示连接已关闭。
+         */
+        bool recv(int fd, uint8_t* buf, size_t length, Handler* handler);
+
+        // recvMultishot 开始的请求是否因缓冲区耗尽而暂停
+        bool isStarved(uint64_t op) const;
+
+        /**
+         * 发送 count 段数据，数据在完成之前必须保持有效。
+         * 可能只发送一部分，结果为发送的字节数。
+         */
+        bool send(int fd, const SocketBuffer* bufs, size_t count, Handler* handler);
+
+        /**
+         * 取得一个空闲的注册发送缓冲区，没有空闲的缓冲区时返回 -1。
+         * 写入数据后调用 sendFixed，完成后缓冲区自动释放。
+         */
+        int acquireSendBuffer(uint8_t** buf, size_t* capacity);
+        bool sendFixed(int fd, int buf_index, size_t length, Handler* handler);
+
+        /**
+         * 取消 recvMultishot 开始的请求。请求结束时 onRecv 的 more 为 false。
+         * 请求因缓冲区耗尽而暂停时立即结束，在返回之前回调。
+         */
+        bool cancel(uint64_t op, Handler* handler);
+        void releaseRecvBuffer(uint16_t buf_id);
+
+        /**
+         * 用一次系统调用提交所有排队的请求，并等待至少 wait_nr 个完成事件，
+         * 然后分发所有已完成的事件。
+         */
+        bool run(unsigned wait_nr);
+
+    private:
+        static const size_t kMaxIov = 64;
+        static const uint16_t kBufGroup = 0;
+
+        struct Op {
+            OpType type;
+            Handler* handler;
+            int fd;
+            int buf_index;
+            // 每次分配时递增，与序号一起组成 user_data
+            uint32_t generation;
+            bool in_use;
+            // 接收缓冲区耗尽，等待有缓冲区归还
+            bool starved;
+            msghdr msg;
+            iovec iov[kMaxIov];
+            Op* next_free;
+        };
+
+        UringEngine(const UringEngine&) = delete;
+        UringEngine& operator=(const UringEngine&) = delete;
+
+        io_uring_sqe* getSqe();
+        Op* allocOp(OpType type, int fd, Handler* handler);
+        void freeOp(Op* op);
+        // user_data 的高 32 位为 generation，低 32 位为 Op 的序号。
+        // Op 被释放并重新分配之后，旧请求迟到的完成事件和取消不会作用到新请求上
+        uint64_t getUserData(const Op* op) const;
+        Op* findOp(uint64_t user_data) const;
+        bool submitRecv(Op* op);
+        void provideRecvBuffer(uint16_t buf_id);
+        void handleCqe(const io_uring_cqe* cqe);
+
+        int ring_fd_ = -1;
+
+        // 提交队列
+        void* sq_ptr_ = nullptr;
+        size_t sq_size_ = 0;
+        unsigned* sq_head_ = nullptr;
+        unsigned* sq_tail_ = nullptr;
+        unsigned sq_mask_ = 0;
+        unsigned* sq_array_ = nullptr;
+        io_uring_sqe* sqes_ = nullptr;
+        size_t sqes_size_ = 0;
+        unsigned sq_local_tail_ = 0;
+        unsigned sq_pending_ = 0;
+
+        // 完成队列
+        void* cq_ptr_ = nullptr;
+        size_t cq_size_ = 0;
+        unsigned* cq_head_ = nullptr;
+        unsigned* cq_tail_ = nullptr;
+        unsigned cq_mask_ = 0;
+        io_uring_cqe* cqes_ = nullptr;
+
+        // 提供给内核的接收缓冲区组
+        io_uring_buf_ring* buf_ring_ = nullptr;
+        size_t buf_ring_size_ = 0;
+        unsigned recv_buf_count_ = 0;
+        size_t recv_buf_size_ = 0;
+        std::unique_ptr<uint8_t[]> recv_bufs_;
+        unsigned starved_count_ = 0;
+
+        // 注册的发送缓冲区
+        unsigned send_buf_count_ = 0;
+        size_t send_buf_size_ = 0;
+        std::unique_ptr<uint8_t[]> send_bufs_;
+        std::unique_ptr<bool[]> send_buf_used_;
+
+        std::unique_ptr<Op[]> ops_;
+        unsigned op_count_ = 0;
+        Op* free_ops_ = nullptr;
+    };
+
+}
+}
+
+#endif  // AKASH_SOCKET_POSIX_URING_ENGINE_H_
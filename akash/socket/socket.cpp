@@ -6,34 +6,52 @@
 
 #include "akash/socket/socket.h"
 
+#ifdef _WIN32
 #include "akash/socket/win/socket_win.h"
+#else
+#include "akash/socket/posix/socket_posix.h"
+#endif
 
 
 namespace akash {
 
+#ifdef _WIN32
+    namespace platform = win;
+#else
+    namespace platform = posix;
+#endif
+
     SocketClient* SocketClient::create() {
         if (!isSocketInitialized()) {
             initializeSocket();
         }
+#ifdef _WIN32
         return new win::SocketClientWin();
+#else
+        return new posix::SocketClientPosix();
+#endif
     }
 
     SocketServer* SocketServer::create() {
         if (!isSocketInitialized()) {
             initializeSocket();
         }
+#ifdef _WIN32
         return new win::SocketServerWin();
+#else
+        return new posix::SocketServerPosix();
+#endif
     }
 
     void initializeSocket() {
-        win::initializeSocket();
+        platform::initializeSocket();
     }
 
     void unInitializeSocket() {
-        win::unInitializeSocket();
+        platform::unInitializeSocket();
     }
 
     bool isSocketInitialized() {
-        return win::isSocketInitialized();
+        return platform::isSocketInitialized();
     }
 }
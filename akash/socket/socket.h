@@ -7,11 +7,19 @@
 #ifndef AKASH_SOCKET_SOCKET_H_
 #define AKASH_SOCKET_SOCKET_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 
 namespace akash {
 
+    // 用于分散/聚集 I/O 的一段数据
+    struct SocketBuffer {
+        const uint8_t* data;
+        size_t length;
+    };
+
     class SocketClient {
     public:
         static SocketClient* create();
@@ -21,8 +29,13 @@ namespace akash {
         virtual bool connect(const std::string& ip, uint16_t port) = 0;
         virtual bool connectByHost(const std::string& host, uint16_t port) = 0;
         virtual bool send(const std::string& buf) = 0;
+        // 在一次调用中依次发送 count 段数据
+        virtual bool send(const SocketBuffer* bufs, size_t count) = 0;
         virtual bool recv(int length, std::string* buf) = 0;
         virtual bool recv(std::string* buf) = 0;
+        // 接收一次，最多 length 字节，直接写入 buf。
+        // 连接已关闭时返回 true，*received 为 0。
+        virtual bool recv(uint8_t* buf, size_t length, size_t* received) = 0;
 
         virtual bool shutdown() = 0;
         virtual void close() = 0;
@@ -6,6 +6,9 @@
 
 #include "akash/socket/win/socket_win.h"
 
+#include <algorithm>
+#include <climits>
+
 #include <WS2tcpip.h>
 
 #include "utils/log.h"
@@ -156,6 +159,33 @@ namespace win {
         return true;
     }
 
+    bool SocketClientWin::send(const SocketBuffer* bufs, size_t count) {
+        if (socket_ == INVALID_SOCKET) {
+            LOG(Log::ERR) << "Invalid socket.";
+            return false;
+        }
+
+        // 每次最多提交 kMaxBufs 段
+        const size_t kMaxBufs = 64;
+        WSABUF wsa_bufs[kMaxBufs];
+        while (count > 0) {
+            DWORD n = DWORD(std::min(count, kMaxBufs));
+            for (DWORD i = 0; i < n; ++i) {
+                wsa_bufs[i].buf = reinterpret_cast<CHAR*>(const_cast<uint8_t*>(bufs[i].data));
+                wsa_bufs[i].len = utl::num_cast<ULONG>(bufs[i].length);
+            }
+
+            DWORD bytes_sent;
+            if (::WSASend(socket_, wsa_bufs, n, &bytes_sent, 0, nullptr, nullptr) == SOCKET_ERROR) {
+                LOG(Log::ERR) << "Failed to send: " << WSAGetLastError();
+                return false;
+            }
+            bufs += n;
+            count -= n;
+        }
+        return true;
+    }
+
     bool SocketClientWin::recv(int length, std::string* buf) {
         if (length <= 0) {
             return true;
@@ -214,6 +244,26 @@ namespace win {
         return true;
     }
 
+    bool SocketClientWin::recv(uint8_t* buf, size_t length, size_t* received) {
+        if (socket_ == INVALID_SOCKET) {
+            LOG(Log::ERR) << "Invalid socket.";
+            return false;
+        }
+
+        int cur_length = length > INT_MAX ? INT_MAX : int(length);
+        int bytes_revd = ::recv(socket_, reinterpret_cast<char*>(buf), cur_length, 0);
+        if (bytes_revd == SOCKET_ERROR) {
+            LOG(Log::ERR) << "Failed to recv: " << WSAGetLastError();
+            return false;
+        }
+        if (bytes_revd == 0) {
+            LOG(Log::INFO) << "Connection closed";
+        }
+
+        *received = size_t(bytes_revd);
+        return true;
+    }
+
     bool SocketClientWin::shutdown() {
         if (socket_ != INVALID_SOCKET) {
             if (::shutdown(socket_, SD_SEND) == SOCKET_ERROR) {
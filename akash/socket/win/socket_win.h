@@ -23,8 +23,10 @@ namespace win {
         bool connect(const std::string& ip, uint16_t port) override;
         bool connectByHost(const std::string& host, uint16_t port) override;
         bool send(const std::string& buf) override;
+        bool send(const SocketBuffer* bufs, size_t count) override;
         bool recv(int length, std::string* buf) override;
         bool recv(std::string* buf) override;
+        bool recv(uint8_t* buf, size_t length, size_t* received) override;
 
         bool shutdown() override;
         void close() override;
@@ -8,7 +8,9 @@
 
 #include "utils/stream_utils.h"
 
+#include "akash/security/crypto/curve25519.h"
 #include "akash/security/crypto/ecdp.h"
+#include "akash/security/crypto/p256.h"
 #include "akash/tls/extensions/tls_ext.h"
 
 
@@ -23,29 +25,15 @@ namespace ext {
 
         BEGIN_WRB16(1);
         {
-            auto k = utl::BigInteger::fromRandom(32 * 8);
-            k.setBit(255, 0);
-            k.setBit(254, 1);
-            k.setBit(2, 0);
-            k.setBit(1, 0);
-            k.setBit(0, 0);
-            assert(k.getByteCount() == 32);
-
-            uint32_t A;
-            uint8_t cofactor, Up;
-            utl::BigInteger p, order, Vp, result;
-            crypto::ECDP::curve25519(&p, &A, &order, &cofactor, &Up, &Vp);
-            crypto::ECDP::X25519(p, k, utl::BigInteger::fromU32(Up), &result);
-
-            out->x25519_K = k;
-            out->x25519_P = p;
-
-            auto r = result.getBytesLE();
-            assert(r.size() == 32);
+            uint8_t k[crypto::Curve25519::kKeySize];
+            uint8_t U[crypto::Curve25519::kKeySize];
+            crypto::Curve25519::generateKey(k, U);
+
+            out->x25519_K.assign(reinterpret_cast<char*>(k), sizeof(k));
 
             WRITE_STREAM_BE(enum_cast(NamedGroup::X25519), 2);
-            WRITE_STREAM_BE(UIntToUInt16(r.length()), 2);
-            WRITE_STREAM_STR(r);
+            WRITE_STREAM_BE(UIntToUInt16(sizeof(U)), 2);
+            WRITE_STREAM(U[0], sizeof(U));
         }
 
         uint8_t h;
@@ -67,19 +55,17 @@ namespace ext {
         }
 
         {
-            crypto::ECDP::secp256r1(&p, &a, &b, &S, &Gx, &Gy, &n, &h);
-            auto d = utl::BigInteger::fromRandom(utl::BigInteger::ONE, n - 1);
-            crypto::ECDP::mulPoint(p, a, d, &Gx, &Gy);
-            crypto::ECDP::verifyPoint(p, a, b, Gx, Gy);
+            uint8_t d[crypto::P256::kScalarSize];
+            uint8_t Q[crypto::P256::kPointSize];
+            if (!crypto::P256::generateKey(d, Q)) {
+                return false;
+            }
 
-            ECDHEParams p_secp256;
-            p_secp256.X = Gx.getBytesBE();
-            p_secp256.Y = Gy.getBytesBE();
+            out->secp256r1_K.assign(reinterpret_cast<char*>(d), sizeof(d));
 
-            auto r = p_secp256.toBytes();
             WRITE_STREAM_BE(enum_cast(NamedGroup::SECP256R1), 2);
-            WRITE_STREAM_BE(UIntToUInt16(r.length()), 2);
-            WRITE_STREAM_STR(r);
+            WRITE_STREAM_BE(UIntToUInt16(sizeof(Q)), 2);
+            WRITE_STREAM(Q[0], sizeof(Q));
         }
         END_WRB16(1);
 
@@ -105,6 +91,18 @@ namespace ext {
         return true;
     }
 
+    bool KeyShareEntry::parseSECP256R1(std::istream& s, std::string* Q) {
+        uint16_t length;
+        READ_STREAM_BE(length, 2);
+        if (length != crypto::P256::kPointSize) {
+            return false;
+        }
+
+        Q->resize(length);
+        READ_STREAM(*Q->begin(), length);
+        return true;
+    }
+
 }
 }
 }
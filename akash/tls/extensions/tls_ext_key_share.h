@@ -9,7 +9,6 @@
 
 #include <istream>
 
-#include "akash/security/big_integer/big_integer.h"
 #include "akash/tls/tls_common.h"
 
 
@@ -22,8 +21,10 @@ namespace ext {
     class KeyShare {
     public:
         struct Data {
-            utl::BigInteger x25519_K;
-            utl::BigInteger x25519_P;
+            // X25519 私钥，小端序
+            std::string x25519_K;
+            // secp256r1 私钥，大端序
+            std::string secp256r1_K;
         };
 
         static bool write(std::ostream& s, Data* out);
@@ -34,6 +35,7 @@ namespace ext {
     class KeyShareEntry {
     public:
         static bool parseX25519(std::istream& s, std::string* U);
+        static bool parseSECP256R1(std::istream& s, std::string* Q);
 
         NamedGroup group;
     };
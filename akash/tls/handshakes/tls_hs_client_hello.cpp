@@ -185,7 +185,7 @@ namespace tls {
         }
 
         x25519_K_ = std::move(ks_data.x25519_K);
-        x25519_P_ = std::move(ks_data.x25519_P);
+        secp256r1_K_ = std::move(ks_data.secp256r1_K);
 
         auto end_p = s.tellp();
         len = IntToUInt16(end_p - start_p);
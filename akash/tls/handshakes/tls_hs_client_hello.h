@@ -9,7 +9,6 @@
 
 #include <ostream>
 
-#include "akash/security/big_integer/big_integer.h"
 #include "akash/tls/tls_common.h"
 
 
@@ -27,8 +26,8 @@ namespace tls {
         bool writeSupportExtensions(const std::string& host, std::ostream& s);
 
     public:
-        utl::BigInteger x25519_K_;
-        utl::BigInteger x25519_P_;
+        std::string x25519_K_;
+        std::string secp256r1_K_;
     };
 
 }
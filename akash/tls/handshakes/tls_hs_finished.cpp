@@ -17,43 +17,39 @@ namespace tls {
 
     bool HSFinished::parse(
         std::istream& s,
-        const std::string& context,
-        const std::string& base_key)
+        const TranscriptHash& transcript,
+        const uint8_t* base_key)
     {
-        std::string verify_data(32, 0);
-        READ_STREAM(*verify_data.begin(), 32);
+        // Section 4.4.4
+        // finished_key 与 verify_data 的长度均为 Hash.length
+        auto which = transcript.getVersion();
+        size_t hash_size = transcript.getHashSize();
 
-        std::string finished_key;
+        uint8_t verify_data[TranscriptHash::kMaxHashSize];
+        READ_STREAM(*verify_data, hash_size);
+
+        uint8_t finished_key[TranscriptHash::kMaxHashSize];
         if (!KeySchedule::HKDFExpandLabel(
-            reinterpret_cast<const uint8_t*>(base_key.data()), base_key.length(),
-            "finished", "", 32, &finished_key))
+            which, base_key, hash_size,
+            "finished", nullptr, 0, finished_key, hash_size))
         {
             return false;
         }
 
-        uint8_t hash[32];
-        digest::SHA256 sha256;
-        sha256.init();
-        int ret = sha256.update(
-            reinterpret_cast<const uint8_t*>(context.data()), context.length());
-        if (ret != digest::SHAResult::shaSuccess) {
-            return false;
-        }
-        ret = sha256.result(hash);
-        if (ret != digest::SHAResult::shaSuccess) {
+        uint8_t hash[TranscriptHash::kMaxHashSize];
+        if (!transcript.current(hash)) {
             return false;
         }
 
-        uint8_t result_vd[32];
-        ret = digest::HMAC::calculate(
-            digest::SHAVersion::SHA256, hash, 32,
-            reinterpret_cast<const uint8_t*>(finished_key.data()), finished_key.length(),
-            result_vd);
+        uint8_t result_vd[TranscriptHash::kMaxHashSize];
+        int ret = digest::HMAC::calculate(
+            which, hash, int(hash_size),
+            finished_key, int(hash_size), result_vd);
         if (ret != digest::SHAResult::shaSuccess) {
             return false;
         }
 
-        if (std::memcmp(verify_data.data(), result_vd, 32) != 0) {
+        if (std::memcmp(verify_data, result_vd, hash_size) != 0) {
             return false;
         }
         return true;
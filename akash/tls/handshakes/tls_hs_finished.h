@@ -9,6 +9,8 @@
 
 #include <istream>
 
+#include "akash/tls/tls_transcript_hash.h"
+
 
 namespace akash {
 namespace tls {
@@ -17,8 +19,8 @@ namespace tls {
     public:
         bool parse(
             std::istream& s,
-            const std::string& context,
-            const std::string& base_key);
+            const TranscriptHash& transcript,
+            const uint8_t* base_key);
     };
 
 }
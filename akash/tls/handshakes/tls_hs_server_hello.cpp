@@ -9,7 +9,8 @@
 #include "utils/log.h"
 #include "utils/stream_utils.h"
 
-#include "akash/security/crypto/ecdp.h"
+#include "akash/security/crypto/curve25519.h"
+#include "akash/security/crypto/p256.h"
 #include "akash/tls/extensions/tls_ext.h"
 #include "akash/tls/extensions/tls_ext_sp_vers.h"
 #include "akash/tls/extensions/tls_ext_key_share.h"
@@ -45,7 +46,21 @@ namespace tls {
             uint8_t cs0, cs1;
             READ_STREAM(cs0, 1);
             READ_STREAM(cs1, 1);
-            ubassert(cs0 == 0x13 && cs1 == 0x01);
+            if (cs0 != 0x13) {
+                ubassert(false);
+                return false;
+            }
+
+            switch (cs1) {
+            case 0x01: cipher_suite = CipherSuite::TLS_AES_128_GCM_SHA256; break;
+            case 0x02: cipher_suite = CipherSuite::TLS_AES_256_GCM_SHA384; break;
+            case 0x03: cipher_suite = CipherSuite::TLS_CHACHA20_POLY1305_SHA256; break;
+            case 0x04: cipher_suite = CipherSuite::TLS_AES_128_CCM_SHA256; break;
+            case 0x05: cipher_suite = CipherSuite::TLS_AES_128_CCM_8_SHA256; break;
+            default:
+                ubassert(false);
+                return false;
+            }
         }
 
         READ_STREAM(legacy_compression_method, 1);
@@ -101,20 +116,43 @@ namespace tls {
                 if (!ext::KeyShare::parseSH(s, &entry)) {
                     return false;
                 }
-                ubassert(entry.group == NamedGroup::X25519);
+                ubassert(
+                    entry.group == NamedGroup::X25519 ||
+                    entry.group == NamedGroup::SECP256R1);
                 if (entry.group == NamedGroup::X25519) {
-                    std::string U_bytes;
-                    if (!ext::KeyShareEntry::parseX25519(s, &U_bytes)) {
+                    std::string U;
+                    if (!ext::KeyShareEntry::parseX25519(s, &U) ||
+                        U.size() != crypto::Curve25519::kKeySize ||
+                        x25519_K_.size() != crypto::Curve25519::kKeySize)
+                    {
                         return false;
                     }
 
-                    utl::BigInteger share_K;
-                    auto U = utl::BigInteger::fromBytesLE(U_bytes);
-                    U.setBit(255, 0);
-                    crypto::ECDP::X25519(x25519_P_, x25519_K_, U, &share_K);
+                    uint8_t Z[crypto::Curve25519::kKeySize];
+                    if (!crypto::Curve25519::X25519(
+                        Z,
+                        reinterpret_cast<const uint8_t*>(x25519_K_.data()),
+                        reinterpret_cast<const uint8_t*>(U.data())))
+                    {
+                        return false;
+                    }
+                    share_K_.assign(reinterpret_cast<char*>(Z), sizeof(Z));
+                } else if (entry.group == NamedGroup::SECP256R1) {
+                    std::string Q;
+                    if (!ext::KeyShareEntry::parseSECP256R1(s, &Q) ||
+                        secp256r1_K_.size() != crypto::P256::kScalarSize)
+                    {
+                        return false;
+                    }
 
-                    share_K_ = share_K.getBytesLE();
-                    assert(share_K_.size() == 32);
+                    uint8_t Z[crypto::P256::kScalarSize];
+                    if (!crypto::P256::ECDH(
+                        reinterpret_cast<const uint8_t*>(secp256r1_K_.data()),
+                        reinterpret_cast<const uint8_t*>(Q.data()), Z))
+                    {
+                        return false;
+                    }
+                    share_K_.assign(reinterpret_cast<char*>(Z), sizeof(Z));
                 }
                 break;
             }
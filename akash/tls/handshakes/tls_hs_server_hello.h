@@ -9,7 +9,6 @@
 
 #include <istream>
 
-#include "akash/security/big_integer/big_integer.h"
 #include "akash/tls/tls_common.h"
 
 
@@ -32,7 +31,8 @@ namespace tls {
 
         //
         std::string share_K_;
-        utl::BigInteger x25519_P_, x25519_K_;
+        std::string x25519_K_;
+        std::string secp256r1_K_;
     };
 
 }
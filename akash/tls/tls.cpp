@@ -30,8 +30,9 @@ namespace tls {
 
     TLS::~TLS() {}
 
-    bool TLS::parseFragment(const TLSRecordLayer::TLSPlaintext& text) {
-        std::istringstream s(std::string(text.fragment.begin(), text.fragment.end()), std::ios::binary);
+    bool TLS::parseFragment(const TLSRecordLayer::TLSRecordView& text) {
+        // 握手消息的解析基于流，需要复制一次
+        std::istringstream s(std::string(text.fragment), std::ios::binary);
 
         for (; !finished_;) {
             PEEK_STREAM(char buf);
@@ -92,7 +93,7 @@ namespace tls {
             }
 
             x25519_K_ = client_hello.x25519_K_;
-            x25519_P_ = client_hello.x25519_P_;
+            secp256r1_K_ = client_hello.secp256r1_K_;
             break;
         }
         default:
@@ -107,7 +108,8 @@ namespace tls {
         return true;
     }
 
-    bool TLS::parseHandshake(std::istream& s, const std::string& fragment) {
+    bool TLS::parseHandshake(std::istream& s, std::string_view fragment) {
+        auto begin_p = s.tellg();
         HSHandshake::Data data;
         if (!HSHandshake::parse(s, &data)) {
             return false;
@@ -115,26 +117,44 @@ namespace tls {
 
         auto end_p = s.tellg() + std::streamoff(data.length);
 
+        // 当前握手消息，包括消息头
+        std::streamoff msg_begin = begin_p;
+        std::streamoff msg_end = end_p;
+        if (msg_begin < 0 || msg_end > std::streamoff(fragment.size())) {
+            return false;
+        }
+        auto msg = reinterpret_cast<const uint8_t*>(fragment.data()) + msg_begin;
+        size_t msg_length = size_t(msg_end - msg_begin);
+
         switch (data.type) {
         case HandshakeType::ServerHello:
         {
-            server_hello_data_ = fragment;
-
             HSServerHello server_hello;
-            server_hello.x25519_P_ = x25519_P_;
             server_hello.x25519_K_ = x25519_K_;
+            server_hello.secp256r1_K_ = secp256r1_K_;
             if (!server_hello.parse(s)) {
                 return false;
             }
 
             share_K_ = server_hello.share_K_;
-            generateServerWriteKey();
+            selected_cs_ = server_hello.cipher_suite;
+
+            // 摘要算法由选定的密码套件决定
+            if (!key_schedule_.init(selected_cs_)) {
+                return false;
+            }
+            transcript_.init(key_schedule_.getVersion());
+            transcript_.update(client_hello_data_);
+            transcript_.update(msg, msg_length);
+            if (!generateServerWriteKey()) {
+                return false;
+            }
             break;
         }
 
         case HandshakeType::EncryptedExtensions:
         {
-            encrypted_exts_data_ = fragment;
+            transcript_.update(msg, msg_length);
 
             HSEncryptedExtensions encrypted_exts;
             if (!encrypted_exts.parse(s)) {
@@ -145,7 +165,7 @@ namespace tls {
 
         case HandshakeType::Certificate:
         {
-            certificate_data_ = fragment;
+            transcript_.update(msg, msg_length);
 
             HSCertificate cert;
             if (!cert.parse(s)) {
@@ -159,7 +179,7 @@ namespace tls {
             break;
 
         case HandshakeType::CertificateVerify:
-            certificate_verify_data_ = fragment;
+            transcript_.update(msg, msg_length);
             SKIP_BYTES(data.length);
             break;
 
@@ -167,16 +187,30 @@ namespace tls {
         {
             finished_ = true;
             HSFinished finished;
-            std::string context = client_hello_data_
-                + server_hello_data_
-                + encrypted_exts_data_
-                + certificate_data_
-                + certificate_verify_data_;
-
-            if (!finished.parse(s, context, server_handshake_traffic_secret_)) {
+            if (!finished.parse(
+                s, transcript_,
+                key_schedule_.getSecret(KeySchedule::Secret::ServerHandshakeTraffic)))
+            {
                 assert(false);
                 return false;
             }
+            // Finished 的校验值不包括其自身
+            transcript_.update(msg, msg_length);
+
+            // application traffic secret 使用截至 server Finished 的摘要
+            if (!key_schedule_.deriveApplicationSecrets(transcript_)) {
+                return false;
+            }
+
+            // 服务器之后的记录使用 application traffic key；
+            // 客户端发出自己的 Finished 之后才能切换写方向
+            KeySchedule::TrafficKey tk;
+            if (!key_schedule_.getTrafficKey(KeySchedule::Secret::ServerApplicationTraffic, &tk) ||
+                !record_layer_.setReadKey(TLSRecordLayer::Epoch::Application, selected_cs_, tk))
+            {
+                return false;
+            }
+            std::memset(&tk, 0, sizeof(tk));
             break;
         }
 
@@ -195,49 +229,26 @@ namespace tls {
 
     bool TLS::generateServerWriteKey() {
         // Section 7.1
-        // 生成 server_handshake_traffic_secret
-        uint8_t salt[32];
-        uint8_t psk[32];
-        std::memset(salt, 0, 32);
-        std::memset(psk, 0, 32);
-
-        uint8_t early_secret[64];
-        digest::HKDF::hkdfExtract(
-            digest::SHAVersion::SHA256,
-            salt, 32, psk, 32, early_secret);
-
-        std::string out;
-        KeySchedule::deriveSecret(early_secret, 32, "derived", {}, &out);
-
-        std::string_view ecdhe(share_K_);
-
-        uint8_t handshake_secret[64];
-        digest::HKDF::hkdfExtract(
-            digest::SHAVersion::SHA256,
-            reinterpret_cast<const uint8_t*>(out.data()), out.size(),
-            reinterpret_cast<const uint8_t*>(ecdhe.data()), ecdhe.size(), handshake_secret);
-
-        std::string sht_secret;
-        std::string message = client_hello_data_ + server_hello_data_;
-        KeySchedule::deriveSecret(handshake_secret, 32, "s hs traffic", message, &sht_secret);
-        server_handshake_traffic_secret_ = sht_secret;
+        if (!key_schedule_.deriveHandshakeSecrets(
+            reinterpret_cast<const uint8_t*>(share_K_.data()), share_K_.size(), transcript_))
+        {
+            return false;
+        }
 
         // Section 7.3
-        // 生成 server_write_iv
-        std::string sw_iv;
-        // iv 的长度根据 RFC 5116
-        // https://tools.ietf.org/html/rfc5116
-        KeySchedule::HKDFExpandLabel(
-            reinterpret_cast<const uint8_t*>(sht_secret.data()), sht_secret.length(),
-            "iv", "", 12, &sw_iv);
-
-        // 生成 server_write_key
-        std::string sw_key;
-        KeySchedule::HKDFExpandLabel(
-            reinterpret_cast<const uint8_t*>(sht_secret.data()), sht_secret.length(),
-            "key", "", 16, &sw_key);
-
-        record_layer_.setServerWriteKey(sw_key, sw_iv);
+        // ServerHello 之后双方的握手消息均使用 handshake traffic key
+        KeySchedule::TrafficKey tk;
+        if (!key_schedule_.getTrafficKey(KeySchedule::Secret::ServerHandshakeTraffic, &tk) ||
+            !record_layer_.setReadKey(TLSRecordLayer::Epoch::Handshake, selected_cs_, tk))
+        {
+            return false;
+        }
+        if (!key_schedule_.getTrafficKey(KeySchedule::Secret::ClientHandshakeTraffic, &tk) ||
+            !record_layer_.setWriteKey(TLSRecordLayer::Epoch::Handshake, selected_cs_, tk))
+        {
+            return false;
+        }
+        std::memset(&tk, 0, sizeof(tk));
 
         return true;
     }
@@ -269,9 +280,9 @@ namespace tls {
             return;
         }
 
-        TLSRecordLayer::TLSPlaintext out;
+        TLSRecordLayer::TLSRecordView out;
         for (;;) {
-            if (!record_layer_.recvFragment(&out)) {
+            if (!record_layer_.recvRecord(&out)) {
                 ubassert(false);
                 break;
             }
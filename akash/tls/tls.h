@@ -8,10 +8,12 @@
 #define AKASH_TLS_TLS_H_
 
 #include <string>
+#include <string_view>
 
-#include "akash/security/big_integer/big_integer.h"
 #include "akash/tls/tls_common.h"
+#include "akash/tls/tls_key_schedule.h"
 #include "akash/tls/tls_record_layer.h"
+#include "akash/tls/tls_transcript_hash.h"
 
 
 namespace akash {
@@ -27,10 +29,10 @@ namespace tls {
         void testHandshake();
 
     private:
-        bool parseFragment(const TLSRecordLayer::TLSPlaintext& text);
+        bool parseFragment(const TLSRecordLayer::TLSRecordView& text);
 
         bool writeHandshake(HandshakeType type, std::ostream& s);
-        bool parseHandshake(std::istream& s, const std::string& fragment);
+        bool parseHandshake(std::istream& s, std::string_view fragment);
 
         // Section 7.1
         bool generateServerWriteKey();
@@ -40,17 +42,15 @@ namespace tls {
         bool finished_ = false;
 
         // handshake context
+        // 收到 ServerHello 之前无法确定摘要算法，ClientHello 暂时保存
         std::string client_hello_data_;
-        std::string server_hello_data_;
-        std::string encrypted_exts_data_;
-        std::string certificate_data_;
-        std::string certificate_verify_data_;
+        TranscriptHash transcript_;
 
         KeyShareClientHello key_share_;
-        utl::BigInteger x25519_K_;
-        utl::BigInteger x25519_P_;
+        std::string x25519_K_;
+        std::string secp256r1_K_;
         std::string share_K_;
-        std::string server_handshake_traffic_secret_;
+        KeySchedule key_schedule_;
         CipherSuite selected_cs_;
     };
 
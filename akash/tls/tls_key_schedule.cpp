@@ -6,73 +6,278 @@
 
 #include "akash/tls/tls_key_schedule.h"
 
-#include <sstream>
-
-#include "utils/stream_utils.h"
-
-#include "akash/security/digest/sha.h"
+#include <cstring>
 
 
 namespace akash {
 namespace tls {
 
-    bool KeySchedule::deriveSecret(
-        const uint8_t* secret, size_t ls,
-        const std::string& label, const std::string& message, std::string* out)
-    {
-        uint8_t hash_result[32];
+    KeySchedule::KeySchedule() {}
+
+    KeySchedule::~KeySchedule() {
+        clear();
+    }
 
-        digest::SHA256 sha256;
-        sha256.init();
-        int ret = sha256.update(
-            reinterpret_cast<const uint8_t*>(message.data()), message.size());
-        if (ret != digest::shaSuccess) {
+    bool KeySchedule::init(CipherSuite suite) {
+        clear();
+
+        // Section B.4
+        switch (suite) {
+        case CipherSuite::TLS_AES_128_GCM_SHA256:
+        case CipherSuite::TLS_AES_128_CCM_SHA256:
+        case CipherSuite::TLS_AES_128_CCM_8_SHA256:
+            which_ = digest::SHAVersion::SHA256;
+            key_length_ = 16;
+            break;
+        case CipherSuite::TLS_AES_256_GCM_SHA384:
+            which_ = digest::SHAVersion::SHA384;
+            key_length_ = 32;
+            break;
+        case CipherSuite::TLS_CHACHA20_POLY1305_SHA256:
+            which_ = digest::SHAVersion::SHA256;
+            key_length_ = 32;
+            break;
+        default:
             return false;
         }
-        ret = sha256.result(hash_result);
-        if (ret != digest::shaSuccess) {
+
+        suite_ = suite;
+        hash_size_ = size_t(digest::USHA::USHAHashSize(which_));
+
+        // 不使用 PSK 时，PSK 和 salt 均为 Hash.length 个 0
+        uint8_t zero[kMaxHashSize];
+        std::memset(zero, 0, hash_size_);
+        if (digest::HKDF::hkdfExtract(
+            which_, zero, int(hash_size_), zero, int(hash_size_),
+            early_secret_) != digest::shaSuccess)
+        {
             return false;
         }
 
-        return HKDFExpandLabel(
-            secret, ls, label,
-            std::string(reinterpret_cast<char*>(hash_result), 32), 32, out);
+        stage_ = STAGE_EARLY;
+        return true;
     }
 
-    bool KeySchedule::HKDFExpandLabel(
-        const uint8_t* secret, size_t ls,
-        const std::string& label, const std::string& context,
-        uint32_t length, std::string* out)
+    bool KeySchedule::deriveHandshakeSecrets(
+        const uint8_t* ecdhe, size_t length, const TranscriptHash& transcript)
     {
-        HKDFLabel hkdf_label;
-        hkdf_label.length = length;
-        hkdf_label.label.append("tls13 ").append(label);
-        hkdf_label.context.append(context);
+        if (stage_ != STAGE_EARLY || transcript.getVersion() != which_) {
+            return false;
+        }
+        if (!extractNext(early_secret_, ecdhe, length, handshake_secret_)) {
+            return false;
+        }
 
-        std::ostringstream s(std::ios::binary);
+        uint8_t hash[TranscriptHash::kMaxHashSize];
+        if (!transcript.current(hash)) {
+            return false;
+        }
+        if (!derive(handshake_secret_, "c hs traffic", hash, c_hs_traffic_) ||
+            !derive(handshake_secret_, "s hs traffic", hash, s_hs_traffic_))
+        {
+            return false;
+        }
 
-        WRITE_STREAM_BE(hkdf_label.length, 2);
-        PUT_STREAM(uint8_t(hkdf_label.label.size()));
-        WRITE_STREAM_STR(hkdf_label.label);
-        PUT_STREAM(uint8_t(hkdf_label.context.size()));
-        WRITE_STREAM_STR(hkdf_label.context);
+        stage_ = STAGE_HANDSHAKE;
+        return true;
+    }
 
-        std::string input(s.str());
+    bool KeySchedule::deriveApplicationSecrets(const TranscriptHash& transcript) {
+        if (stage_ != STAGE_HANDSHAKE || transcript.getVersion() != which_) {
+            return false;
+        }
 
-        uint8_t* okm = new uint8_t[length];
-        int result = digest::HKDF::hkdfExpand(
-            digest::SHAVersion::SHA256, secret, int(ls),
-            reinterpret_cast<const uint8_t*>(input.data()), input.size(),
-            okm, length);
-        if (result != digest::shaSuccess) {
-            delete[] okm;
+        // 此时 IKM 为 Hash.length 个 0
+        uint8_t zero[kMaxHashSize];
+        std::memset(zero, 0, hash_size_);
+        if (!extractNext(handshake_secret_, zero, hash_size_, master_secret_)) {
             return false;
         }
 
-        *out = std::string(reinterpret_cast<char*>(okm), length);
-        delete[] okm;
+        uint8_t hash[TranscriptHash::kMaxHashSize];
+        if (!transcript.current(hash)) {
+            return false;
+        }
+        if (!derive(master_secret_, "c ap traffic", hash, c_ap_traffic_) ||
+            !derive(master_secret_, "s ap traffic", hash, s_ap_traffic_) ||
+            !derive(master_secret_, "exp master", hash, exp_master_))
+        {
+            return false;
+        }
+
+        stage_ = STAGE_MASTER;
+        return true;
+    }
+
+    bool KeySchedule::updateTrafficSecret(Secret secret) {
+        uint8_t* s;
+        switch (secret) {
+        case Secret::ClientApplicationTraffic: s = c_ap_traffic_; break;
+        case Secret::ServerApplicationTraffic: s = s_ap_traffic_; break;
+        default: return false;
+        }
+        if (stage_ < STAGE_MASTER) {
+            return false;
+        }
+
+        uint8_t next[kMaxHashSize];
+        if (!HKDFExpandLabel(
+            which_, s, hash_size_, "traffic upd", nullptr, 0, next, hash_size_))
+        {
+            return false;
+        }
+        std::memcpy(s, next, hash_size_);
+        std::memset(next, 0, sizeof(next));
+        return true;
+    }
+
+    bool KeySchedule::getTrafficKey(Secret secret, TrafficKey* key) const {
+        auto s = getSecret(secret);
+        if (!s || secret == Secret::ExporterMaster) {
+            return false;
+        }
+
+        // Section 7.3
+        // key 和 iv 由同一个 secret 导出
+        digest::HMACKey hmac_key;
+        if (hmac_key.init(which_, s, int(hash_size_)) != digest::shaSuccess) {
+            return false;
+        }
+        if (!HKDFExpandLabel(hmac_key, "key", nullptr, 0, key->key, key_length_) ||
+            !HKDFExpandLabel(hmac_key, "iv", nullptr, 0, key->iv, kIVSize))
+        {
+            return false;
+        }
+        key->key_length = key_length_;
         return true;
     }
 
+    const uint8_t* KeySchedule::getSecret(Secret secret) const {
+        switch (secret) {
+        case Secret::ClientHandshakeTraffic:
+            return stage_ >= STAGE_HANDSHAKE ? c_hs_traffic_ : nullptr;
+        case Secret::ServerHandshakeTraffic:
+            return stage_ >= STAGE_HANDSHAKE ? s_hs_traffic_ : nullptr;
+        case Secret::ClientApplicationTraffic:
+            return stage_ >= STAGE_MASTER ? c_ap_traffic_ : nullptr;
+        case Secret::ServerApplicationTraffic:
+            return stage_ >= STAGE_MASTER ? s_ap_traffic_ : nullptr;
+        case Secret::ExporterMaster:
+            return stage_ >= STAGE_MASTER ? exp_master_ : nullptr;
+        default:
+            return nullptr;
+        }
+    }
+
+    CipherSuite KeySchedule::getCipherSuite() const {
+        return suite_;
+    }
+
+    digest::SHAVersion KeySchedule::getVersion() const {
+        return which_;
+    }
+
+    size_t KeySchedule::getHashSize() const {
+        return hash_size_;
+    }
+
+    size_t KeySchedule::getKeyLength() const {
+        return key_length_;
+    }
+
+    bool KeySchedule::derive(
+        const uint8_t* secret, std::string_view label,
+        const uint8_t* hash, uint8_t* out) const
+    {
+        digest::HMACKey key;
+        if (key.init(which_, secret, int(hash_size_)) != digest::shaSuccess) {
+            return false;
+        }
+        return HKDFExpandLabel(key, label, hash, hash_size_, out, hash_size_);
+    }
+
+    bool KeySchedule::extractNext(
+        const uint8_t* secret, const uint8_t* ikm, size_t length, uint8_t* out) const
+    {
+        // Derive-Secret(., "derived", "")
+        uint8_t empty_hash[digest::USHA::kMaxHashSize];
+        digest::USHA sha;
+        if (sha.init(which_) != digest::shaSuccess ||
+            sha.result(empty_hash) != digest::shaSuccess)
+        {
+            return false;
+        }
+
+        uint8_t salt[kMaxHashSize];
+        if (!derive(secret, "derived", empty_hash, salt)) {
+            return false;
+        }
+
+        return digest::HKDF::hkdfExtract(
+            which_, salt, int(hash_size_), ikm, int(length), out) == digest::shaSuccess;
+    }
+
+    void KeySchedule::clear() {
+        stage_ = STAGE_NONE;
+        std::memset(early_secret_, 0, sizeof(early_secret_));
+        std::memset(handshake_secret_, 0, sizeof(handshake_secret_));
+        std::memset(master_secret_, 0, sizeof(master_secret_));
+        std::memset(c_hs_traffic_, 0, sizeof(c_hs_traffic_));
+        std::memset(s_hs_traffic_, 0, sizeof(s_hs_traffic_));
+        std::memset(c_ap_traffic_, 0, sizeof(c_ap_traffic_));
+        std::memset(s_ap_traffic_, 0, sizeof(s_ap_traffic_));
+        std::memset(exp_master_, 0, sizeof(exp_master_));
+    }
+
+    bool KeySchedule::HKDFExpandLabel(
+        digest::SHAVersion which,
+        const uint8_t* secret, size_t ls,
+        std::string_view label, const uint8_t* context, size_t lc,
+        uint8_t* out, size_t length)
+    {
+        if (ls < size_t(digest::USHA::USHAHashSize(which))) {
+            return false;
+        }
+
+        digest::HMACKey key;
+        if (key.init(which, secret, int(ls)) != digest::shaSuccess) {
+            return false;
+        }
+        return HKDFExpandLabel(key, label, context, lc, out, length);
+    }
+
+    bool KeySchedule::HKDFExpandLabel(
+        const digest::HMACKey& secret,
+        std::string_view label, const uint8_t* context, size_t lc,
+        uint8_t* out, size_t length)
+    {
+        static const char kLabelPrefix[] = "tls13 ";
+        const size_t prefix_length = sizeof(kLabelPrefix) - 1;
+        if (length == 0 || length > 0xFFFF ||
+            label.size() > 255 - prefix_length || lc > 255)
+        {
+            return false;
+        }
+
+        // HkdfLabel 最长为 2 + 1 + 255 + 1 + 255 字节
+        uint8_t info[2 + 1 + 255 + 1 + 255];
+        size_t n = 0;
+        info[n++] = uint8_t(length >> 8);
+        info[n++] = uint8_t(length);
+        info[n++] = uint8_t(prefix_length + label.size());
+        std::memcpy(info + n, kLabelPrefix, prefix_length);
+        n += prefix_length;
+        std::memcpy(info + n, label.data(), label.size());
+        n += label.size();
+        info[n++] = uint8_t(lc);
+        if (lc > 0) {
+            std::memcpy(info + n, context, lc);
+            n += lc;
+        }
+
+        return digest::HKDF::hkdfExpand(
+            secret, info, int(n), out, int(length)) == digest::shaSuccess;
+    }
+
 }
 }
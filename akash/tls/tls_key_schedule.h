@@ -7,28 +7,110 @@
 #ifndef AKASH_TLS_TLS_KEY_SCHEDULE_H_
 #define AKASH_TLS_TLS_KEY_SCHEDULE_H_
 
-#include <string>
+#include <string_view>
+
+#include "akash/security/digest/sha.h"
+#include "akash/tls/tls_common.h"
+#include "akash/tls/tls_transcript_hash.h"
 
 
 namespace akash {
 namespace tls {
 
+    // Section 7.1
+    // 密钥计划。摘要算法和密钥长度由协商的密码套件决定，
+    // 各阶段的 secret 只计算一次，保存在固定长度的缓冲区中。
     class KeySchedule {
     public:
-        struct HKDFLabel {
-            uint16_t length;
-            std::string label;
-            std::string context;
+        static const int kMaxHashSize = digest::USHA::kMaxHashSize;
+        static const int kMaxKeySize = 32;
+        // 根据 RFC 5116，iv 的长度为 12
+        // https://tools.ietf.org/html/rfc5116
+        static const int kIVSize = 12;
+
+        enum class Secret {
+            ClientHandshakeTraffic,
+            ServerHandshakeTraffic,
+            ClientApplicationTraffic,
+            ServerApplicationTraffic,
+            ExporterMaster,
+        };
+
+        // Section 7.3
+        struct TrafficKey {
+            uint8_t key[kMaxKeySize];
+            size_t key_length;
+            uint8_t iv[kIVSize];
         };
 
+        KeySchedule();
+        ~KeySchedule();
+
+        // 根据密码套件确定摘要算法和密钥长度，并计算 early secret (不使用 PSK)
+        bool init(CipherSuite suite);
+        // transcript 为 ClientHello...ServerHello
+        bool deriveHandshakeSecrets(
+            const uint8_t* ecdhe, size_t length, const TranscriptHash& transcript);
+        // transcript 为 ClientHello...server Finished
+        bool deriveApplicationSecrets(const TranscriptHash& transcript);
+
+        // Section 7.2
+        // KeyUpdate 之后用 application_traffic_secret_N+1 替换当前的值
+        bool updateTrafficSecret(Secret secret);
+
+        bool getTrafficKey(Secret secret, TrafficKey* key) const;
+        // 长度为 getHashSize()，尚未计算时返回 nullptr
+        const uint8_t* getSecret(Secret secret) const;
+
+        CipherSuite getCipherSuite() const;
+        digest::SHAVersion getVersion() const;
+        size_t getHashSize() const;
+        size_t getKeyLength() const;
+
         // Section 7.1
-        static bool deriveSecret(
-            const uint8_t* secret, size_t ls,
-            const std::string& label, const std::string& message, std::string* out);
+        // 不分配内存：HkdfLabel 在栈上编码，结果直接写入长度为 length 的 out
         static bool HKDFExpandLabel(
+            digest::SHAVersion which,
             const uint8_t* secret, size_t ls,
-            const std::string& label, const std::string& context,
-            uint32_t length, std::string* out);
+            std::string_view label, const uint8_t* context, size_t lc,
+            uint8_t* out, size_t length);
+        // 同一个 secret 多次使用时，HMACKey 只需计算一次
+        static bool HKDFExpandLabel(
+            const digest::HMACKey& secret,
+            std::string_view label, const uint8_t* context, size_t lc,
+            uint8_t* out, size_t length);
+
+    private:
+        enum Stage {
+            STAGE_NONE,
+            STAGE_EARLY,
+            STAGE_HANDSHAKE,
+            STAGE_MASTER,
+        };
+
+        // Derive-Secret(secret, label, transcript)，结果长度为 hash_size_
+        bool derive(
+            const uint8_t* secret, std::string_view label,
+            const uint8_t* hash, uint8_t* out) const;
+        // Derive-Secret(secret, "derived", "") 之后作为 salt 调用 HKDF-Extract
+        bool extractNext(
+            const uint8_t* secret, const uint8_t* ikm, size_t length, uint8_t* out) const;
+        void clear();
+
+        Stage stage_ = STAGE_NONE;
+        CipherSuite suite_ = CipherSuite::TLS_NULL_WITH_NULL_NULL;
+        digest::SHAVersion which_ = digest::SHAVersion::SHA256;
+        size_t hash_size_ = 0;
+        size_t key_length_ = 0;
+
+        uint8_t early_secret_[kMaxHashSize];
+        uint8_t handshake_secret_[kMaxHashSize];
+        uint8_t master_secret_[kMaxHashSize];
+        uint8_t c_hs_traffic_[kMaxHashSize];
+        uint8_t s_hs_traffic_[kMaxHashSize];
+        uint8_t c_ap_traffic_[kMaxHashSize];
+        uint8_t s_ap_traffic_[kMaxHashSize];
+        uint8_t exp_master_[kMaxHashSize];
     };
 
 }
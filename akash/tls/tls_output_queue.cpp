@@ -0,0 +1,218 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/tls/tls_output_queue.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace akash {
+namespace tls {
+
+    OutputQueue::OutputQueue(size_t seal_capacity)
+        : seal_buf_(new uint8_t[seal_capacity]),
+          seal_capacity_(seal_capacity) {}
+
+    void OutputQueue::setSocket(SocketClient* socket) {
+        socket_ = socket;
+    }
+
+    void OutputQueue::setFlushPolicy(FlushPolicy policy) {
+        policy_ = policy;
+    }
+
+    OutputQueue::FlushPolicy OutputQueue::getFlushPolicy() const {
+        return policy_;
+    }
+
+    bool OutputQueue::queuePlaintext(
+        ContentType type, ProtocolVersion version,
+        const uint8_t* data, size_t length)
+    {
+        const size_t kMaxLength = RecordProtection::kMaxPlaintextSize;
+
+        while (length > 0) {
+            bool mergeable =
+                open_ == OpenType::Plaintext &&
+                open_type_ == type &&
+                open_version_.major == version.major &&
+                open_version_.minor == version.minor &&
+                open_length_ < kMaxLength &&
+                buf_count_ < kMaxBufs;
+            if (!mergeable) {
+                if (!closeRecord()) {
+                    return false;
+                }
+                // 记录头和内容各占一段
+                if (header_count_ == kMaxRecords || buf_count_ + 2 > kMaxBufs) {
+                    if (!flush()) {
+                        return false;
+                    }
+                }
+
+                auto header = headers_ + header_count_ * RecordProtection::kHeaderSize;
+                ++header_count_;
+                header[0] = uint8_t(type);
+                header[1] = version.major;
+                header[2] = version.minor;
+                addBuf(header, RecordProtection::kHeaderSize);
+
+                open_ = OpenType::Plaintext;
+                open_type_ = type;
+                open_version_ = version;
+                open_protection_ = nullptr;
+                open_header_ = header;
+                open_length_ = 0;
+            }
+
+            size_t n = std::min(length, kMaxLength - open_length_);
+            addBuf(data, n);
+            open_length_ += n;
+            data += n;
+            length -= n;
+        }
+
+        return onQueued();
+    }
+
+    bool OutputQueue::queueProtected(
+        ContentType type, const uint8_t* data, size_t length,
+        RecordProtection* protection)
+    {
+        const size_t kMaxLength = RecordProtection::kMaxPlaintextSize;
+        if (!protection || !protection->isEnabled()) {
+            return false;
+        }
+
+        while (length > 0) {
+            bool mergeable =
+                open_ == OpenType::Protected &&
+                open_type_ == type &&
+                open_protection_ == protection &&
+                open_length_ < kMaxLength &&
+                seal_used_ + protection->getSealedSize(open_length_ + 1) <= seal_capacity_;
+            if (!mergeable) {
+                if (!closeRecord()) {
+                    return false;
+                }
+
+                size_t need = protection->getSealedSize(std::min(length, kMaxLength));
+                if (seal_capacity_ - seal_used_ < need || buf_count_ == kMaxBufs) {
+                    if (!flush()) {
+                        return false;
+                    }
+                }
+                if (seal_capacity_ < need) {
+                    return false;
+                }
+
+                open_ = OpenType::Protected;
+                open_type_ = type;
+                open_protection_ = protection;
+                open_header_ = seal_buf_.get() + seal_used_;
+                open_length_ = 0;
+            }
+
+            // 加密区域中剩余的空间决定本条记录还能放入多少内容
+            size_t room = seal_capacity_ - seal_used_ - protection->getSealedSize(open_length_);
+            size_t n = std::min({ length, kMaxLength - open_length_, room });
+            std::memcpy(open_header_ + RecordProtection::kHeaderSize + open_length_, data, n);
+            open_length_ += n;
+            data += n;
+            length -= n;
+        }
+
+        return onQueued();
+    }
+
+    bool OutputQueue::flush() {
+        if (!closeRecord()) {
+            clear();
+            return false;
+        }
+        if (buf_count_ == 0) {
+            return true;
+        }
+
+        bool succeeded = socket_ && socket_->send(bufs_, buf_count_);
+        clear();
+        return succeeded;
+    }
+
+    bool OutputQueue::empty() const {
+        return buf_count_ == 0 && open_ == OpenType::None;
+    }
+
+    void OutputQueue::clear() {
+        buf_count_ = 0;
+        header_count_ = 0;
+        seal_used_ = 0;
+        open_ = OpenType::None;
+        open_protection_ = nullptr;
+        open_header_ = nullptr;
+        open_length_ = 0;
+    }
+
+    bool OutputQueue::closeRecord() {
+        switch (open_) {
+        case OpenType::Plaintext:
+            open_header_[3] = uint8_t(open_length_ >> 8);
+            open_header_[4] = uint8_t(open_length_);
+            break;
+
+        case OpenType::Protected:
+        {
+            if (!open_protection_->seal(open_type_, open_header_, open_length_)) {
+                return false;
+            }
+            size_t size = open_protection_->getSealedSize(open_length_);
+            if (!addBuf(open_header_, size)) {
+                return false;
+            }
+            seal_used_ += size;
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        open_ = OpenType::None;
+        open_protection_ = nullptr;
+        open_header_ = nullptr;
+        open_length_ = 0;
+        return true;
+    }
+
+    bool OutputQueue::onQueued() {
+        if (policy_ == FlushPolicy::Latency) {
+            return flush();
+        }
+        return true;
+    }
+
+    bool OutputQueue::addBuf(const uint8_t* data, size_t length) {
+        // 与上一段相邻时合并，连续的加密记录只占一段
+        if (buf_count_ > 0) {
+            auto& last = bufs_[buf_count_ - 1];
+            if (last.data + last.length == data) {
+                last.length += length;
+                return true;
+            }
+        }
+        if (buf_count_ == kMaxBufs) {
+            return false;
+        }
+
+        bufs_[buf_count_].data = data;
+        bufs_[buf_count_].length = length;
+        ++buf_count_;
+        return true;
+    }
+
+}
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_TLS_TLS_OUTPUT_QUEUE_H_
+#define AKASH_TLS_TLS_OUTPUT_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "akash/socket/socket.h"
+#include "akash/tls/tls_common.h"
+#include "akash/tls/tls_record_protection.h"
+
+
+namespace akash {
+namespace tls {
+
+    // 待发送的记录队列。
+    // 相同类型的连续内容合并为一条记录，一个 flight 中的所有记录用一次分散写发送。
+    // 明文记录的记录头写在头部区域中，内容只保存指针，不复制；
+    // 加密记录的内容在加密区域中就地加密。两个区域在创建时分配，之后不再分配内存。
+    class OutputQueue {
+    public:
+        // 何时发送队列中的记录
+        enum class FlushPolicy {
+            // 每次加入内容后立即发送，延迟最低
+            Latency,
+            // 只在调用 flush 或队列已满时发送，系统调用最少
+            Throughput,
+        };
+
+        explicit OutputQueue(size_t seal_capacity);
+
+        void setSocket(SocketClient* socket);
+        void setFlushPolicy(FlushPolicy policy);
+        FlushPolicy getFlushPolicy() const;
+
+        /**
+         * 加入明文内容。data 不会被复制，在发送之前必须保持有效。
+         */
+        bool queuePlaintext(
+            ContentType type, ProtocolVersion version,
+            const uint8_t* data, size_t length);
+
+        /**
+         * 加入需要加密的内容，使用 protection 加密。
+         * 内容复制到加密区域后在记录关闭时就地加密，调用返回后 data 即可释放。
+         */
+        bool queueProtected(
+            ContentType type, const uint8_t* data, size_t length,
+            RecordProtection* protection);
+
+        /**
+         * 关闭当前的记录，之后加入的内容不再与之合并。
+         * 加密记录在此时加密，因此写方向切换密钥之前必须调用。
+         */
+        bool closeRecord();
+        // 关闭当前的记录并发送队列中的所有数据
+        bool flush();
+        bool empty() const;
+        void clear();
+
+    private:
+        static const size_t kMaxRecords = 32;
+        static const size_t kMaxBufs = 64;
+
+        enum class OpenType {
+            None,
+            Plaintext,
+            Protected,
+        };
+
+        // 按照策略在加入内容后发送
+        bool onQueued();
+        bool addBuf(const uint8_t* data, size_t length);
+
+        SocketClient* socket_ = nullptr;
+        FlushPolicy policy_ = FlushPolicy::Latency;
+
+        SocketBuffer bufs_[kMaxBufs];
+        size_t buf_count_ = 0;
+
+        // 明文记录的记录头
+        uint8_t headers_[kMaxRecords * RecordProtection::kHeaderSize];
+        size_t header_count_ = 0;
+
+        // 加密记录按顺序排列在此区域中
+        std::unique_ptr<uint8_t[]> seal_buf_;
+        size_t seal_capacity_;
+        size_t seal_used_ = 0;
+
+        // 当前尚未关闭的记录
+        OpenType open_ = OpenType::None;
+        ContentType open_type_ = ContentType::Handshake;
+        ProtocolVersion open_version_ = { 3, 3 };
+        RecordProtection* open_protection_ = nullptr;
+        uint8_t* open_header_ = nullptr;
+        size_t open_length_ = 0;
+    };
+
+}
+}
+
+#endif  // AKASH_TLS_TLS_OUTPUT_QUEUE_H_
@@ -0,0 +1,85 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/tls/tls_record_buffer.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "akash/tls/tls_record_protection.h"
+
+
+namespace akash {
+namespace tls {
+
+    RecordBuffer::RecordBuffer(size_t capacity)
+        : buf_(new uint8_t[capacity]),
+          capacity_(capacity) {}
+
+    uint8_t* RecordBuffer::data() const {
+        return buf_.get() + begin_;
+    }
+
+    size_t RecordBuffer::size() const {
+        return end_ - begin_;
+    }
+
+    uint8_t* RecordBuffer::prepare(size_t min_length, size_t* length) {
+        if (begin_ == end_) {
+            begin_ = end_ = 0;
+        } else if (capacity_ - end_ < min_length && begin_ > 0) {
+            // 剩余的数据不超过一条记录，移动的开销很小
+            std::memmove(buf_.get(), buf_.get() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+        }
+
+        *length = capacity_ - end_;
+        return buf_.get() + end_;
+    }
+
+    void RecordBuffer::commit(size_t n) {
+        assert(n <= capacity_ - end_);
+        end_ += n;
+    }
+
+    void RecordBuffer::consume(size_t n) {
+        assert(n <= end_ - begin_);
+        begin_ += n;
+        if (begin_ == end_) {
+            begin_ = end_ = 0;
+        }
+    }
+
+    void RecordBuffer::clear() {
+        begin_ = end_ = 0;
+    }
+
+    RecordBuffer::RecordState RecordBuffer::peekRecord(size_t max_length, size_t* length) const {
+        const size_t kHeaderSize = RecordProtection::kHeaderSize;
+        if (size() < kHeaderSize) {
+            return RecordState::Incomplete;
+        }
+
+        auto header = data();
+        size_t fragment_length = (size_t(header[3]) << 8) | header[4];
+        if (fragment_length > max_length) {
+            return RecordState::Oversized;
+        }
+        if (size() < kHeaderSize + fragment_length) {
+            return RecordState::Incomplete;
+        }
+
+        *length = kHeaderSize + fragment_length;
+        return RecordState::Complete;
+    }
+
+    size_t RecordBuffer::capacity() const {
+        return capacity_;
+    }
+
+}
+}
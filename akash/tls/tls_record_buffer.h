@@ -0,0 +1,68 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_TLS_TLS_RECORD_BUFFER_H_
+#define AKASH_TLS_TLS_RECORD_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace akash {
+namespace tls {
+
+    // 每个连接一个的接收缓冲区，创建时分配一次，之后不再分配内存。
+    // 一次 socket 调用可以读入多条记录，记录在缓冲区中就地解密。
+    // 写入位置到达末尾时，将剩余的不完整记录移到开头再继续写入，
+    // 因此每条记录总是连续的，可以直接交给 AEAD。
+    class RecordBuffer {
+    public:
+        enum class RecordState {
+            // 记录头或记录体尚未接收完整
+            Incomplete,
+            Complete,
+            // 记录头中的长度超过上限
+            Oversized,
+        };
+
+        explicit RecordBuffer(size_t capacity);
+
+        // 已接收但尚未取走的数据
+        uint8_t* data() const;
+        size_t size() const;
+
+        /**
+         * 返回可以写入的连续空间，长度为 *length。
+         * 末尾的空间不足 min_length 时先将已有数据移到开头。
+         */
+        uint8_t* prepare(size_t min_length, size_t* length);
+        // 写入 prepare 返回的空间后，提交其中的 n 字节
+        void commit(size_t n);
+        // 取走开头的 n 字节
+        void consume(size_t n);
+        void clear();
+
+        /**
+         * 检查开头的记录是否已经接收完整。
+         * 完整时 *length 为整条记录的长度（包括记录头）。
+         * 记录头中的长度超过 max_length 时返回 Oversized，不需要等待记录体。
+         */
+        RecordState peekRecord(size_t max_length, size_t* length) const;
+
+        size_t capacity() const;
+
+    private:
+        std::unique_ptr<uint8_t[]> buf_;
+        size_t capacity_;
+        size_t begin_ = 0;
+        size_t end_ = 0;
+    };
+
+}
+}
+
+#endif  // AKASH_TLS_TLS_RECORD_BUFFER_H_
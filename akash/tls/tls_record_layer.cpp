@@ -7,18 +7,20 @@
 #include "akash/tls/tls_record_layer.h"
 
 #include "utils/log.h"
-#include "utils/stream_utils.h"
 
-#include "akash/security/big_integer/byte_string.h"
-#include "akash/security/crypto/aead.h"
 #include "akash/socket/socket.h"
 
 
 namespace akash {
 namespace tls {
 
-    TLSRecordLayer::TLSRecordLayer() {
+    TLSRecordLayer::TLSRecordLayer()
+        : out_queue_(kSealBufferSize),
+          recv_buf_(kRecvBufferSize) {
         socket_client_.reset(SocketClient::create());
+        out_queue_.setSocket(socket_client_.get());
+        // recvRecord 等待对方回应之前会发送队列中的数据，因此一个 flight 只需一次写入
+        out_queue_.setFlushPolicy(OutputQueue::FlushPolicy::Throughput);
     }
 
     TLSRecordLayer::~TLSRecordLayer() {
@@ -36,110 +38,190 @@ namespace tls {
     void TLSRecordLayer::disconnect() {
         //worker_.join();
         socket_client_->close();
+        out_queue_.clear();
+        recv_buf_.clear();
+        recv_consumed_ = 0;
     }
 
     bool TLSRecordLayer::sendFragment(const TLSPlaintext& text) {
-        std::ostringstream s(std::ios::binary);
-
-        PUT_STREAM(enum_cast(text.type));
-        PUT_STREAM(text.version.major);
-        PUT_STREAM(text.version.minor);
-
-        // length, 16bit
-        WRITE_STREAM_BE(UIntToUInt16(text.fragment.size()), 2);
-        WRITE_STREAM_STR(text.fragment);
-
-        ++sequence_num_w_;
-
-        return socket_client_->send(s.str());
+        // 明文内容不复制，因此在返回之前发送
+        if (!queueFragment(
+            text.type, reinterpret_cast<const uint8_t*>(text.fragment.data()),
+            text.fragment.size(), text.version))
+        {
+            return false;
+        }
+        return flush();
     }
 
-    bool TLSRecordLayer::recvFragment(TLSPlaintext* text) {
-        std::string rec_header;
-        if (!socket_client_->recv(5, &rec_header)) {
-            ubassert(false);
-            return false;
+    bool TLSRecordLayer::queueFragment(
+        ContentType type, const uint8_t* data, size_t length, ProtocolVersion version)
+    {
+        // change_cipher_spec 始终以明文发送
+        bool succeeded;
+        if (!write_.isEnabled() || type == ContentType::ChangeCipherSpec) {
+            succeeded = out_queue_.queuePlaintext(type, version, data, length);
+        } else {
+            succeeded = out_queue_.queueProtected(type, data, length, &write_);
         }
-        if (rec_header.length() < 5) {
+        if (!succeeded) {
             ubassert(false);
             return false;
         }
+        return true;
+    }
 
-        {
-            std::istringstream s(rec_header, std::ios::binary);
-            READ_STREAM(text->type, 1);
-            READ_STREAM(text->version.major, 1);
-            READ_STREAM(text->version.minor, 1);
-            READ_STREAM_BE(text->length, 2);
-        }
-
-        std::string out;
-        if (!socket_client_->recv(text->length, &out)) {
+    bool TLSRecordLayer::flush() {
+        if (!out_queue_.flush()) {
             ubassert(false);
             return false;
         }
-        if (out.length() < text->length) {
-            ubassert(false);
+        return true;
+    }
+
+    void TLSRecordLayer::setFlushPolicy(OutputQueue::FlushPolicy policy) {
+        out_queue_.setFlushPolicy(policy);
+    }
+
+    bool TLSRecordLayer::recvFragment(TLSPlaintext* text) {
+        TLSRecordView record;
+        if (!recvRecord(&record)) {
             return false;
         }
 
-        if (text->type == ContentType::ChangeCipherSpec) {
-            return true;
-        }
+        text->type = record.type;
+        text->version = record.version;
+        text->length = uint16_t(record.fragment.size());
+        text->fragment.assign(record.fragment.data(), record.fragment.size());
+        return true;
+    }
+
+    bool TLSRecordLayer::recvRecord(TLSRecordView* record) {
+        const size_t kHeaderSize = RecordProtection::kHeaderSize;
+        const size_t kMaxRecordSize = kHeaderSize + RecordProtection::kMaxCiphertextSize;
+
+        recv_buf_.consume(recv_consumed_);
+        recv_consumed_ = 0;
 
-        std::string result;
-        if (is_encrypt_enabled_ && text->type == ContentType::ApplicationData) {
-            std::string_view C(out);
-            auto tag = C.substr(C.size() - 16);
-            C = C.substr(0, C.size() - 16);
-            std::string_view A(rec_header);
-
-            // Section 5.3
-            std::string padded_seq_num(sw_iv_.size() - 8, 0);
-            auto val = utl::fromToBE(sequence_num_r_);
-            padded_seq_num.append(reinterpret_cast<const char*>(&val), 8);
-
-            std::string nonce(sw_iv_.size(), 0);
-            utl::ByteString::exor(
-                reinterpret_cast<const uint8_t*>(padded_seq_num.data()), padded_seq_num.size(),
-                reinterpret_cast<const uint8_t*>(sw_iv_.data()), sw_iv_.size(),
-                reinterpret_cast<uint8_t*>(&*nonce.begin()));
-
-            result.resize(C.length());
-            if (!crypto::GCM::GCM_AD(
-                reinterpret_cast<const uint8_t*>(sw_key_.data()), sw_key_.length(),
-                reinterpret_cast<const uint8_t*>(nonce.data()), nonce.length(),
-                reinterpret_cast<const uint8_t*>(C.data()), C.length(),
-                reinterpret_cast<const uint8_t*>(A.data()), A.length(),
-                reinterpret_cast<const uint8_t*>(tag.data()), 16,
-                reinterpret_cast<uint8_t*>(&*result.begin())))
-            {
+        // 缓冲区中没有完整的记录时才从 socket 读取，一次可能读入多条记录
+        size_t record_length;
+        for (;;) {
+            auto state = recv_buf_.peekRecord(RecordProtection::kMaxCiphertextSize, &record_length);
+            if (state == RecordBuffer::RecordState::Oversized) {
                 ubassert(false);
                 return false;
             }
-            ++sequence_num_r_;
+            if (state == RecordBuffer::RecordState::Complete) {
+                break;
+            }
+
+            // 等待对方回应之前先发出队列中的数据
+            if (!out_queue_.empty() && !flush()) {
+                return false;
+            }
 
-            char ch = 0;
-            auto idx = result.find_last_not_of(ch);
-            if (idx == std::string::npos) {
+            size_t space;
+            auto buf = recv_buf_.prepare(kMaxRecordSize, &space);
+            size_t received;
+            if (!socket_client_->recv(buf, space, &received) || received == 0) {
                 ubassert(false);
                 return false;
             }
+            recv_buf_.commit(received);
+        }
 
-            text->type = ContentType(result[idx]);
-            result = result.substr(0, idx);
-        } else {
-            result = std::move(out);
+        auto header = recv_buf_.data();
+        auto fragment = header + kHeaderSize;
+        size_t length = record_length - kHeaderSize;
+        recv_consumed_ = record_length;
+
+        record->type = ContentType(header[0]);
+        record->version.major = header[1];
+        record->version.minor = header[2];
+
+        if (read_.isEnabled()) {
+            // Section 5
+            // 启用记录保护后外层类型只能是 application_data，真实的内容类型在密文中。
+            // 唯一的例外是兼容模式下的明文 change_cipher_spec，其内容只能是 0x01
+            if (record->type == ContentType::ChangeCipherSpec) {
+                if (length != 1 || fragment[0] != 0x01) {
+                    ubassert(false);
+                    return false;
+                }
+            } else if (record->type != ContentType::ApplicationData) {
+                ubassert(false);
+                return false;
+            } else {
+                // 就地解密，记录头作为 AAD
+                if (!read_.open(header, fragment, length, &record->type, &length)) {
+                    ubassert(false);
+                    return false;
+                }
+                // 加密的 change_cipher_spec 是意外的消息
+                if (record->type == ContentType::ChangeCipherSpec) {
+                    ubassert(false);
+                    return false;
+                }
+            }
         }
 
-        text->fragment = std::move(result);
+        record->fragment = std::string_view(reinterpret_cast<const char*>(fragment), length);
         return true;
     }
 
-    void TLSRecordLayer::setServerWriteKey(const std::string& key, const std::string& iv) {
-        sw_iv_ = iv;
-        sw_key_ = key;
-        is_encrypt_enabled_ = true;
+    bool TLSRecordLayer::setReadKey(
+        Epoch epoch, CipherSuite suite, const KeySchedule::TrafficKey& key)
+    {
+        return switchEpoch(epoch, suite, key, &read_epoch_, &read_generation_, &read_);
+    }
+
+    bool TLSRecordLayer::setWriteKey(
+        Epoch epoch, CipherSuite suite, const KeySchedule::TrafficKey& key)
+    {
+        // 队列中尚未关闭的记录仍使用旧的密钥
+        if (!out_queue_.closeRecord()) {
+            ubassert(false);
+            return false;
+        }
+        return switchEpoch(epoch, suite, key, &write_epoch_, &write_generation_, &write_);
+    }
+
+    TLSRecordLayer::Epoch TLSRecordLayer::getReadEpoch() const {
+        return read_epoch_;
+    }
+
+    TLSRecordLayer::Epoch TLSRecordLayer::getWriteEpoch() const {
+        return write_epoch_;
+    }
+
+    uint32_t TLSRecordLayer::getReadGeneration() const {
+        return read_generation_;
+    }
+
+    uint32_t TLSRecordLayer::getWriteGeneration() const {
+        return write_generation_;
+    }
+
+    // static
+    bool TLSRecordLayer::switchEpoch(
+        Epoch epoch, CipherSuite suite, const KeySchedule::TrafficKey& key,
+        Epoch* cur_epoch, uint32_t* generation, RecordProtection* protection)
+    {
+        if (epoch == Epoch::Initial || epoch < *cur_epoch ||
+            (epoch == *cur_epoch && epoch != Epoch::Application))
+        {
+            ubassert(false);
+            return false;
+        }
+
+        if (!protection->init(suite, key)) {
+            ubassert(false);
+            return false;
+        }
+
+        *generation = (epoch == *cur_epoch) ? *generation + 1 : 0;
+        *cur_epoch = epoch;
+        return true;
     }
 
     void TLSRecordLayer::OnBackgroundWorker() {
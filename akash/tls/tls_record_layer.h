@@ -7,9 +7,14 @@
 #ifndef AKASH_TLS_TLS_RECORD_LAYER_H_
 #define AKASH_TLS_TLS_RECORD_LAYER_H_
 
+#include <string_view>
 #include <thread>
 
 #include "akash/tls/tls_common.h"
+#include "akash/tls/tls_key_schedule.h"
+#include "akash/tls/tls_output_queue.h"
+#include "akash/tls/tls_record_buffer.h"
+#include "akash/tls/tls_record_protection.h"
 
 
 namespace akash {
@@ -47,28 +52,93 @@ namespace tls {
             std::string encrypted_record;
         };
 
+        // 接收缓冲区中的一条记录，已解密
+        struct TLSRecordView {
+            ContentType type;
+            ProtocolVersion version;
+            std::string_view fragment;
+        };
+
+        // 记录保护所处的阶段。读写两个方向分别切换
+        enum class Epoch {
+            // 明文，ClientHello 与 ServerHello
+            Initial,
+            // 使用 handshake traffic secret
+            Handshake,
+            // 使用 application traffic secret，KeyUpdate 之后仍为此阶段
+            Application,
+        };
+
         TLSRecordLayer();
         ~TLSRecordLayer();
 
         bool connect(const std::string& host);
         void disconnect();
 
+        // 加入队列并立即发送
         bool sendFragment(const TLSPlaintext& text);
         bool recvFragment(TLSPlaintext* text);
 
-        void setServerWriteKey(const std::string& key, const std::string& iv);
+        /**
+         * 加入发送队列，相同类型的连续内容合并为一条记录。
+         * 何时发送由 FlushPolicy 决定（默认为 Throughput），开始接收之前也会发送。
+         * 以明文发送时 data 不被复制，在发送之前必须保持有效。
+         */
+        bool queueFragment(
+            ContentType type, const uint8_t* data, size_t length,
+            ProtocolVersion version = { 3, 3 });
+        bool flush();
+        void setFlushPolicy(OutputQueue::FlushPolicy policy);
+
+        /**
+         * 零拷贝接收。记录在接收缓冲区中就地解密，
+         * record->fragment 指向缓冲区中的明文，在下一次接收之前有效。
+         */
+        bool recvRecord(TLSRecordView* record);
+
+        /**
+         * 切换读/写方向的密钥。epoch 不能早于当前的阶段；
+         * 在 Application 阶段再次设置即为 KeyUpdate。
+         * 序列号从 0 开始，旧的密钥被清除。
+         */
+        bool setReadKey(
+            Epoch epoch, CipherSuite suite, const KeySchedule::TrafficKey& key);
+        bool setWriteKey(
+            Epoch epoch, CipherSuite suite, const KeySchedule::TrafficKey& key);
+
+        Epoch getReadEpoch() const;
+        Epoch getWriteEpoch() const;
+        // 当前阶段中 KeyUpdate 的次数
+        uint32_t getReadGeneration() const;
+        uint32_t getWriteGeneration() const;
 
     private:
+        // 可以容纳 4 条最长的记录
+        static const size_t kSealBufferSize =
+            4 * (RecordProtection::kHeaderSize + RecordProtection::kMaxCiphertextSize);
+        static const size_t kRecvBufferSize =
+            4 * (RecordProtection::kHeaderSize + RecordProtection::kMaxCiphertextSize);
+
+        static bool switchEpoch(
+            Epoch epoch, CipherSuite suite, const KeySchedule::TrafficKey& key,
+            Epoch* cur_epoch, uint32_t* generation, RecordProtection* protection);
+
         void OnBackgroundWorker();
 
         std::thread worker_;
         std::unique_ptr<SocketClient> socket_client_;
 
-        bool is_encrypt_enabled_ = false;
-        uint64_t sequence_num_w_ = 0;
-        uint64_t sequence_num_r_ = 0;
-        std::string sw_key_;
-        std::string sw_iv_;
+        Epoch read_epoch_ = Epoch::Initial;
+        Epoch write_epoch_ = Epoch::Initial;
+        uint32_t read_generation_ = 0;
+        uint32_t write_generation_ = 0;
+        RecordProtection read_;
+        RecordProtection write_;
+
+        OutputQueue out_queue_;
+        // 上一条记录在下一次接收时才从 recv_buf_ 中取走
+        RecordBuffer recv_buf_;
+        size_t recv_consumed_ = 0;
     };
 
 }
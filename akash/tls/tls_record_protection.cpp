@@ -0,0 +1,205 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/tls/tls_record_protection.h"
+
+#include <cstring>
+
+
+namespace akash {
+namespace tls {
+
+    RecordProtection::RecordProtection() {
+        std::memset(iv_, 0, sizeof(iv_));
+        std::memset(nonce_, 0, sizeof(nonce_));
+    }
+
+    RecordProtection::~RecordProtection() {
+        clear();
+    }
+
+    bool RecordProtection::init(CipherSuite suite, const KeySchedule::TrafficKey& key) {
+        clear();
+
+        bool succeeded;
+        switch (suite) {
+        case CipherSuite::TLS_AES_128_GCM_SHA256:
+        case CipherSuite::TLS_AES_256_GCM_SHA384:
+            succeeded = gcm_.init(key.key, key.key_length);
+            tag_size_ = 16;
+            break;
+        case CipherSuite::TLS_CHACHA20_POLY1305_SHA256:
+            succeeded = chacha_.init(key.key, key.key_length);
+            tag_size_ = crypto::ChaCha20Poly1305::kTagSize;
+            break;
+        case CipherSuite::TLS_AES_128_CCM_SHA256:
+            succeeded = ccm_.init(key.key, key.key_length);
+            tag_size_ = 16;
+            break;
+        case CipherSuite::TLS_AES_128_CCM_8_SHA256:
+            succeeded = ccm_.init(key.key, key.key_length);
+            tag_size_ = 8;
+            break;
+        default:
+            succeeded = false;
+            break;
+        }
+        if (!succeeded) {
+            clear();
+            return false;
+        }
+
+        suite_ = suite;
+        std::memcpy(iv_, key.iv, sizeof(iv_));
+        std::memcpy(nonce_, key.iv, sizeof(nonce_));
+        is_enabled_ = true;
+        return true;
+    }
+
+    void RecordProtection::clear() {
+        is_enabled_ = false;
+        suite_ = CipherSuite::TLS_NULL_WITH_NULL_NULL;
+        tag_size_ = 0;
+        seq_ = 0;
+        std::memset(iv_, 0, sizeof(iv_));
+        std::memset(nonce_, 0, sizeof(nonce_));
+        gcm_.clear();
+        chacha_.clear();
+        ccm_.clear();
+    }
+
+    bool RecordProtection::isEnabled() const {
+        return is_enabled_;
+    }
+
+    size_t RecordProtection::getTagSize() const {
+        return tag_size_;
+    }
+
+    uint64_t RecordProtection::getSequenceNumber() const {
+        return seq_;
+    }
+
+    size_t RecordProtection::getSealedSize(size_t length) const {
+        return kHeaderSize + length + 1 + tag_size_;
+    }
+
+    bool RecordProtection::seal(ContentType type, uint8_t* record, size_t length) {
+        if (!is_enabled_ || length > kMaxPlaintextSize) {
+            return false;
+        }
+        // Section 5.3
+        // 序列号不能回绕，需要在此之前更新密钥
+        if (seq_ == ~uint64_t(0)) {
+            return false;
+        }
+
+        // TLSInnerPlaintext，不填充 0
+        uint8_t* content = record + kHeaderSize;
+        content[length] = uint8_t(type);
+        size_t lp = length + 1;
+
+        // TLSCiphertext 的记录头同时作为 AAD
+        size_t lc = lp + tag_size_;
+        record[0] = uint8_t(ContentType::ApplicationData);
+        record[1] = 3;
+        record[2] = 3;
+        record[3] = uint8_t(lc >> 8);
+        record[4] = uint8_t(lc);
+
+        computeNonce();
+
+        uint8_t* tag = content + lp;
+        switch (suite_) {
+        case CipherSuite::TLS_CHACHA20_POLY1305_SHA256:
+            chacha_.seal(nonce_, content, lp, record, kHeaderSize, content, tag);
+            break;
+        case CipherSuite::TLS_AES_128_CCM_SHA256:
+        case CipherSuite::TLS_AES_128_CCM_8_SHA256:
+            ccm_.seal(
+                nonce_, sizeof(nonce_), content, lp, record, kHeaderSize,
+                content, tag, tag_size_);
+            break;
+        default:
+            gcm_.seal(
+                nonce_, sizeof(nonce_), content, lp, record, kHeaderSize,
+                content, tag, tag_size_);
+            break;
+        }
+
+        ++seq_;
+        return true;
+    }
+
+    bool RecordProtection::open(
+        const uint8_t* header, uint8_t* data, size_t length,
+        ContentType* type, size_t* content_length)
+    {
+        if (!is_enabled_ || length > kMaxCiphertextSize) {
+            return false;
+        }
+        if (length < tag_size_ + 1) {
+            return false;
+        }
+        if (seq_ == ~uint64_t(0)) {
+            return false;
+        }
+
+        size_t lc = length - tag_size_;
+        const uint8_t* tag = data + lc;
+
+        computeNonce();
+
+        bool opened;
+        switch (suite_) {
+        case CipherSuite::TLS_CHACHA20_POLY1305_SHA256:
+            opened = chacha_.open(nonce_, data, lc, header, kHeaderSize, tag, data);
+            break;
+        case CipherSuite::TLS_AES_128_CCM_SHA256:
+        case CipherSuite::TLS_AES_128_CCM_8_SHA256:
+            opened = ccm_.open(
+                nonce_, sizeof(nonce_), data, lc, header, kHeaderSize,
+                tag, tag_size_, data);
+            break;
+        default:
+            opened = gcm_.open(
+                nonce_, sizeof(nonce_), data, lc, header, kHeaderSize,
+                tag, tag_size_, data);
+            break;
+        }
+        if (!opened) {
+            return false;
+        }
+        ++seq_;
+
+        // Section 5.4
+        // 去掉末尾填充的 0，最后一个非 0 字节为真实的内容类型
+        size_t idx = lc;
+        while (idx > 0 && data[idx - 1] == 0) {
+            --idx;
+        }
+        if (idx == 0) {
+            return false;
+        }
+
+        *type = ContentType(data[idx - 1]);
+        *content_length = idx - 1;
+        if (*content_length > kMaxPlaintextSize) {
+            return false;
+        }
+        return true;
+    }
+
+    void RecordProtection::computeNonce() {
+        // iv 的前 4 字节不变，后 8 字节与大端序的序列号异或
+        const size_t offset = sizeof(nonce_) - 8;
+        for (size_t i = 0; i < 8; ++i) {
+            nonce_[offset + i] = uint8_t(iv_[offset + i] ^ (seq_ >> (56 - 8 * i)));
+        }
+    }
+
+}
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_TLS_TLS_RECORD_PROTECTION_H_
+#define AKASH_TLS_TLS_RECORD_PROTECTION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "akash/security/crypto/aead.h"
+#include "akash/tls/tls_common.h"
+#include "akash/tls/tls_key_schedule.h"
+
+
+namespace akash {
+namespace tls {
+
+    // Section 5.2
+    // 一个方向上一个 epoch 的记录保护。
+    // AEAD 的密钥只在 init 时扩展一次；nonce 由缓存的 iv 与序列号异或得到，
+    // 每条记录只需改写其后 8 个字节。加密和解密均在调用者的缓冲区中就地进行。
+    class RecordProtection {
+    public:
+        static const size_t kHeaderSize = 5;
+        static const size_t kMaxTagSize = 16;
+        // Section 5.1
+        static const size_t kMaxPlaintextSize = 1 << 14;
+        // Section 5.2
+        static const size_t kMaxCiphertextSize = kMaxPlaintextSize + 256;
+
+        RecordProtection();
+        ~RecordProtection();
+
+        bool init(CipherSuite suite, const KeySchedule::TrafficKey& key);
+        void clear();
+
+        bool isEnabled() const;
+        size_t getTagSize() const;
+        uint64_t getSequenceNumber() const;
+
+        // 加密后记录的总长度，包括记录头、内容类型和认证标签
+        size_t getSealedSize(size_t length) const;
+
+        /**
+         * 就地加密一条记录。
+         * record 的前 kHeaderSize 字节用于写入记录头，其后 length 字节为明文内容。
+         * record 的长度不能小于 getSealedSize(length)。
+         * 成功时 record 的前 getSealedSize(length) 字节为完整的 TLSCiphertext。
+         */
+        bool seal(ContentType type, uint8_t* record, size_t length);
+
+        /**
+         * 就地解密一条记录。
+         * header 为长度为 kHeaderSize 的记录头，用作 AAD。
+         * data 为 encrypted_record，长度为 length。
+         * 成功时 data 的前 *content_length 字节为明文内容，*type 为真实的内容类型。
+         */
+        bool open(
+            const uint8_t* header, uint8_t* data, size_t length,
+            ContentType* type, size_t* content_length);
+
+    private:
+        // Section 5.3
+        void computeNonce();
+
+        bool is_enabled_ = false;
+        CipherSuite suite_ = CipherSuite::TLS_NULL_WITH_NULL_NULL;
+        size_t tag_size_ = 0;
+        uint64_t seq_ = 0;
+
+        uint8_t iv_[KeySchedule::kIVSize];
+        uint8_t nonce_[KeySchedule::kIVSize];
+
+        crypto::GCMContext gcm_;
+        crypto::ChaCha20Poly1305 chacha_;
+        crypto::CCMContext ccm_;
+    };
+
+}
+}
+
+#endif  // AKASH_TLS_TLS_RECORD_PROTECTION_H_
@@ -0,0 +1,54 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#include "akash/tls/tls_transcript_hash.h"
+
+
+namespace akash {
+namespace tls {
+
+    TranscriptHash::TranscriptHash()
+        : which_(digest::SHAVersion::SHA256)
+    {
+        sha_.init(which_);
+    }
+
+    bool TranscriptHash::init(digest::SHAVersion which) {
+        which_ = which;
+        return sha_.init(which) == digest::shaSuccess;
+    }
+
+    bool TranscriptHash::update(const uint8_t* msg, size_t length) {
+        return sha_.update(msg, length) == digest::shaSuccess;
+    }
+
+    bool TranscriptHash::update(const std::string& msg) {
+        return update(reinterpret_cast<const uint8_t*>(msg.data()), msg.size());
+    }
+
+    bool TranscriptHash::current(uint8_t hash[kMaxHashSize]) const {
+        return sha_.peekResult(hash) == digest::shaSuccess;
+    }
+
+    bool TranscriptHash::current(std::string* hash) const {
+        uint8_t buf[kMaxHashSize];
+        if (!current(buf)) {
+            return false;
+        }
+        hash->assign(reinterpret_cast<const char*>(buf), getHashSize());
+        return true;
+    }
+
+    size_t TranscriptHash::getHashSize() const {
+        return size_t(digest::USHA::USHAHashSize(which_));
+    }
+
+    digest::SHAVersion TranscriptHash::getVersion() const {
+        return which_;
+    }
+
+}
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2019 ucclkp <ucclkp@gmail.com>.
+// This file is part of akash project.
+//
+// This program is licensed under GPLv3 license that can be
+// found in the LICENSE file.
+
+#ifndef AKASH_TLS_TLS_TRANSCRIPT_HASH_H_
+#define AKASH_TLS_TLS_TRANSCRIPT_HASH_H_
+
+#include <string>
+
+#include "akash/security/digest/sha.h"
+
+
+namespace akash {
+namespace tls {
+
+    // Section 4.4.1
+    // 握手消息的摘要。握手消息到达时逐条输入，
+    // 需要时取得当前的摘要，不影响之后的输入，也不必重新计算之前的消息。
+    class TranscriptHash {
+    public:
+        static const int kMaxHashSize = digest::USHA::kMaxHashSize;
+
+        TranscriptHash();
+
+        bool init(digest::SHAVersion which);
+        bool update(const uint8_t* msg, size_t length);
+        bool update(const std::string& msg);
+
+        // 当前已输入的所有握手消息的摘要，长度为 getHashSize()
+        bool current(uint8_t hash[kMaxHashSize]) const;
+        bool current(std::string* hash) const;
+
+        size_t getHashSize() const;
+        digest::SHAVersion getVersion() const;
+
+    private:
+        digest::SHAVersion which_;
+        digest::USHA sha_;
+    };
+
+}
+}
+
+#endif  // AKASH_TLS_TLS_TRANSCRIPT_HASH_H_